@@ -2,11 +2,8 @@
 # Automatically generated by qmake (2.01a) Fri May 1 17:27:28 2009
 ######################################################################
 
-TEMPLATE = app
-TARGET = 
-DEPENDPATH += .
-INCLUDEPATH += .
+TEMPLATE = subdirs
+CONFIG += ordered
 
-# Input
-HEADERS += calculator.h
-SOURCES += calculator.cpp main.cpp
+# Engine library first, then everything linking it
+SUBDIRS += engine.pro app.pro bench.pro check.pro
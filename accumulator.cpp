@@ -0,0 +1,559 @@
+/** @file accumulator.cpp
+ *
+ *  @brief This file contains the definitions of the running statistics
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "accumulator.h"
+#include "parse.h"
+#include <string.h>
+#include <math.h>
+
+/**
+ *  @brief  Check for a character between numbers
+ *
+ *  @param  c   Character
+ *
+ *  @return true for a blank, comma, semicolon or carriage return
+ */
+static bool isSeparator(char c)
+{
+    /* Check the separators */
+    return (c == ' ') || (c == '\t') || (c == ',') || (c == ';') || (c == '\r');
+}
+
+/**
+ *  @brief  Parse a number
+ *
+ *  @param  p       Start of the number
+ *  @param  end     End of the line
+ *  @param  value   Set to the number
+ *
+ *  @return End of the number, 0 if not a number
+ */
+static const char *parseNumber(const char *p, const char *end, double *value)
+{
+    /* The number must end at a separator */
+    int length = Parse::scan(p, end - p, value);
+    if ((length == 0) || ((p + length < end) && !isSeparator(p[length]))) {
+        return 0;
+    }
+    return p + length;
+}
+
+/**
+ *  @brief  Accumulator object constructor
+ *
+ *  @return N/A
+ */
+Accumulator::Accumulator()
+    : isPairMode(false)
+{
+    /* Start empty */
+    clear();
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Forget all values
+ *
+ *  @return N/A
+ */
+void Accumulator::clear(void)
+{
+    /* Reset everything */
+    count = 0;
+    mean = 0;
+    m2 = 0;
+    sum = 0;
+    compensation = 0;
+    min = HUGE_VAL;
+    max = -HUGE_VAL;
+    pairCount = 0;
+    meanX = 0;
+    meanY = 0;
+    m2X = 0;
+    m2Y = 0;
+    coMoment = 0;
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add to the compensated sum
+ *
+ *  @param  value   Value to add
+ *
+ *  @return N/A
+ */
+void Accumulator::addSum(double value)
+{
+    /* Keep what the larger one rounds off of the smaller one */
+    double total = sum + value;
+    if (fabs(sum) >= fabs(value)) {
+        compensation += (sum - total) + value;
+    } else {
+        compensation += (value - total) + sum;
+    }
+    sum = total;
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add a value
+ *
+ *  @param  value   Value
+ *
+ *  @return N/A
+ */
+void Accumulator::add(double value)
+{
+    /* Move the mean, the moment grows by the old and new differences */
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    addSum(value);
+
+    /* Range */
+    if (value < min) {
+        min = value;
+    }
+    if (value > max) {
+        max = value;
+    }
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add a pair
+ *
+ *  @param  x   Independent value
+ *  @param  y   Dependent value, also added as a value
+ *
+ *  @return N/A
+ */
+void Accumulator::add(double x, double y)
+{
+    /* The value statistics are about y */
+    add(y);
+
+    /* Move both means, the co-moment takes the old x and new y differences */
+    pairCount++;
+    double deltaX = x - meanX;
+    double deltaY = y - meanY;
+    meanX += deltaX / pairCount;
+    meanY += deltaY / pairCount;
+    m2X += deltaX * (x - meanX);
+    m2Y += deltaY * (y - meanY);
+    coMoment += deltaX * (y - meanY);
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add an array of values
+ *
+ *  @param  values  Values
+ *  @param  number  Number of values
+ *
+ *  @return N/A
+ */
+void Accumulator::add(const double *values, int number)
+{
+    for (int first = 0; first < number; first += ACCUMULATOR_BLOCK) {
+        const double *block = values + first;
+        int size = (number - first < ACCUMULATOR_BLOCK) ? number - first : ACCUMULATOR_BLOCK;
+        double sums[4] = { 0, 0, 0, 0 };
+        double squares[4] = { 0, 0, 0, 0 };
+        double blockMin = block[0], blockMax = block[0];
+        int i;
+
+        /* First pass: sum and range, four independent sums */
+        for (i = 0; i + 4 <= size; i += 4) {
+            sums[0] += block[i];
+            sums[1] += block[i + 1];
+            sums[2] += block[i + 2];
+            sums[3] += block[i + 3];
+        }
+        for (; i < size; i++) {
+            sums[0] += block[i];
+        }
+        for (i = 0; i < size; i++) {
+            blockMin = (block[i] < blockMin) ? block[i] : blockMin;
+            blockMax = (block[i] > blockMax) ? block[i] : blockMax;
+        }
+        double blockSum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        double blockMean = blockSum / size;
+
+        /* Second pass over the block in the cache: differences from its mean */
+        for (i = 0; i + 4 <= size; i += 4) {
+            double d0 = block[i] - blockMean;
+            double d1 = block[i + 1] - blockMean;
+            double d2 = block[i + 2] - blockMean;
+            double d3 = block[i + 3] - blockMean;
+            squares[0] += d0 * d0;
+            squares[1] += d1 * d1;
+            squares[2] += d2 * d2;
+            squares[3] += d3 * d3;
+        }
+        for (; i < size; i++) {
+            double d = block[i] - blockMean;
+            squares[0] += d * d;
+        }
+
+        mergeBlock(size, blockMean, (squares[0] + squares[1]) + (squares[2] + squares[3]),
+                   blockSum, blockMin, blockMax);
+    }
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Merge a summed up block of values
+ *
+ *  @param  number      Number of values in the block
+ *  @param  blockMean   Mean of the block
+ *  @param  blockM2     Sum of squared differences from the block mean
+ *  @param  blockSum    Sum of the block
+ *  @param  blockMin    Smallest value of the block
+ *  @param  blockMax    Largest value of the block
+ *
+ *  @return N/A
+ */
+void Accumulator::mergeBlock(quint64 number, double blockMean, double blockM2, double blockSum,
+                             double blockMin, double blockMax)
+{
+    if (number == 0) {
+        return;
+    }
+
+    /* The moment grows by the block's and by the distance of the means */
+    quint64 total = count + number;
+    double delta = blockMean - mean;
+    mean += delta * ((double) number / total);
+    m2 += blockM2 + delta * delta * ((double) count * number / total);
+    count = total;
+    addSum(blockSum);
+
+    /* Range */
+    if (blockMin < min) {
+        min = blockMin;
+    }
+    if (blockMax > max) {
+        max = blockMax;
+    }
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add the values of another accumulator
+ *
+ *  @param  other   Accumulator to add
+ *
+ *  @return N/A
+ */
+void Accumulator::merge(const Accumulator &other)
+{
+    /* Values */
+    mergeBlock(other.count, other.mean, other.m2, other.sum, other.min, other.max);
+    addSum(other.compensation);
+
+    /* Pairs, the same way */
+    if (other.pairCount == 0) {
+        return;
+    }
+    quint64 total = pairCount + other.pairCount;
+    double deltaX = other.meanX - meanX;
+    double deltaY = other.meanY - meanY;
+    double weight = (double) pairCount * other.pairCount / total;
+    meanX += deltaX * ((double) other.pairCount / total);
+    meanY += deltaY * ((double) other.pairCount / total);
+    m2X += other.m2X + deltaX * deltaX * weight;
+    m2Y += other.m2Y + deltaY * deltaY * weight;
+    coMoment += other.coMoment + deltaX * deltaY * weight;
+    pairCount = total;
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Add the numbers of one line
+ *
+ *  In pair mode a line of two numbers is a pair, any other line holds
+ *  values. Numbers are separated by blanks, commas or semicolons.
+ *
+ *  @param  line    Start of the line
+ *  @param  end     End of the line, without the new line
+ *  @param  pending Values waiting to be added as a block
+ *  @param  number  Number of values waiting, updated
+ *
+ *  @return false if the line has something else than numbers, it is skipped
+ */
+bool Accumulator::addLine(const char *line, const char *end, double *pending, int *number)
+{
+    int first = *number;
+    int found = 0;
+
+    /* Make room for a whole line */
+    if (first > ACCUMULATOR_BLOCK - ACCUMULATOR_LINE) {
+        add(pending, first);
+        first = 0;
+        *number = 0;
+    }
+
+    /* Parse the numbers after the waiting ones */
+    const char *p = line;
+    for (;;) {
+        while ((p < end) && isSeparator(*p)) {
+            p++;
+        }
+        if (p == end) {
+            break;
+        }
+        if (found == ACCUMULATOR_LINE) {
+            return false;
+        }
+        p = parseNumber(p, end, &pending[first + found]);
+        if (p == 0) {
+            return false;
+        }
+        found++;
+    }
+
+    if (isPairMode && (found == 2)) {
+        /* Pair */
+        add(pending[first], pending[first + 1]);
+    } else {
+        /* Values, added with the block */
+        *number = first + found;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Accumulator object method : Set whether lines of two numbers in a stream are pairs
+ *
+ *  Off by default, every number read is a value. On, a line of two
+ *  numbers is an x and y pair for the regression and only y is a value.
+ *
+ *  @param  enable  true for pairs
+ *
+ *  @return N/A
+ */
+void Accumulator::setPairMode(bool enable)
+{
+    /* Set the mode, the values added so far stay */
+    isPairMode = enable;
+    return;
+}
+
+/**
+ *  @brief  Accumulator object method : Get whether lines of two numbers in a stream are pairs
+ *
+ *  @return true for pairs
+ */
+bool Accumulator::getPairMode(void) const
+{
+    /* Return the mode */
+    return isPairMode;
+}
+
+/**
+ *  @brief  Accumulator object method : Add the numbers read from a stream
+ *
+ *  The stream is read in large blocks and the values are added a block
+ *  at a time, see addLine() for the format.
+ *
+ *  @param  file    Stream to read to its end
+ *
+ *  @return Number of lines skipped
+ */
+quint64 Accumulator::addStream(FILE *file)
+{
+    char *buffer = new char[ACCUMULATOR_READ];
+    double pending[ACCUMULATOR_BLOCK];
+    int number = 0;
+    size_t kept = 0;
+    quint64 skipped = 0;
+    bool isSkipping = false;
+
+    for (;;) {
+        /* Read after the unfinished line */
+        size_t got = fread(buffer + kept, 1, ACCUMULATOR_READ - kept, file);
+        const char *p = buffer;
+        const char *end = buffer + kept + got;
+
+        /* Whole lines */
+        for (;;) {
+            const char *eol = (const char *) memchr(p, '\n', end - p);
+            if (eol == 0) {
+                break;
+            }
+            if (isSkipping) {
+                /* The rest of a line too long to read */
+                isSkipping = false;
+            } else if (!addLine(p, eol, pending, &number)) {
+                skipped++;
+            }
+            p = eol + 1;
+        }
+        kept = end - p;
+
+        if (got == 0) {
+            /* End of the stream, the last line may have no new line */
+            if ((kept > 0) && !isSkipping && !addLine(p, end, pending, &number)) {
+                skipped++;
+            }
+            break;
+        }
+        if (kept == ACCUMULATOR_READ) {
+            /* No new line in the whole buffer */
+            if (!isSkipping) {
+                skipped++;
+            }
+            isSkipping = true;
+            kept = 0;
+        }
+        memmove(buffer, p, kept);
+    }
+
+    /* The last block */
+    add(pending, number);
+    delete [] buffer;
+    return skipped;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the number of values
+ *
+ *  @return Number of values
+ */
+quint64 Accumulator::getCount(void) const
+{
+    /* Return the count */
+    return count;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the sum
+ *
+ *  @return Sum, with what the rounding lost added back
+ */
+double Accumulator::getSum(void) const
+{
+    /* Return the sum with the compensation */
+    return sum + compensation;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the mean
+ *
+ *  @return Mean, 0 if there are no values
+ */
+double Accumulator::getMean(void) const
+{
+    /* Return the mean */
+    return mean;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the sample variance
+ *
+ *  @return Variance, 0 for fewer than two values
+ */
+double Accumulator::getVariance(void) const
+{
+    /* Return the sample variance */
+    return (count > 1) ? m2 / (count - 1) : 0;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the sample standard deviation
+ *
+ *  @return Standard deviation, 0 for fewer than two values
+ */
+double Accumulator::getDeviation(void) const
+{
+    /* Return the square root of the variance */
+    return sqrt(getVariance());
+}
+
+/**
+ *  @brief  Accumulator object method : Get the smallest value
+ *
+ *  @return Smallest value, 0 if there are no values
+ */
+double Accumulator::getMin(void) const
+{
+    /* Return the minimum */
+    return (count > 0) ? min : 0;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the largest value
+ *
+ *  @return Largest value, 0 if there are no values
+ */
+double Accumulator::getMax(void) const
+{
+    /* Return the maximum */
+    return (count > 0) ? max : 0;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the number of pairs
+ *
+ *  @return Number of pairs
+ */
+quint64 Accumulator::getPairCount(void) const
+{
+    /* Return the pair count */
+    return pairCount;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the slope of the regression line
+ *
+ *  @return Slope of the least squares line of y on x, 0 if x never changes
+ */
+double Accumulator::getSlope(void) const
+{
+    /* Return the slope */
+    return (m2X != 0) ? coMoment / m2X : 0;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the intercept of the regression line
+ *
+ *  @return Value of the least squares line of y on x at x = 0
+ */
+double Accumulator::getIntercept(void) const
+{
+    /* Return the intercept */
+    return meanY - getSlope() * meanX;
+}
+
+/**
+ *  @brief  Accumulator object method : Get the correlation coefficient of the pairs
+ *
+ *  @return Correlation coefficient, 0 if x or y never changes
+ */
+double Accumulator::getCorrelation(void) const
+{
+    /* Return the correlation */
+    return ((m2X != 0) && (m2Y != 0)) ? coMoment / sqrt(m2X * m2Y) : 0;
+}
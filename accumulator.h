@@ -0,0 +1,135 @@
+/** @file accumulator.h
+ *
+ *  @brief This file contains the declarations of the running statistics
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+/* Includes */
+#include <stdio.h>
+#include <QString>
+
+/* Defines */
+
+/** Values summed up as one block before they are merged */
+#define ACCUMULATOR_BLOCK   1024
+/** Most numbers on a line of a stream */
+#define ACCUMULATOR_LINE    64
+/** Bytes read from a stream at once */
+#define ACCUMULATOR_READ    (1 << 20)
+
+/**
+ *  Running statistics of a stream of values, in one pass.
+ *
+ *  Count, sum, mean, variance, minimum and maximum are kept for the
+ *  values, and the means, variances and co-moment of the pairs for a
+ *  linear regression of y on x. The mean and the moments are updated
+ *  the Welford way, so no sum of squares ever cancels, and the sum is
+ *  compensated the Kahan-Babuska way. The memory used does not grow
+ *  with the number of values.
+ *
+ *  Arrays of values are summed up in blocks, two passes over a block
+ *  in the cache, and the block is merged in with the formula of Chan,
+ *  Golub and LeVeque.
+ */
+class Accumulator
+{
+public:
+    /** Constructor */
+    Accumulator();
+    /** Forget all values */
+    void clear(void);
+    /** Add a value */
+    void add(double value);
+    /** Add a pair, y is also added as a value */
+    void add(double x, double y);
+    /** Add an array of values */
+    void add(const double *values, int count);
+    /** Add the values of another accumulator */
+    void merge(const Accumulator &other);
+    /** Set whether lines of two numbers in a stream are pairs */
+    void setPairMode(bool enable);
+    /** Get whether lines of two numbers in a stream are pairs */
+    bool getPairMode(void) const;
+    /** Add the numbers read from a stream */
+    quint64 addStream(FILE *file);
+    /** Get the number of values */
+    quint64 getCount(void) const;
+    /** Get the sum */
+    double getSum(void) const;
+    /** Get the mean */
+    double getMean(void) const;
+    /** Get the sample variance */
+    double getVariance(void) const;
+    /** Get the sample standard deviation */
+    double getDeviation(void) const;
+    /** Get the smallest value */
+    double getMin(void) const;
+    /** Get the largest value */
+    double getMax(void) const;
+    /** Get the number of pairs */
+    quint64 getPairCount(void) const;
+    /** Get the slope of the regression line */
+    double getSlope(void) const;
+    /** Get the intercept of the regression line */
+    double getIntercept(void) const;
+    /** Get the correlation coefficient of the pairs */
+    double getCorrelation(void) const;
+
+private:
+    /** Number of values */
+    quint64 count;
+    /** Mean */
+    double mean;
+    /** Sum of squared differences from the mean */
+    double m2;
+    /** Sum */
+    double sum;
+    /** Lost low order part of the sum */
+    double compensation;
+    /** Smallest value */
+    double min;
+    /** Largest value */
+    double max;
+    /** Number of pairs */
+    quint64 pairCount;
+    /** Mean of x */
+    double meanX;
+    /** Mean of y */
+    double meanY;
+    /** Sum of squared differences of x from its mean */
+    double m2X;
+    /** Sum of squared differences of y from its mean */
+    double m2Y;
+    /** Sum of the products of the differences from the means */
+    double coMoment;
+    /** Lines of two numbers in a stream are pairs */
+    bool isPairMode;
+    /** Add to the compensated sum */
+    void addSum(double value);
+    /** Merge a summed up block of values */
+    void mergeBlock(quint64 number, double blockMean, double blockM2, double blockSum,
+                    double blockMin, double blockMax);
+    /** Add the numbers of one line */
+    bool addLine(const char *line, const char *end, double *pending, int *number);
+};
+
+#endif // ACCUMULATOR_H
@@ -0,0 +1,14 @@
+######################################################################
+# Calculator application
+######################################################################
+
+TEMPLATE = app
+TARGET = QCalc
+DEPENDPATH += .
+INCLUDEPATH += .
+LIBS += -L. -lqcalcengine
+PRE_TARGETDEPS += libqcalcengine.a
+
+# Input
+HEADERS += calculator.h lcd.h
+SOURCES += calculator.cpp lcd.cpp main.cpp
@@ -0,0 +1,397 @@
+/** @file batch.cpp
+ *
+ *  @brief This file contains the definitions of the batch mode
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "batch.h"
+#include "expression.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+/** Batch token to button map entry */
+struct BatchToken {
+    /** Token name */
+    const char *name;
+    /** Button index */
+    int button;
+};
+
+/** Batch tokens, button labels first and then aliases */
+static const BatchToken batchTokens[] = {
+    { "/",    BUTTON_DIV },  { "C",    BUTTON_CLR },  { "*",    BUTTON_MUL },
+    { "Sq",   BUTTON_SQ },   { "-",    BUTTON_NEG },  { "1/x",  BUTTON_INV },
+    { "+/-",  BUTTON_SIGN }, { ".",    BUTTON_DOT },  { "+",    BUTTON_PLUS },
+    { "=",    BUTTON_EQ },   { "MC",   BUTTON_MC },   { "MR",   BUTTON_MR },
+    { "MS",   BUTTON_MS },   { "M+",   BUTTON_MP },   { "Bksp", BUTTON_BS },
+    { "Sqrt", BUTTON_SQRT }, { "!x",   BUTTON_FACT }, { "x^3",  BUTTON_CUBE },
+    { "Bin",  BUTTON_BIN },  { "Hex",  BUTTON_HEX },
+    { "esc",  BUTTON_CLR },  { "backspace", BUTTON_BS }, { "!", BUTTON_FACT },
+    { "inv",  BUTTON_INV },  { "sign", BUTTON_SIGN } };
+
+/** Number of batch tokens */
+#define NUM_BATCH_TOKENS    ((int) (sizeof(batchTokens) / sizeof(batchTokens[0])))
+
+/** Digit to button map */
+static const int digitButtons[10] = {
+    BUTTON_0, BUTTON_1, BUTTON_2, BUTTON_3, BUTTON_4,
+    BUTTON_5, BUTTON_6, BUTTON_7, BUTTON_8, BUTTON_9 };
+
+/**
+ *  @brief  Batch object constructor
+ *
+ *  @return N/A
+ */
+BatchRunner::BatchRunner()
+    : isExpressionMode(false), isPasteMode(false), isUndoMode(false)
+{
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Set expression mode
+ *
+ *  @param  status  true to read expressions, false for keystrokes
+ *
+ *  @return N/A
+ */
+void BatchRunner::setExpressionMode(bool status)
+{
+    /* Set expression mode */
+    isExpressionMode = status;
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Set paste mode
+ *
+ *  @param  status  true to enter numbers whole, false to type them
+ *
+ *  @return N/A
+ */
+void BatchRunner::setPasteMode(bool status)
+{
+    /* Set paste mode */
+    isPasteMode = status;
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Set undo mode
+ *
+ *  @param  status  true to record the tokens for undo, false to run them only
+ *
+ *  @return N/A
+ */
+void BatchRunner::setUndoMode(bool status)
+{
+    /* Set undo mode */
+    isUndoMode = status;
+    history.clear();
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Get the engine
+ *
+ *  @return Pointer to the calculator engine
+ */
+Engine *BatchRunner::getEngine(void)
+{
+    /* Return engine */
+    return &engine;
+}
+
+/**
+ *  @brief  Batch object method : Run the scripts named on the command line
+ *
+ *  @param  count   Number of script names
+ *  @param  names   Script names, "-" for standard input
+ *
+ *  @return 0 on success, 1 on failure
+ */
+int BatchRunner::runFiles(int count, char **names)
+{
+    int ret = 0;
+    static char outBuffer[1 << 16];
+
+    /* Keystrokes come fast, so do the output */
+    setvbuf(stdout, outBuffer, _IOFBF, sizeof(outBuffer));
+
+    /* No script named, read from standard input */
+    if (count == 0) {
+        return run(stdin, stdout);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], "-") == 0) {
+            /* Script from standard input */
+            ret |= run(stdin, stdout);
+            continue;
+        }
+
+        FILE *in = fopen(names[i], "r");
+        if (in == NULL) {
+            /* Report the missing script and go on with the rest */
+            fprintf(stderr, "qcalc: cannot open '%s'\n", names[i]);
+            ret = 1;
+            continue;
+        }
+        ret |= run(in, stdout);
+        fclose(in);
+    }
+    fflush(stdout);
+    return ret;
+}
+
+/**
+ *  @brief  Batch object method : Run one script stream
+ *
+ *  @param  in      Script stream
+ *  @param  out     Result stream
+ *
+ *  @return 0 on success
+ */
+int BatchRunner::run(FILE *in, FILE *out)
+{
+    char *line = NULL;
+    size_t size = 0;
+
+    /* Run the script line by line */
+    while (getline(&line, &size, in) != -1) {
+        runLine(line, out);
+    }
+    free(line);
+    return 0;
+}
+
+/**
+ *  @brief  Batch object method : Run one script line
+ *
+ *  @param  line    Script line, keystrokes separated by white space
+ *  @param  out     Result stream
+ *
+ *  @return N/A
+ */
+void BatchRunner::runLine(const char *line, FILE *out)
+{
+    const char *p = line;
+    bool pressed = false;
+
+    /* Skip leading white space */
+    while (isspace((unsigned char) *p)) {
+        p++;
+    }
+
+    /* Skip empty and comment lines */
+    if ((*p == '\0') || (*p == '#')) {
+        return;
+    }
+
+    /* Expressions are compiled as a whole */
+    if (isExpressionMode) {
+        runExpression(p, out);
+        return;
+    }
+
+    while (*p != '\0') {
+        /* Find the end of the token */
+        const char *end = p;
+        while ((*end != '\0') && !isspace((unsigned char) *end)) {
+            end++;
+        }
+
+        if (end > p) {
+            if (!pressToken(p, end - p)) {
+                fprintf(stderr, "qcalc: unknown key '%.*s'\n", (int) (end - p), p);
+            }
+            pressed = true;
+        }
+
+        /* Skip white space up to the next token */
+        p = end;
+        while (isspace((unsigned char) *p)) {
+            p++;
+        }
+    }
+
+    if (pressed) {
+        /* Print the LCD text */
+        QByteArray text = engine.getDisplayText().toLatin1();
+        fwrite(text.constData(), 1, text.size(), out);
+        fputc('\n', out);
+    }
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Run one expression line
+ *
+ *  @param  line    Expression text
+ *  @param  out     Result stream
+ *
+ *  @return N/A
+ */
+void BatchRunner::runExpression(const char *line, FILE *out)
+{
+    Expression expression;
+
+    /* Compile the expression, report errors but keep one result per line.
+     * Constants are only folded in double precision, see Engine::evaluate(). */
+    if (!expression.compile(QString::fromLatin1(line).trimmed(), engine.getArithMode() == ARITH_DOUBLE)) {
+        QByteArray error = expression.getError().toLatin1();
+        fprintf(stderr, "qcalc: %s\n", error.constData());
+    }
+
+    /* Evaluate it and print the LCD text */
+    engine.evaluate(expression);
+    QByteArray text = engine.getDisplayText().toLatin1();
+    fwrite(text.constData(), 1, text.size(), out);
+    fputc('\n', out);
+    return;
+}
+
+/**
+ *  @brief  Batch object method : Press the button for a token
+ *
+ *  @param  token   Token text, not terminated
+ *  @param  length  Token length
+ *
+ *  @return true if the token was known
+ */
+bool BatchRunner::pressToken(const char *token, int length)
+{
+    /* Undo and redo step through the tokens */
+    if ((length == 4) && ((strncasecmp(token, "undo", 4) == 0) || (strncasecmp(token, "redo", 4) == 0))) {
+        if (!isUndoMode) {
+            /* Nothing was recorded to step through */
+            fprintf(stderr, "qcalc: '%.*s' needs --undo\n", length, token);
+        } else if (tolower(token[0]) == 'u') {
+            history.undo(&engine);
+        } else {
+            history.redo(&engine);
+        }
+        return true;
+    }
+
+    /* Keep the state before the token, forgotten if it is not known */
+    if (isUndoMode) {
+        history.record(&engine);
+    }
+
+    /* Numbers are typed digit by digit */
+    if (typeNumber(token, length)) {
+        return true;
+    }
+
+    /* Look for the button label */
+    for (int i = 0; i < NUM_BATCH_TOKENS; i++) {
+        if (((int) strlen(batchTokens[i].name) == length) &&
+            (strncasecmp(batchTokens[i].name, token, length) == 0)) {
+            engine.buttonPressed(batchTokens[i].button);
+            return true;
+        }
+    }
+
+#if HEX
+    /* Hex digits */
+    if ((length == 1) && (tolower(token[0]) >= 'a') && (tolower(token[0]) <= 'f')) {
+        engine.hexButtonPressed(HEX_BUTTON_A + (tolower(token[0]) - 'a'));
+        return true;
+    }
+#endif
+
+    /* In paste mode anything else is pasted, "1,234.5" or "2*3" say */
+    if (isPasteMode && engine.enterText(QString::fromLatin1(token, length))) {
+        return true;
+    }
+
+    history.drop();
+    return false;
+}
+
+/**
+ *  @brief  Batch object method : Type a number token digit by digit
+ *
+ *  @param  token   Token text, not terminated
+ *  @param  length  Token length
+ *
+ *  @return true if the token was a number
+ */
+bool BatchRunner::typeNumber(const char *token, int length)
+{
+    int start = 0, dots = 0, digits = 0;
+    bool negative = false;
+#if HEX
+    /* Hex numbers take letters, a lone "c" is still Clear */
+    bool hex = (engine.getRadix() == MODE_HEX) && (length > 1);
+#endif
+
+    /* A leading '-' makes a negative number, a lone '-' is the operator */
+    if ((length > 1) && (token[0] == '-')) {
+        negative = true;
+        start = 1;
+    }
+
+    /* Check the number first, nothing is pressed for other tokens */
+    for (int i = start; i < length; i++) {
+        if (token[i] == '.') {
+            dots++;
+        } else if ((token[i] >= '0') && (token[i] <= '9')) {
+            digits++;
+#if HEX
+        } else if (hex && (tolower(token[i]) >= 'a') && (tolower(token[i]) <= 'f')) {
+            digits++;
+#endif
+        } else {
+            return false;
+        }
+    }
+    if ((digits == 0) || (dots > 1)) {
+        return false;
+    }
+
+    /* Enter it whole in paste mode */
+    if (isPasteMode) {
+        engine.enterText(QString::fromLatin1(token, length));
+        return true;
+    }
+
+    /* Type the digits */
+    for (int i = start; i < length; i++) {
+        if (token[i] == '.') {
+            engine.buttonPressed(BUTTON_DOT);
+#if HEX
+        } else if ((token[i] < '0') || (token[i] > '9')) {
+            engine.hexButtonPressed(HEX_BUTTON_A + (tolower(token[i]) - 'a'));
+#endif
+        } else {
+            engine.buttonPressed(digitButtons[token[i] - '0']);
+        }
+    }
+
+    /* Apply the sign last, as a user would */
+    if (negative) {
+        engine.buttonPressed(BUTTON_SIGN);
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+/** @file batch.h
+ *
+ *  @brief This file contains the declarations of the batch mode
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/* Includes */
+#include <stdio.h>
+#include "engine.h"
+#include "undo.h"
+
+/**
+ *  Our batch mode runner, drives the engine without any widget.
+ *
+ *  A script is read line by line. Each line holds keystrokes separated
+ *  by white space: a button label ("7", "+", "Sqrt", "M+", ...) presses
+ *  that button, a number ("12.5", "-3") is typed digit by digit. After
+ *  each line the LCD text is printed. Empty lines and lines starting
+ *  with '#' are skipped. In paste mode numbers are entered whole
+ *  instead, as a clipboard paste does. In undo mode "undo" and "redo"
+ *  step through the tokens pressed so far, the state is then recorded
+ *  before each token.
+ *
+ *  In expression mode each line is an expression instead, see
+ *  Expression for the grammar, and its result is printed.
+ */
+class BatchRunner
+{
+public:
+    /** Constructor */
+    BatchRunner();
+    /** Set expression mode */
+    void setExpressionMode(bool);
+    /** Set paste mode */
+    void setPasteMode(bool);
+    /** Set undo mode */
+    void setUndoMode(bool);
+    /** Get the engine */
+    Engine *getEngine(void);
+    /** Run the scripts named on the command line */
+    int runFiles(int count, char **names);
+    /** Run one script stream */
+    int run(FILE *in, FILE *out);
+    /** Run one script line */
+    void runLine(const char *line, FILE *out);
+
+private:
+    /** Calculator engine */
+    Engine engine;
+    /** Undo history */
+    UndoHistory history;
+    /** Expression mode status */
+    bool isExpressionMode;
+    /** Paste mode status */
+    bool isPasteMode;
+    /** Undo mode status */
+    bool isUndoMode;
+    /** Run one expression line */
+    void runExpression(const char *line, FILE *out);
+    /** Press the button for a token */
+    bool pressToken(const char *token, int length);
+    /** Type a number token digit by digit */
+    bool typeNumber(const char *token, int length);
+};
+
+#endif // BATCH_H
@@ -0,0 +1,450 @@
+/** @file bench.cpp
+ *
+ *  @brief This file contains the benchmark suite of the calculator engine
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "engine.h"
+#include "format.h"
+#include "parse.h"
+
+/* Defines */
+
+/** Default number of samples per benchmark */
+#define BENCH_SAMPLES       15
+/** Most samples per benchmark */
+#define BENCH_MAX_SAMPLES   1000
+/** Default shortest sample in milliseconds */
+#define BENCH_MIN_TIME      20
+/** Number of keystrokes in the keystroke sequence */
+#define BENCH_KEYSTROKES    8
+
+/** Listener counting the LCD text handed out */
+class CountingListener : public EngineListener
+{
+public:
+    /** Constructor */
+    CountingListener() : count(0) {}
+    /** LCD text changed */
+    void lcdChanged(const QString &text) { count += text.length(); }
+    /** Button name changed */
+    void buttonChanged(int, const QString &, int) {}
+    /** Arithmetic changed */
+    void arithChanged(int) {}
+    /** Characters seen */
+    long count;
+};
+
+/** One benchmark */
+struct BenchCase
+{
+    /** Name, '<group>.<arithmetic>[.<operator>]' */
+    const char *name;
+    /** Run the benchmark for a number of iterations */
+    void (*function)(const BenchCase &bench, long iterations);
+    /** Arithmetic */
+    int arith;
+    /** Operator */
+    int op;
+};
+
+/** Engine the benchmarks run on */
+static Engine engine;
+/** Listener of the engine */
+static CountingListener listener;
+/** Results end up here, so the work cannot be dropped */
+static volatile double sink;
+
+/** Keystrokes typed over and over: "12.5 * 3 = C" */
+static const int keystrokes[BENCH_KEYSTROKES] = {
+    BUTTON_1, BUTTON_2, BUTTON_DOT, BUTTON_5, BUTTON_MUL, BUTTON_3, BUTTON_EQ, BUTTON_CLR
+};
+
+/**
+ *  @brief  Operand 1 of an operator
+ *
+ *  @param  op  Operator
+ *
+ *  @return Operand text
+ */
+static const char *operand1(int op)
+{
+    /* Factorial wants a small integer, square root anything positive */
+    if (op == OPERATOR_FACT) {
+        return "20";
+    }
+    if (op == OPERATOR_SQRT) {
+        return "2";
+    }
+    return "1234.5678";
+}
+
+/**
+ *  @brief  Operand 2 of an operator
+ *
+ *  @param  op  Operator
+ *
+ *  @return Operand text
+ */
+static const char *operand2(int op)
+{
+    /* Unary operators ignore it */
+    if ((op == OPERATOR_FACT) || (op == OPERATOR_SQRT)) {
+        return operand1(op);
+    }
+    return "9.87654321";
+}
+
+/**
+ *  @brief  Benchmark : Calculation on doubles, no text involved
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of iterations
+ *
+ *  @return N/A
+ */
+static void benchCompute(const BenchCase &bench, long iterations)
+{
+    double op1 = atof(operand1(bench.op));
+    double op2 = atof(operand2(bench.op));
+    double sum = 0;
+    bool error = false;
+
+    for (long i = 0; i < iterations; i++) {
+        sum += Engine::compute(op1, op2, bench.op, &error);
+    }
+    sink = sum;
+    return;
+}
+
+/**
+ *  @brief  Benchmark : Calculation on text, as the engine does it
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of iterations
+ *
+ *  @return N/A
+ */
+static void benchCalculate(const BenchCase &bench, long iterations)
+{
+    QString op1 = operand1(bench.op);
+    QString op2 = operand2(bench.op);
+    long length = 0;
+
+    engine.setArithMode(bench.arith);
+    for (long i = 0; i < iterations; i++) {
+        length += engine.calculate(op1, op2, bench.op).length();
+    }
+    sink = length;
+    return;
+}
+
+/**
+ *  @brief  Benchmark : Parse a number
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of iterations
+ *
+ *  @return N/A
+ */
+static void benchParse(const BenchCase &bench, long iterations)
+{
+    QString text = "1234.5678901234";
+    double sum = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        if (bench.arith == ARITH_BIG) {
+            sum += BigFloat::fromString(text, 0).isZero() ? 0 : 1;
+        } else if (bench.arith == ARITH_DECIMAL) {
+            sum += Decimal::fromString(text, 0).isZero() ? 0 : 1;
+        } else {
+            sum += Parse::toDouble(text);
+        }
+    }
+    sink = sum;
+    return;
+}
+
+/**
+ *  @brief  Benchmark : Format a number
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of iterations
+ *
+ *  @return N/A
+ */
+static void benchFormat(const BenchCase &bench, long iterations)
+{
+    double value = 1234.5678901234;
+    BigFloat bigValue(value);
+    Decimal decimalValue(value);
+    int digits = engine.getPrecision();
+    QString text;
+    long length = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        if (bench.arith == ARITH_BIG) {
+            text = bigValue.toString(digits);
+        } else if (bench.arith == ARITH_DECIMAL) {
+            text = decimalValue.toString();
+        } else {
+            text = Format::toString(value);
+        }
+        length += text.length();
+    }
+    sink = length;
+    return;
+}
+
+/**
+ *  @brief  Benchmark : Full keystrokes through the engine
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of keystrokes
+ *
+ *  @return N/A
+ */
+static void benchKeystroke(const BenchCase &bench, long iterations)
+{
+    engine.reset();
+    engine.setArithMode(bench.arith);
+    for (long i = 0; i < iterations; i++) {
+        engine.buttonPressed(keystrokes[i % BENCH_KEYSTROKES]);
+    }
+    sink = listener.count;
+    return;
+}
+
+/**
+ *  @brief  Benchmark : LCD update handed to the listener
+ *
+ *  @param  bench       Benchmark
+ *  @param  iterations  Number of iterations
+ *
+ *  @return N/A
+ */
+static void benchUpdateLCD(const BenchCase &bench, long iterations)
+{
+    engine.reset();
+    engine.setArithMode(bench.arith);
+    engine.setText("-12345.6789");
+    for (long i = 0; i < iterations; i++) {
+        engine.updateLCD();
+    }
+    sink = listener.count;
+    return;
+}
+
+/** All benchmarks */
+static const BenchCase benchCases[] = {
+    { "compute.double.plus",        benchCompute,   ARITH_DOUBLE,   OPERATOR_PLUS },
+    { "compute.double.minus",       benchCompute,   ARITH_DOUBLE,   OPERATOR_MINUS },
+    { "compute.double.mul",         benchCompute,   ARITH_DOUBLE,   OPERATOR_MUL },
+    { "compute.double.div",         benchCompute,   ARITH_DOUBLE,   OPERATOR_DIV },
+    { "compute.double.sqrt",        benchCompute,   ARITH_DOUBLE,   OPERATOR_SQRT },
+    { "compute.double.fact",        benchCompute,   ARITH_DOUBLE,   OPERATOR_FACT },
+    { "calculate.double.plus",      benchCalculate, ARITH_DOUBLE,   OPERATOR_PLUS },
+    { "calculate.double.minus",     benchCalculate, ARITH_DOUBLE,   OPERATOR_MINUS },
+    { "calculate.double.mul",       benchCalculate, ARITH_DOUBLE,   OPERATOR_MUL },
+    { "calculate.double.div",       benchCalculate, ARITH_DOUBLE,   OPERATOR_DIV },
+    { "calculate.double.sqrt",      benchCalculate, ARITH_DOUBLE,   OPERATOR_SQRT },
+    { "calculate.double.fact",      benchCalculate, ARITH_DOUBLE,   OPERATOR_FACT },
+    { "calculate.decimal.plus",     benchCalculate, ARITH_DECIMAL,  OPERATOR_PLUS },
+    { "calculate.decimal.minus",    benchCalculate, ARITH_DECIMAL,  OPERATOR_MINUS },
+    { "calculate.decimal.mul",      benchCalculate, ARITH_DECIMAL,  OPERATOR_MUL },
+    { "calculate.decimal.div",      benchCalculate, ARITH_DECIMAL,  OPERATOR_DIV },
+    { "calculate.decimal.sqrt",     benchCalculate, ARITH_DECIMAL,  OPERATOR_SQRT },
+    { "calculate.decimal.fact",     benchCalculate, ARITH_DECIMAL,  OPERATOR_FACT },
+    { "calculate.big.plus",         benchCalculate, ARITH_BIG,      OPERATOR_PLUS },
+    { "calculate.big.minus",        benchCalculate, ARITH_BIG,      OPERATOR_MINUS },
+    { "calculate.big.mul",          benchCalculate, ARITH_BIG,      OPERATOR_MUL },
+    { "calculate.big.div",          benchCalculate, ARITH_BIG,      OPERATOR_DIV },
+    { "calculate.big.sqrt",         benchCalculate, ARITH_BIG,      OPERATOR_SQRT },
+    { "calculate.big.fact",         benchCalculate, ARITH_BIG,      OPERATOR_FACT },
+    { "parse.double",               benchParse,     ARITH_DOUBLE,   OPERATOR_NONE },
+    { "parse.decimal",              benchParse,     ARITH_DECIMAL,  OPERATOR_NONE },
+    { "parse.big",                  benchParse,     ARITH_BIG,      OPERATOR_NONE },
+    { "format.double",              benchFormat,    ARITH_DOUBLE,   OPERATOR_NONE },
+    { "format.decimal",             benchFormat,    ARITH_DECIMAL,  OPERATOR_NONE },
+    { "format.big",                 benchFormat,    ARITH_BIG,      OPERATOR_NONE },
+    { "keystroke.double",           benchKeystroke, ARITH_DOUBLE,   OPERATOR_NONE },
+    { "keystroke.decimal",          benchKeystroke, ARITH_DECIMAL,  OPERATOR_NONE },
+    { "keystroke.big",              benchKeystroke, ARITH_BIG,      OPERATOR_NONE },
+    { "updatelcd.double",           benchUpdateLCD, ARITH_DOUBLE,   OPERATOR_NONE }
+};
+
+/**
+ *  @brief  Monotonic clock
+ *
+ *  @return Time in nanoseconds
+ */
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ *  @brief  Compare two doubles for qsort
+ *
+ *  @param  a   Pointer to the first double
+ *  @param  b   Pointer to the second double
+ *
+ *  @return Negative, zero or positive
+ */
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+/**
+ *  @brief  Run one benchmark and print its result
+ *
+ *  The number of iterations is doubled until one sample takes the
+ *  shortest sample time, then that many iterations are timed for each
+ *  sample.
+ *
+ *  @param  bench       Benchmark
+ *  @param  samples     Number of samples
+ *  @param  minTime     Shortest sample in nanoseconds
+ *  @param  first       true for the first benchmark printed
+ *
+ *  @return N/A
+ */
+static void runCase(const BenchCase &bench, int samples, double minTime, bool first)
+{
+    double times[BENCH_MAX_SAMPLES];
+    long iterations = 1;
+    double start, elapsed;
+
+    /* Calibrate, this also warms up caches and the memo table */
+    for (;;) {
+        start = now();
+        bench.function(bench, iterations);
+        elapsed = now() - start;
+        if (elapsed >= minTime) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    /* Time the samples */
+    for (int i = 0; i < samples; i++) {
+        start = now();
+        bench.function(bench, iterations);
+        times[i] = (now() - start) / iterations;
+    }
+
+    /* Statistics in ns per operation */
+    double mean = 0, variance = 0;
+    for (int i = 0; i < samples; i++) {
+        mean += times[i];
+    }
+    mean /= samples;
+    for (int i = 0; i < samples; i++) {
+        variance += (times[i] - mean) * (times[i] - mean);
+    }
+    variance = (samples > 1) ? variance / (samples - 1) : 0;
+    qsort(times, samples, sizeof(times[0]), compareDouble);
+    double median = (samples % 2) ? times[samples / 2]
+        : (times[samples / 2 - 1] + times[samples / 2]) / 2;
+
+    printf("%s    {\"name\": \"%s\", \"iterations\": %ld, \"samples\": %d, "
+           "\"ns_per_op\": {\"median\": %.3f, \"mean\": %.3f, \"min\": %.3f, \"max\": %.3f, \"stddev\": %.3f}, "
+           "\"cv\": %.4f, \"ops_per_sec\": %.0f}",
+           first ? "" : ",\n", bench.name, iterations, samples,
+           median, mean, times[0], times[samples - 1], sqrt(variance),
+           (mean > 0) ? sqrt(variance) / mean : 0, (median > 0) ? 1e9 / median : 0);
+    fflush(stdout);
+    return;
+}
+
+/**
+ *  @brief  Print usage
+ *
+ *  @return N/A
+ */
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: qcalcbench [--filter TEXT] [--samples N] [--min-time MS] [--precision N] [--list]\n");
+    return;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = 0;
+    int samples = BENCH_SAMPLES;
+    int minTime = BENCH_MIN_TIME;
+    int count = sizeof(benchCases) / sizeof(benchCases[0]);
+
+    /* Options */
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+            /* Only benchmarks whose name contains the text */
+            filter = argv[++i];
+        } else if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc)) {
+            samples = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--min-time") == 0) && (i + 1 < argc)) {
+            minTime = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--precision") == 0) && (i + 1 < argc)) {
+            /* Digits for the arbitrary precision benchmarks */
+            engine.setPrecision(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (int j = 0; j < count; j++) {
+                printf("%s\n", benchCases[j].name);
+            }
+            return 0;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if ((samples < 1) || (samples > BENCH_MAX_SAMPLES) || (minTime < 1)) {
+        usage();
+        return 2;
+    }
+    engine.setListener(&listener);
+
+    /* One JSON document on standard output */
+    printf("{\n  \"suite\": \"qcalc\",\n  \"precision\": %d,\n  \"samples\": %d,\n"
+           "  \"min_time_ms\": %d,\n  \"benchmarks\": [\n",
+           engine.getPrecision(), samples, minTime);
+    bool first = true;
+    for (int i = 0; i < count; i++) {
+        if ((filter != 0) && (strstr(benchCases[i].name, filter) == 0)) {
+            continue;
+        }
+        runCase(benchCases[i], samples, minTime * 1e6, first);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,16 @@
+######################################################################
+# Engine benchmarks, prints JSON to standard output
+######################################################################
+
+TEMPLATE = app
+TARGET = qcalcbench
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+DEPENDPATH += .
+INCLUDEPATH += .
+LIBS += -L. -lqcalcengine
+PRE_TARGETDEPS += libqcalcengine.a
+
+# Input
+SOURCES += bench.cpp
@@ -0,0 +1,1313 @@
+/** @file bignum.cpp
+ *
+ *  @brief This file contains the definitions of the arbitrary precision numbers
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "bignum.h"
+#include "engine.h"
+#include "parse.h"
+#include <math.h>
+#include <string.h>
+
+/* Defines */
+
+/** First transform prime, 119 * 2^23 + 1 */
+#define NTT_PRIME1      998244353u
+/** Second transform prime, 7 * 2^26 + 1 */
+#define NTT_PRIME2      469762049u
+/** Primitive root of both primes */
+#define NTT_ROOT        3
+/** Extra digits carried through Newton iterations */
+#define BIG_GUARD_DIGITS    (2 * BIG_LIMB_DIGITS)
+
+/**
+ *  @brief  Modular power
+ *
+ *  @param  base    Base
+ *  @param  exp     Exponent
+ *  @param  mod     Modulus
+ *
+ *  @return base ^ exp mod mod
+ */
+static quint32 powMod(quint64 base, quint64 exp, quint32 mod)
+{
+    quint64 result = 1;
+
+    /* Square and multiply */
+    base %= mod;
+    while (exp > 0) {
+        if (exp & 1) {
+            result = result * base % mod;
+        }
+        base = base * base % mod;
+        exp >>= 1;
+    }
+    return (quint32) result;
+}
+
+/**
+ *  @brief  Number theoretic transform in place
+ *
+ *  @param  a       Values, length a power of two
+ *  @param  n       Length
+ *  @param  inverse Inverse transform
+ *  @param  mod     Prime modulus
+ *
+ *  @return N/A
+ */
+static void transform(quint32 *a, int n, bool inverse, quint32 mod)
+{
+    QVector<quint32> roots(n / 2 > 0 ? n / 2 : 1);
+    quint32 *w = roots.data();
+
+    /* Bit reversal permutation */
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            quint32 t = a[i];
+            a[i] = a[j];
+            a[j] = t;
+        }
+    }
+
+    /* Butterflies, one stage per length */
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        quint32 step = powMod(NTT_ROOT, (mod - 1) / len, mod);
+        if (inverse) {
+            step = powMod(step, mod - 2, mod);
+        }
+
+        /* Twiddle factors of the stage */
+        w[0] = 1;
+        for (int j = 1; j < half; j++) {
+            w[j] = (quint64) w[j - 1] * step % mod;
+        }
+
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; j++) {
+                quint32 u = a[i + j];
+                quint32 v = (quint64) a[i + j + half] * w[j] % mod;
+                a[i + j] = (u + v >= mod) ? (u + v - mod) : (u + v);
+                a[i + j + half] = (u >= v) ? (u - v) : (u + mod - v);
+            }
+        }
+    }
+
+    /* Scale the inverse */
+    if (inverse) {
+        quint64 scale = powMod(n, mod - 2, mod);
+        for (int i = 0; i < n; i++) {
+            a[i] = a[i] * scale % mod;
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Convolution modulo one prime
+ *
+ *  @param  a       Limbs of operand 1
+ *  @param  na      Number of limbs of operand 1
+ *  @param  b       Limbs of operand 2
+ *  @param  nb      Number of limbs of operand 2
+ *  @param  n       Transform length
+ *  @param  mod     Prime modulus
+ *  @param  out     Convolution modulo the prime, n values
+ *
+ *  @return N/A
+ */
+static void convolveModulo(const quint32 *a, int na, const quint32 *b, int nb,
+                           int n, quint32 mod, QVector<quint32> &out)
+{
+    QVector<quint32> other;
+
+    /* Transform operand 1 */
+    out.fill(0, n);
+    memcpy(out.data(), a, na * sizeof(quint32));
+    transform(out.data(), n, false, mod);
+
+    if ((a == b) && (na == nb)) {
+        /* Squares need only one transform */
+        quint32 *x = out.data();
+        for (int i = 0; i < n; i++) {
+            x[i] = (quint64) x[i] * x[i] % mod;
+        }
+    } else {
+        /* Transform operand 2 and multiply point wise */
+        other.fill(0, n);
+        memcpy(other.data(), b, nb * sizeof(quint32));
+        transform(other.data(), n, false, mod);
+        quint32 *x = out.data();
+        const quint32 *y = other.constData();
+        for (int i = 0; i < n; i++) {
+            x[i] = (quint64) x[i] * y[i] % mod;
+        }
+    }
+
+    /* Back to coefficients */
+    transform(out.data(), n, true, mod);
+    return;
+}
+
+/**
+ *  @brief  Convolution with the number theoretic transform
+ *
+ *  Two primes and the Chinese remainder theorem give the exact column
+ *  sums, which stay well below their product for any length the
+ *  primes support.
+ *
+ *  @param  a       Limbs of operand 1
+ *  @param  na      Number of limbs of operand 1
+ *  @param  b       Limbs of operand 2
+ *  @param  nb      Number of limbs of operand 2
+ *  @param  out     Column sums, na + nb - 1 values
+ *
+ *  @return N/A
+ */
+static void convolveNtt(const quint32 *a, int na, const quint32 *b, int nb, quint64 *out)
+{
+    QVector<quint32> r1, r2;
+    int n = 1;
+
+    /* Transform length */
+    while (n < na + nb - 1) {
+        n <<= 1;
+    }
+
+    /* Convolve modulo both primes */
+    convolveModulo(a, na, b, nb, n, NTT_PRIME1, r1);
+    convolveModulo(a, na, b, nb, n, NTT_PRIME2, r2);
+
+    /* Combine the remainders */
+    quint64 inverse = powMod(NTT_PRIME1, NTT_PRIME2 - 2, NTT_PRIME2);
+    const quint32 *x = r1.constData();
+    const quint32 *y = r2.constData();
+    for (int i = 0; i < na + nb - 1; i++) {
+        quint64 t = (y[i] + NTT_PRIME2 - x[i] % NTT_PRIME2) % NTT_PRIME2 * inverse % NTT_PRIME2;
+        out[i] = x[i] + (quint64) NTT_PRIME1 * t;
+    }
+    return;
+}
+
+/**
+ *  @brief  Convolution with schoolbook and Karatsuba multiplication
+ *
+ *  Coefficients are not carried until the end, so operand sums can
+ *  exceed a limb. The result is added to out.
+ *
+ *  @param  a       Coefficients of operand 1
+ *  @param  na      Number of coefficients of operand 1
+ *  @param  b       Coefficients of operand 2
+ *  @param  nb      Number of coefficients of operand 2
+ *  @param  out     Column sums, na + nb - 1 values
+ *
+ *  @return N/A
+ */
+static void convolve(const qint64 *a, int na, const qint64 *b, int nb, qint64 *out)
+{
+    /* Longer operand first */
+    if (na < nb) {
+        const qint64 *t = a;
+        a = b;
+        b = t;
+        int n = na;
+        na = nb;
+        nb = n;
+    }
+
+    /* Schoolbook for small operands */
+    if (nb < BIG_KARATSUBA_LIMBS) {
+        for (int i = 0; i < na; i++) {
+            qint64 x = a[i];
+            qint64 *o = out + i;
+            for (int j = 0; j < nb; j++) {
+                o[j] += x * b[j];
+            }
+        }
+        return;
+    }
+
+    /* Unbalanced operands, slice the longer one */
+    if (na > nb) {
+        for (int i = 0; i < na; i += nb) {
+            convolve(a + i, (na - i < nb) ? (na - i) : nb, b, nb, out + i);
+        }
+        return;
+    }
+
+    /* Karatsuba on balanced operands */
+    int m = na / 2, h = na - m;
+    QVector<qint64> buffer((h + h) + (2 * m - 1) + 3 * (2 * h - 1), 0);
+    qint64 *sa = buffer.data();
+    qint64 *sb = sa + h;
+    qint64 *z0 = sb + h;
+    qint64 *z1 = z0 + (2 * m - 1);
+    qint64 *z2 = z1 + (2 * h - 1);
+
+    /* Sums of the halves */
+    for (int i = 0; i < h; i++) {
+        sa[i] = a[m + i] + ((i < m) ? a[i] : 0);
+        sb[i] = b[m + i] + ((i < m) ? b[i] : 0);
+    }
+
+    /* Three half size products */
+    convolve(a, m, b, m, z0);
+    convolve(a + m, h, b + m, h, z2);
+    convolve(sa, h, sb, h, z1);
+
+    /* Combine them */
+    for (int i = 0; i < 2 * m - 1; i++) {
+        out[i] += z0[i];
+        z1[i] -= z0[i];
+    }
+    for (int i = 0; i < 2 * h - 1; i++) {
+        out[2 * m + i] += z2[i];
+        out[m + i] += z1[i] - z2[i];
+    }
+    return;
+}
+
+/**
+ *  @brief  Cancel request object constructor, never cancelled
+ *
+ *  @return N/A
+ */
+BigCancel::BigCancel()
+    : flag(0), value(0)
+{
+    return;
+}
+
+/**
+ *  @brief  Cancel request object constructor watching a flag
+ *
+ *  @param  newFlag     Flag, changed by another thread to stop
+ *  @param  newValue    Value of the flag while the calculation goes on
+ *
+ *  @return N/A
+ */
+BigCancel::BigCancel(const QAtomicInt *newFlag, int newValue)
+    : flag(newFlag), value(newValue)
+{
+    return;
+}
+
+/**
+ *  @brief  Cancel request object method : Check for a request to stop
+ *
+ *  @return true if the calculation should stop
+ */
+bool BigCancel::isCancelled(void) const
+{
+    /* Stopped once the flag moves off its value */
+    return (flag != 0) && ((int) *flag != value);
+}
+
+/**
+ *  @brief  Big integer object constructor
+ *
+ *  @return N/A
+ */
+BigInt::BigInt()
+{
+    return;
+}
+
+/**
+ *  @brief  Big integer object constructor from a machine integer
+ *
+ *  @param  value   Value
+ *
+ *  @return N/A
+ */
+BigInt::BigInt(quint64 value)
+{
+    /* Split into limbs */
+    while (value > 0) {
+        limbs.append((quint32) (value % BIG_LIMB_BASE));
+        value /= BIG_LIMB_BASE;
+    }
+    return;
+}
+
+/**
+ *  @brief  Big integer object method : Check for zero
+ *
+ *  @return true if zero
+ */
+bool BigInt::isZero(void) const
+{
+    /* No limbs is zero */
+    return limbs.isEmpty();
+}
+
+/**
+ *  @brief  Big integer object method : Get the number of limbs
+ *
+ *  @return Number of limbs
+ */
+int BigInt::getSize(void) const
+{
+    /* Return number of limbs */
+    return limbs.size();
+}
+
+/**
+ *  @brief  Big integer object method : Drop leading zero limbs
+ *
+ *  @return N/A
+ */
+void BigInt::trim(void)
+{
+    int size = limbs.size();
+
+    /* Find the most significant non-zero limb */
+    while ((size > 0) && (limbs.at(size - 1) == 0)) {
+        size--;
+    }
+    limbs.resize(size);
+    return;
+}
+
+/**
+ *  @brief  Big integer class method : Compare two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return Negative, zero or positive as a is less, equal or greater
+ */
+int BigInt::compare(const BigInt &a, const BigInt &b)
+{
+    /* More limbs is larger */
+    if (a.limbs.size() != b.limbs.size()) {
+        return (a.limbs.size() < b.limbs.size()) ? -1 : 1;
+    }
+
+    /* Otherwise the first differing limb from the top decides */
+    for (int i = a.limbs.size() - 1; i >= 0; i--) {
+        if (a.limbs.at(i) != b.limbs.at(i)) {
+            return (a.limbs.at(i) < b.limbs.at(i)) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  @brief  Big integer class method : Add two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return a + b
+ */
+BigInt BigInt::add(const BigInt &a, const BigInt &b)
+{
+    const BigInt &longer = (a.limbs.size() >= b.limbs.size()) ? a : b;
+    const BigInt &shorter = (a.limbs.size() >= b.limbs.size()) ? b : a;
+    int nl = longer.limbs.size(), ns = shorter.limbs.size();
+    BigInt r;
+    quint32 carry = 0;
+
+    /* Add limb by limb */
+    r.limbs.resize(nl + 1);
+    quint32 *o = r.limbs.data();
+    const quint32 *x = longer.limbs.constData();
+    const quint32 *y = shorter.limbs.constData();
+    for (int i = 0; i < nl; i++) {
+        quint32 v = x[i] + ((i < ns) ? y[i] : 0) + carry;
+        carry = (v >= BIG_LIMB_BASE);
+        o[i] = carry ? (v - BIG_LIMB_BASE) : v;
+    }
+    o[nl] = carry;
+    r.trim();
+    return r;
+}
+
+/**
+ *  @brief  Big integer class method : Subtract a smaller number from a larger one
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2, not larger than number 1
+ *
+ *  @return a - b
+ */
+BigInt BigInt::subtract(const BigInt &a, const BigInt &b)
+{
+    int na = a.limbs.size(), nb = b.limbs.size();
+    BigInt r;
+    qint32 borrow = 0;
+
+    /* Subtract limb by limb */
+    r.limbs.resize(na);
+    quint32 *o = r.limbs.data();
+    const quint32 *x = a.limbs.constData();
+    const quint32 *y = b.limbs.constData();
+    for (int i = 0; i < na; i++) {
+        qint32 v = (qint32) x[i] - ((i < nb) ? (qint32) y[i] : 0) - borrow;
+        borrow = (v < 0);
+        o[i] = borrow ? (v + BIG_LIMB_BASE) : v;
+    }
+    r.trim();
+    return r;
+}
+
+/**
+ *  @brief  Big integer class method : Multiply two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return a * b
+ */
+BigInt BigInt::multiply(const BigInt &a, const BigInt &b)
+{
+    int na = a.limbs.size(), nb = b.limbs.size();
+    BigInt r;
+
+    /* Trivial cases */
+    if ((na == 0) || (nb == 0)) {
+        return r;
+    }
+    if (nb == 1) {
+        return multiply(a, b.limbs.at(0));
+    }
+    if (na == 1) {
+        return multiply(b, a.limbs.at(0));
+    }
+
+    /* Column sums of the product */
+    QVector<quint64> columns(na + nb, 0);
+    if (((na < nb) ? na : nb) >= BIG_NTT_LIMBS) {
+        convolveNtt(a.limbs.constData(), na, b.limbs.constData(), nb, columns.data());
+    } else {
+        QVector<qint64> x(na), y(nb), z(na + nb - 1, 0);
+        for (int i = 0; i < na; i++) {
+            x[i] = a.limbs.at(i);
+        }
+        for (int i = 0; i < nb; i++) {
+            y[i] = b.limbs.at(i);
+        }
+        convolve(x.constData(), na, y.constData(), nb, z.data());
+        for (int i = 0; i < na + nb - 1; i++) {
+            columns[i] = z.at(i);
+        }
+    }
+
+    /* Carry the columns into limbs */
+    quint64 carry = 0;
+    r.limbs.resize(na + nb);
+    quint32 *o = r.limbs.data();
+    const quint64 *c = columns.constData();
+    for (int i = 0; i < na + nb; i++) {
+        quint64 v = c[i] + carry;
+        o[i] = (quint32) (v % BIG_LIMB_BASE);
+        carry = v / BIG_LIMB_BASE;
+    }
+    r.trim();
+    return r;
+}
+
+/**
+ *  @brief  Big integer class method : Multiply by a machine integer
+ *
+ *  @param  a   Number
+ *  @param  b   Machine integer
+ *
+ *  @return a * b
+ */
+BigInt BigInt::multiply(const BigInt &a, quint32 b)
+{
+    int na = a.limbs.size();
+    BigInt r;
+    quint64 carry = 0;
+
+    /* Zero */
+    if ((na == 0) || (b == 0)) {
+        return r;
+    }
+
+    /* Multiply limb by limb */
+    r.limbs.resize(na);
+    quint32 *o = r.limbs.data();
+    const quint32 *x = a.limbs.constData();
+    for (int i = 0; i < na; i++) {
+        quint64 v = (quint64) x[i] * b + carry;
+        o[i] = (quint32) (v % BIG_LIMB_BASE);
+        carry = v / BIG_LIMB_BASE;
+    }
+    while (carry > 0) {
+        r.limbs.append((quint32) (carry % BIG_LIMB_BASE));
+        carry /= BIG_LIMB_BASE;
+    }
+    return r;
+}
+
+/**
+ *  @brief  Big integer class method : Product of a range of integers
+ *
+ *  Splitting the range in halves keeps the operands balanced, so the
+ *  large products get the fast multiplications.
+ *
+ *  @param  low     First integer
+ *  @param  high    Last integer
+ *  @param  cancel  Request to stop, checked on each short range
+ *
+ *  @return low * (low + 1) * ... * high, 0 once cancelled
+ */
+BigInt BigInt::product(quint32 low, quint32 high, const BigCancel &cancel)
+{
+    /* Nothing more once cancelled */
+    if (cancel.isCancelled()) {
+        return BigInt();
+    }
+
+    /* Short ranges one by one */
+    if (high - low < 16) {
+        BigInt r(low);
+        for (quint32 i = low + 1; i <= high; i++) {
+            r = multiply(r, i);
+        }
+        return r;
+    }
+
+    /* Long ranges in halves */
+    quint32 mid = low + (high - low) / 2;
+    return multiply(product(low, mid, cancel), product(mid + 1, high, cancel));
+}
+
+/**
+ *  @brief  Big integer class method : Factorial
+ *
+ *  @param  n       Argument
+ *  @param  cancel  Request to stop
+ *
+ *  @return n!, 0 once cancelled
+ */
+BigInt BigInt::factorial(quint32 n, const BigCancel &cancel)
+{
+    /* 0! and 1! */
+    if (n < 2) {
+        return BigInt(1);
+    }
+    return product(2, n, cancel);
+}
+
+/**
+ *  @brief  Big integer class method : Convert from decimal digits
+ *
+ *  @param  digits  Decimal digits, most significant first
+ *  @param  count   Number of digits
+ *
+ *  @return Number
+ */
+BigInt BigInt::fromDigits(const char *digits, int count)
+{
+    BigInt r;
+
+    /* Limbs from the least significant digits up */
+    r.limbs.resize((count + BIG_LIMB_DIGITS - 1) / BIG_LIMB_DIGITS);
+    quint32 *o = r.limbs.data();
+    for (int end = count, i = 0; end > 0; end -= BIG_LIMB_DIGITS, i++) {
+        quint32 v = 0;
+        for (int j = (end > BIG_LIMB_DIGITS) ? (end - BIG_LIMB_DIGITS) : 0; j < end; j++) {
+            v = v * 10 + (digits[j] - '0');
+        }
+        o[i] = v;
+    }
+    r.trim();
+    return r;
+}
+
+/**
+ *  @brief  Big integer object method : Convert to decimal digits
+ *
+ *  @return Decimal digits, most significant first
+ */
+QByteArray BigInt::toDigits(void) const
+{
+    int n = limbs.size();
+    char top[16];
+
+    /* Zero */
+    if (n == 0) {
+        return QByteArray("0");
+    }
+
+    /* Most significant limb without padding ... */
+    int length = snprintf(top, sizeof(top), "%u", limbs.at(n - 1));
+    QByteArray r(length + (n - 1) * BIG_LIMB_DIGITS, '0');
+    char *o = r.data();
+    memcpy(o, top, length);
+    o += length;
+
+    /* ... and the rest with */
+    for (int i = n - 2; i >= 0; i--) {
+        quint32 v = limbs.at(i);
+        for (int j = BIG_LIMB_DIGITS - 1; j >= 0; j--) {
+            o[j] = '0' + v % 10;
+            v /= 10;
+        }
+        o += BIG_LIMB_DIGITS;
+    }
+    return r;
+}
+
+/**
+ *  @brief  Big float object constructor
+ *
+ *  @return N/A
+ */
+BigFloat::BigFloat()
+    : negative(false), exponent(0)
+{
+    return;
+}
+
+/**
+ *  @brief  Big float object constructor from a double
+ *
+ *  @param  value   Value, zero if not finite
+ *
+ *  @return N/A
+ */
+BigFloat::BigFloat(double value)
+    : negative(false), exponent(0)
+{
+    /* Through text, the fewest digits that round trip */
+    QString text = QString::number(value, 'g', 15);
+    if (Parse::toDouble(text) != value) {
+        text = QString::number(value, 'g', 17);
+    }
+    *this = fromString(text, 0);
+    return;
+}
+
+/**
+ *  @brief  Big float class method : Convert from text
+ *
+ *  @param  text    Text, [-]digits[.digits][e[-]digits]
+ *  @param  ok      Set to false on invalid text, may be NULL
+ *
+ *  @return Number, zero on invalid text
+ */
+BigFloat BigFloat::fromString(const QString &text, bool *ok)
+{
+    QByteArray bytes = text.toLatin1();
+    const char *p = bytes.constData();
+    QByteArray digits;
+    BigFloat r;
+    int scale = 0;
+    bool seenDigit = false, seenDot = false;
+
+    /* Sign */
+    if ((*p == '-') || (*p == '+')) {
+        r.negative = (*p == '-');
+        p++;
+    }
+
+    /* Digits, dropping leading zeros */
+    for (; *p != '\0'; p++) {
+        if ((*p >= '0') && (*p <= '9')) {
+            seenDigit = true;
+            if (seenDot) {
+                scale--;
+            }
+            if (!digits.isEmpty() || (*p != '0')) {
+                digits.append(*p);
+            }
+        } else if ((*p == '.') && !seenDot) {
+            seenDot = true;
+        } else {
+            break;
+        }
+    }
+
+    /* Exponent */
+    if (seenDigit && ((*p == 'e') || (*p == 'E'))) {
+        bool negativeExp = false;
+        long exp = 0;
+        p++;
+        if ((*p == '-') || (*p == '+')) {
+            negativeExp = (*p == '-');
+            p++;
+        }
+        if ((*p < '0') || (*p > '9')) {
+            seenDigit = false;
+        }
+        for (; (*p >= '0') && (*p <= '9'); p++) {
+            if (exp < 100000000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        scale += negativeExp ? -exp : exp;
+    }
+
+    /* Everything must be used up */
+    if (!seenDigit || (*p != '\0')) {
+        if (ok != 0) {
+            *ok = false;
+        }
+        return BigFloat();
+    }
+    if (ok != 0) {
+        *ok = true;
+    }
+
+    /* Align the decimal scale to whole limbs */
+    while (scale % BIG_LIMB_DIGITS != 0) {
+        digits.append('0');
+        scale--;
+    }
+    r.mantissa = BigInt::fromDigits(digits.constData(), digits.size());
+    r.exponent = scale / BIG_LIMB_DIGITS;
+    r.round(0);
+    return r;
+}
+
+/**
+ *  @brief  Big float object method : Convert to text
+ *
+ *  @param  digits  Largest number of digits before exponent notation is used
+ *
+ *  @return Text
+ */
+QString BigFloat::toString(int digits) const
+{
+    QByteArray d = mantissa.toDigits();
+    QByteArray r;
+
+    /* Zero */
+    if (mantissa.isZero()) {
+        return QString("0");
+    }
+
+    /* Drop insignificant zeros, keeping where the point goes */
+    int point = d.size() + exponent * BIG_LIMB_DIGITS;
+    int n = d.size();
+    while (d.at(n - 1) == '0') {
+        n--;
+    }
+    d.truncate(n);
+
+    if (negative) {
+        r.append('-');
+    }
+    if ((point > digits) || (point < -digits)) {
+        /* Exponent notation */
+        r.append(d.at(0));
+        if (n > 1) {
+            r.append('.');
+            r.append(d.constData() + 1, n - 1);
+        }
+        r.append('e');
+        r.append(QByteArray::number(point - 1));
+    } else if (point >= n) {
+        /* Integer */
+        r.append(d);
+        r.append(QByteArray(point - n, '0'));
+    } else if (point > 0) {
+        /* Point inside the digits */
+        r.append(d.constData(), point);
+        r.append('.');
+        r.append(d.constData() + point, n - point);
+    } else {
+        /* Point before the digits */
+        r.append("0.");
+        r.append(QByteArray(-point, '0'));
+        r.append(d);
+    }
+    return QString::fromLatin1(r.constData(), r.size());
+}
+
+/**
+ *  @brief  Big float object method : Convert to the nearest double
+ *
+ *  @return Value, infinity beyond the double range
+ */
+double BigFloat::toDouble(void) const
+{
+    QByteArray d = mantissa.toDigits();
+    int point = d.size() + exponent * BIG_LIMB_DIGITS;
+
+    /* Beyond the double range */
+    if (mantissa.isZero() || (point < -330)) {
+        return 0;
+    }
+    if (point > 310) {
+        return negative ? -HUGE_VAL : HUGE_VAL;
+    }
+
+    /* Twenty digits are plenty to round correctly */
+    QByteArray r(negative ? "-0." : "0.");
+    r.append(d.left(20));
+    r.append('e');
+    r.append(QByteArray::number(point));
+    return Parse::toDouble(r.constData(), r.size());
+}
+
+/**
+ *  @brief  Big float object method : Check for zero
+ *
+ *  @return true if zero
+ */
+bool BigFloat::isZero(void) const
+{
+    /* Zero mantissa is zero */
+    return mantissa.isZero();
+}
+
+/**
+ *  @brief  Big float object method : Check for negative
+ *
+ *  @return true if less than zero
+ */
+bool BigFloat::isNegative(void) const
+{
+    /* Return sign */
+    return negative;
+}
+
+/**
+ *  @brief  Big float object method : Check for an integer
+ *
+ *  @return true if the value is an integer
+ */
+bool BigFloat::isInteger(void) const
+{
+    /* Trailing zero limbs are always dropped, so no fraction limbs means integer */
+    return exponent >= 0;
+}
+
+/**
+ *  @brief  Big float object method : Hash of the representation
+ *
+ *  @return Hash of sign, exponent and mantissa
+ */
+quint64 BigFloat::hash(void) const
+{
+    /* FNV-1a style over the limbs */
+    quint64 h = 14695981039346656037ULL ^ ((quint64) (quint32) exponent << 1) ^ (negative ? 1 : 0);
+    const quint32 *limb = mantissa.limbs.constData();
+    for (int i = 0; i < mantissa.getSize(); i++) {
+        h = (h ^ limb[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ *  @brief  Big float object method : Check for the same representation
+ *
+ *  @param  other   Number to compare with
+ *
+ *  @return true if sign, exponent and mantissa are the same
+ */
+bool BigFloat::isSame(const BigFloat &other) const
+{
+    /* Cheap fields first */
+    return (negative == other.negative) && (exponent == other.exponent)
+            && (BigInt::compare(mantissa, other.mantissa) == 0);
+}
+
+/**
+ *  @brief  Big float object method : Round to a number of decimal digits
+ *
+ *  @param  digits  Significant digits to keep, 0 to only drop trailing zero limbs
+ *
+ *  @return N/A
+ */
+void BigFloat::round(int digits)
+{
+    int size = mantissa.getSize();
+
+    /* Zero has no sign */
+    if (size == 0) {
+        negative = false;
+        exponent = 0;
+        return;
+    }
+
+    /* Count the digits */
+    int total = (size - 1) * BIG_LIMB_DIGITS;
+    for (quint32 top = mantissa.limbs.at(size - 1); top > 0; top /= 10) {
+        total++;
+    }
+
+    if ((digits > 0) && (total > digits)) {
+        int drop = total - digits;
+        int dropLimbs = drop / BIG_LIMB_DIGITS;
+        quint32 unit = 1;
+        for (int i = 0; i < drop % BIG_LIMB_DIGITS; i++) {
+            unit *= 10;
+        }
+
+        /* Find the first dropped digit and clear the dropped digits of the kept limb */
+        quint32 *o = mantissa.limbs.data();
+        quint32 roundDigit;
+        if (unit == 1) {
+            roundDigit = o[dropLimbs - 1] / (BIG_LIMB_BASE / 10);
+        } else {
+            roundDigit = (o[dropLimbs] / (unit / 10)) % 10;
+            o[dropLimbs] -= o[dropLimbs] % unit;
+        }
+
+        /* Drop the whole limbs */
+        mantissa.limbs.remove(0, dropLimbs);
+        exponent += dropLimbs;
+
+        /* Round half up */
+        if (roundDigit >= 5) {
+            mantissa = BigInt::add(mantissa, BigInt(unit));
+        }
+    }
+
+    /* Drop trailing zero limbs */
+    int zeros = 0;
+    while (mantissa.limbs.at(zeros) == 0) {
+        zeros++;
+    }
+    if (zeros > 0) {
+        mantissa.limbs.remove(0, zeros);
+        exponent += zeros;
+    }
+    return;
+}
+
+/**
+ *  @brief  Big float class method : Add two numbers
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  digits  Significant digits of the result
+ *
+ *  @return a + b
+ */
+BigFloat BigFloat::add(const BigFloat &a, const BigFloat &b, int digits)
+{
+    BigFloat r;
+
+    /* Zero operands */
+    if (a.isZero() || b.isZero()) {
+        r = a.isZero() ? b : a;
+        r.round(digits);
+        return r;
+    }
+
+    /* An operand far below the precision of the other does not count */
+    int topA = a.exponent + a.mantissa.getSize();
+    int topB = b.exponent + b.mantissa.getSize();
+    int reach = digits / BIG_LIMB_DIGITS + 3;
+    if ((topA - topB > reach) || (topB - topA > reach)) {
+        r = (topA > topB) ? a : b;
+        r.round(digits);
+        return r;
+    }
+
+    /* Align the mantissas */
+    BigInt ma = a.mantissa, mb = b.mantissa;
+    r.exponent = (a.exponent < b.exponent) ? a.exponent : b.exponent;
+    ma.limbs.insert(0, a.exponent - r.exponent, 0);
+    mb.limbs.insert(0, b.exponent - r.exponent, 0);
+
+    if (a.negative == b.negative) {
+        /* Same sign, add the magnitudes */
+        r.mantissa = BigInt::add(ma, mb);
+        r.negative = a.negative;
+    } else if (BigInt::compare(ma, mb) >= 0) {
+        /* Different signs, subtract the smaller magnitude */
+        r.mantissa = BigInt::subtract(ma, mb);
+        r.negative = a.negative;
+    } else {
+        r.mantissa = BigInt::subtract(mb, ma);
+        r.negative = b.negative;
+    }
+    r.round(digits);
+    return r;
+}
+
+/**
+ *  @brief  Big float class method : Subtract two numbers
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  digits  Significant digits of the result
+ *
+ *  @return a - b
+ */
+BigFloat BigFloat::subtract(const BigFloat &a, const BigFloat &b, int digits)
+{
+    BigFloat minus = b;
+
+    /* Add the negated number */
+    minus.negative = !b.negative && !b.isZero();
+    return add(a, minus, digits);
+}
+
+/**
+ *  @brief  Big float class method : Multiply two numbers
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  digits  Significant digits of the result
+ *
+ *  @return a * b
+ */
+BigFloat BigFloat::multiply(const BigFloat &a, const BigFloat &b, int digits)
+{
+    BigFloat r;
+
+    /* Multiply the mantissas, add the exponents */
+    r.mantissa = BigInt::multiply(a.mantissa, b.mantissa);
+    r.exponent = a.exponent + b.exponent;
+    r.negative = (a.negative != b.negative);
+    r.round(digits);
+    return r;
+}
+
+/**
+ *  @brief  Big float object method : Leading limbs as a double and their limb exponent
+ *
+ *  @param  limbExponent    Set to the limb exponent of the leading limbs
+ *
+ *  @return Leading limbs, the value is about that times BIG_LIMB_BASE ^ limbExponent
+ */
+double BigFloat::leading(int *limbExponent) const
+{
+    int size = mantissa.getSize();
+    int count = (size < 4) ? size : 4;
+    double m = 0;
+
+    /* Up to four limbs, more than a double holds */
+    for (int i = size - 1; i >= size - count; i--) {
+        m = m * BIG_LIMB_BASE + mantissa.limbs.at(i);
+    }
+    *limbExponent = exponent + size - count;
+    return m;
+}
+
+/**
+ *  @brief  Big float class method : Reciprocal
+ *
+ *  Newton iteration r = r + r * (1 - a * r), starting from a double
+ *  estimate and doubling the precision on each step.
+ *
+ *  @param  a       Number, not zero
+ *  @param  digits  Significant digits of the result
+ *  @param  cancel  Request to stop, checked on each step
+ *
+ *  @return 1 / a, short of the digits once cancelled
+ */
+BigFloat BigFloat::reciprocal(const BigFloat &a, int digits, const BigCancel &cancel)
+{
+    const BigFloat one(1.0);
+    int limbExponent, precision = 14;
+    int target = digits + BIG_GUARD_DIGITS;
+
+    /* Estimate from the leading limbs */
+    BigFloat r(1 / a.leading(&limbExponent));
+    r.exponent -= limbExponent;
+    r.negative = a.negative;
+
+    /* Refine it */
+    while ((precision < target) && !cancel.isCancelled()) {
+        precision = (2 * precision < target) ? (2 * precision) : target;
+        BigFloat ap = a;
+        ap.round(precision + BIG_GUARD_DIGITS);
+        BigFloat e = subtract(one, multiply(ap, r, precision + BIG_GUARD_DIGITS), precision + BIG_GUARD_DIGITS);
+        r = add(r, multiply(r, e, precision + BIG_GUARD_DIGITS), precision + BIG_GUARD_DIGITS);
+    }
+    return r;
+}
+
+/**
+ *  @brief  Big float class method : Reciprocal square root
+ *
+ *  Newton iteration y = y + y * (1 - a * y * y) / 2, starting from a
+ *  double estimate and doubling the precision on each step.
+ *
+ *  @param  a       Number, greater than zero
+ *  @param  digits  Significant digits of the result
+ *  @param  cancel  Request to stop, checked on each step
+ *
+ *  @return 1 / sqrt(a), short of the digits once cancelled
+ */
+BigFloat BigFloat::reciprocalRoot(const BigFloat &a, int digits, const BigCancel &cancel)
+{
+    const BigFloat one(1.0), half(0.5);
+    int limbExponent, precision = 14;
+    int target = digits + BIG_GUARD_DIGITS;
+
+    /* Estimate from the leading limbs, with an even exponent to halve */
+    double m = a.leading(&limbExponent);
+    if (limbExponent % 2 != 0) {
+        m *= BIG_LIMB_BASE;
+        limbExponent--;
+    }
+    BigFloat y(1 / sqrt(m));
+    y.exponent -= limbExponent / 2;
+
+    /* Refine it */
+    while ((precision < target) && !cancel.isCancelled()) {
+        precision = (2 * precision < target) ? (2 * precision) : target;
+        int p = precision + BIG_GUARD_DIGITS;
+        BigFloat ap = a;
+        ap.round(p);
+        BigFloat e = subtract(one, multiply(ap, multiply(y, y, p), p), p);
+        y = add(y, multiply(multiply(y, e, p), half, p), p);
+    }
+    return y;
+}
+
+/**
+ *  @brief  Big float class method : Divide two numbers
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  digits  Significant digits of the result
+ *  @param  error   Set to true on divide-by-zero, left untouched otherwise
+ *  @param  cancel  Request to stop
+ *
+ *  @return a / b, 0 on error
+ */
+BigFloat BigFloat::divide(const BigFloat &a, const BigFloat &b, int digits, bool *error, const BigCancel &cancel)
+{
+    /* Check for divide-by-zero error */
+    if (b.isZero()) {
+        *error = true;
+        return BigFloat();
+    }
+
+    /* Multiply by the reciprocal */
+    return multiply(a, reciprocal(b, digits, cancel), digits);
+}
+
+/**
+ *  @brief  Big float class method : Square root
+ *
+ *  @param  a       Number
+ *  @param  digits  Significant digits of the result
+ *  @param  error   Set to true for negative numbers, left untouched otherwise
+ *  @param  cancel  Request to stop
+ *
+ *  @return sqrt(a), 0 on error
+ */
+BigFloat BigFloat::squareRoot(const BigFloat &a, int digits, bool *error, const BigCancel &cancel)
+{
+    /* No square root of negative numbers */
+    if (a.negative) {
+        *error = true;
+        return BigFloat();
+    }
+    if (a.isZero()) {
+        return BigFloat();
+    }
+
+    /* Multiply by the reciprocal square root */
+    return multiply(a, reciprocalRoot(a, digits, cancel), digits);
+}
+
+/**
+ *  @brief  Big float class method : Factorial
+ *
+ *  Only integers have a factorial here, Gamma is not known to the digits
+ *  asked for and a double would pass for them.
+ *
+ *  @param  a       Number
+ *  @param  digits  Significant digits of the result
+ *  @param  error   Set to true for non-integers, negative integers and overflow, left untouched otherwise
+ *  @param  cancel  Request to stop
+ *
+ *  @return a!, 0 on error
+ */
+BigFloat BigFloat::factorial(const BigFloat &a, int digits, bool *error, const BigCancel &cancel)
+{
+    BigFloat r;
+
+    /* Non-integer, pole or too large */
+    double n = a.toDouble();
+    if (!a.isInteger() || a.negative || (n > BIG_FACTORIAL_MAX)) {
+        *error = true;
+        return r;
+    }
+
+    /* Integers exactly */
+    r.mantissa = BigInt::factorial((quint32) n, cancel);
+    r.round(digits);
+    return r;
+}
+
+/**
+ *  @brief  Big float class method : Make calculation, as Engine::compute() does
+ *
+ *  Unlike doubles, square roots of negative numbers are errors. A
+ *  calculation cancelled from another thread is an error too, whatever
+ *  it got to.
+ *
+ *  @param  a       Operand 1
+ *  @param  b       Operand 2
+ *  @param  op      Operator
+ *  @param  digits  Significant digits of the result
+ *  @param  error   Set to true on error, left untouched otherwise
+ *  @param  cancel  Request to stop
+ *
+ *  @return Calculated result, 0 on error
+ */
+BigFloat BigFloat::calculate(const BigFloat &a, const BigFloat &b, int op, int digits, bool *error,
+                             const BigCancel &cancel)
+{
+    BigFloat r;
+
+    /* Perform the calculation */
+    switch (op) {
+        case OPERATOR_PLUS:
+            r = add(a, b, digits);
+            break;
+        case OPERATOR_MINUS:
+            r = subtract(a, b, digits);
+            break;
+        case OPERATOR_MUL:
+            r = multiply(a, b, digits);
+            break;
+        case OPERATOR_DIV:
+            r = divide(a, b, digits, error, cancel);
+            break;
+        case OPERATOR_SQRT:
+            r = squareRoot(a, digits, error, cancel);
+            break;
+        case OPERATOR_FACT:
+            r = factorial(a, digits, error, cancel);
+            break;
+        default:
+            break;
+    }
+
+    /* Cut short, the result means nothing */
+    if (cancel.isCancelled()) {
+        *error = true;
+        return BigFloat();
+    }
+    return r;
+}
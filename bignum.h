@@ -0,0 +1,187 @@
+/** @file bignum.h
+ *
+ *  @brief This file contains the declarations of the arbitrary precision numbers
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+/* Includes */
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QtCore/QAtomicInt>
+
+/* Defines */
+
+/** Decimal digits per big number limb */
+#define BIG_LIMB_DIGITS     4
+/** Big number limb base */
+#define BIG_LIMB_BASE       10000
+/** Limbs from which multiplication uses Karatsuba */
+#define BIG_KARATSUBA_LIMBS 32
+/** Limbs from which multiplication uses the number theoretic transform */
+#define BIG_NTT_LIMBS       512
+/** Largest integer factorial in arbitrary precision */
+#define BIG_FACTORIAL_MAX   100000
+/** Default precision in decimal digits */
+#define BIG_DEFAULT_DIGITS  1000
+/** Smallest precision in decimal digits */
+#define BIG_MIN_DIGITS      20
+/** Largest precision in decimal digits */
+#define BIG_MAX_DIGITS      1000000
+
+/**
+ *  Request to stop a long calculation, made from another thread.
+ *
+ *  The calculation watches a flag owned by the thread that started it
+ *  and goes on while the flag holds the value it was given. Once it
+ *  changes, the calculation is cut short at its next step and fails.
+ */
+class BigCancel
+{
+public:
+    /** Constructor, never cancelled */
+    BigCancel();
+    /** Constructor watching a flag */
+    BigCancel(const QAtomicInt *newFlag, int newValue);
+    /** Check for a request to stop */
+    bool isCancelled(void) const;
+
+private:
+    /** Flag watched, 0 for none */
+    const QAtomicInt *flag;
+    /** Value of the flag while the calculation goes on */
+    int value;
+};
+
+/**
+ *  Arbitrary size non-negative integer.
+ *
+ *  Limbs hold BIG_LIMB_DIGITS decimal digits each, least significant
+ *  first, so that conversion to and from text is linear. Products use
+ *  schoolbook multiplication for small operands, Karatsuba from
+ *  BIG_KARATSUBA_LIMBS and a two prime number theoretic transform from
+ *  BIG_NTT_LIMBS.
+ */
+class BigInt
+{
+public:
+    /** Constructor */
+    BigInt();
+    /** Constructor from a machine integer */
+    BigInt(quint64 value);
+    /** Check for zero */
+    bool isZero(void) const;
+    /** Get the number of limbs */
+    int getSize(void) const;
+    /** Compare two numbers */
+    static int compare(const BigInt &a, const BigInt &b);
+    /** Add two numbers */
+    static BigInt add(const BigInt &a, const BigInt &b);
+    /** Subtract a smaller number from a larger one */
+    static BigInt subtract(const BigInt &a, const BigInt &b);
+    /** Multiply two numbers */
+    static BigInt multiply(const BigInt &a, const BigInt &b);
+    /** Multiply by a machine integer */
+    static BigInt multiply(const BigInt &a, quint32 b);
+    /** Factorial */
+    static BigInt factorial(quint32 n, const BigCancel &cancel = BigCancel());
+    /** Convert from decimal digits */
+    static BigInt fromDigits(const char *digits, int count);
+    /** Convert to decimal digits */
+    QByteArray toDigits(void) const;
+
+    /** Limbs, least significant first, no leading zero limbs */
+    QVector<quint32> limbs;
+
+private:
+    /** Drop leading zero limbs */
+    void trim(void);
+    /** Product of a range of integers */
+    static BigInt product(quint32 low, quint32 high, const BigCancel &cancel);
+};
+
+/**
+ *  Arbitrary precision floating point number.
+ *
+ *  The value is mantissa * BIG_LIMB_BASE ^ exponent. Results are
+ *  rounded to the number of decimal digits asked for, division and
+ *  square root use Newton iterations that double the precision on each
+ *  step.
+ */
+class BigFloat
+{
+public:
+    /** Constructor */
+    BigFloat();
+    /** Constructor from a double */
+    BigFloat(double value);
+    /** Convert from text */
+    static BigFloat fromString(const QString &text, bool *ok);
+    /** Convert to text */
+    QString toString(int digits) const;
+    /** Convert to the nearest double */
+    double toDouble(void) const;
+    /** Check for zero */
+    bool isZero(void) const;
+    /** Check for negative */
+    bool isNegative(void) const;
+    /** Check for an integer */
+    bool isInteger(void) const;
+    /** Hash of the representation */
+    quint64 hash(void) const;
+    /** Check for the same representation */
+    bool isSame(const BigFloat &other) const;
+    /** Add two numbers */
+    static BigFloat add(const BigFloat &a, const BigFloat &b, int digits);
+    /** Subtract two numbers */
+    static BigFloat subtract(const BigFloat &a, const BigFloat &b, int digits);
+    /** Multiply two numbers */
+    static BigFloat multiply(const BigFloat &a, const BigFloat &b, int digits);
+    /** Divide two numbers */
+    static BigFloat divide(const BigFloat &a, const BigFloat &b, int digits, bool *error,
+                           const BigCancel &cancel = BigCancel());
+    /** Square root */
+    static BigFloat squareRoot(const BigFloat &a, int digits, bool *error, const BigCancel &cancel = BigCancel());
+    /** Factorial */
+    static BigFloat factorial(const BigFloat &a, int digits, bool *error, const BigCancel &cancel = BigCancel());
+    /** Make calculation, as Engine::compute() does */
+    static BigFloat calculate(const BigFloat &a, const BigFloat &b, int op, int digits, bool *error,
+                              const BigCancel &cancel = BigCancel());
+
+private:
+    /** Sign */
+    bool negative;
+    /** Mantissa */
+    BigInt mantissa;
+    /** Exponent in limbs */
+    int exponent;
+    /** Round to a number of decimal digits */
+    void round(int digits);
+    /** Reciprocal */
+    static BigFloat reciprocal(const BigFloat &a, int digits, const BigCancel &cancel);
+    /** Reciprocal square root */
+    static BigFloat reciprocalRoot(const BigFloat &a, int digits, const BigCancel &cancel);
+    /** Leading limbs as a double and their limb exponent */
+    double leading(int *limbExponent) const;
+};
+
+#endif // BIGNUM_H
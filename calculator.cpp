@@ -22,26 +22,64 @@
 
 /* Includes */
 #include "calculator.h"
-#include <QtGui/QLCDNumber>
+#include "lcd.h"
 #include <QtGui/QGridLayout>
 #include <QtGui/QVBoxLayout>
 #include <QtGui/QPushButton>
 #include <QtGui/QButtonGroup>
-#include <QtGui/QLabel>
-#if DEBUG
+#include <QtGui/QAction>
+#include <QtGui/QActionGroup>
+#include <QtGui/QApplication>
+#include <QtGui/QClipboard>
+#include <QtGui/QKeySequence>
+#include <QtGui/QListView>
+#include <QtGui/QLineEdit>
+#include <QtGui/QTabBar>
 #include <QtGui/QMessageBox>
-#endif
-
-#include <math.h>
-
-#if DEBUG
-void alert(QString text)
+#include <QtCore/QTimer>
+#include <QtCore/QThreadPool>
+#include <QtCore/QRunnable>
+#include <QtCore/QEvent>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+
+/** Event carrying the engine back from a background keystroke */
+class EngineEvent : public QEvent
 {
-    QMessageBox msgBox;
-    msgBox.setText(text);
-    msgBox.exec();
-}
-#endif
+public:
+    /** Constructor */
+    EngineEvent(Engine *newEngine, int newTask)
+        : QEvent((QEvent::Type) CONTROL_EVENT_DONE), engine(newEngine), task(newTask) {}
+    /** Destructor */
+    ~EngineEvent() { delete engine; }
+    /** Engine after the keystroke */
+    Engine *engine;
+    /** Calculations of the keystroke, logged only if it is taken back */
+    QVector<HistoryEntry> records;
+    /** Number of the keystroke */
+    int task;
+};
+
+/** Keystroke run on a copy of the engine in a worker thread */
+class EngineTask : public QRunnable
+{
+public:
+    /** Constructor */
+    EngineTask(QObject *newReceiver, const Engine &current, int newKey, int newTask, const QAtomicInt *running);
+    /** Run the keystroke and post the engine back */
+    void run();
+
+private:
+    /** Object the engine is posted to */
+    QObject *receiver;
+    /** Copy of the engine, it is posted back */
+    Engine *engine;
+    /** Button pressed */
+    int key;
+    /** Number of the keystroke */
+    int task;
+};
 
 /**
  *  @brief  Main object constructor
@@ -51,98 +89,138 @@ void alert(QString text)
  *  @return N/A
  */
 Calculator::Calculator(QWidget *parent)
-    : QWidget(parent)
+    : QWidget(parent), isPainted(false)
 {
     /* Initilize the components */
 
-    lcd = new QLCDNumber(LCD_LENGTH + 1);
+    lcd = new LCDDisplay(LCD_LENGTH + 1);
     buttonLayout = new QGridLayout;
     buttonGroup = new QButtonGroup;
 #if HEX
-    hexButtonLayout = new QGridLayout;
-    hexButtonGroup = new QButtonGroup;
+    /* Created with the first switch to hex */
+    hexButtonLayout = 0;
+    hexButtonGroup = 0;
 #endif
     control = new Control;
+    tabBar = new QTabBar;
+    lastTabNumber = 1;
     mainLayout = new QVBoxLayout;
-#if DEBUG
-    label = new QLabel;
+    arithGroup = new QActionGroup(this);
+    doubleAction = new QAction("Double precision", arithGroup);
+    bigAction = new QAction("Arbitrary precision", arithGroup);
+    decimalAction = new QAction("Decimal", arithGroup);
+    integerAction = new QAction("Integer", arithGroup);
+    pasteAction = new QAction("Paste", this);
+    undoAction = new QAction("Undo", this);
+    redoAction = new QAction("Redo", this);
+    historyAction = new QAction("History", this);
+    newTabAction = new QAction("New tab", this);
+    closeTabAction = new QAction("Close tab", this);
+    summaryAction = new QAction("Summary mode", this);
+    showSummaryAction = new QAction("Show summary", this);
+    historyPanel = 0;
+    historySearch = 0;
+    historyView = 0;
+    historyModel = 0;
+#if STATS
+    statsAction = new QAction("Statistics", this);
 #endif
 
     /* Configure the LCD */
-    lcd->setMode(QLCDNumber::Dec);
-    lcd->setSegmentStyle(QLCDNumber::Filled);
-    lcd->setSmallDecimalPoint(true);
     lcd->setFixedHeight(50);
-    lcd->setStyleSheet("border-color: black; color: white; background-color: rgb(90, 90, 150)");
+
+    /* Configure the arithmetic menu */
+    doubleAction->setCheckable(true);
+    doubleAction->setChecked(true);
+    bigAction->setCheckable(true);
+    decimalAction->setCheckable(true);
+    integerAction->setCheckable(true);
+    addAction(doubleAction);
+    addAction(bigAction);
+    addAction(decimalAction);
+    addAction(integerAction);
+    pasteAction->setShortcut(QKeySequence::Paste);
+    addAction(pasteAction);
+    undoAction->setShortcut(QKeySequence::Undo);
+    addAction(undoAction);
+    redoAction->setShortcut(QKeySequence::Redo);
+    addAction(redoAction);
+    addAction(historyAction);
+    newTabAction->setShortcut(QKeySequence::AddTab);
+    addAction(newTabAction);
+    closeTabAction->setShortcut(QKeySequence::Close);
+    addAction(closeTabAction);
+    summaryAction->setCheckable(true);
+    addAction(summaryAction);
+    addAction(showSummaryAction);
+#if STATS
+    addAction(statsAction);
+#endif
+    setContextMenuPolicy(Qt::ActionsContextMenu);
+
+    /* Configure the tab bar, hidden while there is one tab */
+    tabBar->addTab(QString::number(lastTabNumber));
+    tabBar->setTabsClosable(true);
+    tabBar->setExpanding(false);
+    tabBar->setVisible(false);
 
     /* Create the buttons, add them to button group and button layout */
     for (int row = 0, index = 0; row < BUTTONS_ROW; row++) {
         for (int col = 0; col < BUTTONS_COL; col++, index++) {
             if (index < NUM_BUTTONS) {
                 QPushButton *button = new QPushButton(buttonLabels[index]);
-                button->setStyleSheet("color: black; background-color: rgb(215, 215, 215)");
-                button->setShortcut(buttonShotcuts[index]);
+                if (buttonShotcuts[index][0] != '\0') {
+                    button->setShortcut(QKeySequence(buttonShotcuts[index]));
+                }
                 buttonGroup->addButton(button, index);
                 buttonLayout->addWidget(button, row, col);
             }
         }
     }
 
-#if HEX
-    /* Create the hex buttons, add them to button group and button layout */
-    for (int index = 0; index < NUM_HEX_BUTTONS; index++) {
-        QPushButton *button = new QPushButton(hexButtonLabels[index]);
-        button->setStyleSheet("color: black; background-color: rgb(215, 215, 215)");
-        button->setShortcut(hexButtonShortcuts[index]);
-        hexButtonGroup->addButton(button, index);
-        hexButtonLayout->addWidget(button, 1, index);
-    }
-#endif
-
     /* Configure the controller object to init status */
-    control->setDecimalStatus(false);
-    control->setNegativeStatus(false);
-    control->setText("0");
-    control->setOperator(OPERATOR_NONE);
-    control->setOperand1("0");
-    control->setLastClicked(TYPE_INIT);
-    control->setMemoryText("0");
-    control->setBinButtonStatus(MODE_BIN, MODE_DEC);
-    control->setHexButtonStatus(MODE_HEX, MODE_DEC);
-    lcd->setMode(QLCDNumber::Dec);
-    control->setFocus();
-#if HEX
-    hexButtonGroup->blockSignals(true);
-    hexButtonLayout->setEnabled(false);
-#endif
+    control->getEngine()->reset();
 
     /* Connect buttons with controller */
     connect(buttonGroup, SIGNAL(buttonClicked(int)), control, SLOT(buttonPressed(int)));
-#if HEX
-    /* Connect hex buttons with controller */
-    connect(hexButtonGroup, SIGNAL(buttonClicked(int)), control, SLOT(hexButtonPressed(int)));
-#endif
     /* Connect controller with LCD */
-    connect(control, SIGNAL(setLCD(QString)), lcd, SLOT(display(QString)));
+    connect(control, SIGNAL(setLCD(QString)), this, SLOT(showLCD(QString)));
+    /* Connect arithmetic menu with main */
+    connect(arithGroup, SIGNAL(triggered(QAction *)), this, SLOT(arithChanged(QAction *)));
+    /* Connect controller with arithmetic menu, 'Bin' and 'Hex' switch it too */
+    connect(control, SIGNAL(setArith(int)), this, SLOT(showArith(int)));
+    /* Connect paste menu with main */
+    connect(pasteAction, SIGNAL(triggered()), this, SLOT(paste()));
+    /* Connect undo menu with controller */
+    connect(undoAction, SIGNAL(triggered()), control, SLOT(undo()));
+    connect(redoAction, SIGNAL(triggered()), control, SLOT(redo()));
+    /* Connect history menu with main */
+    connect(historyAction, SIGNAL(triggered()), this, SLOT(showHistory()));
+    /* Connect tab menu and tab bar with main */
+    connect(newTabAction, SIGNAL(triggered()), this, SLOT(newTab()));
+    connect(closeTabAction, SIGNAL(triggered()), this, SLOT(closeCurrentTab()));
+    connect(tabBar, SIGNAL(currentChanged(int)), this, SLOT(switchTab(int)));
+    connect(tabBar, SIGNAL(tabCloseRequested(int)), this, SLOT(closeTab(int)));
+    /* Connect summary menu with main */
+    connect(summaryAction, SIGNAL(triggered(bool)), this, SLOT(summaryChanged(bool)));
+    connect(showSummaryAction, SIGNAL(triggered()), this, SLOT(showSummary()));
     /* Connect controller with main */
     connect(control, SIGNAL(setButton(int, QString, int)), this, SLOT(buttonChanged(int, QString, int)));
-#if DEBUG
-    /* Connect controller with debug label */
-    connect(control, SIGNAL(setLCD(QString)), label, SLOT(setText(QString)));
+#if STATS
+    /* Connect statistics menu with main */
+    connect(statsAction, SIGNAL(triggered()), this, SLOT(dumpStats()));
 #endif
     /* Add the components to the main layout */
+    mainLayout->addWidget(tabBar);
     mainLayout->addWidget(lcd);
-#if DEBUG
-    mainLayout->addWidget(label);
-#endif
     mainLayout->addLayout(buttonLayout, 1);
-#if HEX
-    mainLayout->addLayout(hexButtonLayout, 1);
-#endif
     mainLayout->setSizeConstraint(QLayout::SetFixedSize);
 
     /* Set the layout to main layout */
     setLayout(mainLayout);
+
+    /* Color it, one style sheet is parsed once for all the widgets */
+    setStyleSheet(CALCULATOR_STYLE);
 }
 
 /**
@@ -152,10 +230,11 @@ Calculator::Calculator(QWidget *parent)
  */
 Calculator::~Calculator()
 {
-    /* Release the keyboard */
-    control->releaseKeyboard();
+    /* The control unit first, nothing may reach the widgets it signals once they are gone */
+    delete control;
 
     /* Free the allocated components */
+    delete tabBar;
     delete lcd;
     delete buttonLayout;
     delete buttonGroup;
@@ -163,10 +242,19 @@ Calculator::~Calculator()
     delete hexButtonLayout;
     delete hexButtonGroup;
 #endif
-    delete control;
     delete mainLayout;
-#if DEBUG
-    delete label;
+    delete arithGroup;
+    delete pasteAction;
+    delete undoAction;
+    delete redoAction;
+    delete historyAction;
+    delete newTabAction;
+    delete closeTabAction;
+    delete summaryAction;
+    delete showSummaryAction;
+    delete historyPanel;
+#if STATS
+    delete statsAction;
 #endif
     return;
 }
@@ -188,844 +276,1055 @@ void Calculator::buttonChanged(int buttonIdx, QString text, int mode)
     /* Change the text */
     tempButton->setText(text);
 
-    /* Update the LCD mode accordingly */
-    if (mode == MODE_DEC) {
-        lcd->setMode(QLCDNumber::Dec);
 #if HEX
-        hexButtonGroup->blockSignals(true);
-#endif
-    } else if (mode == MODE_HEX) {
-        lcd->setMode(QLCDNumber::Hex);
-#if HEX
-        hexButtonGroup->blockSignals(false);
+    /* The LCD shows any base as it is, hex needs its buttons */
+    if (mode == MODE_HEX) {
+        createHexButtons();
+    }
+
+    /* Enable/disable the Hex buttons, if there are any yet */
+    if (hexButtonGroup != 0) {
+        hexButtonGroup->blockSignals(mode != MODE_HEX);
+        hexButtonLayout->setEnabled(mode == MODE_HEX);
+    }
+#else
+    (void) mode;
 #endif
-    } else if (mode == MODE_BIN) {
-        lcd->setMode(QLCDNumber::Bin);
+    return;
+}
+
 #if HEX
-        hexButtonGroup->blockSignals(true);
-#endif
+/**
+ *  @brief  Main object method : Create the hex buttons when first needed
+ *
+ *  Most sessions never leave decimal, so the panel is not built at startup.
+ *
+ *  @return N/A
+ */
+void Calculator::createHexButtons(void)
+{
+    /* Already there */
+    if (hexButtonGroup != 0) {
+        return;
     }
+    hexButtonLayout = new QGridLayout;
+    hexButtonGroup = new QButtonGroup;
 
-#if HEX
-    /* Enable/disable the Hex buttons */
-    if (mode == MODE_HEX) {
-        hexButtonLayout->setEnabled(true);
-    } else {
-        hexButtonLayout->setEnabled(false);
+    /* Create the hex buttons, add them to button group and button layout */
+    for (int index = 0; index < NUM_HEX_BUTTONS; index++) {
+        QPushButton *button = new QPushButton(hexButtonLabels[index]);
+        button->setShortcut(QKeySequence(hexButtonShortcuts[index]));
+        hexButtonGroup->addButton(button, index);
+        hexButtonLayout->addWidget(button, 1, index);
     }
+
+    /* Connect hex buttons with controller */
+    connect(hexButtonGroup, SIGNAL(buttonClicked(int)), control, SLOT(hexButtonPressed(int)));
+
+    /* Add them below the buttons */
+    mainLayout->addLayout(hexButtonLayout, 1);
+    return;
+}
 #endif
+
+/**
+ *  @brief  Main object slot : Show text in LCD
+ *
+ *  @param  text    New LCD text
+ *
+ *  @return N/A
+ */
+void Calculator::showLCD(QString text)
+{
+    /* The LCD shows the end of the text, where digits are entered */
+    lcd->setText(text);
+
+    /* A calculation may have added to the history */
+    if (historyModel != 0) {
+        historyModel->refresh();
+    }
+
+    /* Undo or another tab may have changed the summary status */
+    summaryAction->setChecked(control->getEngine()->getSummaryMode());
     return;
 }
 
 /**
- *  @brief  Controller object constructor
+ *  @brief  Main object slot : Handle arithmetic change
  *
- *  @param  parent  pointer to parent widget
+ *  @param  action  Action triggered
  *
  *  @return N/A
  */
-Control::Control(QWidget *parent)
-    : QWidget(parent)
+void Calculator::arithChanged(QAction *action)
 {
+    /* A background keystroke would bring the old arithmetic back */
+    control->cancel();
+    control->record();
+
+    /* Switch the engine, it shows the LCD again */
+    if (action == bigAction) {
+        control->getEngine()->setArithMode(ARITH_BIG);
+    } else if (action == decimalAction) {
+        control->getEngine()->setArithMode(ARITH_DECIMAL);
+    } else if (action == integerAction) {
+        control->getEngine()->setArithMode(ARITH_INTEGER);
+    } else {
+        control->getEngine()->setArithMode(ARITH_DOUBLE);
+    }
     return;
 }
 
 /**
- *  @brief  Controller object destructor
+ *  @brief  Main object slot : Show the arithmetic in the menu
+ *
+ *  @param  mode    Arithmetic mode
  *
  *  @return N/A
  */
-Control::~Control()
+void Calculator::showArith(int mode)
 {
+    /* Check the action of the mode */
+    if (mode == ARITH_BIG) {
+        bigAction->setChecked(true);
+    } else if (mode == ARITH_DECIMAL) {
+        decimalAction->setChecked(true);
+    } else if (mode == ARITH_INTEGER) {
+        integerAction->setChecked(true);
+    } else {
+        doubleAction->setChecked(true);
+    }
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the current set text
+ *  @brief  Main object slot : Paste the clipboard text
  *
- *  @return Current set text
+ *  @return N/A
  */
-QString Control::getText(void)
+void Calculator::paste(void)
 {
-    /* Return set text */
-    return lcdText;
+    /* The engine takes a number or an expression in one go */
+    control->enterText(QApplication::clipboard()->text());
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the current text
+ *  @brief  Main object slot : Show the history panel
  *
- *  @param  newText     The text to set
+ *  The panel is built when first shown, most sessions never open it.
  *
  *  @return N/A
  */
-void Control::setText(QString newText)
+void Calculator::showHistory(void)
 {
-    /* Set text */
-    lcdText = newText;
+    if (historyPanel == 0) {
+        /* Build the panel: search text above the list */
+        historyPanel = new QWidget;
+        historyPanel->setWindowTitle("History");
+        historySearch = new QLineEdit;
+        historyView = new QListView;
+        historyModel = new HistoryModel(control->getHistory(), this);
+        historyView->setModel(historyModel);
+        /* Rows of one height let the view only look at the visible rows */
+        historyView->setUniformItemSizes(true);
+        QVBoxLayout *layout = new QVBoxLayout;
+        layout->addWidget(historySearch);
+        layout->addWidget(historyView);
+        historyPanel->setLayout(layout);
+
+        /* Connect the panel with main */
+        connect(historySearch, SIGNAL(returnPressed()), this, SLOT(searchHistory()));
+        connect(historyView, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(replayHistory(QModelIndex)));
+    }
+
+    /* Show the latest records */
+    historyModel->refresh();
+    historyPanel->show();
+    historyView->scrollToBottom();
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the text set in memory
+ *  @brief  Main object slot : Search the history
  *
- *  @return Current set text in memory
+ *  @return N/A
  */
-QString Control::getMemoryText(void)
+void Calculator::searchHistory(void)
 {
-    /* Return memory text */
-    return memoryText;
+    /* Show what is found, or all if the text is empty */
+    if (!historyModel->setFilter(historySearch->text())) {
+        historySearch->selectAll();
+    }
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the text in memory
+ *  @brief  Main object slot : Enter a result from the history
  *
- *  @param  newText     The text to set in memory
+ *  @param  index   Row double clicked
  *
  *  @return N/A
  */
-void Control::setMemoryText(QString newText)
+void Calculator::replayHistory(const QModelIndex &index)
 {
-    /* Set memory text */
-    memoryText = newText;
+    const HistoryRecord *record = historyModel->getRecord(index.row());
+    QString operand1, operand2, result;
+
+    /* Enter the result as if pasted, with all its digits */
+    if ((record == 0) || ((record->flags & HISTORY_ERROR) != 0)) {
+        return;
+    }
+    if (!control->getHistory()->getTexts(record, &operand1, &operand2, &result)) {
+        result = QString::number(record->result, 'g', 17);
+    }
+    control->enterText(result);
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the operand text
+ *  @brief  Main object slot : Open a new calculator tab
+ *
+ *  The tab gets no widgets of its own, only an engine state.
  *
- *  @return Current operand text
+ *  @return N/A
  */
-QString Control::getOperand1(void)
+void Calculator::newTab(void)
 {
-    /* Return operand text */
-    return operand1;
+    /* Add it after the others and show it */
+    int index = control->addTab();
+    lastTabNumber++;
+    tabBar->addTab(QString::number(lastTabNumber));
+    tabBar->setVisible(true);
+    tabBar->setCurrentIndex(index);
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the operand text
+ *  @brief  Main object slot : Close a calculator tab
  *
- *  @param  operand     The text to set in operand
+ *  @param  index   Index of the tab
  *
  *  @return N/A
  */
-void Control::setOperand1(QString operand)
+void Calculator::closeTab(int index)
 {
-    /* Set operand text */
-    operand1 = operand;
+    /* The last tab stays */
+    if (tabBar->count() < 2) {
+        return;
+    }
+
+    /* The controller shows the next tab first, the tab bar follows it */
+    control->removeTab(index);
+    tabBar->removeTab(index);
+    tabBar->setCurrentIndex(control->getCurrentTab());
+    tabBar->setVisible(tabBar->count() > 1);
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the last set operator
+ *  @brief  Main object slot : Close the calculator tab shown
  *
- *  @return Current set operator
+ *  @return N/A
  */
-int Control::getOperator(void)
+void Calculator::closeCurrentTab(void)
 {
-    /* Return set operator */
-    return lastOperator;
+    /* Close the current one */
+    closeTab(tabBar->currentIndex());
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the operator
+ *  @brief  Main object slot : Show a calculator tab
  *
- *  @param  op  The operator to set
+ *  @param  index   Index of the tab
  *
  *  @return N/A
  */
-void Control::setOperator(int op)
+void Calculator::switchTab(int index)
 {
-    /* Set operator */
-    lastOperator = op;
+    /* The engine notifies the LCD, menu and buttons */
+    control->switchTab(index);
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the decimal status
+ *  @brief  Main object slot : Start or stop the summary
  *
- *  @return Current decimal status
+ *  In summary mode 'M+' also sums up the value for the statistics.
+ *
+ *  @param  status  true to start afresh, false to stop
+ *
+ *  @return N/A
  */
-bool Control::getDecimalStatus(void)
+void Calculator::summaryChanged(bool status)
 {
-    /* Return decimal status */
-    return isDecimalEnabled;
+    /* It can be undone as a keystroke */
+    control->cancel();
+    control->record();
+    control->getEngine()->setSummaryMode(status);
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the decimal status
+ *  @brief  Main object slot : Show the summary
  *
- *  @param  status  The decimal status to set
+ *  @return N/A
+ */
+void Calculator::showSummary(void)
+{
+    const Accumulator *summary = control->getEngine()->getSummary();
+    QString text;
+
+    /* One statistic a line */
+    text.append("Count: " + QString::number(summary->getCount()) + "\n");
+    text.append("Sum: " + QString::number(summary->getSum(), 'g', 15) + "\n");
+    text.append("Mean: " + QString::number(summary->getMean(), 'g', 15) + "\n");
+    text.append("Standard deviation: " + QString::number(summary->getDeviation(), 'g', 15) + "\n");
+    text.append("Minimum: " + QString::number(summary->getMin(), 'g', 15) + "\n");
+    text.append("Maximum: " + QString::number(summary->getMax(), 'g', 15));
+
+    /* Show it */
+    QMessageBox box(this);
+    box.setWindowTitle("Summary");
+    box.setText(text);
+    box.exec();
+    return;
+}
+
+#if STATS
+/**
+ *  @brief  Main object slot : Dump the engine statistics
  *
  *  @return N/A
  */
-void Control::setDecimalStatus(bool status)
+void Calculator::dumpStats(void)
 {
-    /* Set decimal status */
-    isDecimalEnabled = status;
+    /* Dump to the standard error */
+    control->getEngine()->dumpStats(stderr);
+    fflush(stderr);
     return;
 }
+#endif
 
 /**
- *  @brief  Controller object method : Get the negative sign status
+ *  @brief  Main object method : Paint the window
+ *
+ *  The widgets paint themselves, the first paint is only signalled.
+ *
+ *  @param  event   Paint event
  *
- *  @return Current negative sign status
+ *  @return N/A
  */
-bool Control::getNegativeStatus(void)
+void Calculator::paintEvent(QPaintEvent *event)
 {
-    /* Return negative sign status */
-    return isNegativeEnabled;
+    /* Paint as any widget */
+    QWidget::paintEvent(event);
+    if (!isPainted) {
+        isPainted = true;
+        emit painted();
+    }
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set the negative sign status
+ *  @brief  Controller object constructor
+ *
+ *  @param  parent  pointer to parent object
  *
- *  @param  status  The negative sign status to set
+ *  @return N/A
+ */
+Control::Control(QObject *parent)
+    : QObject(parent)
+{
+    /* Get notified of engine changes */
+    engine.setListener(this);
+    /* Start with one tab, new ones start from the init status */
+    engine.saveState(&initState);
+    tabs.append(new ControlTab);
+    currentTab = 0;
+    /* LCD text held back within a frame is shown by the timer */
+    lcdTimer = new QTimer(this);
+    lcdTimer->setSingleShot(true);
+    connect(lcdTimer, SIGNAL(timeout()), this, SLOT(flushLCD()));
+    /* Slow keystrokes run in the background, the LCD shows they are busy */
+    pool = new QThreadPool(this);
+    busyTask = 0;
+    lastTask = 0;
+    runningTask = 0;
+    busyTimer = new QTimer(this);
+    busyTimer->setSingleShot(true);
+    connect(busyTimer, SIGNAL(timeout()), this, SLOT(showBusy()));
+    /* Log the calculations, opening the history reads nothing but its header */
+    if (tape.open(QDir::homePath() + "/" HISTORY_FILE)) {
+        engine.setHistory(&tape);
+    }
+#if STATS
+    /* Collect statistics, they are dumped from the menu */
+    engine.setStats(&stats);
+#endif
+    return;
+}
+
+/**
+ *  @brief  Controller object destructor
  *
  *  @return N/A
  */
-void Control::setNegativeStatus(bool status)
+Control::~Control()
 {
-    /* Set negative sign status */
-    isNegativeEnabled = status;
+    /* Drop the background keystroke without a word to the widgets. The
+     * worker stops at its next step, deleting the pool waits for no more */
+    busyTask = 0;
+    runningTask = 0;
+    busyTimer->stop();
+    lcdTimer->stop();
+
+    /* Free the allocated components */
+    qDeleteAll(tabs);
+    delete pool;
+    delete busyTimer;
+    delete lcdTimer;
     return;
 }
 
 /**
- *  @brief  Controller object method : Get the last clicked button type
+ *  @brief  Controller object method : Get the engine
  *
- *  @return Last clicked button type
+ *  @return Pointer to the calculator engine
  */
-int Control::getLastClicked(void)
+Engine *Control::getEngine(void)
 {
-    /* Return last clicked button type */
-    return lastClicked;
+    /* Return engine */
+    return &engine;
 }
 
 /**
- *  @brief  Controller object method : Set the last clicked button type
+ *  @brief  Controller object method : Engine listener, LCD text changed
  *
- *  @param  lc      Last clicked button type to set
+ *  @param  text    New LCD text
  *
  *  @return N/A
  */
-void Control::setLastClicked(int lc)
+void Control::lcdChanged(const QString &text)
 {
-    /* Set last clicked button type */
-    lastClicked = lc;
+    /* The engine is up to date already, the LCD only needs the latest text */
+    pendingText = text;
+    if (lcdTimer->isActive()) {
+        return;
+    }
+
+    /* Show it now unless the LCD was updated within this frame */
+    int elapsed = shownTime.isNull() ? LCD_FRAME_TIME : shownTime.elapsed();
+    if ((elapsed >= LCD_FRAME_TIME) || (elapsed < 0)) {
+        flushLCD();
+    } else {
+        lcdTimer->start(LCD_FRAME_TIME - elapsed);
+    }
     return;
 }
 
 /**
- *  @brief  Controller object method : Get 'Bin' button status
+ *  @brief  Controller object slot :  Show the latest LCD text
  *
- *  @return 'Bin' button status
+ *  @return N/A
  */
-int Control::getBinButtonStatus(void)
+void Control::flushLCD(void)
 {
-    /* Return 'Bin' button status */
-    return binButtonStatus;
+    /* Signal the LCD component to show the text, if it changed */
+    shownTime.start();
+    if (pendingText != shownText) {
+        shownText = pendingText;
+        emit setLCD(shownText);
+    }
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set 'Bin' button status
+ *  @brief  Controller object method : Engine listener, button name changed
  *
- *  @param  status      'Bin' button status to set
+ *  @param  button      Index of button to change
+ *  @param  text        New button text
  *  @param  oldStatus   Old status to override
  *
  *  @return N/A
  */
-void Control::setBinButtonStatus(int status, int oldStatus)
+void Control::buttonChanged(int button, const QString &text, int oldStatus)
 {
-    /* Set 'Bin' button status */
-    binButtonStatus = status;
-
-    if (status == MODE_BIN) { emit setButton(BUTTON_BIN, "Bin", oldStatus); }
-    if (status == MODE_HEX) { emit setButton(BUTTON_BIN, "Hex", oldStatus); }
-    if (status == MODE_DEC) { emit setButton(BUTTON_BIN, "Dec", oldStatus); }
+    /* Signal the main object to change the button */
+    emit setButton(button, text, oldStatus);
     return;
 }
 
 /**
- *  @brief  Controller object method : Get 'Hex' button status
+ *  @brief  Controller object method : Engine listener, arithmetic changed
+ *
+ *  @param  mode    New arithmetic mode
  *
- *  @return 'Hex' button status
+ *  @return N/A
  */
-int Control::getHexButtonStatus(void)
+void Control::arithChanged(int mode)
 {
-    /* Return 'Hex' button status */
-    return hexButtonStatus;
+    /* Signal the main object to check the menu */
+    emit setArith(mode);
+    return;
 }
 
 /**
- *  @brief  Controller object method : Set 'Hex' button status
+ *  @brief  Controller object slot :  Capture button press
  *
- *  @param  status      'Hex' button status to set
- *  @param  oldStatus   Old status to override
+ *  @param  index   Index of button pressed
  *
  *  @return N/A
  */
-void Control::setHexButtonStatus(int status, int oldStatus)
+void Control::buttonPressed(int index)
 {
-    /* Set 'Hex' button status */
-    hexButtonStatus = status;
+    if (busyTask != 0) {
+        /* 'C' or Esc drops the background keystroke, others wait for it */
+        if (index == BUTTON_CLR) {
+            cancel();
+            pressKey(index);
+        } else {
+            queuedKeys.append(index);
+        }
+        return;
+    }
 
-    if (status == MODE_BIN) { emit setButton(BUTTON_HEX, "Bin", oldStatus); }
-    if (status == MODE_HEX) { emit setButton(BUTTON_HEX, "Hex", oldStatus); }
-    if (status == MODE_DEC) { emit setButton(BUTTON_HEX, "Dec", oldStatus); }
+    /* Let the engine handle it */
+    pressKey(index);
     return;
 }
 
+#if HEX
 /**
- *  @brief  Controller object method : Get number of digits in LCD
+ *  @brief  Controller object slot :  Capture hex button press
  *
- *  @return Number of digits shown in LCD
+ *  @param  index   Index of hex button pressed
+ *
+ *  @return N/A
  */
-int Control::getNumDigits(void)
+void Control::hexButtonPressed(int index)
 {
-    /* Return number of digits in LCD */
-    return numLCDDigits;
+    if (busyTask != 0) {
+        /* Wait for the background keystroke */
+        queuedKeys.append(NUM_BUTTONS + index);
+        return;
+    }
+
+    /* Let the engine handle it */
+    pressKey(NUM_BUTTONS + index);
+    return;
 }
+#endif
 
 /**
- *  @brief  Controller object method : Save number of digits in LCD
+ *  @brief  Controller object method :  Press a key, in the background if it may take long
  *
- *  @param  num     Number of digits to save
+ *  @param  key     Index of button, hex buttons follow the buttons,
+ *                  or CONTROL_KEY_TEXT for the next queued text
  *
  *  @return N/A
  */
-void Control::setNumDigits(int num)
+void Control::pressKey(int key)
 {
-    /* Save number of digits in LCD */
-    numLCDDigits = num;
+    /* Keep the state before it for undo */
+    record();
+
+    if (key == CONTROL_KEY_TEXT) {
+        /* Text not understood leaves the engine as it was */
+        if (!engine.enterText(queuedTexts.takeFirst())) {
+            history.drop();
+        }
+        return;
+    }
+
+#if HEX
+    if (key >= NUM_BUTTONS) {
+        /* Hex digits are always quick */
+        engine.hexButtonPressed(key - NUM_BUTTONS);
+        return;
+    }
+#endif
+    if (!engine.isSlowButton(key)) {
+        engine.buttonPressed(key);
+        return;
+    }
+
+    /* Run it on a copy of the engine, the copy is taken back when done */
+    busyTask = ++lastTask;
+    runningTask = busyTask;
+    busyTime.start();
+    busyTimer->start(LCD_BUSY_DELAY);
+    pool->start(new EngineTask(this, engine, key, busyTask, &runningTask));
     return;
 }
 
 /**
- *  @brief  Controller object method :  Update LCD
+ *  @brief  Controller object method :  Check for a calculation in the background
+ *
+ *  @return true if a keystroke runs in the background
+ */
+bool Control::isBusy(void)
+{
+    /* Return busy status */
+    return busyTask != 0;
+}
+
+/**
+ *  @brief  Controller object method :  Drop the calculation in the background
+ *
+ *  The worker is asked to stop and gives up at its next step, whatever
+ *  it posts back is thrown away. The engine is left as it was before
+ *  the keystroke.
  *
  *  @return N/A
  */
-void Control::updateLCD(void)
+void Control::cancel(void)
 {
-    /* Get the current set text */
-    QString text = getText();
+    /* Nothing to do if idle */
+    if (busyTask == 0) {
+        return;
+    }
 
-    /* Disable dot button action if already present */
-    setDecimalStatus(text.contains("."));
-    /* Disable sign button action if already present */
-    setNegativeStatus(text.contains("-"));
+    /* Stop the worker, forget the keystroke and the keys waiting for it */
+    busyTask = 0;
+    runningTask = 0;
+    busyTimer->stop();
+    queuedKeys.clear();
+    queuedTexts.clear();
+    history.drop();
+    lcdChanged(engine.getDisplayText());
+    return;
+}
 
-    /* Signal the LCD component to show the text */
-    emit setLCD(text);
+/**
+ *  @brief  Controller object method :  Keep the state for undo
+ *
+ *  Keys are recorded as they are pressed, other changes call this first.
+ *
+ *  @return N/A
+ */
+void Control::record(void)
+{
+    /* Record the engine state */
+    history.record(&engine);
+    return;
+}
 
-    /* Save the number of digits shown */
-    setNumDigits(text.length());
+/**
+ *  @brief  Controller object method :  Enter a number or expression, after the background keystroke
+ *
+ *  The text waits for a background keystroke as keys pressed meanwhile
+ *  do, it is entered once the keystroke is taken back.
+ *
+ *  @param  text    Number or expression text
+ *
+ *  @return N/A
+ */
+void Control::enterText(const QString &text)
+{
+    /* Keep the text with the keys */
+    queuedTexts.append(text);
+    if (busyTask != 0) {
+        queuedKeys.append(CONTROL_KEY_TEXT);
+        return;
+    }
 
+    /* Let the engine take it */
+    pressKey(CONTROL_KEY_TEXT);
     return;
 }
 
 /**
- *  @brief  Controller object method :  Make calculation
+ *  @brief  Controller object method :  Get the calculation history
  *
- *  @param  opString1   Operand 1 as string
- *  @param  opString2   Operand 2 as string
- *  @param  op          Operator
+ *  @return Pointer to the history
+ */
+HistoryLog *Control::getHistory(void)
+{
+    /* Return history */
+    return &tape;
+}
+
+/**
+ *  @brief  Controller object method :  Add a tab in init status
  *
- *  @return Calculated result as string
+ *  @return Index of the tab
  */
-QString Control::calculate(QString opString1, QString opString2, int op)
+int Control::addTab(void)
 {
-    double op1 = 0, op2 = 0, result = 0;
-    QString ret = "0";
+    /* A state is all a tab needs until shown */
+    ControlTab *tab = new ControlTab;
+    tab->state = initState;
+    tabs.append(tab);
+    return tabs.size() - 1;
+}
 
-    /* Check if operand 1 exists, 0 value is allowed */
-    if (opString1.isEmpty()) {
-        return ret;
+/**
+ *  @brief  Controller object method :  Remove a tab
+ *
+ *  The tab after it is shown if it was shown, or the one before if it
+ *  was the last. The last tab left is not removed.
+ *
+ *  @param  index   Index of the tab
+ *
+ *  @return N/A
+ */
+void Control::removeTab(int index)
+{
+    if ((index < 0) || (index >= tabs.size()) || (tabs.size() < 2)) {
+        return;
     }
 
-    /* Check if operand 2 exists, 0 value is allowed */
-    if (opString2.isEmpty()) {
-        return ret;
+    /* Move off the tab first */
+    if (index == currentTab) {
+        switchTab((index + 1 < tabs.size()) ? index + 1 : index - 1);
     }
 
-    /* Convert strings to doubles */
-    op1 = opString1.toDouble();
-    op2 = opString2.toDouble();
-
-    /* Perform the calculation */
-    switch (op) {
-        case OPERATOR_PLUS:
-            /* Addition */
-            result = op1 + op2;
-            ret.setNum(result);
-            break;
-        case OPERATOR_MINUS:
-            /* Substraction */
-            result = op1 - op2;
-            ret.setNum(result);
-            break;
-        case OPERATOR_MUL:
-            /* Multiplication */
-            result = op1 * op2;
-            ret.setNum(result);
-            break;
-        case OPERATOR_DIV:
-            /* Division */
-            if (op2 == 0) {
-                /* Check for divide-by-zero error */
-                showError();
-                break;
-            }
-            result = op1 / op2;
-            ret.setNum(result);
-            break;
-        case OPERATOR_SQRT:
-            /* Square root */
-            result = sqrt(op1);
-            ret.setNum(result);
-            break;
-        case OPERATOR_FACT:
-            /* Factorial */
-            if (op1 == 0) {
-                op1 = 1;
-            } else if (op1 < 0) {
-                op1 = -op1;
-            } else {
-                op1 = round(op1);
-            }
-            result = 1;
-            for (int i = 1; i <= op1; i++) {
-                result = result * i;
-            }
-            ret.setNum(result);
-            break;
-        default:
-            break;
+    /* Forget it, the tabs after it move down */
+    delete tabs.takeAt(index);
+    if (currentTab > index) {
+        currentTab--;
     }
-    return ret;
+    return;
 }
 
 /**
- *  @brief  Controller object method :  Show error function
+ *  @brief  Controller object method :  Show a tab in the engine
+ *
+ *  The state of the tab shown is kept and the new one is restored, the
+ *  engine notifies the widgets of it. A background keystroke belongs to
+ *  the tab shown, so it is dropped as 'C' would.
+ *
+ *  @param  index   Index of the tab
  *
  *  @return N/A
  */
-void Control::showError(void)
+void Control::switchTab(int index)
 {
-    /* Show error */
-    setText("-- error --");
-    updateLCD();
-
-    /* Reset the components */
-    setDecimalStatus(false);
-    setNegativeStatus(false);
-    setText("0");
-    setOperator(OPERATOR_NONE);
-    setOperand1("0");
-    setLastClicked(TYPE_INIT);
+    if ((index < 0) || (index >= tabs.size()) || (index == currentTab)) {
+        return;
+    }
+    cancel();
+
+    /* Keep the state of the tab shown */
+    ControlTab *tab = tabs[currentTab];
+    engine.saveState(&tab->state);
+    tab->history = history;
+
+    /* Take the new one over, its copy of the history is not needed */
+    tab = tabs[index];
+    history = tab->history;
+    tab->history.clear();
+    currentTab = index;
+    engine.restoreState(tab->state);
+    return;
 }
 
 /**
- *  @brief  Controller object slot :  Capture button press
+ *  @brief  Controller object method :  Get the tab shown
  *
- *  @param  index   Index of button pressed
+ *  @return Index of the tab
+ */
+int Control::getCurrentTab(void)
+{
+    /* Return current tab */
+    return currentTab;
+}
+
+/**
+ *  @brief  Controller object slot :  Undo the last keystroke
  *
  *  @return N/A
  */
-void Control::buttonPressed(int index)
+void Control::undo(void)
 {
-    /* Get the current set text */
-    QString text = getText();
-    /* Allocate a temporary text buffer */
-    QString tempText;
-
-    /* Initialize in use operators */
-    int op = OPERATOR_NONE, newOp = OPERATOR_NONE;
-
-    /* Get the last clicked button type */
-    int lc = getLastClicked();
-
-    /** Allocate operand text buffer */
-    QString operand1;
-
-    /* Actual working logic */
-    switch(index) {
-        case BUTTON_1:  /* Button 1: Fall through */
-        case BUTTON_2:  /* Button 2: Fall through */
-        case BUTTON_3:  /* Button 3: Fall through */
-        case BUTTON_4:  /* Button 4: Fall through */
-        case BUTTON_5:  /* Button 5: Fall through */
-        case BUTTON_6:  /* Button 6: Fall through */
-        case BUTTON_7:  /* Button 7: Fall through */
-        case BUTTON_8:  /* Button 8: Fall through */
-        case BUTTON_9:  /* Button 9: Fall through */
-        case BUTTON_0:  /* Button 0 */
-            if (text.toDouble() == 0) {
-            /* Value is zero */
-                if ((lc == TYPE_OP) || (lc == TYPE_EQ) || (lc == TYPE_INIT) || (lc == TYPE_OTHER) || (lc == TYPE_NUM)) {
-                    /* Take a new value */
-                    text = buttonLabels[index];
-                } else if (lc == TYPE_DOT) {
-                    /* User pressed '.' before */
-                    text = "0.";
-                    text.append(buttonLabels[index]);
-                }
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-            } else if ((lc == TYPE_OP) || (lc == TYPE_EQ)) {
-                /* Value is not zero, but need to take a new value */
-                text = buttonLabels[index];
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-            } else if (text.length() < LCD_LENGTH) {
-                /* Value is not zero, append to existing text */
-                text.append(buttonLabels[index]);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-            }
-            /* Set the last clicked button type to number */
-            setLastClicked(TYPE_NUM);
-            break;
-        case BUTTON_SQ: /* Button square */
-            if (text.toDouble() != 0) {
-                /* We need to work only is value is non-zero */
-                /* Square the current value */
-                text = calculate(text, text, OPERATOR_MUL);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-                /* Set the last clicked button type to operator */
-                setLastClicked(TYPE_OP);
-            }
-            break;
-        case BUTTON_SQRT:    /* Button sqaure root */
-            if (text.toDouble() != 0) {
-                /* We need to work only is value is non-zero */
-                /* Square root the current value */
-                text = calculate(text, text, OPERATOR_SQRT);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-                /* Set the last clicked button type to operator */
-                setLastClicked(TYPE_OP);
-            }
-            break;
-        case BUTTON_FACT:    /* Button sqaure root */
-            /* Factorial the current value */
-            text = calculate(text, text, OPERATOR_FACT);
-            /* Update LCD */
-            setText(text);
-            updateLCD();
-            /* Set the last clicked button type to operator */
-            setLastClicked(TYPE_OP);
-            break;
-        case BUTTON_INV:    /* Button inverse */
-            if (text.toDouble() == 0) {
-                /* Value is zero, this makes divide-by-zero error */
-                showError();
-            } else {
-                /* Value is noon-zero, inverse the current value */
-                text = calculate("1", text, OPERATOR_DIV);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-                /* Set the last clicked button type to operator */
-                setLastClicked(TYPE_OP);
-            }
-            break;
-        case BUTTON_SIGN:
-            if (getNegativeStatus() == false) {
-                /* Negative sign not present, need to add it */
-                setNegativeStatus(true);
-                if (text.length() <= LCD_LENGTH) {
-                    /* This does not affect the LCD precision */
-                    text.prepend("-");
-                }
-            } else {
-                /* Negative sign is already present, need to remove it */
-                setNegativeStatus(false);
-                text.remove(0, 1);
-            }
-            /* Update LCD */
-            setText(text);
-            updateLCD();
-            break;
-        case BUTTON_DOT:    /* Button dot */
-            if (getDecimalStatus() == false) {
-                /* Only do this if a dot is not already shown */
-                if ((text.toDouble() == 0) || (lc == TYPE_OP)) {
-                    text = "0.";
-                } else {
-                    text.append(buttonLabels[index]);
-                }
-                /* Make sure dots are disabled for future */
-                setDecimalStatus(true);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-                /* Set the last clicked button type to dot */
-                setLastClicked(TYPE_DOT);
-            }
-            break;
-        case BUTTON_PLUS:   /* Button plus : Fall through */
-            /* Save the operator */
-            if (newOp == OPERATOR_NONE) { newOp = OPERATOR_PLUS; }
-        case BUTTON_NEG:    /* Button minus : Fall through */
-            /* Save the operator */
-            if (newOp == OPERATOR_NONE) { newOp = OPERATOR_MINUS; }
-        case BUTTON_MUL:    /* Button multiply : Fall through */
-            /* Save the operator */
-            if (newOp == OPERATOR_NONE) { newOp = OPERATOR_MUL; }
-        case BUTTON_DIV:    /* Button divide : Fall through */
-            /* Save the operator */
-            if (newOp == OPERATOR_NONE) { newOp = OPERATOR_DIV; }
-            if (((text.toDouble()) == 0) || (lc == TYPE_OP)) {
-                /* No need to do anything, except updating the operator ... */
-                setOperator(newOp);
-                /* ... and last button clicked type */
-                setLastClicked(TYPE_OP);
-                break;
-            }
+    /* A background keystroke is the last one, drop it instead */
+    if (busyTask != 0) {
+        cancel();
+        return;
+    }
+    history.undo(&engine);
+    return;
+}
 
-            /* Get the last operator saved */
-            op = getOperator();
-            /* Get the last operand saved */
-            operand1 = getOperand1();
-
-            if ((operand1.toDouble() == 0) || (lc == TYPE_EQ) || (op == OPERATOR_NONE)) {
-                /* No last operand, save current value for next calculation */
-                setOperand1(text);
-            } else {
-                /* We already have an operand saved, need to perform calculation */
-                operand1 = calculate(operand1, text, op);
-                /* Save the result for next calculation */
-                setOperand1(operand1);
-                /* Update LCD */
-                setText(operand1);
-                updateLCD();
-            }
-            /* Save the operator */
-            setOperator(newOp);
-            /* Set the last clicked button type to operator */
-            setLastClicked(TYPE_OP);
-            /* Enable decimal */
-            setDecimalStatus(false);
-            break;
-        case BUTTON_EQ: /* Button equal to */
-            if ((text.toDouble() == 0) || (lc == TYPE_OP) || (lc == TYPE_EQ)) {
-                /* Nothing to do */
-                setLastClicked(TYPE_EQ);
-                break;
-            }
+/**
+ *  @brief  Controller object slot :  Redo the last undone keystroke
+ *
+ *  @return N/A
+ */
+void Control::redo(void)
+{
+    /* Nothing was undone while busy */
+    if (busyTask != 0) {
+        return;
+    }
+    history.redo(&engine);
+    return;
+}
 
-            /* Get the last operator saved */
-            op = getOperator();
-            /* Get the last operand saved */
-            operand1 = getOperand1();
+/**
+ *  @brief  Controller object slot :  Show the calculation is busy
+ *
+ *  @return N/A
+ */
+void Control::showBusy(void)
+{
+    /* Show the seconds spent so far, they tell it is still alive */
+    int seconds = busyTime.elapsed() / 1000;
+    QString text = "busy";
+    if (seconds > 0) {
+        text.append(" ");
+        text.append(QString::number(seconds));
+    }
+    lcdChanged(text);
+    busyTimer->start(LCD_BUSY_TIME);
+    return;
+}
 
-            /* Calculate the result ... */
-            if (operand1.toDouble() != 0) {
-                /* ... only if we have an operand to operate on */
-                operand1 = calculate(operand1, text, op);
-            }
-            /* Check the result */
-            if (operand1.toDouble() != 0) {
-                /* Update the operator saved */
-                setOperator(newOp);
-                /* Update LCD */
-                setText(operand1);
-                updateLCD();
-            }
-            /* Set the last clicked button type to equal to */
-            setLastClicked(TYPE_EQ);
-            /* Enable decimal */
-            setDecimalStatus(false);
-            break;
-        case BUTTON_MC: /* Button memory clear */
-            /* Reset the memory string */
-            setMemoryText("0");
-            break;
-        case BUTTON_MR: /* Button memory recall */
-            /* Get the current memory text */
-            tempText = getMemoryText();
-            /* Update LCD */
-            if (tempText.toDouble() == 0)
-                setText("0");
-            else
-                setText(tempText);
-            updateLCD();
-            break;
-        case BUTTON_MS: /* Button memory set */
-            /* Save current value to memory */
-            if (text.toDouble() == 0)
-                setMemoryText("0");
-            else
-                setMemoryText(text);
-            /* Make sure the next value is started anew */
-            setText("0");
-            setLastClicked(TYPE_INIT);
-            break;
-        case BUTTON_MP: /* Button memory plus */
-            /* Get the current memory text */
-            tempText = getMemoryText();
-            if (text.toDouble() == 0) {
-                /* Current value is zero, do nothing */
-                break;
-            }
-            if (tempText.toDouble() == 0) {
-                /* Memory value is zero, save the current one */
-                setMemoryText(text);
-            } else {
-                /* Update memory after addition */
-                setMemoryText(calculate(text, tempText, OPERATOR_PLUS));
-            }
-            break;
-        case BUTTON_BS: /* Button backspace */
-            if (text.length() > 1) {
-                /* If length is more than one, just cut one from end */
-                text.remove((text.length() - 1), 1);
-                /* Update LCD */
-                setText(text);
-                updateLCD();
-            } else if (text.length() == 1) {
-                /* If length is 1, set the value to zero and update LCD */
-                setText("0");
-                updateLCD();
-            }
-            /* Set the last clicked button type to others */
-            setLastClicked(TYPE_OTHER);
-            break;
-        case BUTTON_CLR:    /* Button clear */
-            /* Reset everything, except memory text */
-            setDecimalStatus(false);
-            setNegativeStatus(false);
-            setText("0");
-            setOperator(OPERATOR_NONE);
-            setOperand1("0");
-            setLastClicked(TYPE_INIT);
-            updateLCD();
-            break;
-        case BUTTON_CUBE:   /* Button cube */
-            if (text.toDouble() != 0) {
-                /* We need to work only is value is non-zero */
-                /* Cube the current value */
-                tempText = calculate(text, text, OPERATOR_MUL);
-                tempText = calculate(tempText, text, OPERATOR_MUL);
-                /* Update LCD */
-                setText(tempText);
-                updateLCD();
-                /* Set the last clicked button type to operator */
-                setLastClicked(TYPE_OP);
-            }
-            break;
-        case BUTTON_BIN:    /* Button binary */
-            switch (getBinButtonStatus()) {
-                case MODE_DEC:
-                    /* Currently set to 'Dec', change to 'Bin' */
-                    setBinButtonStatus(MODE_BIN, MODE_DEC);
-                    break;
-                case MODE_BIN:
-                    /* We already changed to 'Bin' before, change back to 'Dec' */
-                    setBinButtonStatus(MODE_DEC, MODE_BIN);
-                    break;
-                case MODE_HEX:  /* This should never come */
-                default:
-                    break;
-            }
-            break;
-        case BUTTON_HEX:    /* Button hexadecimal */
-            switch (getHexButtonStatus()) {
-                case MODE_DEC:
-                    /* Currently set to 'Dec', change to 'Hex' */
-                    setHexButtonStatus(MODE_HEX, MODE_DEC);
-                    break;
-                case MODE_HEX:
-                    /* We already changed to 'Hex' before, change back to 'Dec' */
-                    setHexButtonStatus(MODE_DEC, MODE_HEX);
-                    break;
-                case MODE_BIN:  /* This should never come */
-                default:
-                    break;
-            }
-            break;
-        default:
-            break;
+/**
+ *  @brief  Controller object method :  Take the engine back from the background
+ *
+ *  @param  event   Event posted by the worker
+ *
+ *  @return N/A
+ */
+void Control::customEvent(QEvent *event)
+{
+    if (event->type() != CONTROL_EVENT_DONE) {
+        QObject::customEvent(event);
+        return;
+    }
+
+    /* Results of dropped keystrokes are thrown away with the event */
+    EngineEvent *done = static_cast<EngineEvent *>(event);
+    if (done->task != busyTask) {
+        return;
+    }
+    busyTask = 0;
+    runningTask = 0;
+    busyTimer->stop();
+
+    /* Take the engine over and show its LCD */
+    engine = *done->engine;
+    engine.setListener(this);
+    if (tape.isOpen()) {
+        /* Log the calculations of the keystroke now it is kept */
+        for (int i = 0; i < done->records.size(); i++) {
+            tape.append(done->records.at(i));
         }
+        engine.setHistory(&tape);
+    }
+#if STATS
+    engine.setStats(&stats);
+#endif
+    lcdChanged(engine.getDisplayText());
 
+    /* Replay the keys pressed meanwhile, until one goes to the background */
+    while (!queuedKeys.isEmpty() && (busyTask == 0)) {
+        pressKey(queuedKeys.takeFirst());
+    }
     return;
 }
 
-#if HEX
 /**
- *  @brief  Controller object slot :  Capture hex button press
+ *  @brief  Worker object constructor
  *
- *  @param  index   Index of hex button pressed
+ *  @param  newReceiver Object the engine is posted to
+ *  @param  current     Engine to copy
+ *  @param  newKey      Button pressed
+ *  @param  newTask     Number of the keystroke
+ *  @param  running     Number of the keystroke allowed to go on, the copy stops once it changes
  *
  *  @return N/A
  */
-void Control::hexButtonPressed(int index)
+EngineTask::EngineTask(QObject *newReceiver, const Engine &current, int newKey, int newTask, const QAtomicInt *running)
+    : receiver(newReceiver), key(newKey), task(newTask)
 {
-    /* Get the current set text */
-    QString text = getText();
-
-    /* Get the last clicked button type */
-    int lc = getLastClicked();
-
-    /* Get the number of digits displayed */
-    int numDigits = getNumDigits();
-
-    if (getHexButtonStatus() == MODE_DEC) {
-        switch(index) {
-            case HEX_BUTTON_A:  /* Button A: Fall through */
-            case HEX_BUTTON_B:  /* Button B: Fall through */
-            case HEX_BUTTON_C:  /* Button C: Fall through */
-            case HEX_BUTTON_D:  /* Button D: Fall through */
-            case HEX_BUTTON_E:  /* Button E: Fall through */
-            case HEX_BUTTON_F:  /* Button F: */
-                if (numDigits == 0) {
-#if DEBUG
-                alert("Here 1");
+    /* The copy tells nobody, it is shown and logged when taken back */
+    engine = new Engine(current);
+    engine->setListener(0);
+    engine->setHistory(0);
+    engine->setCancel(BigCancel(running, newTask));
+#if STATS
+    engine->setStats(0);
 #endif
-                /* Value is zero */
-                    if ((lc == TYPE_OP) || (lc == TYPE_EQ) || (lc == TYPE_INIT) || (lc == TYPE_OTHER) || (lc == TYPE_DOT)) {
-                        /* Take a new value */
-                        text = hexButtonLabels[index];
-                    }
-                    /* Update LCD */
-                    setText(text.toLower());
-                    updateLCD();
-                } else if ((lc == TYPE_OP) || (lc == TYPE_EQ)) {
-#if DEBUG
-                alert("Here 2");
-#endif
-                    /* Value is not zero, but need to take a new value */
-                    text = hexButtonLabels[index];
-                    /* Update LCD */
-                    setText(text.toLower());
-                    updateLCD();
-                } else if (text.length() < LCD_LENGTH) {
-#if DEBUG
-                alert("Here 3");
-#endif
-                    /* Value is not zero, append to existing text */
-                    text.append(hexButtonLabels[index]);
-                    /* Update LCD */
-                    setText(text.toLower());
-                    updateLCD();
-                }
-#if DEBUG
-                alert("Here 4");
-#endif
-                /* Set the last clicked button type to number */
-                setLastClicked(TYPE_NUM);
-                break;
-            default:
-                break;
+    return;
+}
+
+/**
+ *  @brief  Worker object method :  Run the keystroke and post the engine back
+ *
+ *  @return N/A
+ */
+void EngineTask::run()
+{
+    EngineEvent *done = new EngineEvent(engine, task);
+
+    /* Press the button, its calculations are held in the event */
+    engine->setHistoryBuffer(&done->records);
+    engine->buttonPressed(key);
+    engine->setHistoryBuffer(0);
+
+    /* The event owns the engine from here */
+    QCoreApplication::postEvent(receiver, done);
+    engine = 0;
+    return;
+}
+
+/** Signs of the operators, by OPERATOR_* */
+static const char * const historyOperators[] = { "?", "+", "-", "*", "/", "sqrt", "!" };
+
+/** Forms of the unary operations, by UNARY_* */
+static const char * const historyUnaries[] = { "sqr(%1)", "sqrt(%1)", "%1!", "1/%1", "cube(%1)" };
+
+/**
+ *  @brief  History model constructor
+ *
+ *  @param  newLog  Calculation history
+ *  @param  parent  Parent object
+ *
+ *  @return N/A
+ */
+HistoryModel::HistoryModel(HistoryLog *newLog, QObject *parent)
+    : QAbstractListModel(parent), log(newLog), shown(newLog->getCount()), isFiltered(false)
+{
+    return;
+}
+
+/**
+ *  @brief  History model method : Get the number of rows
+ *
+ *  @param  parent  Parent index, the list has none
+ *
+ *  @return Number of rows
+ */
+int HistoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return isFiltered ? found.size() : shown;
+}
+
+/**
+ *  @brief  History model method : Get the record of a row
+ *
+ *  @param  row     Row
+ *
+ *  @return Record, 0 if there is no such row
+ */
+const HistoryRecord *HistoryModel::getRecord(int row) const
+{
+    if ((row < 0) || (row >= rowCount())) {
+        return 0;
+    }
+    return log->at(isFiltered ? found[row] : row);
+}
+
+/**
+ *  @brief  History model method : Get the text of a row
+ *
+ *  @param  index   Row
+ *  @param  role    Data role, only the display text is given
+ *
+ *  @return Text, as "2009-05-04 12:00:00   3 * 4 = 12"
+ */
+QVariant HistoryModel::data(const QModelIndex &index, int role) const
+{
+    const HistoryRecord *record = getRecord(index.row());
+    QString text, operand1, operand2, result;
+
+    if ((role != Qt::DisplayRole) || (record == 0)) {
+        return QVariant();
+    }
+
+    /* Time */
+    text = QDateTime::fromTime_t(record->time / 1000).toString("yyyy-MM-dd hh:mm:ss   ");
+
+    /* The exact values, the doubles if the texts cannot be read */
+    if (!log->getTexts(record, &operand1, &operand2, &result)) {
+        operand1 = QString::number(record->operand1, 'g', 15);
+        operand2 = QString::number(record->operand2, 'g', 15);
+        result = QString::number(record->result, 'g', 15);
+    }
+
+    /* Calculation */
+    if ((record->flags & HISTORY_UNARY) != 0) {
+        if ((record->op >= UNARY_SQ) && (record->op <= UNARY_CUBE)) {
+            text.append(QString(historyUnaries[record->op]).arg(operand1));
         }
+    } else if ((record->op >= OPERATOR_PLUS) && (record->op <= OPERATOR_FACT)) {
+        text.append(operand1);
+        text.append(" ");
+        text.append(historyOperators[record->op]);
+        text.append(" ");
+        text.append(operand2);
     }
+
+    /* Result */
+    text.append(" = ");
+    if ((record->flags & HISTORY_ERROR) != 0) {
+        text.append("error");
+    } else {
+        text.append(result);
+    }
+    return text;
+}
+
+/**
+ *  @brief  History model method : Show the records appended since
+ *
+ *  @return N/A
+ */
+void HistoryModel::refresh(void)
+{
+    int count = log->getCount();
+
+    /* Only the new rows, a filter is kept as it is */
+    if (isFiltered || (count <= shown)) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), shown, count - 1);
+    shown = count;
+    endInsertRows();
     return;
 }
-#endif
+
+/**
+ *  @brief  History model method : Show the records with a value, a range, or all
+ *
+ *  @param  text    Value, range as 'low..high', or empty for all records
+ *
+ *  @return true if the text is understood
+ */
+bool HistoryModel::setFilter(const QString &text)
+{
+    QString filter = text.trimmed();
+    double low, high;
+    bool ok = true, highOk = true;
+
+    /* Parse the value or the range */
+    int dots = filter.indexOf("..");
+    if (dots >= 0) {
+        low = filter.left(dots).trimmed().toDouble(&ok);
+        high = filter.mid(dots + 2).trimmed().toDouble(&highOk);
+    } else {
+        low = high = filter.toDouble(&ok);
+    }
+    if (!filter.isEmpty() && (!ok || !highOk)) {
+        return false;
+    }
+
+    /* Show what is found */
+    beginResetModel();
+    isFiltered = !filter.isEmpty();
+    if (isFiltered) {
+        log->find(low, high, &found);
+    } else {
+        found.clear();
+        shown = log->getCount();
+    }
+    endResetModel();
+    return true;
+}
@@ -23,25 +23,32 @@
 #ifndef CALCULATOR_H
 #define CALCULATOR_H
 
-/** Enable or disabled debugging */
-#define DEBUG   0
-
-/** Enable or disable hex input */
-#define HEX     0
-
 /* Includes */
 #include <QtGui/QWidget>
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QVector>
+#include <QtCore/QTime>
+#include <QtCore/QList>
 #include <QString>
+#include "engine.h"
+#include "undo.h"
+#include "history.h"
 
 /* Forward declarations */
-class QLCDNumber;
 class QGridLayout;
 class QButtonGroup;
 class QVBoxLayout;
-#if DEBUG
-class QLabel;
-#endif
+class QAction;
+class QActionGroup;
+class QTimer;
+class QThreadPool;
+class QEvent;
+class QListView;
+class QLineEdit;
+class QTabBar;
 class Control;
+class HistoryModel;
+class LCDDisplay;
 
 /* Defines */
 
@@ -49,155 +56,41 @@ class Control;
 #define BUTTONS_ROW     6
 /** Number of columns of buttons */
 #define BUTTONS_COL     5
-/** Total number of buttons except hex buttons */
-#define NUM_BUTTONS     30
-#if HEX
-/** Total number of hex buttons */
-#define NUM_HEX_BUTTONS 6
-#endif
-/** Number of digits supported in LCD */
-#define LCD_LENGTH      20
+/** Shortest time between LCD updates in milliseconds, one frame */
+#define LCD_FRAME_TIME  16
+/** Time before the LCD shows a calculation is busy in milliseconds */
+#define LCD_BUSY_DELAY  100
+/** Time between busy LCD updates in milliseconds */
+#define LCD_BUSY_TIME   1000
+/** Event : Background keystroke done */
+#define CONTROL_EVENT_DONE  (QEvent::User + 1)
+/** Queued key : Enter the next queued text */
+#define CONTROL_KEY_TEXT    (-1)
 
-/** Operator : None */
-#define OPERATOR_NONE   0
-/** Operator : '+' */
-#define OPERATOR_PLUS   1
-/** Operator : '-' */
-#define OPERATOR_MINUS  2
-/** Operator : '*' */
-#define OPERATOR_MUL    3
-/** Operator : '/' */
-#define OPERATOR_DIV    4
-/** Operator : 'sqrt' */
-#define OPERATOR_SQRT   5
-/** Operator : '!' */
-#define OPERATOR_FACT   6
-
-/** Last button clicked: Init */
-#define TYPE_INIT       0
-/** Last button clicked: Number */
-#define TYPE_NUM        1
-/** Last button clicked: Operator */
-#define TYPE_OP         2
-/** Last button clicked: Equal-to */
-#define TYPE_EQ         3
-/** Last button clicked: Dot */
-#define TYPE_DOT        4
-/** Last button clicked: Others */
-#define TYPE_OTHER      5
-
-/** Button names */
-const QString buttonLabels[NUM_BUTTONS] = {
-        "7",    "8",   "9",   "/",   "C",
-        "4",    "5",   "6",   "*",   "Sq",
-        "1",    "2",   "3",   "-",   "1/x",
-        "0",    "+/-", ".",   "+",   "=",
-        "MC",   "MR",  "MS",  "M+",  "Bksp",
-        "Sqrt", "!x",  "x^3", "Bin", "Hex" };
-
-#if HEX
-/** Hex button names */
-const QString hexButtonLabels[NUM_HEX_BUTTONS] = {
-        "A", "B", "C", "D", "E", "F" };
-#endif
+/** Style of the calculator, set once for all its widgets */
+#define CALCULATOR_STYLE \
+        "QWidget { background-color: white }" \
+        "QPushButton { color: black; background-color: rgb(215, 215, 215) }"
 
 /** Button shortcuts */
-const QString buttonShotcuts[NUM_BUTTONS] = {
+const char * const buttonShotcuts[] = {
         "7",    "8",   "9",  "/",  "esc",
         "4",    "5",   "6",  "*",  "",
         "1",    "2",   "3",  "-",  "",
         "0",    "", ".",  "+",  "=",
         "",   "",  "", "", "backspace",
-        "", "",  "" };
+        "", "",  "", "", "" };
+
+/** Compile time check : One label and one shortcut per button */
+typedef char buttonTablesCheck[((sizeof(buttonLabels) / sizeof(buttonLabels[0]) == NUM_BUTTONS)
+                                && (sizeof(buttonShotcuts) / sizeof(buttonShotcuts[0]) == NUM_BUTTONS)) ? 1 : -1];
 
 #if HEX
 /* Hex button shortcuts */
-const QString hexButtonShortcuts[NUM_HEX_BUTTONS] = {
+const char * const hexButtonShortcuts[NUM_HEX_BUTTONS] = {
         "a", "b", "c", "d", "e", "f" };
 #endif
 
-/** Button : '7' */
-#define BUTTON_7    0
-/** Button : '8' */
-#define BUTTON_8    1
-/** Button : '9' */
-#define BUTTON_9    2
-/** Button : '/' */
-#define BUTTON_DIV  3
-/** Button : 'C' */
-#define BUTTON_CLR  4
-/** Button : '4' */
-#define BUTTON_4    5
-/** Button : '5' */
-#define BUTTON_5    6
-/** Button : '6' */
-#define BUTTON_6    7
-/** Button : '*' */
-#define BUTTON_MUL  8
-/** Button : 'Sqrt' */
-#define BUTTON_SQ   9
-/** Button : '1' */
-#define BUTTON_1    10
-/** Button : '2' */
-#define BUTTON_2    11
-/** Button : '3' */
-#define BUTTON_3    12
-/** Button : '4' */
-#define BUTTON_NEG  13
-/** Button : '1/x' */
-#define BUTTON_INV  14
-/** Button : '0' */
-#define BUTTON_0    15
-/** Button : '+/-' */
-#define BUTTON_SIGN 16
-/** Button : '.' */
-#define BUTTON_DOT  17
-/** Button : '+' */
-#define BUTTON_PLUS 18
-/** Button : '=' */
-#define BUTTON_EQ   19
-/** Button : 'MC' */
-#define BUTTON_MC   20
-/** Button : 'MR' */
-#define BUTTON_MR   21
-/** Button : 'MS' */
-#define BUTTON_MS   22
-/** Button : 'MP' */
-#define BUTTON_MP   23
-/** Button : 'Bksp' */
-#define BUTTON_BS   24
-/** Button : 'Sqrt' */
-#define BUTTON_SQRT 25
-/** Button : '!x' */
-#define BUTTON_FACT 26
-/** Button : 'x^3' */
-#define BUTTON_CUBE 27
-/** Button : 'Bin' */
-#define BUTTON_BIN  28
-/** Button : 'Hex' */
-#define BUTTON_HEX  29
-
-#if HEX
-/** Hex button : 'A' */
-#define HEX_BUTTON_A    0
-/** Hex button : 'B' */
-#define HEX_BUTTON_B    1
-/** Hex button : 'C' */
-#define HEX_BUTTON_C    2
-/** Hex button : 'D' */
-#define HEX_BUTTON_D    3
-/** Hex button : 'E' */
-#define HEX_BUTTON_E    4
-/** Hex button : 'F' */
-#define HEX_BUTTON_F    5
-#endif
-
-/** Mode status : Decimal */
-#define MODE_DEC    1
-/** Mode status : Binary */
-#define MODE_BIN    2
-/** Mode status : Hexadecimal */
-#define MODE_HEX    3
 
 /** Our main object */
 class Calculator : public QWidget
@@ -213,15 +106,93 @@ public:
 public slots:
     /** Handle button change */
     void buttonChanged(int button, QString text, int mode);
+    /** Show text in LCD */
+    void showLCD(QString text);
+    /** Handle arithmetic change */
+    void arithChanged(QAction *action);
+    /** Show the arithmetic in the menu */
+    void showArith(int mode);
+    /** Paste the clipboard text */
+    void paste(void);
+    /** Show the history panel */
+    void showHistory(void);
+    /** Search the history */
+    void searchHistory(void);
+    /** Enter a result from the history */
+    void replayHistory(const QModelIndex &index);
+    /** Open a new calculator tab */
+    void newTab(void);
+    /** Close a calculator tab */
+    void closeTab(int index);
+    /** Close the calculator tab shown */
+    void closeCurrentTab(void);
+    /** Show a calculator tab */
+    void switchTab(int index);
+    /** Start or stop the summary */
+    void summaryChanged(bool status);
+    /** Show the summary */
+    void showSummary(void);
+#if STATS
+    /** Dump the engine statistics */
+    void dumpStats(void);
+#endif
+
+signals:
+    /** Signal the window was painted for the first time */
+    void painted(void);
+
+protected:
+    /** Paint the window */
+    void paintEvent(QPaintEvent *event);
 
 private:
     /** Control unit */
     class Control *control;
-    /** LCD Number */
-    QLCDNumber *lcd;
-#if DEBUG
-    /** Label */
-    QLabel *label;
+    /** The window was painted */
+    bool isPainted;
+    /** Tab bar, shown with more than one tab */
+    QTabBar *tabBar;
+    /** Number of the last tab opened, it names the tab */
+    int lastTabNumber;
+    /** LCD display */
+    LCDDisplay *lcd;
+    /** Arithmetic action group */
+    QActionGroup *arithGroup;
+    /** Action : Double precision */
+    QAction *doubleAction;
+    /** Action : Arbitrary precision */
+    QAction *bigAction;
+    /** Action : Decimal */
+    QAction *decimalAction;
+    /** Action : 64-bit integer */
+    QAction *integerAction;
+    /** Action : Paste */
+    QAction *pasteAction;
+    /** Action : Undo */
+    QAction *undoAction;
+    /** Action : Redo */
+    QAction *redoAction;
+    /** Action : History */
+    QAction *historyAction;
+    /** Action : New tab */
+    QAction *newTabAction;
+    /** Action : Close tab */
+    QAction *closeTabAction;
+    /** Action : Summary mode */
+    QAction *summaryAction;
+    /** Action : Show summary */
+    QAction *showSummaryAction;
+    /** History panel, built when first shown */
+    QWidget *historyPanel;
+    /** History search text */
+    QLineEdit *historySearch;
+    /** History list */
+    QListView *historyView;
+    /** History list model */
+    HistoryModel *historyModel;
+#if STATS
+    /** Action : Dump statistics */
+    QAction *statsAction;
 #endif
     /** Button group */
     QButtonGroup *buttonGroup;
@@ -235,62 +206,63 @@ private:
 #endif
     /** Main layout */
     QVBoxLayout *mainLayout;
+#if HEX
+    /** Create the hex buttons when first needed */
+    void createHexButtons(void);
+#endif
 };
 
-/** Our controller unit object */
-class Control : public QWidget
+/** State of a calculator tab, all a tab keeps while not shown */
+struct ControlTab
+{
+    /** Engine state */
+    EngineState state;
+    /** Undo history */
+    UndoHistory history;
+};
+
+/**
+ *  Our controller unit object, connects the engine with the widgets.
+ *
+ *  All the tabs share the one engine, thread pool and widgets. The tab
+ *  shown lives in the engine, the others are kept as their state alone
+ *  and are swapped in when shown.
+ */
+class Control : public QObject, public EngineListener
 {
     Q_OBJECT
 
 public:
     /** Constructor */
-    Control(QWidget *parent = 0);
+    Control(QObject *parent = 0);
     /** Destructor */
     ~Control();
-    /** Get the current set text */
-    QString getText(void);
-    /** Set the current text */
-    void setText(QString);
-    /** Get the text set in memory */
-    QString getMemoryText(void);
-    /** Set the text in memory */
-    void setMemoryText(QString);
-    /** Get the operand text */
-    QString getOperand1(void);
-    /** Set the operand text */
-    void setOperand1(QString);
-    /** Get the last set operator */
-    int getOperator(void);
-    /** Set the operator */
-    void setOperator(int);
-    /** Get the decimal status */
-    bool getDecimalStatus(void);
-    /** Set the decimal status */
-    void setDecimalStatus(bool);
-    /** Get the negative sign status */
-    bool getNegativeStatus(void);
-    /** Set the negative sign status */
-    void setNegativeStatus(bool);
-    /** Get the last clicked button type */
-    int getLastClicked(void);
-    /** Set the last clicked button type */
-    void setLastClicked(int);
-    /** Get 'Bin' button status */
-    int getBinButtonStatus(void);
-    /** Set 'Bin' button status */
-    void setBinButtonStatus(int, int);
-    /** Get 'Hex' button status */
-    int getHexButtonStatus(void);
-    /** Set 'Hex' button status */
-    void setHexButtonStatus(int, int);
-    /** Get number of digits in LCD */
-    int getNumDigits(void);
-    /** Save number of digits in LCD */
-    void setNumDigits(int);
-    /** Update LCD */
-    void updateLCD(void);
-    /** Make calculation */
-    QString calculate(QString, QString, int);
+    /** Get the engine */
+    Engine *getEngine(void);
+    /** Engine listener : LCD text changed */
+    void lcdChanged(const QString &text);
+    /** Engine listener : Button name changed */
+    void buttonChanged(int button, const QString &text, int oldStatus);
+    /** Engine listener : Arithmetic changed */
+    void arithChanged(int mode);
+    /** Check for a calculation in the background */
+    bool isBusy(void);
+    /** Drop the calculation in the background */
+    void cancel(void);
+    /** Keep the state for undo */
+    void record(void);
+    /** Enter a number or expression, after the background keystroke */
+    void enterText(const QString &text);
+    /** Get the calculation history */
+    HistoryLog *getHistory(void);
+    /** Add a tab in init status */
+    int addTab(void);
+    /** Remove a tab */
+    void removeTab(int index);
+    /** Show a tab in the engine */
+    void switchTab(int index);
+    /** Get the tab shown */
+    int getCurrentTab(void);
 
 public slots:
     /** Capture button press */
@@ -299,36 +271,106 @@ public slots:
     /** Capture hex button press */
     void hexButtonPressed(int index);
 #endif
+    /** Show the latest LCD text */
+    void flushLCD(void);
+    /** Show the calculation is busy */
+    void showBusy(void);
+    /** Undo the last keystroke */
+    void undo(void);
+    /** Redo the last undone keystroke */
+    void redo(void);
 
 signals:
     /** Signal LCD change */
     void setLCD(QString text);
     /** Signal button name change */
     void setButton(int button, QString text, int oldStatus);
+    /** Signal arithmetic change */
+    void setArith(int mode);
+
+protected:
+    /** Take the engine back from the background */
+    void customEvent(QEvent *event);
+
+private:
+    /** Calculator engine */
+    Engine engine;
+    /** Undo history */
+    UndoHistory history;
+    /** Tabs, the one shown is out of date */
+    QList<ControlTab *> tabs;
+    /** Tab shown */
+    int currentTab;
+    /** State of a new tab */
+    EngineState initState;
+    /** Calculation history, the tape */
+    HistoryLog tape;
+    /** Worker threads for slow keystrokes */
+    QThreadPool *pool;
+    /** Number of the keystroke in the background, 0 if none */
+    int busyTask;
+    /** Number of the last keystroke sent to the background */
+    int lastTask;
+    /** Number of the keystroke the workers may go on with, 0 stops them */
+    QAtomicInt runningTask;
+    /** Keys pressed while busy, hex keys follow the buttons */
+    QList<int> queuedKeys;
+    /** Texts entered while busy, one for each CONTROL_KEY_TEXT */
+    QList<QString> queuedTexts;
+    /** Time the keystroke went to the background */
+    QTime busyTime;
+    /** Timer for the busy LCD */
+    QTimer *busyTimer;
+    /** Press a key, in the background if it may take long */
+    void pressKey(int key);
+    /** Latest LCD text */
+    QString pendingText;
+    /** LCD text last signalled */
+    QString shownText;
+    /** Time the LCD text was last signalled */
+    QTime shownTime;
+    /** Timer for the LCD text held back */
+    QTimer *lcdTimer;
+#if STATS
+    /** Engine statistics */
+    EngineStats stats;
+#endif
+};
+
+/**
+ *  List model of the calculation history.
+ *
+ *  Rows are formatted only when the view asks for them, so the view
+ *  scrolls through millions of records as fast as through a few. A
+ *  filter shows the records found by a search instead of all of them.
+ */
+class HistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    /** Constructor */
+    HistoryModel(HistoryLog *log, QObject *parent = 0);
+    /** Get the number of rows */
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    /** Get the text of a row */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    /** Get the record of a row */
+    const HistoryRecord *getRecord(int row) const;
+    /** Show the records appended since */
+    void refresh(void);
+    /** Show the records with a value, a range 'low..high', or all of them */
+    bool setFilter(const QString &text);
 
 private:
-    /** LCD text */
-    QString lcdText;
-    /** Operand */
-    QString operand1;
-    /** Memory text */
-    QString memoryText;
-    /** Last operator */
-    int lastOperator;
-    /** Last clicked button type */
-    int lastClicked;
-    /** Decimal status */
-    bool isDecimalEnabled;
-    /** Negative sign status */
-    bool isNegativeEnabled;
-    /** 'Bin' button status */
-    int binButtonStatus;
-    /** 'Hex' button status */
-    int hexButtonStatus;
-    /** Number of digits in LCD */
-    int numLCDDigits;
-    /** Show error function */
-    void showError(void);
+    /** Calculation history */
+    HistoryLog *log;
+    /** Number of records shown without a filter */
+    int shown;
+    /** Filter status */
+    bool isFiltered;
+    /** Record numbers found by the filter */
+    QVector<int> found;
 };
 
 #endif // CALCULATOR_H
@@ -0,0 +1,1372 @@
+/** @file check.cpp
+ *
+ *  @brief This file contains the consistency checks of the calculator engine
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "accumulator.h"
+#include "bignum.h"
+#include "decimal.h"
+#include "engine.h"
+#include "expression.h"
+#include "format.h"
+#include "history.h"
+#include "integer.h"
+#include "parse.h"
+#include "server.h"
+#include "sessions.h"
+#include "undo.h"
+#include "vectorcalc.h"
+
+/* Defines */
+
+/** Default number of random cases per check */
+#define CHECK_COUNT         1000000
+/** Number of sessions run side by side with engines */
+#define CHECK_SESSIONS      64
+/** Deepest nesting of a random expression */
+#define CHECK_EXPRESSION_DEPTH  6
+/** Largest array calculated at once */
+#define CHECK_VECTOR_SIZE   100
+/** Digits of the arbitrary precision calculations on integers, all exact */
+#define CHECK_BIG_DIGITS    60
+/** Undo steps taken before the undo check starts over */
+#define CHECK_UNDO_RUN      1000
+/** Searches of the history check */
+#define CHECK_HISTORY_SEARCHES  100
+/** Requests sent to the server at once */
+#define CHECK_SERVER_BATCH  1000
+/** Most values added at once to an accumulator */
+#define CHECK_ACCUMULATOR_SIZE  5000
+/** Lines of a stream of numbers */
+#define CHECK_ACCUMULATOR_LINES 10000
+/** Relative tolerance of the statistics */
+#define CHECK_TOLERANCE     1e-12
+/** Most failures reported per check */
+#define CHECK_MAX_REPORTS   10
+/** Size of a test text */
+#define CHECK_TEXT_SIZE     64
+
+/** One check */
+struct CheckCase
+{
+    /** Name */
+    const char *name;
+    /** Run the check on a number of random cases, return the number of failures */
+    long (*function)(long count);
+};
+
+/** One decimal calculation with its expected result */
+struct DecimalVector
+{
+    /** Operand 1 */
+    const char *operand1;
+    /** Operator */
+    int op;
+    /** Operand 2 */
+    const char *operand2;
+    /** Result text, 0 for an error */
+    const char *result;
+};
+
+/** Decimal calculations, results from a 34 digit reference with rounding half to even */
+static const DecimalVector decimalVectors[] = {
+    { "0.1",    OPERATOR_PLUS,  "0.2",      "0.3" },
+    { "1",      OPERATOR_MINUS, "0.0001",   "0.9999" },
+    { "0.5",    OPERATOR_MINUS, "0.5",      "0" },
+    { "1.10",   OPERATOR_MUL,   "2.20",     "2.42" },
+    { "-7",     OPERATOR_DIV,   "2",        "-3.5" },
+    { "1",      OPERATOR_DIV,   "3",        "0.3333333333333333333333333333333333" },
+    { "2",      OPERATOR_DIV,   "3",        "0.6666666666666666666666666666666667" },
+    { "2",      OPERATOR_SQRT,  "2",        "1.414213562373095048801688724209698" },
+    { "12",     OPERATOR_FACT,  "12",       "479001600" },
+    { "9999999999999999999999999999999999", OPERATOR_PLUS, "1", "1e34" },
+    { "1",      OPERATOR_PLUS,  "5e-34",    "1" },
+    { "1",      OPERATOR_PLUS,  "1.5e-33",  "1.000000000000000000000000000000002" },
+    { "123456789012345678901234567890", OPERATOR_MUL, "1e-5", "1234567890123456789012345.6789" },
+    { "1",      OPERATOR_DIV,   "0",        0 },
+    { "-4",     OPERATOR_SQRT,  "-4",       0 }
+};
+
+/** One arbitrary precision calculation with its expected result */
+struct BigVector
+{
+    /** Operand 1 */
+    const char *operand1;
+    /** Operator */
+    int op;
+    /** Operand 2 */
+    const char *operand2;
+    /** Significant digits */
+    int digits;
+    /** Result text, 0 for an error */
+    const char *result;
+};
+
+/** Arbitrary precision calculations, results from a reference with rounding half to even */
+static const BigVector bigVectors[] = {
+    { "1",      OPERATOR_DIV,   "3",        40, "0.3333333333333333333333333333333333333333" },
+    { "2",      OPERATOR_DIV,   "3",        40, "0.6666666666666666666666666666666666666667" },
+    { "2",      OPERATOR_DIV,   "3",        5,  "0.66667" },
+    { "1",      OPERATOR_DIV,   "7",        30, "0.142857142857142857142857142857" },
+    { "-7",     OPERATOR_DIV,   "2",        10, "-3.5" },
+    { "2",      OPERATOR_SQRT,  "2",        50, "1.4142135623730950488016887242096980785696718753769" },
+    { "10",     OPERATOR_SQRT,  "10",       30, "3.16227766016837933199889354443" },
+    { "0.1",    OPERATOR_PLUS,  "0.2",      40, "0.3" },
+    { "1e-30",  OPERATOR_PLUS,  "1",        40, "1.000000000000000000000000000001" },
+    { "1",      OPERATOR_MINUS, "1e-50",    40, "1" },
+    { "1",      OPERATOR_MINUS, "1e-50",    60, "0.99999999999999999999999999999999999999999999999999" },
+    { "123456789012345678901234567890", OPERATOR_MUL, "987654321098765432109876543210", 70,
+      "121932631137021795226185032733622923332237463801111263526900" },
+    { "30",     OPERATOR_FACT,  "30",       40, "265252859812191058636308480000000" },
+    { "100",    OPERATOR_FACT,  "100",      200,
+      "93326215443944152681699238856266700490715968264381621468592963895217599993229915608941463976156518286253697920827223758251185210916864000000000000000000000000" },
+    { "2.5",    OPERATOR_FACT,  "2.5",      40, 0 },
+    { "-3",     OPERATOR_FACT,  "-3",       40, 0 },
+    { "1",      OPERATOR_DIV,   "0",        40, 0 },
+    { "-4",     OPERATOR_SQRT,  "-4",       40, 0 }
+};
+
+/** Keys pressed at random in the session check, digits more often */
+static const int sessionKeys[] = {
+    BUTTON_0, BUTTON_1, BUTTON_2, BUTTON_3, BUTTON_4, BUTTON_5, BUTTON_6, BUTTON_7, BUTTON_8, BUTTON_9,
+    BUTTON_0, BUTTON_9, BUTTON_1, BUTTON_DOT, BUTTON_SIGN, BUTTON_PLUS, BUTTON_NEG, BUTTON_MUL, BUTTON_DIV,
+    BUTTON_EQ, BUTTON_SQ, BUTTON_SQRT, BUTTON_FACT, BUTTON_INV, BUTTON_CUBE, BUTTON_MC, BUTTON_MR,
+    BUTTON_MS, BUTTON_MP, BUTTON_BS, BUTTON_CLR, BUTTON_MUL, BUTTON_EQ, BUTTON_SQ, BUTTON_PLUS, BUTTON_DOT };
+
+/** State of the random numbers, the same cases on every run */
+static quint64 randomState = 0x9e3779b97f4a7c15ULL;
+
+/**
+ *  @brief  Get a random number, xorshift64*
+ *
+ *  @return Random 64 bits
+ */
+static quint64 random64(void)
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ *  @brief  Get a random double, any bit pattern but not a number
+ *
+ *  @return Random double
+ */
+static double randomDouble(void)
+{
+    quint64 bits;
+    double value;
+
+    do {
+        bits = random64();
+        memcpy(&value, &bits, sizeof(value));
+    } while (isnan(value));
+    return value;
+}
+
+/**
+ *  @brief  Check two doubles are the same, signs of zero included
+ *
+ *  @param  a   Value
+ *  @param  b   Value
+ *
+ *  @return true if the same
+ */
+static bool isSame(double a, double b)
+{
+    return (isnan(a) && isnan(b)) || ((a == b) && (signbit(a) == signbit(b)));
+}
+
+/**
+ *  @brief  Report a failure, only the first few are printed
+ *
+ *  @param  failures    Failures so far, incremented
+ *  @param  name        Check name
+ *  @param  text        Failing case
+ *
+ *  @return N/A
+ */
+static void fail(long *failures, const char *name, const char *text)
+{
+    if (++*failures <= CHECK_MAX_REPORTS) {
+        fprintf(stderr, "%s: %s\n", name, text);
+    }
+    return;
+}
+
+/**
+ *  @brief  Parse texts of random doubles and random digits, as strtod() does
+ *
+ *  @param  count   Number of texts
+ *
+ *  @return Number of failures
+ */
+static long checkParse(long count)
+{
+    char text[CHECK_TEXT_SIZE];
+    char report[2 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (long i = 0; i < count; i++) {
+        int length;
+        if (i % 3 == 0) {
+            /* Round trip digits */
+            length = snprintf(text, sizeof(text), "%.17g", randomDouble());
+        } else if (i % 3 == 1) {
+            /* Rounded to any number of digits */
+            length = snprintf(text, sizeof(text), "%.*e", (int) (random64() % 25), randomDouble());
+        } else {
+            /* Long digit strings, halfway cases among them */
+            int digits = 1 + (int) (random64() % 40);
+            int point = (int) (random64() % (digits + 1));
+            length = 0;
+            for (int j = 0; j < digits; j++) {
+                if (j == point) {
+                    text[length++] = '.';
+                }
+                text[length++] = (char) ('0' + random64() % 10);
+            }
+            length += snprintf(text + length, sizeof(text) - length, "e%d", (int) (random64() % 700) - 350);
+        }
+
+        bool ok = false;
+        double value = Parse::toDouble(text, length, &ok);
+        if (!ok || !isSame(value, strtod(text, 0))) {
+            snprintf(report, sizeof(report), "'%s' parsed as %.17g", text, value);
+            fail(&failures, "parse", report);
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Format random doubles, check they parse back with the fewest digits
+ *
+ *  Texts rounded to fit the LCD do not parse back, they must be the
+ *  value correctly rounded to their digits.
+ *
+ *  @param  count   Number of doubles
+ *
+ *  @return Number of failures
+ */
+static long checkFormat(long count)
+{
+    char buffer[FORMAT_SIZE];
+    char text[CHECK_TEXT_SIZE];
+    char report[2 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (long i = 0; i < count; i++) {
+        double value = randomDouble();
+        if (i % 2 == 0) {
+            /* Values typed on a calculator */
+            value = (double) ((qint64) (random64() % 2000000000) - 1000000000) / (double) (1 + random64() % 100000);
+        }
+        int length = Format::toText(value, buffer);
+        if ((length > LCD_LENGTH) || (length != (int) strlen(buffer))) {
+            snprintf(report, sizeof(report), "%.17g formatted as '%s', too long", value, buffer);
+            fail(&failures, "format", report);
+            continue;
+        }
+        if (isinf(value) || (value == 0)) {
+            continue;
+        }
+
+        /* Significant digits shown, trailing zeros of whole numbers do not count */
+        int digits = 0, shown = 0;
+        for (const char *t = buffer; (*t != '\0') && (*t != 'e'); t++) {
+            if ((*t >= '1') && (*t <= '9')) {
+                shown = digits + 1;
+            }
+            if ((*t >= '0') && (*t <= '9') && ((digits > 0) || (*t != '0'))) {
+                digits++;
+            }
+        }
+
+        /* The value correctly rounded to the digits shown */
+        double back = strtod(buffer, 0);
+        snprintf(text, sizeof(text), "%.*e", shown - 1, value);
+        if (!isSame(back, strtod(text, 0))) {
+            snprintf(report, sizeof(report), "%.17g formatted as '%s', badly rounded", value, buffer);
+            fail(&failures, "format", report);
+            continue;
+        }
+
+        /* Parsing back with no fewer digits doing it, unless rounded to fit */
+        if (isSame(back, value) && (shown > 1)) {
+            snprintf(text, sizeof(text), "%.*e", shown - 2, value);
+            if (strtod(text, 0) == value) {
+                snprintf(report, sizeof(report), "%.17g formatted as '%s', '%s' is shorter", value, buffer, text);
+                fail(&failures, "format", report);
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Check the decimal calculations against the fixed vectors
+ *
+ *  @param  count   Not used, the vectors are fixed
+ *
+ *  @return Number of failures
+ */
+static long checkDecimal(long count)
+{
+    char report[4 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    (void) count;
+    for (int i = 0; i < (int) (sizeof(decimalVectors) / sizeof(decimalVectors[0])); i++) {
+        const DecimalVector &vector = decimalVectors[i];
+        bool error = false;
+        Decimal result = Decimal::calculate(Decimal::fromString(vector.operand1, 0),
+                                            Decimal::fromString(vector.operand2, 0), vector.op, &error);
+        QByteArray text = result.toString().toLatin1();
+        if ((vector.result == 0) ? !error : (error || (strcmp(text.constData(), vector.result) != 0))) {
+            snprintf(report, sizeof(report), "%s op %d %s gave '%s'%s, expected '%s'", vector.operand1, vector.op,
+                     vector.operand2, text.constData(), error ? " with an error" : "",
+                     (vector.result == 0) ? "an error" : vector.result);
+            fail(&failures, "decimal", report);
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Press random keys in sessions and engines side by side
+ *
+ *  Each key goes to all sessions or to a range of them, the shown texts,
+ *  values and memories must stay those of the engines.
+ *
+ *  @param  count   Number of session keystrokes
+ *
+ *  @return Number of failures
+ */
+static long checkSessions(long count)
+{
+    Engine engines[CHECK_SESSIONS];
+    SessionStore sessions;
+    char report[4 * CHECK_TEXT_SIZE];
+    int numKeys = sizeof(sessionKeys) / sizeof(sessionKeys[0]);
+    long failures = 0;
+
+    sessions.setCount(CHECK_SESSIONS);
+    for (long step = 0; step < count / CHECK_SESSIONS; step++) {
+        int key = sessionKeys[random64() % numKeys];
+        int first = 0, number = CHECK_SESSIONS;
+        if (random64() % 2) {
+            first = (int) (random64() % CHECK_SESSIONS);
+            number = 1 + (int) (random64() % (CHECK_SESSIONS - first));
+        }
+        sessions.press(key, first, number);
+        for (int i = first; i < first + number; i++) {
+            engines[i].buttonPressed(key);
+        }
+
+        for (int i = 0; i < CHECK_SESSIONS; i++) {
+            /* Sessions keep shorter texts than the engine, start over past them */
+            if ((engines[i].getDisplayText().length() >= SESSION_TEXT_SIZE) ||
+                (engines[i].getText().length() >= SESSION_TEXT_SIZE)) {
+                engines[i].reset();
+                sessions.reset(i, 1);
+                continue;
+            }
+            QByteArray text = sessions.getDisplayText(i).toLatin1();
+            QByteArray expected = engines[i].getDisplayText().toLatin1();
+            if ((strcmp(text.constData(), expected.constData()) != 0) || !isSame(sessions.getValue(i), engines[i].getRegister(REG_LCD)) ||
+                !isSame(sessions.getMemory(i), engines[i].getRegister(REG_MEMORY))) {
+                snprintf(report, sizeof(report), "step %ld key %d session %d shows '%s', the engine '%s'",
+                         step, key, i, text.constData(), expected.constData());
+                fail(&failures, "sessions", report);
+                /* Go on from the same state */
+                engines[i].reset();
+                sessions.reset(i, 1);
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Make a random expression and calculate it the way the engine does
+ *
+ *  @param  depth   Levels of operators left
+ *  @param  memory  Memory value
+ *  @param  text    Expression text, appended to
+ *  @param  error   Set to true if a calculation fails
+ *
+ *  @return Value, as Engine::compute() gives it
+ */
+static double randomExpression(int depth, double memory, QString *text, bool *error)
+{
+    static const char * const binaries = "?+-*/";
+    int kind = (depth == 0) ? (int) (random64() % 2) : (int) (random64() % 9);
+    double x, y;
+
+    switch (kind) {
+        case 0:
+            /* Constant, round trip digits */
+            x = (double) ((qint64) (random64() % 2000000) - 1000000) / (double) (1 + random64() % 1000);
+            text->append(QString::number(fabs(x), 'g', 17));
+            return fabs(x);
+        case 1:
+            /* Memory */
+            text->append("M");
+            return memory;
+        case 2:
+        case 3:
+        case 4:
+        case 5: {
+            /* Binary operator, in parentheses */
+            int op = OPERATOR_PLUS + kind - 2;
+            text->append("(");
+            x = randomExpression(depth - 1, memory, text, error);
+            text->append(" ");
+            text->append(QChar(binaries[op]));
+            text->append(" ");
+            y = randomExpression(depth - 1, memory, text, error);
+            text->append(")");
+            return Engine::compute(x, y, op, error);
+        }
+        case 6:
+            /* Negation */
+            text->append("-(");
+            x = randomExpression(depth - 1, memory, text, error);
+            text->append(")");
+            return -x;
+        case 7:
+            /* Prefix unary operator */
+            switch (random64() % 4) {
+                case 0:
+                    text->append("sqrt(");
+                    x = randomExpression(depth - 1, memory, text, error);
+                    text->append(")");
+                    return Engine::compute(x, x, OPERATOR_SQRT, error);
+                case 1:
+                    text->append("sq(");
+                    x = randomExpression(depth - 1, memory, text, error);
+                    text->append(")");
+                    return Engine::compute(x, x, OPERATOR_MUL, error);
+                case 2:
+                    text->append("cube(");
+                    x = randomExpression(depth - 1, memory, text, error);
+                    text->append(")");
+                    return Engine::compute(Engine::compute(x, x, OPERATOR_MUL, error), x, OPERATOR_MUL, error);
+                default:
+                    text->append("inv(");
+                    x = randomExpression(depth - 1, memory, text, error);
+                    text->append(")");
+                    return Engine::compute(1, x, OPERATOR_DIV, error);
+            }
+        default:
+            /* Postfix unary operator */
+            text->append("(");
+            x = randomExpression(depth - 1, memory, text, error);
+            if (random64() % 2) {
+                text->append(")^3");
+                return Engine::compute(Engine::compute(x, x, OPERATOR_MUL, error), x, OPERATOR_MUL, error);
+            }
+            text->append(")!");
+            return Engine::compute(x, x, OPERATOR_FACT, error);
+    }
+}
+
+/**
+ *  @brief  Compile random expressions, folded and not, and check their values
+ *
+ *  The values must be those of the same calculations made one by one
+ *  with Engine::compute(), errors included.
+ *
+ *  @param  count   Number of expressions
+ *
+ *  @return Number of failures
+ */
+static long checkExpressions(long count)
+{
+    char report[8 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (long i = 0; i < count; i++) {
+        QString text;
+        bool expectedError = false;
+        double memory = randomDouble();
+        double expected = randomExpression(1 + (int) (random64() % CHECK_EXPRESSION_DEPTH), memory, &text,
+                                           &expectedError);
+        QByteArray latin = text.toLatin1();
+
+        for (int fold = 0; fold < 2; fold++) {
+            Expression expression;
+            bool error = false;
+            if (!expression.compile(text, fold != 0)) {
+                snprintf(report, sizeof(report), "'%.200s' does not compile: %s", latin.constData(),
+                         expression.getError().toLatin1().constData());
+                fail(&failures, "expressions", report);
+                break;
+            }
+            double value = expression.evaluate(memory, &error);
+            if ((error != expectedError) || (!error && !isSame(value, expected))) {
+                snprintf(report, sizeof(report), "'%.200s' with M = %.17g%s gave %.17g%s, expected %.17g%s",
+                         latin.constData(), memory, fold ? " folded" : "", value, error ? " with an error" : "",
+                         expected, expectedError ? " with an error" : "");
+                fail(&failures, "expressions", report);
+                break;
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Calculate random arrays with each kernel, element by element as the engine does
+ *
+ *  Arrays of any length start anywhere, so the kernels run their blocks
+ *  unaligned and their left over elements too. Some operands are zero
+ *  and some are negative, for the errors and the square roots.
+ *
+ *  @param  count   Number of elements per kernel
+ *
+ *  @return Number of failures
+ */
+static long checkVectors(long count)
+{
+    double op1[CHECK_VECTOR_SIZE + 8], op2[CHECK_VECTOR_SIZE + 8], result[CHECK_VECTOR_SIZE + 8];
+    unsigned char errors[(CHECK_VECTOR_SIZE + 7) / 8];
+    char report[4 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (int kernel = VECTOR_KERNEL_SCALAR; kernel <= VECTOR_KERNEL_AVX512; kernel++) {
+        /* Kernels the CPU lacks fall back, they are checked once */
+        if (VectorCalc::setKernel(kernel) != kernel) {
+            continue;
+        }
+        for (long done = 0; done < count; ) {
+            int op = OPERATOR_PLUS + (int) (random64() % (OPERATOR_FACT - OPERATOR_PLUS + 1));
+            int length = 1 + (int) (random64() % CHECK_VECTOR_SIZE);
+            int start = (int) (random64() % 8);
+            for (int i = start; i < start + length; i++) {
+                op1[i] = (random64() % 16 == 0) ? 0 : (double) ((qint64) (random64() % 2000001) - 1000000) / 1000;
+                op2[i] = (random64() % 16 == 0) ? 0 : randomDouble();
+            }
+
+            VectorCalc::calculate(op, op1 + start, op2 + start, result + start, errors, length);
+            for (int i = 0; i < length; i++) {
+                bool error = false;
+                double expected = Engine::compute(op1[start + i], op2[start + i], op, &error);
+                bool isError = (errors[i >> 3] & (1 << (i & 7))) != 0;
+                if ((isError != error) || !isSame(result[start + i], error ? 0 : expected)) {
+                    snprintf(report, sizeof(report), "%s kernel %.17g op %d %.17g gave %.17g%s, expected %.17g%s",
+                             VectorCalc::getKernelName(), op1[start + i], op, op2[start + i], result[start + i],
+                             isError ? " with an error" : "", expected, error ? " with an error" : "");
+                    fail(&failures, "vectors", report);
+                }
+            }
+            done += length;
+        }
+    }
+
+    /* Back to the best kernel */
+    VectorCalc::setKernel(VECTOR_KERNEL_AVX512);
+    return failures;
+}
+
+/**
+ *  @brief  Get the text of a 128-bit integer
+ *
+ *  @param  magnitude   Magnitude
+ *  @param  negative    Sign
+ *  @param  text        Set to the text, CHECK_TEXT_SIZE bytes
+ *
+ *  @return N/A
+ */
+static void integerText(quint128 magnitude, bool negative, char *text)
+{
+    char digits[CHECK_TEXT_SIZE];
+    int length = 0;
+
+    /* Digits from the lowest */
+    do {
+        digits[length++] = (char) ('0' + (int) (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (negative) {
+        *text++ = '-';
+    }
+    while (length > 0) {
+        *text++ = digits[--length];
+    }
+    *text = '\0';
+    return;
+}
+
+/**
+ *  @brief  Check the arbitrary precision arithmetic against fixed results and exact integers
+ *
+ *  Sums, differences and products of random 64-bit integers are exact
+ *  with enough digits, as are the quotients and square roots that undo
+ *  them.
+ *
+ *  @param  count   Number of random integer pairs
+ *
+ *  @return Number of failures
+ */
+static long checkBig(long count)
+{
+    char report[8 * CHECK_TEXT_SIZE];
+    char expected[CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    /* Fixed results */
+    for (int i = 0; i < (int) (sizeof(bigVectors) / sizeof(bigVectors[0])); i++) {
+        const BigVector &vector = bigVectors[i];
+        bool error = false;
+        BigFloat result = BigFloat::calculate(BigFloat::fromString(vector.operand1, 0),
+                                              BigFloat::fromString(vector.operand2, 0), vector.op, vector.digits,
+                                              &error);
+        QByteArray text = result.toString(vector.digits).toLatin1();
+        if ((vector.result == 0) ? !error : (error || (strcmp(text.constData(), vector.result) != 0))) {
+            snprintf(report, sizeof(report), "%s op %d %s gave '%.200s'%s, expected '%.200s'", vector.operand1,
+                     vector.op, vector.operand2, text.constData(), error ? " with an error" : "",
+                     (vector.result == 0) ? "an error" : vector.result);
+            fail(&failures, "big", report);
+        }
+    }
+
+    /* Random integers of any size */
+    for (long i = 0; i < count / 4; i++) {
+        qint64 a = (qint64) random64() >> (random64() % 64);
+        qint64 b = (qint64) random64() >> (random64() % 64);
+        bool error = false;
+        char textA[CHECK_TEXT_SIZE], textB[CHECK_TEXT_SIZE];
+        snprintf(textA, sizeof(textA), "%lld", (long long) a);
+        snprintf(textB, sizeof(textB), "%lld", (long long) b);
+        BigFloat bigA = BigFloat::fromString(textA, 0);
+        BigFloat bigB = BigFloat::fromString(textB, 0);
+
+        /* Product, exact */
+        BigFloat product = BigFloat::calculate(bigA, bigB, OPERATOR_MUL, CHECK_BIG_DIGITS, &error);
+        quint128 magnitude = (quint128) (a < 0 ? -(quint128) a : (quint128) a) *
+                             (quint128) (b < 0 ? -(quint128) b : (quint128) b);
+        integerText(magnitude, (magnitude != 0) && ((a < 0) != (b < 0)), expected);
+        QByteArray text = product.toString(CHECK_BIG_DIGITS).toLatin1();
+        if (strcmp(text.constData(), expected) != 0) {
+            snprintf(report, sizeof(report), "%s * %s gave '%s', expected '%s'", textA, textB, text.constData(),
+                     expected);
+            fail(&failures, "big", report);
+        }
+
+        /* Sum and difference undone */
+        BigFloat sum = BigFloat::calculate(bigA, bigB, OPERATOR_PLUS, CHECK_BIG_DIGITS, &error);
+        BigFloat difference = BigFloat::calculate(sum, bigB, OPERATOR_MINUS, CHECK_BIG_DIGITS, &error);
+        text = difference.toString(CHECK_BIG_DIGITS).toLatin1();
+        if (strcmp(text.constData(), textA) != 0) {
+            snprintf(report, sizeof(report), "%s + %s - %s gave '%s'", textA, textB, textB, text.constData());
+            fail(&failures, "big", report);
+        }
+
+        /* Product undone by a quotient */
+        if (b != 0) {
+            BigFloat quotient = BigFloat::calculate(product, bigB, OPERATOR_DIV, CHECK_BIG_DIGITS, &error);
+            text = quotient.toString(CHECK_BIG_DIGITS).toLatin1();
+            if (error || (strcmp(text.constData(), textA) != 0)) {
+                snprintf(report, sizeof(report), "%s * %s / %s gave '%s'", textA, textB, textB, text.constData());
+                fail(&failures, "big", report);
+            }
+        }
+
+        /* Square undone by a square root */
+        BigFloat square = BigFloat::calculate(bigA, bigA, OPERATOR_MUL, CHECK_BIG_DIGITS, &error);
+        BigFloat root = BigFloat::calculate(square, square, OPERATOR_SQRT, CHECK_BIG_DIGITS, &error);
+        text = root.toString(CHECK_BIG_DIGITS).toLatin1();
+        snprintf(expected, sizeof(expected), "%s", textA + ((a < 0) ? 1 : 0));
+        if (error || (strcmp(text.constData(), expected) != 0)) {
+            snprintf(report, sizeof(report), "sqrt(%s ^ 2) gave '%s'", textA, text.constData());
+            fail(&failures, "big", report);
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Check the 64-bit integers against 128-bit arithmetic and the C library texts
+ *
+ *  Results must be the low 64 bits of the exact ones, texts must be
+ *  those of printf() and parse back in their base.
+ *
+ *  @param  count   Number of random integer pairs
+ *
+ *  @return Number of failures
+ */
+static long checkInteger(long count)
+{
+    static const int bases[] = { 2, 10, 16 };
+    char report[4 * CHECK_TEXT_SIZE];
+    char expected[2 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (long i = 0; i < count; i++) {
+        qint64 a = (qint64) random64() >> (random64() % 64);
+        qint64 b = (qint64) random64() >> (random64() % 64);
+        int op = OPERATOR_PLUS + (int) (i % (OPERATOR_FACT - OPERATOR_PLUS + 1));
+        bool error = false, expectedError = false;
+        qint64 result = 0;
+
+        /* The exact result, wrapped to 64 bits */
+        __int128 wide = 0;
+        switch (op) {
+            case OPERATOR_PLUS:
+                wide = (__int128) a + b;
+                break;
+            case OPERATOR_MINUS:
+                wide = (__int128) a - b;
+                break;
+            case OPERATOR_MUL:
+                wide = (__int128) a * b;
+                break;
+            case OPERATOR_DIV:
+                expectedError = (b == 0);
+                wide = expectedError ? 0 : (__int128) a / b;
+                break;
+            case OPERATOR_SQRT:
+                /* Rounded down */
+                expectedError = (a < 0);
+                if (!expectedError) {
+                    wide = (__int128) sqrtl((long double) a);
+                    while (wide * wide > a) {
+                        wide--;
+                    }
+                    while ((wide + 1) * (wide + 1) <= a) {
+                        wide++;
+                    }
+                }
+                break;
+            default:
+                /* Factorials of small values, the others are errors */
+                a = (qint64) (random64() % 24) - 1;
+                expectedError = (a < 0) || (a > INTEGER_FACTORIAL_MAX);
+                wide = expectedError ? 0 : 1;
+                for (int n = 2; !expectedError && (n <= a); n++) {
+                    wide *= n;
+                }
+                break;
+        }
+        result = Integer::calculate(a, b, op, &error);
+        if ((error != expectedError) || (result != (qint64) (quint64) wide)) {
+            snprintf(report, sizeof(report), "%lld op %d %lld gave %lld%s, expected %lld%s", (long long) a, op,
+                     (long long) b, (long long) result, error ? " with an error" : "", (long long) (quint64) wide,
+                     expectedError ? " with an error" : "");
+            fail(&failures, "integer", report);
+        }
+
+        /* Texts in every base */
+        for (int j = 0; j < (int) (sizeof(bases) / sizeof(bases[0])); j++) {
+            int base = bases[j];
+            if (base == 10) {
+                snprintf(expected, sizeof(expected), "%lld", (long long) a);
+            } else if (base == 16) {
+                snprintf(expected, sizeof(expected), "%llx", (unsigned long long) a);
+            } else {
+                /* Bits from the highest one */
+                int length = 0;
+                for (int bit = 63; bit >= 0; bit--) {
+                    if ((length > 0) || (bit == 0) || ((((quint64) a >> bit) & 1) != 0)) {
+                        expected[length++] = (char) ('0' + (((quint64) a >> bit) & 1));
+                    }
+                }
+                expected[length] = '\0';
+            }
+            QString text = Integer::toString(a, base);
+            qint64 back = 0;
+            bool ok = Integer::fromString(text, base, &back);
+            if ((strcmp(text.toLatin1().constData(), expected) != 0) || !ok || (back != a) ||
+                (text.length() > Integer::maxDigits(base) + ((base == 10) ? 1 : 0))) {
+                snprintf(report, sizeof(report), "%lld in base %d is '%s', parsed back as %lld", (long long) a, base,
+                         text.toLatin1().constData(), (long long) back);
+                fail(&failures, "integer", report);
+            }
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Undo and redo random keystrokes, against whole states kept for each
+ *
+ *  Every state recorded is also kept whole. After each undo or redo the
+ *  engine must be back in the state kept, and the counts must be those
+ *  of the states kept.
+ *
+ *  @param  count   Eight times the number of keystrokes, undos and redos,
+ *                  each takes a whole state to check
+ *
+ *  @return Number of failures
+ */
+static long checkUndo(long count)
+{
+    Engine engine;
+    UndoHistory history;
+    QVector<EngineState> states;
+    EngineState state;
+    char report[4 * CHECK_TEXT_SIZE];
+    int numKeys = sizeof(sessionKeys) / sizeof(sessionKeys[0]);
+    int current = 0, recorded = 0;
+    long failures = 0;
+
+    for (long step = 0; step < count / 8; step++) {
+        int action = (int) (random64() % 100);
+        int expected = -1;
+        bool done = true;
+
+        /* Start over now and then, the history grows without limit */
+        if (step % CHECK_UNDO_RUN == 0) {
+            engine.reset();
+            history.clear();
+            current = recorded = 0;
+        }
+
+        if (action < 45) {
+            /* Keystroke or mode change, the state before it is kept */
+            history.record(&engine);
+            if (current >= states.size()) {
+                states.resize(current + 1);
+            }
+            engine.saveState(&states[current]);
+            recorded = ++current;
+            if (action < 42) {
+                engine.buttonPressed(sessionKeys[random64() % numKeys]);
+            } else if (action == 42) {
+                engine.setArithMode((engine.getArithMode() == ARITH_BIG) ? ARITH_DOUBLE : ARITH_BIG);
+            } else if (action == 43) {
+                engine.setArithMode((engine.getArithMode() == ARITH_DECIMAL) ? ARITH_DOUBLE : ARITH_DECIMAL);
+            } else {
+                engine.setSummaryMode(!engine.getSummaryMode());
+            }
+        } else if (action < 75) {
+            /* Undo, the current state is kept for redo */
+            if (current > 0) {
+                if (current == recorded) {
+                    if (current >= states.size()) {
+                        states.resize(current + 1);
+                    }
+                    engine.saveState(&states[current]);
+                    recorded++;
+                }
+                expected = --current;
+            }
+            done = history.undo(&engine);
+        } else if (action < 95) {
+            /* Redo */
+            if (current + 1 < recorded) {
+                expected = ++current;
+            }
+            done = history.redo(&engine);
+        } else {
+            /* The last keystroke did not happen */
+            if ((current > 0) && (current == recorded)) {
+                recorded = --current;
+            }
+            history.drop();
+        }
+
+        /* Undo and redo move only when there is somewhere to go, the counts are those of the states kept */
+        int redoCount = (recorded > current) ? recorded - current - 1 : 0;
+        bool isRight = (done == ((action < 45) || (action >= 95) || (expected >= 0))) &&
+                       (history.getUndoCount() == current) && (history.getRedoCount() == redoCount);
+        if (expected >= 0) {
+            /* Back in the state kept */
+            engine.saveState(&state);
+            isRight = isRight && (UndoLog::compare(state, states[expected]) == 0);
+        }
+        if (!isRight) {
+            snprintf(report, sizeof(report), "step %ld action %d shows '%s', %d undos and %d redos, expected %d and %d",
+                     step, action, engine.getDisplayText().toLatin1().constData(), history.getUndoCount(),
+                     history.getRedoCount(), current, redoCount);
+            fail(&failures, "undo", report);
+            /* Go on from a new start */
+            engine.reset();
+            history.clear();
+            current = recorded = 0;
+        }
+    }
+    return failures;
+}
+
+/**
+ *  @brief  Append random calculations to a history file, read and search them back
+ *
+ *  The file is opened again before reading, the records and their texts
+ *  must be those appended, and a search must find the same records as
+ *  a look at each one.
+ *
+ *  @param  count   Sixteen times the number of records
+ *
+ *  @return Number of failures
+ */
+static long checkHistory(long count)
+{
+    HistoryLog log;
+    QVector<HistoryEntry> entries;
+    QVector<int> found;
+    char fileName[CHECK_TEXT_SIZE];
+    char report[4 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    /* A new file of our own */
+    snprintf(fileName, sizeof(fileName), "/tmp/qcalccheck-%d.history", (int) getpid());
+    unlink(fileName);
+    unlink((QString(fileName) + HISTORY_TEXT_SUFFIX).toLatin1().constData());
+    if (!log.open(fileName)) {
+        fail(&failures, "history", "cannot open a history file in /tmp");
+        return failures;
+    }
+
+    /* Records with texts of any length, errors among them */
+    for (long i = 0; i < count / 16; i++) {
+        HistoryEntry entry;
+        memset(&entry.record, 0, sizeof(entry.record));
+        entry.record.time = HistoryLog::now();
+        entry.record.operand1 = randomDouble();
+        entry.record.operand2 = randomDouble();
+        entry.record.result = (double) ((qint64) (random64() % 2000) - 1000) / 8;
+        entry.record.op = (qint16) (OPERATOR_PLUS + random64() % 4);
+        entry.record.arithMode = (quint8) (random64() % 4);
+        entry.record.flags = (random64() % 8 == 0) ? HISTORY_ERROR : 0;
+        for (int part = 0; part < 3; part++) {
+            int digits = (int) (random64() % 100);
+            for (int j = 0; j < digits; j++) {
+                entry.text.append((char) ('0' + random64() % 10));
+            }
+            entry.text.append('\0');
+        }
+        entries.append(entry);
+        if (!log.append(entry)) {
+            fail(&failures, "history", "cannot append a record");
+            break;
+        }
+    }
+
+    /* Read them back from the file opened again */
+    log.close();
+    if (!log.open(fileName) || (log.getCount() != entries.size())) {
+        snprintf(report, sizeof(report), "%d records read back, %d appended", log.getCount(), entries.size());
+        fail(&failures, "history", report);
+    } else {
+        for (int i = 0; i < entries.size(); i++) {
+            const HistoryRecord *record = log.at(i);
+            const HistoryRecord &expected = entries[i].record;
+            QString operand1, operand2, result;
+            QByteArray text;
+            if (log.getTexts(record, &operand1, &operand2, &result)) {
+                text = operand1.toLatin1() + '\0' + operand2.toLatin1() + '\0' + result.toLatin1() + '\0';
+            }
+            if (!isSame(record->operand1, expected.operand1) || !isSame(record->operand2, expected.operand2) ||
+                !isSame(record->result, expected.result) || (record->time != expected.time) ||
+                (record->op != expected.op) || (record->arithMode != expected.arithMode) ||
+                (record->flags != expected.flags) || (text != entries[i].text)) {
+                snprintf(report, sizeof(report), "record %d read back is not the one appended", i);
+                fail(&failures, "history", report);
+            }
+        }
+
+        /* Searches, found in time order */
+        for (int i = 0; i < CHECK_HISTORY_SEARCHES; i++) {
+            double low = (double) ((qint64) (random64() % 2200) - 1100) / 8;
+            double high = low + (double) (random64() % 400) / 8;
+            QVector<int> expected;
+            for (int j = 0; j < entries.size(); j++) {
+                const HistoryRecord &record = entries[j].record;
+                if (((record.flags & HISTORY_ERROR) == 0) && (record.result >= low) && (record.result <= high)) {
+                    expected.append(j);
+                }
+            }
+            log.find(low, high, &found);
+            if (found != expected) {
+                snprintf(report, sizeof(report), "%d records found from %g to %g, expected %d", found.size(), low, high,
+                         expected.size());
+                fail(&failures, "history", report);
+            }
+        }
+    }
+
+    /* Leave nothing behind */
+    log.close();
+    unlink(fileName);
+    unlink((QString(fileName) + HISTORY_TEXT_SUFFIX).toLatin1().constData());
+    return failures;
+}
+
+/**
+ *  @brief  Read reply lines from a connection
+ *
+ *  @param  fd      Socket
+ *  @param  lines   Number of lines to read
+ *  @param  replies Set to the lines, newlines included
+ *
+ *  @return false if the connection ended first
+ */
+static bool readReplies(int fd, int lines, QByteArray *replies)
+{
+    char buffer[SERVER_READ_SIZE];
+
+    replies->clear();
+    while (replies->count('\n') < lines) {
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got <= 0) {
+            return false;
+        }
+        replies->append(buffer, (int) got);
+    }
+    return true;
+}
+
+/**
+ *  @brief  Connect to a server socket
+ *
+ *  @param  path    Socket path
+ *
+ *  @return Socket, -1 on error
+ */
+static int connectServer(const char *path)
+{
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if ((fd >= 0) && (::connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ *  @brief  Send random requests to a server, check the replies against an engine
+ *
+ *  The server runs in a child process. Requests go in batches written
+ *  at once, calculations in every mode with settings between them, and
+ *  the replies must be those of an engine given the same requests. The
+ *  last request ends with the connection instead of a newline, and a
+ *  line too long closes the connection unanswered.
+ *
+ *  @param  count   Number of requests
+ *
+ *  @return Number of failures
+ */
+static long checkServer(long count)
+{
+    static const char * const names[] = { "?", "+", "-", "*", "/", "sqrt", "!" };
+    static const char * const modes[] = { "double", "big", "decimal", "integer" };
+    EvalServer server;
+    Engine engine;
+    char path[CHECK_TEXT_SIZE];
+    char report[4 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    /* Serve from a child */
+    snprintf(path, sizeof(path), "/tmp/qcalccheck-%d.socket", (int) getpid());
+    if (!server.listen(path)) {
+        fail(&failures, "server", "cannot listen in /tmp");
+        return failures;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        server.serve();
+        _exit(0);
+    }
+
+    int fd = connectServer(path);
+    if ((child < 0) || (fd < 0)) {
+        fail(&failures, "server", "cannot start the server");
+    }
+    for (long done = 0; (fd >= 0) && (done < count); done += CHECK_SERVER_BATCH) {
+        QByteArray requests, expected, replies;
+        int lines = (int) ((count - done < CHECK_SERVER_BATCH) ? count - done : CHECK_SERVER_BATCH);
+
+        for (int i = 0; i < lines; i++) {
+            int kind = (int) (random64() % 32);
+            if (kind == 0) {
+                /* Another arithmetic */
+                int mode = (int) (random64() % 4);
+                requests.append("mode ").append(modes[mode]);
+                engine.setArithMode(mode);
+                expected.append("ok");
+            } else if (kind == 1) {
+                /* Another precision */
+                int digits = 10 + (int) (random64() % 60);
+                requests.append("precision ").append(QByteArray::number(digits));
+                engine.setPrecision(digits);
+                expected.append("ok");
+            } else {
+                /* A calculation, small integers for the integer mode */
+                int op = OPERATOR_PLUS + (int) (random64() % (OPERATOR_FACT - OPERATOR_PLUS + 1));
+                QString operand1 = QString::number((qint64) (random64() % 41) - 20);
+                QString operand2 = QString::number((qint64) (random64() % 41) - 20);
+                if (random64() % 2) {
+                    operand1 = QString::number((double) ((qint64) (random64() % 20001) - 10000) / 64, 'g', 17);
+                }
+                requests.append(names[op]).append(' ').append(operand1.toLatin1());
+                if (op <= OPERATOR_DIV) {
+                    requests.append(' ').append(operand2.toLatin1());
+                } else {
+                    operand2 = operand1;
+                }
+                bool error = false;
+                QString result = engine.calculate(operand1, operand2, op, &error);
+                expected.append(error ? QByteArray("error") : result.toLatin1());
+            }
+            expected.append('\n');
+
+            /* The very last one has no newline */
+            if ((done + i + 1 < count) || (i + 1 < lines)) {
+                requests.append('\n');
+            }
+        }
+
+        /* All at once, the replies come in order */
+        bool isLast = (done + lines >= count);
+        bool ok = (write(fd, requests.constData(), requests.size()) == (ssize_t) requests.size());
+        if (ok && isLast) {
+            shutdown(fd, SHUT_WR);
+        }
+        if (!ok || !readReplies(fd, lines, &replies) || (replies != expected)) {
+            snprintf(report, sizeof(report), "batch from request %ld answered wrongly", done);
+            fail(&failures, "server", report);
+            break;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    /* A line too long is not answered */
+    fd = connectServer(path);
+    if (fd >= 0) {
+        QByteArray replies, line("sqrt ");
+        line.append(QByteArray(SERVER_MAX_LINE, '1'));
+        line.append('\n');
+        if ((write(fd, line.constData(), line.size()) != (ssize_t) line.size()) || readReplies(fd, 1, &replies)) {
+            fail(&failures, "server", "a line too long was answered");
+        }
+        close(fd);
+    }
+
+    /* Stop the server */
+    if (child > 0) {
+        kill(child, SIGKILL);
+        waitpid(child, 0, 0);
+    }
+    unlink(path);
+    return failures;
+}
+
+/**
+ *  @brief  Check two statistics agree to a relative tolerance
+ *
+ *  @param  value       Value
+ *  @param  expected    Expected value
+ *
+ *  @return true if close enough
+ */
+static bool isClose(double value, long double expected)
+{
+    return fabsl((long double) value - expected) <= CHECK_TOLERANCE * (1 + fabsl(expected));
+}
+
+/**
+ *  @brief  Add random values and streams of numbers, check the statistics
+ *
+ *  Values added one by one, as arrays and merged from two halves must
+ *  give the count, extremes, mean and variance of a two pass sum in
+ *  long double. Streams of lines of one to three numbers must count
+ *  every number, unless pair mode takes lines of two as pairs.
+ *
+ *  @param  count   Number of values
+ *
+ *  @return Number of failures
+ */
+static long checkAccumulator(long count)
+{
+    double values[CHECK_ACCUMULATOR_SIZE];
+    char report[4 * CHECK_TEXT_SIZE];
+    long failures = 0;
+
+    for (long done = 0; done < count; done += CHECK_ACCUMULATOR_SIZE) {
+        Accumulator single, array, first, second;
+        int number = 1 + (int) (random64() % CHECK_ACCUMULATOR_SIZE);
+        double offset = (double) (random64() % 1000000);
+        long double sum = 0, squares = 0;
+        double low = HUGE_VAL, high = -HUGE_VAL;
+
+        /* Values around an offset, the variance must not cancel */
+        for (int i = 0; i < number; i++) {
+            values[i] = offset + (double) ((qint64) (random64() % 2000001) - 1000000) / 1000;
+            single.add(values[i]);
+            sum += values[i];
+            low = (values[i] < low) ? values[i] : low;
+            high = (values[i] > high) ? values[i] : high;
+        }
+        array.add(values, number);
+        first.add(values, number / 2);
+        second.add(values + number / 2, number - number / 2);
+        first.merge(second);
+
+        long double mean = sum / number;
+        for (int i = 0; i < number; i++) {
+            squares += (values[i] - mean) * (values[i] - mean);
+        }
+        long double variance = (number > 1) ? squares / (number - 1) : 0;
+
+        const Accumulator *all[] = { &single, &array, &first };
+        for (int j = 0; j < 3; j++) {
+            const Accumulator &a = *all[j];
+            if ((a.getCount() != (quint64) number) || (a.getMin() != low) || (a.getMax() != high) ||
+                !isClose(a.getSum(), sum) || !isClose(a.getMean(), mean) ||
+                ((number > 1) && !isClose(a.getVariance(), variance))) {
+                snprintf(report, sizeof(report), "%d values added %s: mean %.17g variance %.17g, "
+                         "expected %.17Lg %.17Lg", number, (j == 0) ? "one by one" : ((j == 1) ? "as an array" : "in two halves"), a.getMean(),
+                         a.getVariance(), mean, variance);
+                fail(&failures, "accumulator", report);
+            }
+        }
+    }
+
+    /* Streams, with and without pairs */
+    for (int pairs = 0; pairs < 2; pairs++) {
+        FILE *file = tmpfile();
+        Accumulator stream;
+        quint64 values = 0, pairCount = 0;
+        if (file == 0) {
+            fail(&failures, "accumulator", "cannot make a temporary file");
+            break;
+        }
+        for (int i = 0; i < CHECK_ACCUMULATOR_LINES; i++) {
+            int numbers = 1 + (int) (random64() % 3);
+            for (int j = 0; j < numbers; j++) {
+                fprintf(file, "%s%d", (j == 0) ? "" : ((j == 1) ? " " : ", "), (int) (random64() % 100));
+            }
+            fprintf(file, "\n");
+            if (pairs && (numbers == 2)) {
+                pairCount++;
+                values++;
+            } else {
+                values += numbers;
+            }
+        }
+        fprintf(file, "not a number\n");
+        rewind(file);
+        stream.setPairMode(pairs != 0);
+        quint64 skipped = stream.addStream(file);
+        fclose(file);
+        if ((skipped != 1) || (stream.getCount() != values) || (stream.getPairCount() != pairCount)) {
+            snprintf(report, sizeof(report), "stream%s read as %llu values, %llu pairs and %llu skipped, "
+                     "expected %llu, %llu and 1", pairs ? " of pairs" : "", (unsigned long long) stream.getCount(),
+                     (unsigned long long) stream.getPairCount(), (unsigned long long) skipped,
+                     (unsigned long long) values, (unsigned long long) pairCount);
+            fail(&failures, "accumulator", report);
+        }
+    }
+    return failures;
+}
+
+/** The checks */
+static const CheckCase checkCases[] = {
+    { "parse",      checkParse },
+    { "format",     checkFormat },
+    { "decimal",    checkDecimal },
+    { "sessions",   checkSessions },
+    { "expressions", checkExpressions },
+    { "vectors",    checkVectors },
+    { "big",        checkBig },
+    { "integer",    checkInteger },
+    { "undo",       checkUndo },
+    { "history",    checkHistory },
+    { "server",     checkServer },
+    { "accumulator", checkAccumulator }
+};
+
+/**
+ *  @brief  Print usage
+ *
+ *  @return N/A
+ */
+static void usage(void)
+{
+    fprintf(stderr, "usage: qcalccheck [--filter TEXT] [--count N] [--list]\n");
+    return;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filter = 0;
+    long count = CHECK_COUNT;
+    int numCases = sizeof(checkCases) / sizeof(checkCases[0]);
+    int status = 0;
+
+    /* Options */
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+            /* Only checks whose name contains the text */
+            filter = argv[++i];
+        } else if ((strcmp(argv[i], "--count") == 0) && (i + 1 < argc)) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (int j = 0; j < numCases; j++) {
+                printf("%s\n", checkCases[j].name);
+            }
+            return 0;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (count < 1) {
+        usage();
+        return 2;
+    }
+
+    /* One line per check, the failures go to the standard error */
+    for (int i = 0; i < numCases; i++) {
+        if ((filter != 0) && (strstr(checkCases[i].name, filter) == 0)) {
+            continue;
+        }
+        long failures = checkCases[i].function(count);
+        if (failures == 0) {
+            printf("%s: ok\n", checkCases[i].name);
+        } else {
+            printf("%s: %ld failures\n", checkCases[i].name, failures);
+            status = 1;
+        }
+    }
+    return status;
+}
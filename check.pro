@@ -0,0 +1,21 @@
+######################################################################
+# Engine consistency checks, 'make check' runs them
+######################################################################
+
+TEMPLATE = app
+TARGET = qcalccheck
+CONFIG += console
+CONFIG -= app_bundle
+QT -= gui
+DEPENDPATH += .
+INCLUDEPATH += .
+LIBS += -L. -lqcalcengine
+PRE_TARGETDEPS += libqcalcengine.a
+
+# Input
+SOURCES += check.cpp
+
+# Run the checks
+check.commands = ./qcalccheck
+check.depends = qcalccheck
+QMAKE_EXTRA_TARGETS += check
@@ -0,0 +1,941 @@
+/** @file decimal.cpp
+ *
+ *  @brief This file contains the definitions of the decimal numbers
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "decimal.h"
+#include "engine.h"
+#include "bignum.h"
+#include "gamma.h"
+#include "parse.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Defines */
+
+/** Largest power of ten below 2^128 */
+#define DECIMAL_MAX_POWER   38
+/** Digits kept when aligning operands, enough to round a sum correctly */
+#define DECIMAL_ALIGN_DIGITS    (DECIMAL_MAX_POWER - 1)
+/** Largest power of ten that is exact in a double */
+#define DECIMAL_MAX_EXACT   22
+/** 128 bit power of ten from its halves */
+#define DECIMAL_POWER(high, low)    ((((quint128) (high)) << 64) | (low))
+
+/** Powers of ten */
+static const quint128 powers[DECIMAL_MAX_POWER + 1] = {
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0000000000000001ULL),  /* 1e0 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x000000000000000aULL),  /* 1e1 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0000000000000064ULL),  /* 1e2 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00000000000003e8ULL),  /* 1e3 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0000000000002710ULL),  /* 1e4 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00000000000186a0ULL),  /* 1e5 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00000000000f4240ULL),  /* 1e6 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0000000000989680ULL),  /* 1e7 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0000000005f5e100ULL),  /* 1e8 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x000000003b9aca00ULL),  /* 1e9 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00000002540be400ULL),  /* 1e10 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x000000174876e800ULL),  /* 1e11 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x000000e8d4a51000ULL),  /* 1e12 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x000009184e72a000ULL),  /* 1e13 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00005af3107a4000ULL),  /* 1e14 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x00038d7ea4c68000ULL),  /* 1e15 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x002386f26fc10000ULL),  /* 1e16 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x016345785d8a0000ULL),  /* 1e17 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x0de0b6b3a7640000ULL),  /* 1e18 */
+        DECIMAL_POWER(0x0000000000000000ULL, 0x8ac7230489e80000ULL),  /* 1e19 */
+        DECIMAL_POWER(0x0000000000000005ULL, 0x6bc75e2d63100000ULL),  /* 1e20 */
+        DECIMAL_POWER(0x0000000000000036ULL, 0x35c9adc5dea00000ULL),  /* 1e21 */
+        DECIMAL_POWER(0x000000000000021eULL, 0x19e0c9bab2400000ULL),  /* 1e22 */
+        DECIMAL_POWER(0x000000000000152dULL, 0x02c7e14af6800000ULL),  /* 1e23 */
+        DECIMAL_POWER(0x000000000000d3c2ULL, 0x1bcecceda1000000ULL),  /* 1e24 */
+        DECIMAL_POWER(0x0000000000084595ULL, 0x161401484a000000ULL),  /* 1e25 */
+        DECIMAL_POWER(0x000000000052b7d2ULL, 0xdcc80cd2e4000000ULL),  /* 1e26 */
+        DECIMAL_POWER(0x00000000033b2e3cULL, 0x9fd0803ce8000000ULL),  /* 1e27 */
+        DECIMAL_POWER(0x00000000204fce5eULL, 0x3e25026110000000ULL),  /* 1e28 */
+        DECIMAL_POWER(0x00000001431e0faeULL, 0x6d7217caa0000000ULL),  /* 1e29 */
+        DECIMAL_POWER(0x0000000c9f2c9cd0ULL, 0x4674edea40000000ULL),  /* 1e30 */
+        DECIMAL_POWER(0x0000007e37be2022ULL, 0xc0914b2680000000ULL),  /* 1e31 */
+        DECIMAL_POWER(0x000004ee2d6d415bULL, 0x85acef8100000000ULL),  /* 1e32 */
+        DECIMAL_POWER(0x0000314dc6448d93ULL, 0x38c15b0a00000000ULL),  /* 1e33 */
+        DECIMAL_POWER(0x0001ed09bead87c0ULL, 0x378d8e6400000000ULL),  /* 1e34 */
+        DECIMAL_POWER(0x0013426172c74d82ULL, 0x2b878fe800000000ULL),  /* 1e35 */
+        DECIMAL_POWER(0x00c097ce7bc90715ULL, 0xb34b9f1000000000ULL),  /* 1e36 */
+        DECIMAL_POWER(0x0785ee10d5da46d9ULL, 0x00f436a000000000ULL),  /* 1e37 */
+        DECIMAL_POWER(0x4b3b4ca85a86c47aULL, 0x098a224000000000ULL)   /* 1e38 */
+    };
+
+/** Powers of ten that are exact in a double */
+static const double doublePowers[DECIMAL_MAX_EXACT + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+/** Unsigned 256 bit integer */
+struct Wide
+{
+    /** Upper 128 bits */
+    quint128 high;
+    /** Lower 128 bits */
+    quint128 low;
+};
+
+/**
+ *  @brief  Number of bits of an integer
+ *
+ *  @param  c   Integer
+ *
+ *  @return Position of the highest set bit plus one, 0 for zero
+ */
+static int bitLength(quint128 c)
+{
+    quint64 high = (quint64) (c >> 64);
+
+    /* Count leading zeros of the non-zero half */
+    if (high != 0) {
+        return 128 - __builtin_clzll(high);
+    }
+    if ((quint64) c != 0) {
+        return 64 - __builtin_clzll((quint64) c);
+    }
+    return 0;
+}
+
+/**
+ *  @brief  Number of decimal digits of an integer
+ *
+ *  @param  c   Integer
+ *
+ *  @return Number of digits, 0 for zero
+ */
+static int digitCount(quint128 c)
+{
+    /* log10(2) is about 1233 / 4096, one compare corrects the estimate */
+    int t = (bitLength(c) * 1233) >> 12;
+    return t + ((c >= powers[t]) ? 1 : 0);
+}
+
+/**
+ *  @brief  Full product of two 128 bit integers
+ *
+ *  @param  a   Integer 1
+ *  @param  b   Integer 2
+ *
+ *  @return a * b
+ */
+static Wide wideMultiply(quint128 a, quint128 b)
+{
+    quint64 a0 = (quint64) a, a1 = (quint64) (a >> 64);
+    quint64 b0 = (quint64) b, b1 = (quint64) (b >> 64);
+    quint128 p00 = (quint128) a0 * b0, p01 = (quint128) a0 * b1;
+    quint128 p10 = (quint128) a1 * b0, p11 = (quint128) a1 * b1;
+    quint128 middle = (p00 >> 64) + (quint64) p01 + (quint64) p10;
+    Wide r;
+
+    /* Schoolbook on 64 bit halves */
+    r.low = (middle << 64) | (quint64) p00;
+    r.high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+    return r;
+}
+
+/**
+ *  @brief  Divide a 256 bit integer in place
+ *
+ *  @param  w   Integer, replaced by the quotient
+ *  @param  d   Divisor
+ *
+ *  @return Remainder
+ */
+static quint64 wideDivide(Wide *w, quint64 d)
+{
+    quint64 limbs[4] = { (quint64) w->low, (quint64) (w->low >> 64),
+                         (quint64) w->high, (quint64) (w->high >> 64) };
+    quint128 rem = 0;
+
+    /* Long division on 64 bit limbs */
+    for (int i = 3; i >= 0; i--) {
+        rem = (rem << 64) | limbs[i];
+        limbs[i] = (quint64) (rem / d);
+        rem %= d;
+    }
+    w->low = ((quint128) limbs[1] << 64) | limbs[0];
+    w->high = ((quint128) limbs[3] << 64) | limbs[2];
+    return (quint64) rem;
+}
+
+/**
+ *  @brief  Narrow a 256 bit integer to 128 bits, dropping low digits
+ *
+ *  At least DECIMAL_DIGITS + 1 digits are kept, so the result can still
+ *  be rounded correctly.
+ *
+ *  @param  w           Integer
+ *  @param  exponent    Decimal exponent, raised by the digits dropped
+ *  @param  sticky      Set to true if non-zero digits are dropped
+ *
+ *  @return Integer without the dropped digits
+ */
+static quint128 narrow(Wide w, int *exponent, bool *sticky)
+{
+    /* Anything above 2^128 has at least 39 digits */
+    while (w.high != 0) {
+        if (wideDivide(&w, 10000) != 0) {
+            *sticky = true;
+        }
+        *exponent += 4;
+    }
+    return w.low;
+}
+
+/**
+ *  @brief  Compare two 256 bit integers
+ *
+ *  @param  a   Integer 1
+ *  @param  b   Integer 2
+ *
+ *  @return true if a >= b
+ */
+static bool wideNotLess(const Wide &a, const Wide &b)
+{
+    /* Upper halves first */
+    return (a.high != b.high) ? (a.high > b.high) : (a.low >= b.low);
+}
+
+/**
+ *  @brief  Subtract two 256 bit integers
+ *
+ *  @param  a   Integer 1
+ *  @param  b   Integer 2, not larger than integer 1
+ *
+ *  @return a - b
+ */
+static Wide wideSubtract(const Wide &a, const Wide &b)
+{
+    Wide r;
+
+    /* Borrow from the upper half */
+    r.low = a.low - b.low;
+    r.high = a.high - b.high - ((r.low > a.low) ? 1 : 0);
+    return r;
+}
+
+/**
+ *  @brief  Convert a 256 bit integer to a long double
+ *
+ *  @param  w   Integer
+ *
+ *  @return Nearest long double, within a few units
+ */
+static long double wideToLongDouble(const Wide &w)
+{
+    /* Upper half scaled by 2^128 */
+    return ldexpl((long double) w.high, 128) + (long double) w.low;
+}
+
+/**
+ *  @brief  Integer square root of a 256 bit integer
+ *
+ *  A floating point estimate is refined by Newton steps on the exact
+ *  residual, then corrected to the exact floor.
+ *
+ *  @param  n   Integer, at least 2^64, replaced by the remainder
+ *
+ *  @return floor(sqrt(n))
+ */
+static quint128 wideSquareRoot(Wide *n)
+{
+    quint128 root = (quint128) sqrtl(wideToLongDouble(*n));
+
+    /* Newton steps until the correction is below one */
+    for (;;) {
+        Wide square = wideMultiply(root, root);
+        long double residual = wideNotLess(*n, square) ? wideToLongDouble(wideSubtract(*n, square))
+                                                       : -wideToLongDouble(wideSubtract(square, *n));
+        long double step = residual / (2 * (long double) root);
+        if (fabsl(step) < 1) {
+            break;
+        }
+        root = (quint128) ((__int128) root + (__int128) step);
+    }
+
+    /* Exact floor */
+    while (!wideNotLess(*n, wideMultiply(root, root))) {
+        root--;
+    }
+    while (wideNotLess(*n, wideMultiply(root + 1, root + 1))) {
+        root++;
+    }
+    *n = wideSubtract(*n, wideMultiply(root, root));
+    return root;
+}
+
+/**
+ *  @brief  Decimal object constructor
+ *
+ *  @return N/A
+ */
+Decimal::Decimal()
+    : negative(false), coefficient(0), exponent(0)
+{
+    return;
+}
+
+/**
+ *  @brief  Decimal object constructor from a double
+ *
+ *  @param  value   Value, zero if not finite
+ *
+ *  @return N/A
+ */
+Decimal::Decimal(double value)
+    : negative(false), coefficient(0), exponent(0)
+{
+    /* Integers directly */
+    if ((value == floor(value)) && (fabs(value) < 9e18)) {
+        negative = (value < 0);
+        coefficient = (quint64) fabs(value);
+        return;
+    }
+
+    /* The rest through text, the fewest digits that round trip */
+    QString text = QString::number(value, 'g', 15);
+    if (Parse::toDouble(text) != value) {
+        text = QString::number(value, 'g', 17);
+    }
+    *this = fromString(text, 0);
+    return;
+}
+
+/**
+ *  @brief  Decimal object constructor from parts, rounding the coefficient
+ *
+ *  @param  negative    Sign
+ *  @param  coefficient Coefficient, any number of digits
+ *  @param  exponent    Exponent
+ *  @param  sticky      Non-zero digits were dropped below the coefficient,
+ *                      only used if it has more than DECIMAL_DIGITS digits
+ *
+ *  @return N/A
+ */
+Decimal::Decimal(bool negative, quint128 coefficient, int exponent, bool sticky)
+    : negative(negative), coefficient(coefficient), exponent(exponent)
+{
+    int excess = digitCount(coefficient) - DECIMAL_DIGITS;
+
+    if (excess > 0) {
+        /* Drop the excess digits, the first one decides the rounding */
+        if (excess > 1) {
+            quint128 unit = powers[excess - 1];
+            if (this->coefficient % unit != 0) {
+                sticky = true;
+            }
+            this->coefficient /= unit;
+        }
+        int digit = (int) (this->coefficient % 10);
+        this->coefficient /= 10;
+        this->exponent += excess;
+
+        /* Round half to even */
+        if ((digit > 5) || ((digit == 5) && (sticky || (this->coefficient & 1)))) {
+            this->coefficient++;
+            if (this->coefficient == powers[DECIMAL_DIGITS]) {
+                this->coefficient = powers[DECIMAL_DIGITS - 1];
+                this->exponent++;
+            }
+        }
+    }
+
+    /* Zero has no sign */
+    if (this->coefficient == 0) {
+        this->negative = false;
+    }
+    return;
+}
+
+/**
+ *  @brief  Decimal class method : Convert from text
+ *
+ *  @param  text    Text, [-]digits[.digits][e[-]digits]
+ *  @param  ok      Set to false on invalid text, may be NULL
+ *
+ *  @return Number rounded to DECIMAL_DIGITS digits, zero on invalid text
+ */
+Decimal Decimal::fromString(const QString &text, bool *ok)
+{
+    QByteArray bytes = text.toLatin1();
+    const char *p = bytes.constData();
+    quint128 c = 0;
+    int count = 0, scale = 0;
+    bool negativeText = false, sticky = false;
+    bool seenDigit = false, seenDot = false;
+
+    /* Sign */
+    if ((*p == '-') || (*p == '+')) {
+        negativeText = (*p == '-');
+        p++;
+    }
+
+    /* Digits, one more than kept for rounding, the rest only count */
+    for (; *p != '\0'; p++) {
+        if ((*p >= '0') && (*p <= '9')) {
+            int digit = *p - '0';
+            seenDigit = true;
+            if ((count == 0) && (digit == 0)) {
+                /* Leading zero */
+                if (seenDot) {
+                    scale--;
+                }
+            } else if (count <= DECIMAL_DIGITS) {
+                c = c * 10 + digit;
+                count++;
+                if (seenDot) {
+                    scale--;
+                }
+            } else {
+                if (digit != 0) {
+                    sticky = true;
+                }
+                if (!seenDot) {
+                    scale++;
+                }
+            }
+        } else if ((*p == '.') && !seenDot) {
+            seenDot = true;
+        } else {
+            break;
+        }
+    }
+
+    /* Exponent */
+    if (seenDigit && ((*p == 'e') || (*p == 'E'))) {
+        bool negativeExp = false;
+        long exp = 0;
+        p++;
+        if ((*p == '-') || (*p == '+')) {
+            negativeExp = (*p == '-');
+            p++;
+        }
+        if ((*p < '0') || (*p > '9')) {
+            seenDigit = false;
+        }
+        for (; (*p >= '0') && (*p <= '9'); p++) {
+            if (exp < 100000000) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        scale += negativeExp ? -exp : exp;
+    }
+
+    /* Everything must be used up */
+    if (!seenDigit || (*p != '\0')) {
+        if (ok != 0) {
+            *ok = false;
+        }
+        return Decimal();
+    }
+    if (ok != 0) {
+        *ok = true;
+    }
+    return Decimal(negativeText, c, scale, sticky);
+}
+
+/**
+ *  @brief  Decimal object method : Convert to text
+ *
+ *  @return Text, exponent notation only beyond DECIMAL_DIGITS digits
+ */
+QString Decimal::toString(void) const
+{
+    char digits[2 * DECIMAL_MAX_POWER];
+    char text[4 * DECIMAL_MAX_POWER];
+    char *d = digits + sizeof(digits);
+    char *t = text;
+
+    /* Zero */
+    if (coefficient == 0) {
+        return QString("0");
+    }
+
+    /* Digits from the end, in two 64 bit halves */
+    quint64 high = (quint64) (coefficient / powers[19]);
+    quint64 low = (quint64) (coefficient % powers[19]);
+    for (int i = 0; (i < 19) && ((low != 0) || (high != 0)); i++) {
+        *--d = '0' + low % 10;
+        low /= 10;
+    }
+    for (; high != 0; high /= 10) {
+        *--d = '0' + high % 10;
+    }
+    int n = digits + sizeof(digits) - d;
+
+    /* Drop insignificant zeros, keeping where the point goes */
+    int point = n + exponent;
+    while (d[n - 1] == '0') {
+        n--;
+    }
+
+    if (negative) {
+        *t++ = '-';
+    }
+    if ((point > DECIMAL_DIGITS) || (point < -DECIMAL_DIGITS)) {
+        /* Exponent notation */
+        *t++ = d[0];
+        if (n > 1) {
+            *t++ = '.';
+            memcpy(t, d + 1, n - 1);
+            t += n - 1;
+        }
+        t += sprintf(t, "e%d", point - 1);
+    } else if (point >= n) {
+        /* Integer */
+        memcpy(t, d, n);
+        t += n;
+        memset(t, '0', point - n);
+        t += point - n;
+    } else if (point > 0) {
+        /* Point inside the digits */
+        memcpy(t, d, point);
+        t += point;
+        *t++ = '.';
+        memcpy(t, d + point, n - point);
+        t += n - point;
+    } else {
+        /* Point before the digits */
+        *t++ = '0';
+        *t++ = '.';
+        memset(t, '0', -point);
+        t += -point;
+        memcpy(t, d, n);
+        t += n;
+    }
+    return QString::fromLatin1(text, t - text);
+}
+
+/**
+ *  @brief  Decimal object method : Convert to the nearest double
+ *
+ *  @return Value
+ */
+double Decimal::toDouble(void) const
+{
+    /* Exact coefficient and power of ten give a correctly rounded result */
+    if (((coefficient >> 53) == 0) && (exponent >= -DECIMAL_MAX_EXACT) && (exponent <= DECIMAL_MAX_EXACT)) {
+        double value = (double) (quint64) coefficient;
+        value = (exponent < 0) ? (value / doublePowers[-exponent]) : (value * doublePowers[exponent]);
+        return negative ? -value : value;
+    }
+
+    /* The rest through text */
+    return Parse::toDouble(toString());
+}
+
+/**
+ *  @brief  Decimal object method : Check for zero
+ *
+ *  @return true if zero
+ */
+bool Decimal::isZero(void) const
+{
+    /* Zero coefficient is zero */
+    return coefficient == 0;
+}
+
+/**
+ *  @brief  Decimal object method : Check for negative
+ *
+ *  @return true if less than zero
+ */
+bool Decimal::isNegative(void) const
+{
+    /* Return sign */
+    return negative;
+}
+
+/**
+ *  @brief  Decimal object method : Check for an integer
+ *
+ *  @return true if the value is an integer
+ */
+bool Decimal::isInteger(void) const
+{
+    /* No fraction digits, or only zeros there */
+    if ((coefficient == 0) || (exponent >= 0)) {
+        return true;
+    }
+    if (-exponent > DECIMAL_MAX_POWER) {
+        return false;
+    }
+    return coefficient % powers[-exponent] == 0;
+}
+
+/**
+ *  @brief  Decimal object method : Hash of the representation
+ *
+ *  @return Hash of sign, exponent and coefficient
+ */
+quint64 Decimal::hash(void) const
+{
+    /* Fold the coefficient halves with the rest */
+    quint64 h = (quint64) coefficient ^ ((quint64) (coefficient >> 64) * 0x9e3779b97f4a7c15ULL);
+    return h ^ ((quint64) (quint32) exponent << 32) ^ (negative ? 1 : 0);
+}
+
+/**
+ *  @brief  Decimal object method : Check for the same representation
+ *
+ *  @param  other   Number to compare with
+ *
+ *  @return true if sign, exponent and coefficient are the same
+ */
+bool Decimal::isSame(const Decimal &other) const
+{
+    /* Same number with a different exponent is not the same */
+    return (negative == other.negative) && (exponent == other.exponent)
+            && (coefficient == other.coefficient);
+}
+
+/**
+ *  @brief  Decimal object method : Drop trailing zeros down to an exponent
+ *
+ *  @param  idealExponent   Exponent not to go beyond
+ *
+ *  @return N/A
+ */
+void Decimal::reduce(int idealExponent)
+{
+    static const int chunks[] = { 16, 8, 4, 2, 1 };
+
+    /* Nothing to drop from zero */
+    if (coefficient == 0) {
+        return;
+    }
+
+    /* Large chunks first */
+    for (unsigned int i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        int k = chunks[i];
+        while ((idealExponent - exponent >= k) && (coefficient % powers[k] == 0)) {
+            coefficient /= powers[k];
+            exponent += k;
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Decimal class method : Add or subtract two numbers
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  negateB Subtract number 2 instead
+ *
+ *  @return a + b or a - b
+ */
+Decimal Decimal::addSigned(const Decimal &a, const Decimal &b, bool negateB)
+{
+    bool signA = a.negative, signB = (b.negative != negateB);
+
+    /* Zero operands */
+    if (b.coefficient == 0) {
+        return a;
+    }
+    if (a.coefficient == 0) {
+        return Decimal(signB, b.coefficient, b.exponent, false);
+    }
+
+    /* Same scale, integer arithmetic only */
+    if (a.exponent == b.exponent) {
+        if (signA == signB) {
+            return Decimal(signA, a.coefficient + b.coefficient, a.exponent, false);
+        }
+        if (a.coefficient >= b.coefficient) {
+            return Decimal(signA, a.coefficient - b.coefficient, a.exponent, false);
+        }
+        return Decimal(signB, b.coefficient - a.coefficient, a.exponent, false);
+    }
+
+    /* x is the operand with the larger exponent */
+    const Decimal &x = (a.exponent > b.exponent) ? a : b;
+    const Decimal &y = (a.exponent > b.exponent) ? b : a;
+    bool signX = (a.exponent > b.exponent) ? signA : signB;
+    bool signY = (a.exponent > b.exponent) ? signB : signA;
+    int diff = x.exponent - y.exponent;
+    int dx = digitCount(x.coefficient);
+    quint128 cx, cy;
+    int e;
+    bool sticky = false;
+
+    if (dx + diff <= DECIMAL_ALIGN_DIGITS) {
+        /* Align exactly */
+        cx = x.coefficient * powers[diff];
+        cy = y.coefficient;
+        e = y.exponent;
+    } else {
+        /* x is far larger, y only needs to be known below its last digit */
+        int shift = DECIMAL_ALIGN_DIGITS - dx;
+        int drop;
+        cx = x.coefficient * powers[shift];
+        e = x.exponent - shift;
+        drop = e - y.exponent;
+        if (drop > DECIMAL_MAX_POWER) {
+            cy = 0;
+            sticky = true;
+        } else {
+            cy = y.coefficient / powers[drop];
+            sticky = (y.coefficient % powers[drop] != 0);
+        }
+    }
+
+    if (signX == signY) {
+        /* Same sign, add the magnitudes */
+        return Decimal(signX, cx + cy, e, sticky);
+    }
+    if (sticky) {
+        /* x - (cy + fraction) = (x - cy - 1) + (1 - fraction) */
+        return Decimal(signX, cx - cy - 1, e, true);
+    }
+    if (cx >= cy) {
+        return Decimal(signX, cx - cy, e, false);
+    }
+    return Decimal(signY, cy - cx, e, false);
+}
+
+/**
+ *  @brief  Decimal class method : Add two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return a + b
+ */
+Decimal Decimal::add(const Decimal &a, const Decimal &b)
+{
+    /* Add as they are */
+    return addSigned(a, b, false);
+}
+
+/**
+ *  @brief  Decimal class method : Subtract two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return a - b
+ */
+Decimal Decimal::subtract(const Decimal &a, const Decimal &b)
+{
+    /* Add the negated number */
+    return addSigned(a, b, true);
+}
+
+/**
+ *  @brief  Decimal class method : Multiply two numbers
+ *
+ *  @param  a   Number 1
+ *  @param  b   Number 2
+ *
+ *  @return a * b
+ */
+Decimal Decimal::multiply(const Decimal &a, const Decimal &b)
+{
+    bool sign = (a.negative != b.negative);
+    int e = a.exponent + b.exponent;
+    bool sticky = false;
+
+    /* Coefficients below 2^64 have a 128 bit product */
+    if (((a.coefficient >> 64) == 0) && ((b.coefficient >> 64) == 0)) {
+        return Decimal(sign, a.coefficient * b.coefficient, e, false);
+    }
+
+    /* Otherwise narrow the full product */
+    quint128 c = narrow(wideMultiply(a.coefficient, b.coefficient), &e, &sticky);
+    return Decimal(sign, c, e, sticky);
+}
+
+/**
+ *  @brief  Decimal class method : Divide two numbers
+ *
+ *  Long division, as many digits at a time as the remainder allows.
+ *
+ *  @param  a       Number 1
+ *  @param  b       Number 2
+ *  @param  error   Set to true on divide-by-zero, left untouched otherwise
+ *
+ *  @return a / b, correctly rounded, 0 on error
+ */
+Decimal Decimal::divide(const Decimal &a, const Decimal &b, bool *error)
+{
+    bool sign = (a.negative != b.negative);
+    int ideal = a.exponent - b.exponent;
+
+    /* Check for divide-by-zero error */
+    if (b.coefficient == 0) {
+        *error = true;
+        return Decimal();
+    }
+    if (a.coefficient == 0) {
+        return Decimal();
+    }
+
+    /* Integer part */
+    quint128 q = a.coefficient / b.coefficient;
+    quint128 r = a.coefficient % b.coefficient;
+    int e = ideal;
+
+    /* More digits while inexact, the remainder stays below the divisor */
+    int step = DECIMAL_MAX_POWER - digitCount(b.coefficient);
+    int count = digitCount(q);
+    while ((r != 0) && (count < DECIMAL_DIGITS)) {
+        int k = (DECIMAL_DIGITS - count < step) ? (DECIMAL_DIGITS - count) : step;
+        r *= powers[k];
+        q = q * powers[k] + r / b.coefficient;
+        r %= b.coefficient;
+        e -= k;
+        count = digitCount(q);
+    }
+
+    /* Round half to even on the remainder */
+    if ((2 * r > b.coefficient) || ((2 * r == b.coefficient) && (r != 0) && (q & 1))) {
+        q++;
+    }
+    Decimal result(sign, q, e, false);
+    if (r == 0) {
+        /* Exact, no more digits than needed */
+        result.reduce(ideal);
+    }
+    return result;
+}
+
+/**
+ *  @brief  Decimal class method : Square root
+ *
+ *  @param  a       Number
+ *  @param  error   Set to true for negative numbers, left untouched otherwise
+ *
+ *  @return sqrt(a), correctly rounded, 0 on error
+ */
+Decimal Decimal::squareRoot(const Decimal &a, bool *error)
+{
+    /* No square root of negative numbers */
+    if (a.negative) {
+        *error = true;
+        return Decimal();
+    }
+    if (a.coefficient == 0) {
+        return Decimal();
+    }
+
+    /* Scale to 67 or 68 digits with an even exponent, the root has 34 */
+    int dc = digitCount(a.coefficient);
+    int k = 2 * DECIMAL_DIGITS - 1 - dc;
+    if (((a.exponent - k) & 1) != 0) {
+        k++;
+    }
+    int k1 = DECIMAL_MAX_POWER - dc;
+    Wide n = wideMultiply(a.coefficient * powers[k1], powers[k - k1]);
+
+    /* Integer root, round up if the remainder is above the root */
+    quint128 root = wideSquareRoot(&n);
+    bool exact = ((n.high | n.low) == 0);
+    if ((n.high != 0) || (n.low > root)) {
+        root++;
+    }
+    Decimal result(false, root, (a.exponent - k) / 2, false);
+    if (exact) {
+        /* No more digits than needed */
+        result.reduce((a.exponent >= 0) ? (a.exponent / 2) : -((1 - a.exponent) / 2));
+    }
+    return result;
+}
+
+/**
+ *  @brief  Decimal class method : Factorial
+ *
+ *  @param  a       Number
+ *  @param  error   Set to true for negative integers and overflow, left untouched otherwise
+ *
+ *  @return a!, 0 on error
+ */
+Decimal Decimal::factorial(const Decimal &a, bool *error)
+{
+    /* Gamma in double precision for non-integers */
+    if (!a.isInteger()) {
+        double g = Gamma::factorial(a.toDouble(), error);
+        if (isinf(g)) {
+            *error = true;
+            return Decimal();
+        }
+        return Decimal(g);
+    }
+
+    /* Pole or too large */
+    double n = a.toDouble();
+    if (a.negative || (n > BIG_FACTORIAL_MAX)) {
+        *error = true;
+        return Decimal();
+    }
+
+    /* Up to 34! in 128 bits ... */
+    quint32 count = (quint32) n;
+    if (count <= 34) {
+        quint128 c = 1;
+        for (quint32 i = 2; i <= count; i++) {
+            c *= i;
+        }
+        return Decimal(false, c, 0, false);
+    }
+
+    /* ... beyond that exactly in arbitrary precision, then rounded */
+    BigFloat f = BigFloat::factorial(BigFloat(n), DECIMAL_DIGITS, error);
+    return fromString(f.toString(DECIMAL_DIGITS), 0);
+}
+
+/**
+ *  @brief  Decimal class method : Make calculation, as Engine::compute() does
+ *
+ *  Unlike doubles, square roots of negative numbers are errors.
+ *
+ *  @param  a       Operand 1
+ *  @param  b       Operand 2
+ *  @param  op      Operator
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Calculated result, 0 on error
+ */
+Decimal Decimal::calculate(const Decimal &a, const Decimal &b, int op, bool *error)
+{
+    /* Perform the calculation */
+    switch (op) {
+        case OPERATOR_PLUS:
+            return add(a, b);
+        case OPERATOR_MINUS:
+            return subtract(a, b);
+        case OPERATOR_MUL:
+            return multiply(a, b);
+        case OPERATOR_DIV:
+            return divide(a, b, error);
+        case OPERATOR_SQRT:
+            return squareRoot(a, error);
+        case OPERATOR_FACT:
+            return factorial(a, error);
+        default:
+            break;
+    }
+    return Decimal();
+}
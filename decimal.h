@@ -0,0 +1,99 @@
+/** @file decimal.h
+ *
+ *  @brief This file contains the declarations of the decimal numbers
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+/* Includes */
+#include <QString>
+
+/* Defines */
+
+/** Significant decimal digits, as in IEEE 754 decimal128 */
+#define DECIMAL_DIGITS  34
+
+/** Unsigned 128 bit integer */
+typedef unsigned __int128 quint128;
+
+/**
+ *  Decimal floating point number.
+ *
+ *  The value is coefficient * 10 ^ exponent with a coefficient of at
+ *  most DECIMAL_DIGITS digits, so decimal fractions like 0.1 are exact.
+ *  Inexact results are rounded half to even. Sums of operands with the
+ *  same exponent and products of operands below 2^64 stay in machine
+ *  integers; division and square root are correctly rounded.
+ */
+class Decimal
+{
+public:
+    /** Constructor */
+    Decimal();
+    /** Constructor from a double */
+    Decimal(double value);
+    /** Convert from text */
+    static Decimal fromString(const QString &text, bool *ok);
+    /** Convert to text */
+    QString toString(void) const;
+    /** Convert to the nearest double */
+    double toDouble(void) const;
+    /** Check for zero */
+    bool isZero(void) const;
+    /** Check for negative */
+    bool isNegative(void) const;
+    /** Check for an integer */
+    bool isInteger(void) const;
+    /** Hash of the representation */
+    quint64 hash(void) const;
+    /** Check for the same representation */
+    bool isSame(const Decimal &other) const;
+    /** Add two numbers */
+    static Decimal add(const Decimal &a, const Decimal &b);
+    /** Subtract two numbers */
+    static Decimal subtract(const Decimal &a, const Decimal &b);
+    /** Multiply two numbers */
+    static Decimal multiply(const Decimal &a, const Decimal &b);
+    /** Divide two numbers */
+    static Decimal divide(const Decimal &a, const Decimal &b, bool *error);
+    /** Square root */
+    static Decimal squareRoot(const Decimal &a, bool *error);
+    /** Factorial */
+    static Decimal factorial(const Decimal &a, bool *error);
+    /** Make calculation, as Engine::compute() does */
+    static Decimal calculate(const Decimal &a, const Decimal &b, int op, bool *error);
+
+private:
+    /** Sign */
+    bool negative;
+    /** Coefficient */
+    quint128 coefficient;
+    /** Exponent */
+    int exponent;
+    /** Constructor from parts, rounding the coefficient */
+    Decimal(bool negative, quint128 coefficient, int exponent, bool sticky);
+    /** Add or subtract two numbers */
+    static Decimal addSigned(const Decimal &a, const Decimal &b, bool negateB);
+    /** Drop trailing zeros down to an exponent */
+    void reduce(int idealExponent);
+};
+
+#endif // DECIMAL_H
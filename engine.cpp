@@ -0,0 +1,2502 @@
+/** @file engine.cpp
+ *
+ *  @brief This file contains the definitions of the calculator engine
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "engine.h"
+#include "expression.h"
+#include "format.h"
+#include "gamma.h"
+#include "history.h"
+#include "parse.h"
+
+#include <float.h>
+#include <math.h>
+
+#if STATS
+/** Count an event if statistics are collected */
+#define STATS_COUNT(counter)    do { if (stats != 0) { stats->count(counter); } } while (0)
+#else
+/** Statistics compiled out */
+#define STATS_COUNT(counter)    do { } while (0)
+#endif
+
+/** Error of the decimal logarithm of a factorial, in units in its last place */
+#define FACTORIAL_LOG_ULPS  8
+
+/* Keypad tables */
+
+/** Key class : Digit 2 to 9 */
+#define KEY_DIGIT           0
+/** Key class : Digit 0 or 1 */
+#define KEY_BINARY_DIGIT    1
+/** Key class : Square or square root */
+#define KEY_UNARY           2
+/** Key class : Cube */
+#define KEY_CUBE            3
+/** Key class : Inverse */
+#define KEY_INV             4
+/** Key class : Factorial */
+#define KEY_FACT            5
+/** Key class : Sign */
+#define KEY_SIGN            6
+/** Key class : Dot */
+#define KEY_DOT             7
+/** Key class : Binary operator */
+#define KEY_OPERATOR        8
+/** Key class : Equal to */
+#define KEY_EQ              9
+/** Key class : Memory clear */
+#define KEY_MC              10
+/** Key class : Memory recall */
+#define KEY_MR              11
+/** Key class : Memory set */
+#define KEY_MS              12
+/** Key class : Memory plus */
+#define KEY_MP              13
+/** Key class : Backspace */
+#define KEY_BS              14
+/** Key class : Clear */
+#define KEY_CLR             15
+/** Key class : Binary */
+#define KEY_BIN             16
+/** Key class : Hexadecimal */
+#define KEY_HEX             17
+/** Key class : Ignored in the mode */
+#define KEY_IGNORE          18
+/** Key class : Factorial, exact */
+#define KEY_FACT_EXACT      19
+/** Key class : Sign, two's complement */
+#define KEY_NEGATE          20
+/** Number of key classes */
+#define NUM_KEYS            21
+
+/** Keypad mode : Double precision */
+#define KEYPAD_DOUBLE       0
+/** Keypad mode : Arbitrary precision or decimal */
+#define KEYPAD_EXACT        1
+/** Keypad mode : Integer in decimal */
+#define KEYPAD_INTEGER      2
+/** Keypad mode : Integer in binary */
+#define KEYPAD_BINARY       3
+/** Keypad mode : Integer in hexadecimal */
+#define KEYPAD_HEX          4
+/** Number of keypad modes */
+#define NUM_KEYPAD_MODES    5
+
+/** Action : Nothing */
+#define ACTION_NONE         0
+/** Action : Start a new number with the digit */
+#define ACTION_DIGIT_NEW    1
+/** Action : Start a fraction with the digit */
+#define ACTION_DIGIT_FRACTION   2
+/** Action : Append the digit */
+#define ACTION_DIGIT_APPEND 3
+/** Action : Unary operation, nothing shown on an error */
+#define ACTION_UNARY        4
+/** Action : Unary operation, shown even on an error */
+#define ACTION_UNARY_SHOW   5
+/** Action : Factorial in double precision */
+#define ACTION_FACT         6
+/** Action : Show an error */
+#define ACTION_ERROR        7
+/** Action : Add or remove the sign */
+#define ACTION_SIGN         8
+/** Action : Negate in two's complement */
+#define ACTION_NEGATE       9
+/** Action : Start a fraction */
+#define ACTION_DOT_NEW      10
+/** Action : Append the dot */
+#define ACTION_DOT_APPEND   11
+/** Action : Only set the operator */
+#define ACTION_OP_SET       12
+/** Action : Save the operand and set the operator */
+#define ACTION_OP_SAVE      13
+/** Action : Calculate with the saved operand, if any, and set the operator */
+#define ACTION_OP_CALC      14
+/** Action : Equal to, nothing to calculate */
+#define ACTION_EQ_NONE      15
+/** Action : Equal to, calculate */
+#define ACTION_EQ_CALC      16
+/** Action : Memory clear */
+#define ACTION_MC           17
+/** Action : Memory recall */
+#define ACTION_MR           18
+/** Action : Memory set */
+#define ACTION_MS           19
+/** Action : Memory plus */
+#define ACTION_MP           20
+/** Action : Backspace */
+#define ACTION_BS           21
+/** Action : Clear */
+#define ACTION_CLR          22
+/** Action : Switch binary */
+#define ACTION_BIN          23
+/** Action : Switch hexadecimal */
+#define ACTION_HEX          24
+/** Action : Memory plus of zero, only summed up */
+#define ACTION_MP_ZERO      25
+
+/** Key class and argument of a button */
+struct KeypadButton
+{
+    /** KEY_ class */
+    unsigned char key;
+    /** OPERATOR_ or UNARY_ argument */
+    unsigned char argument;
+};
+
+/** Key class and argument of each button, laid out as buttonLabels */
+static const KeypadButton keypadButtons[NUM_BUTTONS] = {
+        { KEY_DIGIT, 0 },  { KEY_DIGIT, 0 },  { KEY_DIGIT, 0 }, { KEY_OPERATOR, OPERATOR_DIV },   { KEY_CLR, 0 },
+        { KEY_DIGIT, 0 },  { KEY_DIGIT, 0 },  { KEY_DIGIT, 0 }, { KEY_OPERATOR, OPERATOR_MUL },   { KEY_UNARY, UNARY_SQ },
+        { KEY_BINARY_DIGIT, 0 }, { KEY_DIGIT, 0 }, { KEY_DIGIT, 0 }, { KEY_OPERATOR, OPERATOR_MINUS }, { KEY_INV, UNARY_INV },
+        { KEY_BINARY_DIGIT, 0 }, { KEY_SIGN, 0 }, { KEY_DOT, 0 }, { KEY_OPERATOR, OPERATOR_PLUS },  { KEY_EQ, 0 },
+        { KEY_MC, 0 },     { KEY_MR, 0 },     { KEY_MS, 0 },    { KEY_MP, 0 },                    { KEY_BS, 0 },
+        { KEY_UNARY, UNARY_SQRT }, { KEY_FACT, UNARY_FACT }, { KEY_CUBE, UNARY_CUBE }, { KEY_BIN, 0 }, { KEY_HEX, 0 } };
+
+/** Key class in each keypad mode, where the mode changes it */
+static const unsigned char keypadKeys[NUM_KEYPAD_MODES][KEY_HEX + 1] = {
+        /* Double precision */
+        { KEY_DIGIT, KEY_BINARY_DIGIT, KEY_UNARY, KEY_CUBE, KEY_INV, KEY_FACT, KEY_SIGN, KEY_DOT,
+          KEY_OPERATOR, KEY_EQ, KEY_MC, KEY_MR, KEY_MS, KEY_MP, KEY_BS, KEY_CLR, KEY_BIN, KEY_HEX },
+        /* Arbitrary precision or decimal, the factorial is exact */
+        { KEY_DIGIT, KEY_BINARY_DIGIT, KEY_UNARY, KEY_CUBE, KEY_INV, KEY_FACT_EXACT, KEY_SIGN, KEY_DOT,
+          KEY_OPERATOR, KEY_EQ, KEY_MC, KEY_MR, KEY_MS, KEY_MP, KEY_BS, KEY_CLR, KEY_BIN, KEY_HEX },
+        /* Integer in decimal, there is no fraction */
+        { KEY_DIGIT, KEY_BINARY_DIGIT, KEY_UNARY, KEY_CUBE, KEY_INV, KEY_FACT_EXACT, KEY_SIGN, KEY_IGNORE,
+          KEY_OPERATOR, KEY_EQ, KEY_MC, KEY_MR, KEY_MS, KEY_MP, KEY_BS, KEY_CLR, KEY_BIN, KEY_HEX },
+        /* Integer in binary, 0 and 1 only and no sign shown */
+        { KEY_IGNORE, KEY_BINARY_DIGIT, KEY_UNARY, KEY_CUBE, KEY_INV, KEY_FACT_EXACT, KEY_NEGATE, KEY_IGNORE,
+          KEY_OPERATOR, KEY_EQ, KEY_MC, KEY_MR, KEY_MS, KEY_MP, KEY_BS, KEY_CLR, KEY_BIN, KEY_HEX },
+        /* Integer in hexadecimal, no sign shown */
+        { KEY_DIGIT, KEY_BINARY_DIGIT, KEY_UNARY, KEY_CUBE, KEY_INV, KEY_FACT_EXACT, KEY_NEGATE, KEY_IGNORE,
+          KEY_OPERATOR, KEY_EQ, KEY_MC, KEY_MR, KEY_MS, KEY_MP, KEY_BS, KEY_CLR, KEY_BIN, KEY_HEX } };
+
+/** Actions for a non-zero and a zero value, the same after any button type */
+#define KEYPAD_ROW(nonZero, zero) \
+        { { nonZero, zero }, { nonZero, zero }, { nonZero, zero }, \
+          { nonZero, zero }, { nonZero, zero }, { nonZero, zero } }
+
+/** Action of a key class after each button type, for a non-zero and a zero value */
+static const unsigned char keypadActions[NUM_KEYS][NUM_TYPES][2] = {
+        /* Digit: after an operator or equal to a new number is taken */
+        { { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW },    /* TYPE_INIT */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW },    /* TYPE_NUM */
+          { ACTION_DIGIT_NEW, ACTION_DIGIT_NEW },       /* TYPE_OP */
+          { ACTION_DIGIT_NEW, ACTION_DIGIT_NEW },       /* TYPE_EQ */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_FRACTION }, /* TYPE_DOT */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW } },  /* TYPE_OTHER */
+        /* Digit 0 or 1 */
+        { { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW },    /* TYPE_INIT */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW },    /* TYPE_NUM */
+          { ACTION_DIGIT_NEW, ACTION_DIGIT_NEW },       /* TYPE_OP */
+          { ACTION_DIGIT_NEW, ACTION_DIGIT_NEW },       /* TYPE_EQ */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_FRACTION }, /* TYPE_DOT */
+          { ACTION_DIGIT_APPEND, ACTION_DIGIT_NEW } },  /* TYPE_OTHER */
+        /* Square or square root, only for a non-zero value */
+        KEYPAD_ROW(ACTION_UNARY, ACTION_NONE),
+        /* Cube, only for a non-zero value */
+        KEYPAD_ROW(ACTION_UNARY_SHOW, ACTION_NONE),
+        /* Inverse, zero makes a divide-by-zero error */
+        KEYPAD_ROW(ACTION_UNARY_SHOW, ACTION_ERROR),
+        /* Factorial */
+        KEYPAD_ROW(ACTION_FACT, ACTION_FACT),
+        /* Sign */
+        KEYPAD_ROW(ACTION_SIGN, ACTION_SIGN),
+        /* Dot: after an operator a new number is taken */
+        { { ACTION_DOT_APPEND, ACTION_DOT_NEW },        /* TYPE_INIT */
+          { ACTION_DOT_APPEND, ACTION_DOT_NEW },        /* TYPE_NUM */
+          { ACTION_DOT_NEW, ACTION_DOT_NEW },           /* TYPE_OP */
+          { ACTION_DOT_APPEND, ACTION_DOT_NEW },        /* TYPE_EQ */
+          { ACTION_DOT_APPEND, ACTION_DOT_NEW },        /* TYPE_DOT */
+          { ACTION_DOT_APPEND, ACTION_DOT_NEW } },      /* TYPE_OTHER */
+        /* Binary operator: after an operator it only replaces it */
+        { { ACTION_OP_CALC, ACTION_OP_SET },            /* TYPE_INIT */
+          { ACTION_OP_CALC, ACTION_OP_SET },            /* TYPE_NUM */
+          { ACTION_OP_SET, ACTION_OP_SET },             /* TYPE_OP */
+          { ACTION_OP_SAVE, ACTION_OP_SET },            /* TYPE_EQ */
+          { ACTION_OP_CALC, ACTION_OP_SET },            /* TYPE_DOT */
+          { ACTION_OP_CALC, ACTION_OP_SET } },          /* TYPE_OTHER */
+        /* Equal to: after an operator or equal to there is nothing to do */
+        { { ACTION_EQ_CALC, ACTION_EQ_NONE },           /* TYPE_INIT */
+          { ACTION_EQ_CALC, ACTION_EQ_NONE },           /* TYPE_NUM */
+          { ACTION_EQ_NONE, ACTION_EQ_NONE },           /* TYPE_OP */
+          { ACTION_EQ_NONE, ACTION_EQ_NONE },           /* TYPE_EQ */
+          { ACTION_EQ_CALC, ACTION_EQ_NONE },           /* TYPE_DOT */
+          { ACTION_EQ_CALC, ACTION_EQ_NONE } },         /* TYPE_OTHER */
+        /* Memory clear */
+        KEYPAD_ROW(ACTION_MC, ACTION_MC),
+        /* Memory recall */
+        KEYPAD_ROW(ACTION_MR, ACTION_MR),
+        /* Memory set */
+        KEYPAD_ROW(ACTION_MS, ACTION_MS),
+        /* Memory plus, zero only counts in the summary */
+        KEYPAD_ROW(ACTION_MP, ACTION_MP_ZERO),
+        /* Backspace */
+        KEYPAD_ROW(ACTION_BS, ACTION_BS),
+        /* Clear */
+        KEYPAD_ROW(ACTION_CLR, ACTION_CLR),
+        /* Binary */
+        KEYPAD_ROW(ACTION_BIN, ACTION_BIN),
+        /* Hexadecimal */
+        KEYPAD_ROW(ACTION_HEX, ACTION_HEX),
+        /* Ignored */
+        KEYPAD_ROW(ACTION_NONE, ACTION_NONE),
+        /* Factorial, exact: errors are shown by the calculation */
+        KEYPAD_ROW(ACTION_UNARY, ACTION_UNARY),
+        /* Sign, two's complement */
+        KEYPAD_ROW(ACTION_NEGATE, ACTION_NEGATE) };
+
+/** Keypad mode of each arithmetic and base */
+static const unsigned char keypadModes[ARITH_INTEGER + 1][MODE_HEX + 1] = {
+        { KEYPAD_DOUBLE, KEYPAD_DOUBLE, KEYPAD_DOUBLE, KEYPAD_DOUBLE },     /* ARITH_DOUBLE */
+        { KEYPAD_EXACT, KEYPAD_EXACT, KEYPAD_EXACT, KEYPAD_EXACT },         /* ARITH_BIG */
+        { KEYPAD_EXACT, KEYPAD_EXACT, KEYPAD_EXACT, KEYPAD_EXACT },         /* ARITH_DECIMAL */
+        { KEYPAD_INTEGER, KEYPAD_INTEGER, KEYPAD_BINARY, KEYPAD_HEX } };    /* ARITH_INTEGER */
+
+/**
+ *  @brief  Engine object constructor
+ *
+ *  @return N/A
+ */
+Engine::Engine()
+    : listener(0), arithMode(ARITH_DOUBLE), bigDigits(BIG_DEFAULT_DIGITS), history(0), historyBuffer(0),
+      isSummaryEnabled(false),
+      radix(MODE_DEC)
+{
+#if STATS
+    /* Nothing collected until asked for */
+    stats = 0;
+#endif
+
+    /* Start from init status */
+    reset();
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Reset the engine to init status
+ *
+ *  @return N/A
+ */
+void Engine::reset(void)
+{
+    /* Reset everything, including memory text and modes */
+    setDecimalStatus(false);
+    setNegativeStatus(false);
+    setRegister(REG_LCD, 0);
+    displayText = "0";
+    setOperator(OPERATOR_NONE);
+    setRegister(REG_OPERAND, 0);
+    setLastClicked(TYPE_INIT);
+    setRegister(REG_MEMORY, 0);
+    setRegister(REG_TEMP, 0);
+    radix = MODE_DEC;
+    showRadix();
+    setNumDigits(1);
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Set the listener for state changes
+ *
+ *  @param  newListener     Listener to notify, 0 for none
+ *
+ *  @return N/A
+ */
+void Engine::setListener(EngineListener *newListener)
+{
+    /* Set listener */
+    listener = newListener;
+    return;
+}
+
+/**
+ *  @brief  Number base of a mode
+ *
+ *  @param  mode    MODE_DEC, MODE_BIN or MODE_HEX
+ *
+ *  @return 10, 2 or 16
+ */
+static int radixBase(int mode)
+{
+    if (mode == MODE_BIN) {
+        return 2;
+    } else if (mode == MODE_HEX) {
+        return 16;
+    }
+    return 10;
+}
+
+/**
+ *  @brief  Parse an integer, in a base or as any other number
+ *
+ *  @param  text    Text
+ *  @param  base    2, 10 or 16
+ *
+ *  @return Value, a fraction is truncated
+ */
+static qint64 parseInteger(const QString &text, int base)
+{
+    qint64 value;
+
+    /* Fall back to a double for fractions and exponents */
+    if (Integer::fromString(text, base, &value)) {
+        return value;
+    }
+    return Integer::fromDouble(Parse::toDouble(text));
+}
+
+/**
+ *  @brief  Engine object method : Get the current set text
+ *
+ *  @return Current set text
+ */
+QString Engine::getText(void)
+{
+    /* Derive the text from the LCD register only when needed */
+    if (!isTextValid) {
+        STATS_COUNT(STAT_FORMAT);
+        if (arithMode == ARITH_BIG) {
+            lcdText = bigRegisters[REG_LCD].toString(bigDigits);
+        } else if (arithMode == ARITH_DECIMAL) {
+            lcdText = decimalRegisters[REG_LCD].toString();
+        } else if (arithMode == ARITH_INTEGER) {
+            lcdText = Integer::toString(intRegisters[REG_LCD], radixBase(radix));
+        } else {
+            lcdText = Format::toString(registers[REG_LCD]);
+        }
+        isTextValid = true;
+    }
+
+    /* Return set text */
+    return lcdText;
+}
+
+/**
+ *  @brief  Engine object method : Set the current text
+ *
+ *  @param  newText     The text to set
+ *
+ *  @return N/A
+ */
+void Engine::setText(QString newText)
+{
+    /* Set text, the LCD register is parsed from it when needed */
+    lcdText = newText;
+    isTextValid = true;
+    isValueValid = false;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the text shown in LCD
+ *
+ *  @return Text last shown in LCD
+ */
+QString Engine::getDisplayText(void)
+{
+    /* Return shown text */
+    return displayText;
+}
+
+/**
+ *  @brief  Engine object method : Get a register value
+ *
+ *  @param  reg     Register to get
+ *
+ *  @return Current register value
+ */
+double Engine::getRegister(int reg)
+{
+    /* Parse the LCD register from the text only when needed */
+    if (reg == REG_LCD) {
+        parseLCD();
+    }
+
+    /* Return register value */
+    if (arithMode == ARITH_BIG) {
+        return bigRegisters[reg].toDouble();
+    } else if (arithMode == ARITH_DECIMAL) {
+        return decimalRegisters[reg].toDouble();
+    } else if (arithMode == ARITH_INTEGER) {
+        return (double) intRegisters[reg];
+    }
+    return registers[reg];
+}
+
+/**
+ *  @brief  Engine object method : Get the exact text of a register
+ *
+ *  Texts in the current arithmetic with all its digits, doubles with the
+ *  fewest digits that parse back and integers in base 10.
+ *
+ *  @param  reg     Register to get
+ *
+ *  @return Text of the register value
+ */
+QString Engine::getRegisterText(int reg)
+{
+    /* Parse the LCD register from the text only when needed */
+    if (reg == REG_LCD) {
+        parseLCD();
+    }
+
+    /* Convert the register */
+    if (arithMode == ARITH_BIG) {
+        return bigRegisters[reg].toString(bigDigits);
+    } else if (arithMode == ARITH_DECIMAL) {
+        return decimalRegisters[reg].toString();
+    } else if (arithMode == ARITH_INTEGER) {
+        return Integer::toString(intRegisters[reg], 10);
+    }
+
+    /* The LCD text may be rounded to fit */
+    QString text = Format::toString(registers[reg]);
+    if (!(Parse::toDouble(text) == registers[reg])) {
+        text = QString::number(registers[reg], 'g', 17);
+    }
+    return text;
+}
+
+/**
+ *  @brief  Engine object method : Set a register value
+ *
+ *  @param  reg     Register to set
+ *  @param  value   The value to set
+ *
+ *  @return N/A
+ */
+void Engine::setRegister(int reg, double value)
+{
+    /* Set register value */
+    if (arithMode == ARITH_BIG) {
+        bigRegisters[reg] = BigFloat(value);
+    } else if (arithMode == ARITH_DECIMAL) {
+        decimalRegisters[reg] = Decimal(value);
+    } else if (arithMode == ARITH_INTEGER) {
+        intRegisters[reg] = Integer::fromDouble(value);
+    } else {
+        registers[reg] = value;
+    }
+
+    /* The LCD text is formatted from it when needed */
+    if (reg == REG_LCD) {
+        isValueValid = true;
+        isTextValid = false;
+    }
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Parse the LCD register from the text if needed
+ *
+ *  @return N/A
+ */
+void Engine::parseLCD(void)
+{
+    /* Nothing to do if the register is up to date */
+    if (isValueValid) {
+        return;
+    }
+
+    /* Parse in the current arithmetic */
+    STATS_COUNT(STAT_PARSE);
+    if (arithMode == ARITH_BIG) {
+        bigRegisters[REG_LCD] = BigFloat::fromString(lcdText, 0);
+    } else if (arithMode == ARITH_DECIMAL) {
+        decimalRegisters[REG_LCD] = Decimal::fromString(lcdText, 0);
+    } else if (arithMode == ARITH_INTEGER) {
+        intRegisters[REG_LCD] = parseInteger(lcdText, radixBase(radix));
+    } else {
+        registers[REG_LCD] = Parse::toDouble(lcdText);
+    }
+    isValueValid = true;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Check a register for zero
+ *
+ *  @param  reg     Register to check
+ *
+ *  @return true if the register is zero
+ */
+bool Engine::isRegisterZero(int reg)
+{
+    /* Parse the LCD register from the text only when needed */
+    if (reg == REG_LCD) {
+        parseLCD();
+    }
+
+    /* Check in the current arithmetic */
+    if (arithMode == ARITH_BIG) {
+        return bigRegisters[reg].isZero();
+    } else if (arithMode == ARITH_DECIMAL) {
+        return decimalRegisters[reg].isZero();
+    } else if (arithMode == ARITH_INTEGER) {
+        return intRegisters[reg] == 0;
+    }
+    return registers[reg] == 0;
+}
+
+/**
+ *  @brief  Engine object method : Copy a register
+ *
+ *  @param  dst     Register to set
+ *  @param  src     Register to copy
+ *
+ *  @return N/A
+ */
+void Engine::copyRegister(int dst, int src)
+{
+    /* Parse the LCD register from the text only when needed */
+    if (src == REG_LCD) {
+        parseLCD();
+    }
+
+    /* Copy in the current arithmetic, without going through a double */
+    if (arithMode == ARITH_BIG) {
+        bigRegisters[dst] = bigRegisters[src];
+    } else if (arithMode == ARITH_DECIMAL) {
+        decimalRegisters[dst] = decimalRegisters[src];
+    } else if (arithMode == ARITH_INTEGER) {
+        intRegisters[dst] = intRegisters[src];
+    } else {
+        registers[dst] = registers[src];
+    }
+
+    /* The LCD text is formatted from it when needed */
+    if (dst == REG_LCD) {
+        isValueValid = true;
+        isTextValid = false;
+    }
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Make calculation on registers
+ *
+ *  @param  dst     Register for the result
+ *  @param  src1    Register of operand 1
+ *  @param  src2    Register of operand 2
+ *  @param  op      Operator
+ *
+ *  @return true on success, the error is shown and the result is 0 otherwise
+ */
+bool Engine::calculateRegister(int dst, int src1, int src2, int op)
+{
+    bool error = false;
+    double operand1 = 0, operand2 = 0;
+    QByteArray operandText;
+
+    /* Parse the LCD register from the text only when needed */
+    if ((src1 == REG_LCD) || (src2 == REG_LCD)) {
+        parseLCD();
+    }
+
+    /* The history keeps the operands, the destination may be one of them */
+    if (isLogging()) {
+        operand1 = getRegister(src1);
+        operand2 = getRegister(src2);
+        operandText = getRegisterText(src1).toUtf8();
+        operandText.append('\0');
+        operandText.append(getRegisterText(src2).toUtf8());
+        operandText.append('\0');
+    }
+
+    /* Perform the calculation in the current arithmetic, 0 on error */
+    STATS_COUNT(STAT_CALCULATE);
+    if (arithMode == ARITH_BIG) {
+        bigRegisters[dst] = BigFloat::calculate(bigRegisters[src1], bigRegisters[src2], op, bigDigits, &error, cancel);
+    } else if (arithMode == ARITH_DECIMAL) {
+        decimalRegisters[dst] = Decimal::calculate(decimalRegisters[src1], decimalRegisters[src2], op, &error);
+    } else if (arithMode == ARITH_INTEGER) {
+        intRegisters[dst] = Integer::calculate(intRegisters[src1], intRegisters[src2], op, &error);
+    } else {
+        registers[dst] = compute(registers[src1], registers[src2], op, &error);
+    }
+
+    if (isLogging()) {
+        logCalculation(op, error ? HISTORY_ERROR : 0, operand1, operand2, operandText, dst);
+    }
+
+    if (error) {
+        /* Show the error, it resets the LCD register */
+        showError();
+        return false;
+    }
+
+    /* The LCD text is formatted from it when needed */
+    if (dst == REG_LCD) {
+        isValueValid = true;
+        isTextValid = false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Unary operation in double precision
+ *
+ *  @param  x       Operand
+ *  @param  op      Unary operation
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Result, 0 on error
+ */
+static double unaryDouble(double x, int op, bool *error)
+{
+    /* Same steps as the buttons always took */
+    switch (op) {
+        case UNARY_SQ:
+            return Engine::compute(x, x, OPERATOR_MUL, error);
+        case UNARY_SQRT:
+            return Engine::compute(x, x, OPERATOR_SQRT, error);
+        case UNARY_FACT:
+            return Engine::compute(x, x, OPERATOR_FACT, error);
+        case UNARY_INV:
+            return Engine::compute(1, x, OPERATOR_DIV, error);
+        case UNARY_CUBE:
+            return Engine::compute(Engine::compute(x, x, OPERATOR_MUL, error), x, OPERATOR_MUL, error);
+        default:
+            return 0;
+    }
+}
+
+/**
+ *  @brief  Unary operation in arbitrary precision
+ *
+ *  @param  x       Operand
+ *  @param  op      Unary operation
+ *  @param  digits  Precision in digits
+ *  @param  error   Set to true on error, left untouched otherwise
+ *  @param  cancel  Request to stop
+ *
+ *  @return Result, 0 on error
+ */
+static BigFloat unaryBig(const BigFloat &x, int op, int digits, bool *error, const BigCancel &cancel)
+{
+    /* Same steps as the buttons always took */
+    switch (op) {
+        case UNARY_SQ:
+            return BigFloat::calculate(x, x, OPERATOR_MUL, digits, error, cancel);
+        case UNARY_SQRT:
+            return BigFloat::calculate(x, x, OPERATOR_SQRT, digits, error, cancel);
+        case UNARY_FACT:
+            return BigFloat::calculate(x, x, OPERATOR_FACT, digits, error, cancel);
+        case UNARY_INV:
+            return BigFloat::calculate(BigFloat(1.0), x, OPERATOR_DIV, digits, error, cancel);
+        case UNARY_CUBE:
+            return BigFloat::calculate(BigFloat::calculate(x, x, OPERATOR_MUL, digits, error, cancel), x,
+                                       OPERATOR_MUL, digits, error, cancel);
+        default:
+            return BigFloat();
+    }
+}
+
+/**
+ *  @brief  Unary operation in decimal
+ *
+ *  @param  x       Operand
+ *  @param  op      Unary operation
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Result, 0 on error
+ */
+static Decimal unaryDecimal(const Decimal &x, int op, bool *error)
+{
+    /* Same steps as the buttons always took */
+    switch (op) {
+        case UNARY_SQ:
+            return Decimal::calculate(x, x, OPERATOR_MUL, error);
+        case UNARY_SQRT:
+            return Decimal::calculate(x, x, OPERATOR_SQRT, error);
+        case UNARY_FACT:
+            return Decimal::calculate(x, x, OPERATOR_FACT, error);
+        case UNARY_INV:
+            return Decimal::calculate(Decimal(1.0), x, OPERATOR_DIV, error);
+        case UNARY_CUBE:
+            return Decimal::calculate(Decimal::calculate(x, x, OPERATOR_MUL, error), x, OPERATOR_MUL, error);
+        default:
+            return Decimal();
+    }
+}
+
+/**
+ *  @brief  Unary operation in 64-bit integer
+ *
+ *  @param  x       Operand
+ *  @param  op      Unary operation
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Result, 0 on error
+ */
+static qint64 unaryInteger(qint64 x, int op, bool *error)
+{
+    /* Same steps as the buttons always took */
+    switch (op) {
+        case UNARY_SQ:
+            return Integer::calculate(x, x, OPERATOR_MUL, error);
+        case UNARY_SQRT:
+            return Integer::calculate(x, x, OPERATOR_SQRT, error);
+        case UNARY_FACT:
+            return Integer::calculate(x, x, OPERATOR_FACT, error);
+        case UNARY_INV:
+            return Integer::calculate(1, x, OPERATOR_DIV, error);
+        case UNARY_CUBE:
+            return Integer::calculate(Integer::calculate(x, x, OPERATOR_MUL, error), x, OPERATOR_MUL, error);
+        default:
+            return 0;
+    }
+}
+
+/**
+ *  @brief  Engine object method : Make unary operation on a register
+ *
+ *  Results are looked up in the memo table first, repeated operations on
+ *  the same operand are then only a copy.
+ *
+ *  @param  reg     Register for the operand and the result
+ *  @param  op      Unary operation
+ *
+ *  @return true on success, the error is shown and the result is 0 otherwise
+ */
+bool Engine::calculateUnary(int reg, int op)
+{
+    bool error = false;
+
+    /* Parse the LCD register from the text only when needed */
+    if (reg == REG_LCD) {
+        parseLCD();
+    }
+
+    /* The history keeps the operand, unary operations have no second one */
+    double operand = 0;
+    QByteArray operandText;
+    if (isLogging()) {
+        operand = getRegister(reg);
+        operandText = getRegisterText(reg).toUtf8();
+        operandText.append('\0');
+        operandText.append('\0');
+    }
+
+    /* Use the memo table, compute and save on a miss */
+    STATS_COUNT(STAT_CALCULATE);
+    if (arithMode == ARITH_BIG) {
+        BigFloat result;
+        if (!memo.lookup(op, bigRegisters[reg], bigDigits, &result, &error)) {
+            result = unaryBig(bigRegisters[reg], op, bigDigits, &error, cancel);
+            /* A cancelled result is no result to remember */
+            if (!cancel.isCancelled()) {
+                memo.insert(op, bigRegisters[reg], bigDigits, result, error);
+            }
+        }
+        bigRegisters[reg] = result;
+    } else if (arithMode == ARITH_DECIMAL) {
+        Decimal result;
+        if (!memo.lookup(op, decimalRegisters[reg], &result, &error)) {
+            result = unaryDecimal(decimalRegisters[reg], op, &error);
+            memo.insert(op, decimalRegisters[reg], result, error);
+        }
+        decimalRegisters[reg] = result;
+    } else if (arithMode == ARITH_INTEGER) {
+        /* Quicker than a lookup */
+        intRegisters[reg] = unaryInteger(intRegisters[reg], op, &error);
+    } else {
+        double result;
+        if (!memo.lookup(op, registers[reg], &result, &error)) {
+            result = unaryDouble(registers[reg], op, &error);
+            memo.insert(op, registers[reg], result, error);
+        }
+        registers[reg] = result;
+    }
+
+    if (isLogging()) {
+        logCalculation(op, HISTORY_UNARY | (error ? HISTORY_ERROR : 0), operand, 0, operandText, reg);
+    }
+
+    if (error) {
+        /* Show the error, it resets the LCD register */
+        showError();
+        return false;
+    }
+
+    /* The LCD text is formatted from it when needed */
+    if (reg == REG_LCD) {
+        isValueValid = true;
+        isTextValid = false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Engine object method : Get the unary result memo table
+ *
+ *  @return Memo table, for its counters
+ */
+MemoCache *Engine::getMemoCache(void)
+{
+    /* Return memo table */
+    return &memo;
+}
+
+#if STATS
+/**
+ *  @brief  Engine object method : Set the statistics to collect into
+ *
+ *  @param  newStats    Statistics, 0 to stop collecting
+ *
+ *  @return N/A
+ */
+void Engine::setStats(EngineStats *newStats)
+{
+    /* Set statistics */
+    stats = newStats;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Dump the statistics
+ *
+ *  @param  out     Output stream
+ *
+ *  @return N/A
+ */
+void Engine::dumpStats(FILE *out)
+{
+    QString names[STATS_KEYS];
+
+    /* Name the keys as their buttons */
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        names[i] = buttonLabels[i];
+    }
+#if HEX
+    for (int i = 0; i < NUM_HEX_BUTTONS; i++) {
+        names[NUM_BUTTONS + i] = hexButtonLabels[i];
+    }
+#endif
+
+    fprintf(out, "memo hits %llu misses %llu\n",
+            (unsigned long long) memo.getHits(), (unsigned long long) memo.getMisses());
+    if (stats != 0) {
+        stats->dump(out, names, STATS_KEYS);
+    }
+    return;
+}
+#endif
+
+/**
+ *  @brief  Engine object method : Set the history to log calculations to
+ *
+ *  @param  newHistory  History, 0 to stop logging
+ *
+ *  @return N/A
+ */
+void Engine::setHistory(HistoryLog *newHistory)
+{
+    /* Set history */
+    history = newHistory;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Set the buffer to hold logged calculations in
+ *
+ *  A copy of the engine working in the background holds its calculations
+ *  here, they are appended to the history once the copy is taken back.
+ *
+ *  @param  buffer  Buffer used instead of the history, 0 for none
+ *
+ *  @return N/A
+ */
+void Engine::setHistoryBuffer(QVector<HistoryEntry> *buffer)
+{
+    /* Set history buffer */
+    historyBuffer = buffer;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Set the request to stop long calculations
+ *
+ *  A copy of the engine working in the background is given one, its
+ *  arbitrary precision calculations fail as soon as it is made.
+ *
+ *  @param  newCancel   Request to stop
+ *
+ *  @return N/A
+ */
+void Engine::setCancel(const BigCancel &newCancel)
+{
+    /* Set cancel request */
+    cancel = newCancel;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Check if calculations are logged
+ *
+ *  @return true if there is a history or a buffer to log to
+ */
+bool Engine::isLogging(void)
+{
+    /* Return logging status */
+    return (history != 0) || (historyBuffer != 0);
+}
+
+/**
+ *  @brief  Engine object method : Get the summary status
+ *
+ *  @return true if 'M+' sums up the values
+ */
+bool Engine::getSummaryMode(void)
+{
+    /* Return summary status */
+    return isSummaryEnabled;
+}
+
+/**
+ *  @brief  Engine object method : Start or stop summing up the values added to memory
+ *
+ *  Starting forgets the values summed up before, stopping keeps them.
+ *
+ *  @param  status  true to start, false to stop
+ *
+ *  @return N/A
+ */
+void Engine::setSummaryMode(bool status)
+{
+    /* Start afresh */
+    if (status && !isSummaryEnabled) {
+        summary.clear();
+    }
+    isSummaryEnabled = status;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the statistics of the values added to memory
+ *
+ *  @return Pointer to the statistics
+ */
+const Accumulator *Engine::getSummary(void)
+{
+    /* Return summary */
+    return &summary;
+}
+
+/**
+ *  @brief  Engine object method : Log a calculation to the history
+ *
+ *  Values are kept as doubles to search, and as their exact texts in the
+ *  arithmetic of the calculation.
+ *
+ *  @param  op          Operator, or unary operation with HISTORY_UNARY
+ *  @param  flags       HISTORY_* flags
+ *  @param  operand1    Operand 1
+ *  @param  operand2    Operand 2
+ *  @param  operandText Texts of the operands, each ended by a null
+ *  @param  reg         Register holding the result, not used on error
+ *
+ *  @return N/A
+ */
+void Engine::logCalculation(int op, int flags, double operand1, double operand2, const QByteArray &operandText, int reg)
+{
+    HistoryEntry entry;
+    bool isError = (flags & HISTORY_ERROR) != 0;
+
+    /* Fill the record, the text offset is set when appended */
+    entry.record.time = HistoryLog::now();
+    entry.record.operand1 = operand1;
+    entry.record.operand2 = operand2;
+    entry.record.result = isError ? 0 : getRegister(reg);
+    entry.record.textOffset = 0;
+    entry.record.textLength = 0;
+    entry.record.op = op;
+    entry.record.arithMode = arithMode;
+    entry.record.flags = flags;
+
+    /* The texts, no result on error */
+    entry.text = operandText;
+    if (!isError) {
+        entry.text.append(getRegisterText(reg).toUtf8());
+    }
+    entry.text.append('\0');
+
+    /* Append it */
+    if (historyBuffer != 0) {
+        historyBuffer->append(entry);
+    } else {
+        history->append(entry);
+    }
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the arithmetic
+ *
+ *  @return ARITH_DOUBLE, ARITH_BIG, ARITH_DECIMAL or ARITH_INTEGER
+ */
+int Engine::getArithMode(void)
+{
+    /* Return arithmetic */
+    return arithMode;
+}
+
+/**
+ *  @brief  Engine object method : Set the arithmetic
+ *
+ *  @param  mode    ARITH_DOUBLE, ARITH_BIG, ARITH_DECIMAL or ARITH_INTEGER
+ *
+ *  @return N/A
+ */
+void Engine::setArithMode(int mode)
+{
+    /* Nothing to do if unchanged */
+    if (mode == arithMode) {
+        return;
+    }
+
+    /* Integer text may be in another base, the others parse it */
+    if (arithMode == ARITH_INTEGER) {
+        parseLCD();
+    }
+
+    /* Convert the registers, an LCD text newer than its register is parsed later */
+    for (int reg = 0; reg < NUM_REGISTERS; reg++) {
+        if ((reg == REG_LCD) && !isValueValid) {
+            continue;
+        }
+        if (arithMode == ARITH_DOUBLE) {
+            /* Doubles convert with the fewest digits that round trip */
+            bigRegisters[reg] = BigFloat(registers[reg]);
+            decimalRegisters[reg] = Decimal(registers[reg]);
+            intRegisters[reg] = Integer::fromDouble(registers[reg]);
+        } else if (arithMode == ARITH_INTEGER) {
+            /* Integers exactly through their decimal text */
+            QString text = Integer::toString(intRegisters[reg], 10);
+            registers[reg] = (double) intRegisters[reg];
+            bigRegisters[reg] = BigFloat::fromString(text, 0);
+            decimalRegisters[reg] = Decimal::fromString(text, 0);
+        } else {
+            /* The others through their text */
+            QString text = (arithMode == ARITH_BIG) ? bigRegisters[reg].toString(bigDigits)
+                                                    : decimalRegisters[reg].toString();
+            registers[reg] = Parse::toDouble(text);
+            bigRegisters[reg] = BigFloat::fromString(text, 0);
+            decimalRegisters[reg] = Decimal::fromString(text, 0);
+            intRegisters[reg] = parseInteger(text, 10);
+        }
+    }
+    arithMode = mode;
+
+    /* Only integers are shown in other bases */
+    if ((arithMode != ARITH_INTEGER) && (radix != MODE_DEC)) {
+        radix = MODE_DEC;
+        showRadix();
+    }
+    if (listener != 0) {
+        listener->arithChanged(arithMode);
+    }
+
+    /* Show the LCD in the new arithmetic */
+    if (isValueValid) {
+        isTextValid = false;
+    }
+    updateLCD();
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the arbitrary precision in digits
+ *
+ *  @return Significant digits of arbitrary precision results
+ */
+int Engine::getPrecision(void)
+{
+    /* Return precision */
+    return bigDigits;
+}
+
+/**
+ *  @brief  Engine object method : Set the arbitrary precision in digits
+ *
+ *  @param  digits  Significant digits of arbitrary precision results
+ *
+ *  @return N/A
+ */
+void Engine::setPrecision(int digits)
+{
+    /* Keep it within the supported range */
+    if (digits < BIG_MIN_DIGITS) {
+        digits = BIG_MIN_DIGITS;
+    }
+    if (digits > BIG_MAX_DIGITS) {
+        digits = BIG_MAX_DIGITS;
+    }
+    bigDigits = digits;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the longest number that can be entered
+ *
+ *  @return LCD_LENGTH in double precision, the precision otherwise
+ */
+int Engine::getEntryLength(void)
+{
+    /* The other arithmetics take as many digits as they keep */
+    if (arithMode == ARITH_BIG) {
+        return bigDigits;
+    } else if (arithMode == ARITH_DECIMAL) {
+        return DECIMAL_DIGITS;
+    } else if (arithMode == ARITH_INTEGER) {
+        return Integer::maxDigits(radixBase(radix));
+    }
+    return LCD_LENGTH;
+}
+
+/**
+ *  @brief  Engine object method : Get the last set operator
+ *
+ *  @return Current set operator
+ */
+int Engine::getOperator(void)
+{
+    /* Return set operator */
+    return lastOperator;
+}
+
+/**
+ *  @brief  Engine object method : Set the operator
+ *
+ *  @param  op  The operator to set
+ *
+ *  @return N/A
+ */
+void Engine::setOperator(int op)
+{
+    /* Set operator */
+    lastOperator = op;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the decimal status
+ *
+ *  @return Current decimal status
+ */
+bool Engine::getDecimalStatus(void)
+{
+    /* Return decimal status */
+    return isDecimalEnabled;
+}
+
+/**
+ *  @brief  Engine object method : Set the decimal status
+ *
+ *  @param  status  The decimal status to set
+ *
+ *  @return N/A
+ */
+void Engine::setDecimalStatus(bool status)
+{
+    /* Set decimal status */
+    isDecimalEnabled = status;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the negative sign status
+ *
+ *  @return Current negative sign status
+ */
+bool Engine::getNegativeStatus(void)
+{
+    /* Return negative sign status */
+    return isNegativeEnabled;
+}
+
+/**
+ *  @brief  Engine object method : Set the negative sign status
+ *
+ *  @param  status  The negative sign status to set
+ *
+ *  @return N/A
+ */
+void Engine::setNegativeStatus(bool status)
+{
+    /* Set negative sign status */
+    isNegativeEnabled = status;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the last clicked button type
+ *
+ *  @return Last clicked button type
+ */
+int Engine::getLastClicked(void)
+{
+    /* Return last clicked button type */
+    return lastClicked;
+}
+
+/**
+ *  @brief  Engine object method : Set the last clicked button type
+ *
+ *  @param  lc      Last clicked button type to set
+ *
+ *  @return N/A
+ */
+void Engine::setLastClicked(int lc)
+{
+    /* Set last clicked button type */
+    lastClicked = lc;
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get 'Bin' button status
+ *
+ *  @return 'Bin' button status
+ */
+int Engine::getBinButtonStatus(void)
+{
+    /* Return 'Bin' button status */
+    return binButtonStatus;
+}
+
+/**
+ *  @brief  Engine object method : Set 'Bin' button status
+ *
+ *  @param  status      'Bin' button status to set
+ *  @param  oldStatus   Old status to override
+ *
+ *  @return N/A
+ */
+void Engine::setBinButtonStatus(int status, int oldStatus)
+{
+    /* Set 'Bin' button status */
+    binButtonStatus = status;
+
+    if (listener == 0) {
+        return;
+    }
+    if (status == MODE_BIN) { listener->buttonChanged(BUTTON_BIN, "Bin", oldStatus); }
+    if (status == MODE_HEX) { listener->buttonChanged(BUTTON_BIN, "Hex", oldStatus); }
+    if (status == MODE_DEC) { listener->buttonChanged(BUTTON_BIN, "Dec", oldStatus); }
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get 'Hex' button status
+ *
+ *  @return 'Hex' button status
+ */
+int Engine::getHexButtonStatus(void)
+{
+    /* Return 'Hex' button status */
+    return hexButtonStatus;
+}
+
+/**
+ *  @brief  Engine object method : Set 'Hex' button status
+ *
+ *  @param  status      'Hex' button status to set
+ *  @param  oldStatus   Old status to override
+ *
+ *  @return N/A
+ */
+void Engine::setHexButtonStatus(int status, int oldStatus)
+{
+    /* Set 'Hex' button status */
+    hexButtonStatus = status;
+
+    if (listener == 0) {
+        return;
+    }
+    if (status == MODE_BIN) { listener->buttonChanged(BUTTON_HEX, "Bin", oldStatus); }
+    if (status == MODE_HEX) { listener->buttonChanged(BUTTON_HEX, "Hex", oldStatus); }
+    if (status == MODE_DEC) { listener->buttonChanged(BUTTON_HEX, "Dec", oldStatus); }
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get the base numbers are shown in
+ *
+ *  @return MODE_DEC, MODE_BIN or MODE_HEX
+ */
+int Engine::getRadix(void)
+{
+    /* Return base */
+    return radix;
+}
+
+/**
+ *  @brief  Engine object method : Set the base numbers are shown in
+ *
+ *  Binary and hexadecimal switch to integer arithmetic. The LCD register
+ *  keeps its value, only its text is formatted again.
+ *
+ *  @param  mode    MODE_DEC, MODE_BIN or MODE_HEX
+ *
+ *  @return N/A
+ */
+void Engine::setRadix(int mode)
+{
+    /* Other bases need integers */
+    if ((mode != MODE_DEC) && (arithMode != ARITH_INTEGER)) {
+        setArithMode(ARITH_INTEGER);
+    }
+
+    /* Parse any text in the old base before the base changes */
+    parseLCD();
+    radix = mode;
+    isTextValid = false;
+    showRadix();
+    updateLCD();
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Show the base on the 'Bin' and 'Hex' buttons
+ *
+ *  @return N/A
+ */
+void Engine::showRadix(void)
+{
+    /* Each button names the base it switches to */
+    setBinButtonStatus((radix == MODE_BIN) ? MODE_DEC : MODE_BIN, radix);
+    setHexButtonStatus((radix == MODE_HEX) ? MODE_DEC : MODE_HEX, radix);
+    return;
+}
+
+/**
+ *  @brief  Engine object method : Get number of digits in LCD
+ *
+ *  @return Number of digits shown in LCD
+ */
+int Engine::getNumDigits(void)
+{
+    /* Return number of digits in LCD */
+    return numLCDDigits;
+}
+
+/**
+ *  @brief  Engine object method : Save number of digits in LCD
+ *
+ *  @param  num     Number of digits to save
+ *
+ *  @return N/A
+ */
+void Engine::setNumDigits(int num)
+{
+    /* Save number of digits in LCD */
+    numLCDDigits = num;
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Update LCD
+ *
+ *  @return N/A
+ */
+void Engine::updateLCD(void)
+{
+    /* Get the current set text */
+    QString text = getText();
+
+    /* Disable dot button action if already present */
+    setDecimalStatus(text.contains("."));
+    /* Disable sign button action if already present, an exponent sign is not it */
+    setNegativeStatus(text.startsWith("-"));
+
+    /* Save the text shown ... */
+    displayText = text;
+    /* ... and let the listener show it */
+    if (listener != 0) {
+        listener->lcdChanged(text);
+    }
+
+    /* Save the number of digits shown */
+    setNumDigits(text.length());
+
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Make calculation
+ *
+ *  @param  opString1   Operand 1 as string
+ *  @param  opString2   Operand 2 as string
+ *  @param  op          Operator
+ *
+ *  @return Calculated result as string, "0" and the error is shown on error
+ */
+QString Engine::calculate(QString opString1, QString opString2, int op)
+{
+    bool error = false;
+    QString ret = calculate(opString1, opString2, op, &error);
+
+    if (error) {
+        /* Show the error */
+        showError();
+    }
+    return ret;
+}
+
+/**
+ *  @brief  Engine object method :  Make calculation, without showing errors
+ *
+ *  @param  opString1   Operand 1 as string
+ *  @param  opString2   Operand 2 as string
+ *  @param  op          Operator
+ *  @param  error       Set to true on error, left untouched otherwise
+ *
+ *  @return Calculated result as string, "0" on error
+ */
+QString Engine::calculate(const QString &opString1, const QString &opString2, int op, bool *error)
+{
+    QString ret = "0";
+
+    /* Check if operand 1 exists, 0 value is allowed */
+    if (opString1.isEmpty()) {
+        return ret;
+    }
+
+    /* Check if operand 2 exists, 0 value is allowed */
+    if (opString2.isEmpty()) {
+        return ret;
+    }
+
+    /* Two parses, a calculation and a format */
+    STATS_COUNT(STAT_PARSE);
+    STATS_COUNT(STAT_PARSE);
+    STATS_COUNT(STAT_FORMAT);
+
+    if (arithMode == ARITH_BIG) {
+        /* Calculate in arbitrary precision */
+        BigFloat result = BigFloat::calculate(BigFloat::fromString(opString1, 0),
+                BigFloat::fromString(opString2, 0), op, bigDigits, error);
+        if (*error) {
+            return ret;
+        }
+        return result.toString(bigDigits);
+    } else if (arithMode == ARITH_DECIMAL) {
+        /* Calculate in decimal */
+        Decimal result = Decimal::calculate(Decimal::fromString(opString1, 0),
+                Decimal::fromString(opString2, 0), op, error);
+        if (*error) {
+            return ret;
+        }
+        return result.toString();
+    } else if (arithMode == ARITH_INTEGER) {
+        /* Calculate in 64-bit integer, the text is in the shown base */
+        int base = radixBase(radix);
+        qint64 result = Integer::calculate(parseInteger(opString1, base),
+                parseInteger(opString2, base), op, error);
+        if (*error) {
+            return ret;
+        }
+        return Integer::toString(result, base);
+    }
+
+    /* Convert strings to doubles, calculate and convert back */
+    STATS_COUNT(STAT_CALCULATE);
+    ret = Format::toString(compute(Parse::toDouble(opString1), Parse::toDouble(opString2), op, error));
+    return ret;
+}
+
+/**
+ *  @brief  Engine object method :  Make calculation
+ *
+ *  @param  op1     Operand 1
+ *  @param  op2     Operand 2
+ *  @param  op      Operator
+ *
+ *  @return Calculated result, 0 on error
+ */
+double Engine::calculate(double op1, double op2, int op)
+{
+    bool error = false;
+
+    /* Perform the calculation */
+    STATS_COUNT(STAT_CALCULATE);
+    double result = compute(op1, op2, op, &error);
+
+    if (error) {
+        /* Show the error */
+        showError();
+    }
+    return result;
+}
+
+/**
+ *  @brief  Engine class method :  Compute a result without touching any state
+ *
+ *  @param  op1     Operand 1
+ *  @param  op2     Operand 2
+ *  @param  op      Operator
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Calculated result, 0 on error
+ */
+double Engine::compute(double op1, double op2, int op, bool *error)
+{
+    double result = 0;
+
+    /* Perform the calculation */
+    switch (op) {
+        case OPERATOR_PLUS:
+            /* Addition */
+            result = op1 + op2;
+            break;
+        case OPERATOR_MINUS:
+            /* Substraction */
+            result = op1 - op2;
+            break;
+        case OPERATOR_MUL:
+            /* Multiplication */
+            result = op1 * op2;
+            break;
+        case OPERATOR_DIV:
+            /* Division */
+            if (op2 == 0) {
+                /* Check for divide-by-zero error */
+                *error = true;
+                break;
+            }
+            result = op1 / op2;
+            break;
+        case OPERATOR_SQRT:
+            /* Square root */
+            result = sqrt(op1);
+            break;
+        case OPERATOR_FACT:
+            /* Factorial, Gamma(x + 1) for non-integers */
+            result = Gamma::factorial(op1, error);
+            break;
+        default:
+            break;
+    }
+    return result;
+}
+
+/**
+ *  @brief  Engine class method :  Format a factorial too large for a double
+ *
+ *  The mantissa only shows the digits the fraction of the logarithm
+ *  still carries, fewer as the exponent grows.
+ *
+ *  @param  x   Argument
+ *
+ *  @return Factorial text in exponent notation, "inf" once not even the
+ *          exponent is exact
+ */
+QString Engine::factorialText(double x)
+{
+    /* Split the decimal logarithm into mantissa and exponent */
+    double magnitude = Gamma::log10Factorial(x);
+    double exponent = floor(magnitude);
+
+    /* An error in the logarithm is ln(10) times that relative error in the mantissa */
+    double places = floor(-log10(magnitude * DBL_EPSILON * FACTORIAL_LOG_ULPS * M_LN10));
+    if (!(places >= 1)) {
+        return "inf";
+    }
+    QString exponentText = "e+" + QString::number((qint64) exponent);
+    int digits = qMin((int) places, LCD_LENGTH - 1 - exponentText.length());
+
+    /* Round the mantissa to its digits, rounding may carry into the exponent */
+    double scale = pow(10, digits - 1);
+    double mantissa = floor(pow(10, magnitude - exponent) * scale + 0.5) / scale;
+    if (mantissa >= 10) {
+        mantissa = 1;
+        exponentText = "e+" + QString::number((qint64) exponent + 1);
+    }
+    return Format::toString(mantissa) + exponentText;
+}
+
+/**
+ *  @brief  Engine object method :  Show error function
+ *
+ *  @return N/A
+ */
+void Engine::showError(void)
+{
+    /* Show error */
+    STATS_COUNT(STAT_ERROR);
+    setText("-- error --");
+    updateLCD();
+
+    /* Reset the components */
+    setDecimalStatus(false);
+    setNegativeStatus(false);
+    setRegister(REG_LCD, 0);
+    setOperator(OPERATOR_NONE);
+    setRegister(REG_OPERAND, 0);
+    setLastClicked(TYPE_INIT);
+}
+
+/** One value of an expression in the exact arithmetics */
+struct ExactValue {
+    /** Value in arbitrary precision */
+    BigFloat big;
+    /** Value in decimal */
+    Decimal decimal;
+    /** Value in 64-bit integer */
+    qint64 integer;
+};
+
+/**
+ *  @brief  Load an expression constant in an exact arithmetic
+ *
+ *  @param  arithMode   Arithmetic : ARITH_BIG, ARITH_DECIMAL or ARITH_INTEGER
+ *  @param  expression  Compiled expression
+ *  @param  index       Constant index
+ *  @param  value       Set to the constant
+ *
+ *  @return N/A
+ */
+static void exactConstant(int arithMode, const Expression &expression, int index, ExactValue *value)
+{
+    QString text = expression.getConstantText(index);
+
+    /* Parse the text as typed, folded constants only have a double */
+    if (arithMode == ARITH_BIG) {
+        value->big = text.isEmpty() ? BigFloat(expression.getConstant(index)) : BigFloat::fromString(text, 0);
+    } else if (arithMode == ARITH_DECIMAL) {
+        value->decimal = text.isEmpty() ? Decimal(expression.getConstant(index)) : Decimal::fromString(text, 0);
+    } else {
+        value->integer = text.isEmpty() ? Integer::fromDouble(expression.getConstant(index)) : parseInteger(text, 10);
+    }
+    return;
+}
+
+/**
+ *  @brief  Calculate on expression values in an exact arithmetic
+ *
+ *  @param  arithMode   Arithmetic : ARITH_BIG, ARITH_DECIMAL or ARITH_INTEGER
+ *  @param  digits      Arbitrary precision in digits
+ *  @param  a           Operand 1, set to the result
+ *  @param  b           Operand 2
+ *  @param  op          Operator
+ *  @param  error       Set to true on error, left untouched otherwise
+ *
+ *  @return N/A
+ */
+static void exactCalculate(int arithMode, int digits, ExactValue *a, const ExactValue &b, int op, bool *error)
+{
+    /* Same calculations as Engine::calculateRegister() */
+    if (arithMode == ARITH_BIG) {
+        a->big = BigFloat::calculate(a->big, b.big, op, digits, error);
+    } else if (arithMode == ARITH_DECIMAL) {
+        a->decimal = Decimal::calculate(a->decimal, b.decimal, op, error);
+    } else {
+        a->integer = Integer::calculate(a->integer, b.integer, op, error);
+    }
+    return;
+}
+
+/**
+ *  @brief  Unary operation on an expression value in an exact arithmetic
+ *
+ *  @param  arithMode   Arithmetic : ARITH_BIG, ARITH_DECIMAL or ARITH_INTEGER
+ *  @param  digits      Arbitrary precision in digits
+ *  @param  x           Operand, set to the result
+ *  @param  op          Unary operation
+ *  @param  error       Set to true on error, left untouched otherwise
+ *
+ *  @return N/A
+ */
+static void exactUnary(int arithMode, int digits, ExactValue *x, int op, bool *error)
+{
+    /* Same steps as Engine::calculateUnary() */
+    if (arithMode == ARITH_BIG) {
+        x->big = unaryBig(x->big, op, digits, error, BigCancel());
+    } else if (arithMode == ARITH_DECIMAL) {
+        x->decimal = unaryDecimal(x->decimal, op, error);
+    } else {
+        x->integer = unaryInteger(x->integer, op, error);
+    }
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Run an expression in an exact arithmetic
+ *
+ *  The bytecode runs on values of the current arithmetic, so that the
+ *  result is the one the buttons give. The expression is compiled
+ *  without folding, constants are parsed from their text.
+ *
+ *  @param  expression  Compiled expression, 'M' is the memory value
+ *
+ *  @return true on success, the result is in the LCD register
+ */
+bool Engine::evaluateExact(const Expression &expression)
+{
+    ExactValue stack[EXPRESSION_STACK];
+    ExactValue zero, value;
+    const QVector<Instruction> &code = expression.getCode();
+    int top = -1;
+    bool error = false;
+
+    /* Run the bytecode */
+    zero.integer = 0;
+    for (int i = 0; (i < code.size()) && !error; i++) {
+        const Instruction &insn = code.at(i);
+        switch (insn.code) {
+            case INSN_CONST:
+                exactConstant(arithMode, expression, insn.index, &stack[++top]);
+                break;
+            case INSN_MEMORY:
+                top++;
+                stack[top].big = bigRegisters[REG_MEMORY];
+                stack[top].decimal = decimalRegisters[REG_MEMORY];
+                stack[top].integer = intRegisters[REG_MEMORY];
+                break;
+            case INSN_NEG:
+                value = zero;
+                exactCalculate(arithMode, bigDigits, &value, stack[top], OPERATOR_MINUS, &error);
+                stack[top] = value;
+                break;
+            case INSN_BINARY:
+                top--;
+                exactCalculate(arithMode, bigDigits, &stack[top], stack[top + 1], insn.op, &error);
+                break;
+            case INSN_UNARY:
+                exactCalculate(arithMode, bigDigits, &stack[top], stack[top], insn.op, &error);
+                break;
+            case INSN_SQ:
+                exactUnary(arithMode, bigDigits, &stack[top], UNARY_SQ, &error);
+                break;
+            case INSN_CUBE:
+                exactUnary(arithMode, bigDigits, &stack[top], UNARY_CUBE, &error);
+                break;
+            case INSN_INV:
+                exactUnary(arithMode, bigDigits, &stack[top], UNARY_INV, &error);
+                break;
+            default:
+                break;
+        }
+    }
+    if (error || (top != 0)) {
+        return false;
+    }
+
+    /* Leave the result in the LCD register */
+    bigRegisters[REG_LCD] = stack[0].big;
+    decimalRegisters[REG_LCD] = stack[0].decimal;
+    intRegisters[REG_LCD] = stack[0].integer;
+    isValueValid = true;
+    isTextValid = false;
+    return true;
+}
+
+/**
+ *  @brief  Engine object method :  Evaluate an expression into the LCD
+ *
+ *  @param  expression  Compiled expression, 'M' is the memory value. Outside
+ *                      double precision it is compiled without folding.
+ *
+ *  @return true on success, the error is shown otherwise
+ */
+bool Engine::evaluate(const Expression &expression)
+{
+    bool error = !expression.isValid();
+
+    /* Evaluate with the current memory value, in the current arithmetic */
+    if (!error && (arithMode != ARITH_DOUBLE)) {
+        error = !evaluateExact(expression);
+    } else if (!error) {
+        double result = expression.evaluate(getRegister(REG_MEMORY), &error);
+        if (!error) {
+            setRegister(REG_LCD, result);
+        }
+    }
+
+    if (error) {
+        /* Show the error */
+        showError();
+        return false;
+    }
+
+    /* Show the result, as if '=' was pressed */
+    updateLCD();
+    setLastClicked(TYPE_EQ);
+    setDecimalStatus(false);
+    return true;
+}
+
+/**
+ *  @brief  Check for a digit group separator
+ *
+ *  @param  c   Character
+ *
+ *  @return true for commas, apostrophes, underscores and spaces
+ */
+static bool isGroupSeparator(ushort c)
+{
+    return (c == ',') || (c == '\'') || (c == '_') || (c == ' ') ||
+           (c == 0x00a0) || (c == 0x2009) || (c == 0x202f);
+}
+
+/**
+ *  @brief  Check for a digit
+ *
+ *  @param  text    Text
+ *  @param  i       Position, may be past the end
+ *
+ *  @return true if there is a digit at the position
+ */
+static bool isDigitAt(const QString &text, int i)
+{
+    return (i < text.length()) && (text.at(i).unicode() >= '0') && (text.at(i).unicode() <= '9');
+}
+
+/**
+ *  @brief  Normalize a pasted number
+ *
+ *  White space around it, a leading '+' and digit group separators are
+ *  dropped, a separator must be followed by exactly three digits. A
+ *  number in parentheses is negative, as spreadsheets write it.
+ *
+ *  @param  text    Pasted text
+ *  @param  number  Set to the number in plain notation
+ *
+ *  @return true if the text is a number
+ */
+static bool normalizeNumber(const QString &text, QString *number)
+{
+    QString in = text.trimmed();
+    QString out;
+    bool digits = false;
+    int i = 0;
+
+    /* Sign, or accounting style negative */
+    if ((in.length() > 2) && in.startsWith("(") && in.endsWith(")")) {
+        in = in.mid(1, in.length() - 2).trimmed();
+        out.append('-');
+    } else if (in.startsWith("-") || in.startsWith("+")) {
+        if (in.at(0).unicode() == '-') {
+            out.append('-');
+        }
+        i++;
+    }
+
+    /* Integer part, maybe in groups of three */
+    while (i < in.length()) {
+        if (isDigitAt(in, i)) {
+            out.append(in.at(i++));
+            digits = true;
+        } else if (digits && isGroupSeparator(in.at(i).unicode()) && isDigitAt(in, i + 1) &&
+                   isDigitAt(in, i + 2) && isDigitAt(in, i + 3) && !isDigitAt(in, i + 4)) {
+            i++;
+        } else {
+            break;
+        }
+    }
+
+    /* Fraction */
+    if ((i < in.length()) && (in.at(i).unicode() == '.')) {
+        out.append('.');
+        i++;
+        while (isDigitAt(in, i)) {
+            out.append(in.at(i++));
+            digits = true;
+        }
+    }
+    if (!digits) {
+        return false;
+    }
+
+    /* Exponent */
+    if ((i < in.length()) && ((in.at(i).unicode() == 'e') || (in.at(i).unicode() == 'E'))) {
+        out.append('e');
+        i++;
+        if ((i < in.length()) && ((in.at(i).unicode() == '-') || (in.at(i).unicode() == '+'))) {
+            out.append(in.at(i++));
+        }
+        if (!isDigitAt(in, i)) {
+            return false;
+        }
+        while (isDigitAt(in, i)) {
+            out.append(in.at(i++));
+        }
+    }
+
+    /* Nothing may follow */
+    if (i != in.length()) {
+        return false;
+    }
+    *number = out;
+    return true;
+}
+
+/**
+ *  @brief  Engine object method :  Enter a whole number or expression at once
+ *
+ *  A number is loaded straight into the LCD register in the current
+ *  arithmetic, as if typed. Digits typed after one shown with an
+ *  exponent start a new number. In Bin and Hex it is read in that base.
+ *  Anything else is evaluated as an expression.
+ *  Either way the LCD is updated once.
+ *
+ *  @param  text    Number or expression text, as pasted
+ *
+ *  @return true if taken, an evaluation error is then shown as '='
+ *          shows it. false if not understood, the engine is left as it was.
+ */
+bool Engine::enterText(const QString &text)
+{
+    QString number;
+    Expression expression;
+    qint64 value;
+
+    /* A whole number in the shown base, hexadecimal may have a '0x' prefix */
+    if ((arithMode == ARITH_INTEGER) && (radix != MODE_DEC)) {
+        number = text.trimmed();
+        if ((radix == MODE_HEX) && (number.startsWith("0x") || number.startsWith("0X"))) {
+            number = number.mid(2);
+        }
+        if (Integer::fromString(number, radixBase(radix), &value)) {
+            setText(Integer::toString(value, radixBase(radix)));
+            updateLCD();
+            setLastClicked(TYPE_NUM);
+            return true;
+        }
+    }
+
+    /* A number, parse it and show it as the arithmetic formats it */
+    if (normalizeNumber(text, &number)) {
+        if (arithMode == ARITH_INTEGER) {
+            /* Decimal text, shown in the current base */
+            number = Integer::toString(parseInteger(number, 10), radixBase(radix));
+        }
+        setText(number);
+        copyRegister(REG_LCD, REG_LCD);
+        updateLCD();
+        setLastClicked(TYPE_NUM);
+        return true;
+    }
+
+    /* An expression, evaluate it as '=' would show it */
+    if (!expression.compile(text.trimmed(), arithMode == ARITH_DOUBLE)) {
+        return false;
+    }
+    evaluate(expression);
+    return true;
+}
+
+/**
+ *  @brief  Engine object method :  Handle button press
+ *
+ *  @param  index   Index of button pressed
+ *
+ *  @return N/A
+ */
+void Engine::buttonPressed(int index)
+{
+#if STATS
+    if (stats != 0) {
+        /* Time the keystroke */
+        quint64 start = EngineStats::now();
+        pressButton(index);
+        stats->record(index, EngineStats::now() - start);
+        return;
+    }
+#endif
+    pressButton(index);
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Save the state for undo
+ *
+ *  @param  state   Set to the state
+ *
+ *  @return N/A
+ */
+void Engine::saveState(EngineState *state)
+{
+    /* Copy the state, shared data is only referenced */
+    state->lcdText = lcdText;
+    state->isTextValid = isTextValid;
+    state->isValueValid = isValueValid;
+    state->displayText = displayText;
+    for (int reg = 0; reg < NUM_REGISTERS; reg++) {
+        state->registers[reg] = registers[reg];
+        state->bigRegisters[reg] = bigRegisters[reg];
+        state->decimalRegisters[reg] = decimalRegisters[reg];
+        state->intRegisters[reg] = intRegisters[reg];
+    }
+    state->arithMode = arithMode;
+    state->bigDigits = bigDigits;
+    state->lastOperator = lastOperator;
+    state->lastClicked = lastClicked;
+    state->isDecimalEnabled = isDecimalEnabled;
+    state->isNegativeEnabled = isNegativeEnabled;
+    state->radix = radix;
+    state->numLCDDigits = numLCDDigits;
+    state->summary = summary;
+    state->isSummaryEnabled = isSummaryEnabled;
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Go back to a saved state
+ *
+ *  The listener is told about the LCD, the buttons and the arithmetic.
+ *
+ *  @param  state   State saved before
+ *
+ *  @return N/A
+ */
+void Engine::restoreState(const EngineState &state)
+{
+    /* Copy the state back */
+    lcdText = state.lcdText;
+    isTextValid = state.isTextValid;
+    isValueValid = state.isValueValid;
+    displayText = state.displayText;
+    for (int reg = 0; reg < NUM_REGISTERS; reg++) {
+        registers[reg] = state.registers[reg];
+        bigRegisters[reg] = state.bigRegisters[reg];
+        decimalRegisters[reg] = state.decimalRegisters[reg];
+        intRegisters[reg] = state.intRegisters[reg];
+    }
+    arithMode = state.arithMode;
+    bigDigits = state.bigDigits;
+    lastOperator = state.lastOperator;
+    lastClicked = state.lastClicked;
+    isDecimalEnabled = state.isDecimalEnabled;
+    isNegativeEnabled = state.isNegativeEnabled;
+    radix = state.radix;
+    numLCDDigits = state.numLCDDigits;
+    summary = state.summary;
+    isSummaryEnabled = state.isSummaryEnabled;
+
+    /* Show it */
+    showRadix();
+    if (listener != 0) {
+        listener->arithChanged(arithMode);
+        listener->lcdChanged(displayText);
+    }
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Check if a button press may take long
+ *
+ *  @param  index   Index of button
+ *
+ *  @return true if the button calculates in arbitrary precision
+ */
+bool Engine::isSlowButton(int index)
+{
+    /* Only arbitrary precision has no bound on the calculation time */
+    if (arithMode != ARITH_BIG) {
+        return false;
+    }
+
+    switch (index) {
+        case BUTTON_SQ:     /* Button square: Fall through */
+        case BUTTON_SQRT:   /* Button square root: Fall through */
+        case BUTTON_FACT:   /* Button factorial: Fall through */
+        case BUTTON_INV:    /* Button inverse: Fall through */
+        case BUTTON_CUBE:   /* Button cube: Fall through */
+        case BUTTON_PLUS:   /* Button plus: Fall through */
+        case BUTTON_NEG:    /* Button minus: Fall through */
+        case BUTTON_MUL:    /* Button multiply: Fall through */
+        case BUTTON_DIV:    /* Button divide: Fall through */
+        case BUTTON_EQ:     /* Button equal to: Fall through */
+        case BUTTON_MP:     /* Button memory plus */
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ *  @brief  Check a number text for an exponent
+ *
+ *  @param  text        Number text
+ *  @param  arithMode   Arithmetic, integers have none and 'e' is a hex digit
+ *
+ *  @return true if the text has an exponent
+ */
+static bool hasExponent(const QString &text, int arithMode)
+{
+    /* Integers are shown without one */
+    return (arithMode != ARITH_INTEGER) && text.contains("e");
+}
+
+/**
+ *  @brief  Engine object method :  Handle button press, untimed
+ *
+ *  The button, the arithmetic and base, the last clicked button type
+ *  and whether the value is zero pick one action from the keypad tables.
+ *
+ *  @param  index   Index of button pressed
+ *
+ *  @return N/A
+ */
+void Engine::pressButton(int index)
+{
+    /* Check the current value, the text is only fetched when edited */
+    bool isZero = isRegisterZero(REG_LCD);
+    /* Allocate a text buffer */
+    QString text;
+    /* Allocate a double value */
+    double value = 0;
+
+    /* Initialize in use operators */
+    int op = OPERATOR_NONE;
+
+    /* Not a button */
+    if ((index < 0) || (index >= NUM_BUTTONS)) {
+        return;
+    }
+    const KeypadButton &button = keypadButtons[index];
+
+    /* Look the action up */
+    int key = keypadKeys[keypadModes[arithMode][radix]][button.key];
+    int action = keypadActions[key][getLastClicked()][isZero ? 1 : 0];
+
+    /* Digits and dots are not typed onto an exponent, they start a new number */
+    if (((action == ACTION_DIGIT_APPEND) || (action == ACTION_DOT_APPEND)) && hasExponent(getText(), arithMode)) {
+        action = (action == ACTION_DIGIT_APPEND) ? ACTION_DIGIT_NEW : ACTION_DOT_NEW;
+    }
+
+    /* Actual working logic */
+    switch (action) {
+        case ACTION_DIGIT_NEW:  /* Take a new value */
+            setText(buttonLabels[index]);
+            updateLCD();
+            setLastClicked(TYPE_NUM);
+            break;
+        case ACTION_DIGIT_FRACTION: /* User pressed '.' before */
+            text = "0.";
+            text.append(buttonLabels[index]);
+            setText(text);
+            updateLCD();
+            setLastClicked(TYPE_NUM);
+            break;
+        case ACTION_DIGIT_APPEND:   /* Append to existing text, if there is room */
+            if (getText().length() < getEntryLength()) {
+                text = getText();
+                text.append(buttonLabels[index]);
+                setText(text);
+                updateLCD();
+            }
+            setLastClicked(TYPE_NUM);
+            break;
+        case ACTION_UNARY:  /* Square, square root or exact factorial */
+            if (!calculateUnary(REG_LCD, button.argument)) {
+                break;
+            }
+            /* Update LCD */
+            updateLCD();
+            /* Set the last clicked button type to operator */
+            setLastClicked(TYPE_OP);
+            break;
+        case ACTION_UNARY_SHOW: /* Cube or inverse */
+            calculateUnary(REG_LCD, button.argument);
+            /* Update LCD */
+            updateLCD();
+            /* Set the last clicked button type to operator */
+            setLastClicked(TYPE_OP);
+            break;
+        case ACTION_FACT:   /* Factorial in double precision */
+            value = getRegister(REG_LCD);
+            if ((value < 0) && (value == floor(value))) {
+                /* Negative integer, factorial has a pole here */
+                showError();
+                break;
+            }
+            /* Factorial the current value */
+            if (!calculateUnary(REG_LCD, UNARY_FACT)) {
+                break;
+            }
+            /* Update LCD */
+            if (isinf(getRegister(REG_LCD)) && !isinf(value)) {
+                /* Too large for a double, show the magnitude at least */
+                setText(factorialText(value));
+            }
+            updateLCD();
+            /* Set the last clicked button type to operator */
+            setLastClicked(TYPE_OP);
+            break;
+        case ACTION_ERROR:  /* Value is zero, this makes divide-by-zero error */
+            showError();
+            break;
+        case ACTION_NEGATE: /* Two's complement shows no sign, negate the value */
+            setRegister(REG_TEMP, 0);
+            calculateRegister(REG_LCD, REG_TEMP, REG_LCD, OPERATOR_MINUS);
+            updateLCD();
+            break;
+        case ACTION_SIGN:
+            /* Get the current text */
+            text = getText();
+            if (getNegativeStatus() == false) {
+                /* Negative sign not present, need to add it */
+                setNegativeStatus(true);
+                if (text.length() <= getEntryLength()) {
+                    /* This does not affect the LCD precision */
+                    text.prepend("-");
+                }
+            } else {
+                /* Negative sign is already present, need to remove it */
+                setNegativeStatus(false);
+                text.remove(0, 1);
+            }
+            /* Update LCD */
+            setText(text);
+            updateLCD();
+            break;
+        case ACTION_DOT_NEW:    /* Start a fraction : Fall through */
+        case ACTION_DOT_APPEND: /* Append the dot */
+            if (getDecimalStatus() == false) {
+                /* Only do this if a dot is not already shown */
+                if (action == ACTION_DOT_NEW) {
+                    text = "0.";
+                } else {
+                    text = getText();
+                    text.append(buttonLabels[index]);
+                }
+                /* Make sure dots are disabled for future */
+                setDecimalStatus(true);
+                /* Update LCD */
+                setText(text);
+                updateLCD();
+                /* Set the last clicked button type to dot */
+                setLastClicked(TYPE_DOT);
+            }
+            break;
+        case ACTION_OP_SET:
+            /* No need to do anything, except updating the operator ... */
+            setOperator(button.argument);
+            /* ... and last button clicked type */
+            setLastClicked(TYPE_OP);
+            break;
+        case ACTION_OP_SAVE:    /* Save the operand : Fall through */
+        case ACTION_OP_CALC:    /* Calculate with the saved operand, if any */
+            /* Get the last operator saved */
+            op = getOperator();
+
+            if ((action == ACTION_OP_SAVE) || isRegisterZero(REG_OPERAND) || (op == OPERATOR_NONE)) {
+                /* No last operand, save current value for next calculation */
+                copyRegister(REG_OPERAND, REG_LCD);
+            } else {
+                /* We already have an operand saved, need to perform calculation */
+                /* and save the result for next calculation */
+                calculateRegister(REG_OPERAND, REG_OPERAND, REG_LCD, op);
+                /* Update LCD */
+                copyRegister(REG_LCD, REG_OPERAND);
+                updateLCD();
+            }
+            /* Save the operator */
+            setOperator(button.argument);
+            /* Set the last clicked button type to operator */
+            setLastClicked(TYPE_OP);
+            /* Enable decimal */
+            setDecimalStatus(false);
+            break;
+        case ACTION_EQ_NONE:    /* Nothing to do */
+            setLastClicked(TYPE_EQ);
+            break;
+        case ACTION_EQ_CALC:
+            /* Get the last operator saved */
+            op = getOperator();
+            /* Start from the last operand saved */
+            copyRegister(REG_TEMP, REG_OPERAND);
+
+            /* Calculate the result ... */
+            if (!isRegisterZero(REG_TEMP)) {
+                /* ... only if we have an operand to operate on */
+                calculateRegister(REG_TEMP, REG_OPERAND, REG_LCD, op);
+            }
+            /* Check the result */
+            if (!isRegisterZero(REG_TEMP)) {
+                /* Forget the operator saved */
+                setOperator(OPERATOR_NONE);
+                /* Update LCD */
+                copyRegister(REG_LCD, REG_TEMP);
+                updateLCD();
+            }
+            /* Set the last clicked button type to equal to */
+            setLastClicked(TYPE_EQ);
+            /* Enable decimal */
+            setDecimalStatus(false);
+            break;
+        case ACTION_MC: /* Button memory clear */
+            /* Reset the memory value */
+            setRegister(REG_MEMORY, 0);
+            break;
+        case ACTION_MR: /* Button memory recall */
+            /* Update LCD with the current memory value */
+            copyRegister(REG_LCD, REG_MEMORY);
+            updateLCD();
+            break;
+        case ACTION_MS: /* Button memory set */
+            /* Save current value to memory */
+            copyRegister(REG_MEMORY, REG_LCD);
+            /* Make sure the next value is started anew */
+            setRegister(REG_LCD, 0);
+            setLastClicked(TYPE_INIT);
+            break;
+        case ACTION_MP: /* Button memory plus, the value is not zero */
+            if (isSummaryEnabled) {
+                /* Sum it up */
+                summary.add(getRegister(REG_LCD));
+            }
+            if (isRegisterZero(REG_MEMORY)) {
+                /* Memory value is zero, save the current one */
+                copyRegister(REG_MEMORY, REG_LCD);
+            } else {
+                /* Update memory after addition */
+                calculateRegister(REG_MEMORY, REG_LCD, REG_MEMORY, OPERATOR_PLUS);
+            }
+            break;
+        case ACTION_MP_ZERO:    /* Button memory plus, the value is zero */
+            if (isSummaryEnabled) {
+                /* Memory stays, but zero is a value too */
+                summary.add(getRegister(REG_LCD));
+            }
+            break;
+        case ACTION_BS: /* Button backspace */
+            /* Get the current text */
+            text = getText();
+            if (hasExponent(text, arithMode)) {
+                /* An exponent was not typed, it is not taken back digit by digit */
+            } else if (text.length() > 1) {
+                /* If length is more than one, just cut one from end */
+                text.remove((text.length() - 1), 1);
+                /* Update LCD */
+                setText(text);
+                updateLCD();
+            } else if (text.length() == 1) {
+                /* If length is 1, set the value to zero and update LCD */
+                setText("0");
+                updateLCD();
+            }
+            /* Set the last clicked button type to others */
+            setLastClicked(TYPE_OTHER);
+            break;
+        case ACTION_CLR:    /* Button clear */
+            /* Reset everything, except memory text */
+            setDecimalStatus(false);
+            setNegativeStatus(false);
+            setRegister(REG_LCD, 0);
+            setOperator(OPERATOR_NONE);
+            setRegister(REG_OPERAND, 0);
+            setLastClicked(TYPE_INIT);
+            updateLCD();
+            break;
+        case ACTION_BIN:    /* Button binary */
+            /* Switch between binary and decimal */
+            setRadix((getRadix() == MODE_BIN) ? MODE_DEC : MODE_BIN);
+            break;
+        case ACTION_HEX:    /* Button hexadecimal */
+            /* Switch between hexadecimal and decimal */
+            setRadix((getRadix() == MODE_HEX) ? MODE_DEC : MODE_HEX);
+            break;
+        default:
+            break;
+        }
+
+    return;
+}
+
+#if HEX
+/**
+ *  @brief  Engine object method :  Handle hex button press
+ *
+ *  @param  index   Index of hex button pressed
+ *
+ *  @return N/A
+ */
+void Engine::hexButtonPressed(int index)
+{
+#if STATS
+    if (stats != 0) {
+        /* Time the keystroke, hex keys follow the buttons */
+        quint64 start = EngineStats::now();
+        pressHexButton(index);
+        stats->record(NUM_BUTTONS + index, EngineStats::now() - start);
+        return;
+    }
+#endif
+    pressHexButton(index);
+    return;
+}
+
+/**
+ *  @brief  Engine object method :  Handle hex button press, untimed
+ *
+ *  @param  index   Index of hex button pressed
+ *
+ *  @return N/A
+ */
+void Engine::pressHexButton(int index)
+{
+    /* Check the current value, the text is only fetched when edited */
+    bool isZero = isRegisterZero(REG_LCD);
+    /* Allocate a text buffer */
+    QString text;
+
+    /* Get the last clicked button type */
+    int lc = getLastClicked();
+
+    if ((arithMode == ARITH_INTEGER) && (radix == MODE_HEX)) {
+        switch(index) {
+            case HEX_BUTTON_A:  /* Button A: Fall through */
+            case HEX_BUTTON_B:  /* Button B: Fall through */
+            case HEX_BUTTON_C:  /* Button C: Fall through */
+            case HEX_BUTTON_D:  /* Button D: Fall through */
+            case HEX_BUTTON_E:  /* Button E: Fall through */
+            case HEX_BUTTON_F:  /* Button F: */
+                if (isZero || (lc == TYPE_OP) || (lc == TYPE_EQ)) {
+                    /* Take a new value */
+                    text = hexButtonLabels[index];
+                    /* Update LCD */
+                    setText(text.toLower());
+                    updateLCD();
+                } else if (getText().length() < getEntryLength()) {
+                    /* Value is not zero, append to existing text */
+                    text = getText();
+                    text.append(hexButtonLabels[index]);
+                    /* Update LCD */
+                    setText(text.toLower());
+                    updateLCD();
+                }
+                /* Set the last clicked button type to number */
+                setLastClicked(TYPE_NUM);
+                break;
+            default:
+                break;
+        }
+    }
+    return;
+}
+#endif
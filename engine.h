@@ -0,0 +1,476 @@
+/** @file engine.h
+ *
+ *  @brief This file contains the declarations of the calculator engine
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+/** Enable or disable instrumentation */
+#define STATS   1
+
+/** Enable or disable hex input */
+#define HEX     1
+
+/* Includes */
+#include <QString>
+#include <QtCore/QVector>
+#include "bignum.h"
+#include "decimal.h"
+#include "memo.h"
+#include "integer.h"
+#include "accumulator.h"
+#if STATS
+#include "stats.h"
+#endif
+
+/* Forward declarations */
+class Expression;
+class HistoryLog;
+struct HistoryEntry;
+
+/* Defines */
+
+/** Total number of buttons except hex buttons */
+#define NUM_BUTTONS     30
+#if HEX
+/** Total number of hex buttons */
+#define NUM_HEX_BUTTONS 6
+#endif
+/** Number of digits supported in LCD */
+#define LCD_LENGTH      20
+
+/** Operator : None */
+#define OPERATOR_NONE   0
+/** Operator : '+' */
+#define OPERATOR_PLUS   1
+/** Operator : '-' */
+#define OPERATOR_MINUS  2
+/** Operator : '*' */
+#define OPERATOR_MUL    3
+/** Operator : '/' */
+#define OPERATOR_DIV    4
+/** Operator : 'sqrt' */
+#define OPERATOR_SQRT   5
+/** Operator : '!' */
+#define OPERATOR_FACT   6
+
+/** Unary operation : Square */
+#define UNARY_SQ        0
+/** Unary operation : Square root */
+#define UNARY_SQRT      1
+/** Unary operation : Factorial */
+#define UNARY_FACT      2
+/** Unary operation : Inverse */
+#define UNARY_INV       3
+/** Unary operation : Cube */
+#define UNARY_CUBE      4
+
+/** Last button clicked: Init */
+#define TYPE_INIT       0
+/** Last button clicked: Number */
+#define TYPE_NUM        1
+/** Last button clicked: Operator */
+#define TYPE_OP         2
+/** Last button clicked: Equal-to */
+#define TYPE_EQ         3
+/** Last button clicked: Dot */
+#define TYPE_DOT        4
+/** Last button clicked: Others */
+#define TYPE_OTHER      5
+/** Number of last button clicked types */
+#define NUM_TYPES       6
+
+/** Button names, plain strings need no static construction */
+const char * const buttonLabels[] = {
+        "7",    "8",   "9",   "/",   "C",
+        "4",    "5",   "6",   "*",   "Sq",
+        "1",    "2",   "3",   "-",   "1/x",
+        "0",    "+/-", ".",   "+",   "=",
+        "MC",   "MR",  "MS",  "M+",  "Bksp",
+        "Sqrt", "!x",  "x^3", "Bin", "Hex" };
+
+#if HEX
+/** Hex button names */
+const char * const hexButtonLabels[NUM_HEX_BUTTONS] = {
+        "A", "B", "C", "D", "E", "F" };
+#endif
+
+/** Button : '7' */
+#define BUTTON_7    0
+/** Button : '8' */
+#define BUTTON_8    1
+/** Button : '9' */
+#define BUTTON_9    2
+/** Button : '/' */
+#define BUTTON_DIV  3
+/** Button : 'C' */
+#define BUTTON_CLR  4
+/** Button : '4' */
+#define BUTTON_4    5
+/** Button : '5' */
+#define BUTTON_5    6
+/** Button : '6' */
+#define BUTTON_6    7
+/** Button : '*' */
+#define BUTTON_MUL  8
+/** Button : 'Sqrt' */
+#define BUTTON_SQ   9
+/** Button : '1' */
+#define BUTTON_1    10
+/** Button : '2' */
+#define BUTTON_2    11
+/** Button : '3' */
+#define BUTTON_3    12
+/** Button : '4' */
+#define BUTTON_NEG  13
+/** Button : '1/x' */
+#define BUTTON_INV  14
+/** Button : '0' */
+#define BUTTON_0    15
+/** Button : '+/-' */
+#define BUTTON_SIGN 16
+/** Button : '.' */
+#define BUTTON_DOT  17
+/** Button : '+' */
+#define BUTTON_PLUS 18
+/** Button : '=' */
+#define BUTTON_EQ   19
+/** Button : 'MC' */
+#define BUTTON_MC   20
+/** Button : 'MR' */
+#define BUTTON_MR   21
+/** Button : 'MS' */
+#define BUTTON_MS   22
+/** Button : 'MP' */
+#define BUTTON_MP   23
+/** Button : 'Bksp' */
+#define BUTTON_BS   24
+/** Button : 'Sqrt' */
+#define BUTTON_SQRT 25
+/** Button : '!x' */
+#define BUTTON_FACT 26
+/** Button : 'x^3' */
+#define BUTTON_CUBE 27
+/** Button : 'Bin' */
+#define BUTTON_BIN  28
+/** Button : 'Hex' */
+#define BUTTON_HEX  29
+
+#if HEX
+/** Hex button : 'A' */
+#define HEX_BUTTON_A    0
+/** Hex button : 'B' */
+#define HEX_BUTTON_B    1
+/** Hex button : 'C' */
+#define HEX_BUTTON_C    2
+/** Hex button : 'D' */
+#define HEX_BUTTON_D    3
+/** Hex button : 'E' */
+#define HEX_BUTTON_E    4
+/** Hex button : 'F' */
+#define HEX_BUTTON_F    5
+#endif
+
+/** Register : LCD value */
+#define REG_LCD         0
+/** Register : Operand */
+#define REG_OPERAND     1
+/** Register : Memory */
+#define REG_MEMORY      2
+/** Register : Temporary result */
+#define REG_TEMP        3
+/** Number of registers */
+#define NUM_REGISTERS   4
+
+/** Arithmetic : Double precision */
+#define ARITH_DOUBLE    0
+/** Arithmetic : Arbitrary precision */
+#define ARITH_BIG       1
+/** Arithmetic : Decimal */
+#define ARITH_DECIMAL   2
+/** Arithmetic : 64-bit integer */
+#define ARITH_INTEGER   3
+
+/** Mode status : Decimal */
+#define MODE_DEC    1
+/** Mode status : Binary */
+#define MODE_BIN    2
+/** Mode status : Hexadecimal */
+#define MODE_HEX    3
+
+/** Listener interface for engine state changes */
+class EngineListener
+{
+public:
+    /** Destructor */
+    virtual ~EngineListener() {}
+    /** LCD text changed */
+    virtual void lcdChanged(const QString &text) = 0;
+    /** Button name changed */
+    virtual void buttonChanged(int button, const QString &text, int oldStatus) = 0;
+    /** Arithmetic changed */
+    virtual void arithChanged(int mode) = 0;
+};
+
+/**
+ *  Snapshot of the engine state, as undo keeps it.
+ *
+ *  Texts and arbitrary precision registers are implicitly shared with the
+ *  engine, so a snapshot copies a few hundred bytes and no digits. Caches
+ *  and statistics are not part of the state.
+ */
+struct EngineState
+{
+    /** LCD text */
+    QString lcdText;
+    /** LCD text status */
+    bool isTextValid;
+    /** LCD register status */
+    bool isValueValid;
+    /** Text shown */
+    QString displayText;
+    /** Register file */
+    double registers[NUM_REGISTERS];
+    /** Register file in arbitrary precision */
+    BigFloat bigRegisters[NUM_REGISTERS];
+    /** Register file in decimal */
+    Decimal decimalRegisters[NUM_REGISTERS];
+    /** Register file in 64-bit integer */
+    qint64 intRegisters[NUM_REGISTERS];
+    /** Arithmetic mode */
+    int arithMode;
+    /** Arbitrary precision digits */
+    int bigDigits;
+    /** Last operator */
+    int lastOperator;
+    /** Last clicked button type */
+    int lastClicked;
+    /** Decimal status */
+    bool isDecimalEnabled;
+    /** Negative status */
+    bool isNegativeEnabled;
+    /** Base numbers are shown in */
+    int radix;
+    /** Number of digits shown */
+    int numLCDDigits;
+    /** Statistics of the values added to memory */
+    Accumulator summary;
+    /** Summary status */
+    bool isSummaryEnabled;
+};
+
+/** Our calculator engine, free of any widget */
+class Engine
+{
+public:
+    /** Constructor */
+    Engine();
+    /** Reset the engine to init status */
+    void reset(void);
+    /** Set the listener for state changes */
+    void setListener(EngineListener *);
+    /** Get the current set text */
+    QString getText(void);
+    /** Set the current text */
+    void setText(QString);
+    /** Get the text shown in LCD */
+    QString getDisplayText(void);
+    /** Get a register value */
+    double getRegister(int);
+    /** Set a register value */
+    void setRegister(int, double);
+    /** Check a register for zero */
+    bool isRegisterZero(int);
+    /** Copy a register */
+    void copyRegister(int, int);
+    /** Make calculation on registers */
+    bool calculateRegister(int, int, int, int);
+    /** Make unary operation on a register */
+    bool calculateUnary(int, int);
+    /** Get the unary result memo table */
+    MemoCache *getMemoCache(void);
+#if STATS
+    /** Set the statistics to collect into */
+    void setStats(EngineStats *);
+    /** Dump the statistics */
+    void dumpStats(FILE *);
+#endif
+    /** Set the history to log calculations to */
+    void setHistory(HistoryLog *);
+    /** Set the buffer to hold logged calculations in instead */
+    void setHistoryBuffer(QVector<HistoryEntry> *);
+    /** Set the request to stop long calculations */
+    void setCancel(const BigCancel &);
+    /** Get the summary status */
+    bool getSummaryMode(void);
+    /** Start or stop summing up the values added to memory */
+    void setSummaryMode(bool);
+    /** Get the statistics of the values added to memory */
+    const Accumulator *getSummary(void);
+    /** Get the arithmetic */
+    int getArithMode(void);
+    /** Set the arithmetic */
+    void setArithMode(int);
+    /** Get the arbitrary precision in digits */
+    int getPrecision(void);
+    /** Set the arbitrary precision in digits */
+    void setPrecision(int);
+    /** Get the longest number that can be entered */
+    int getEntryLength(void);
+    /** Get the last set operator */
+    int getOperator(void);
+    /** Set the operator */
+    void setOperator(int);
+    /** Get the decimal status */
+    bool getDecimalStatus(void);
+    /** Set the decimal status */
+    void setDecimalStatus(bool);
+    /** Get the negative sign status */
+    bool getNegativeStatus(void);
+    /** Set the negative sign status */
+    void setNegativeStatus(bool);
+    /** Get the last clicked button type */
+    int getLastClicked(void);
+    /** Set the last clicked button type */
+    void setLastClicked(int);
+    /** Get 'Bin' button status */
+    int getBinButtonStatus(void);
+    /** Set 'Bin' button status */
+    void setBinButtonStatus(int, int);
+    /** Get 'Hex' button status */
+    int getHexButtonStatus(void);
+    /** Set 'Hex' button status */
+    void setHexButtonStatus(int, int);
+    /** Get the base numbers are shown in */
+    int getRadix(void);
+    /** Set the base numbers are shown in */
+    void setRadix(int);
+    /** Get number of digits in LCD */
+    int getNumDigits(void);
+    /** Save number of digits in LCD */
+    void setNumDigits(int);
+    /** Update LCD */
+    void updateLCD(void);
+    /** Make calculation on text */
+    QString calculate(QString, QString, int);
+    /** Make calculation, without showing errors */
+    QString calculate(const QString &, const QString &, int, bool *);
+    /** Make calculation */
+    double calculate(double, double, int);
+    /** Compute a result without touching any state */
+    static double compute(double, double, int, bool *);
+    /** Format a factorial too large for a double */
+    static QString factorialText(double);
+    /** Evaluate an expression into the LCD */
+    bool evaluate(const Expression &expression);
+    /** Enter a whole number or expression at once */
+    bool enterText(const QString &text);
+    /** Handle button press */
+    void buttonPressed(int index);
+#if HEX
+    /** Handle hex button press */
+    void hexButtonPressed(int index);
+#endif
+    /** Save the state for undo */
+    void saveState(EngineState *state);
+    /** Go back to a saved state */
+    void restoreState(const EngineState &state);
+    /** Check if a button press may take long */
+    bool isSlowButton(int index);
+
+private:
+    /** Listener for state changes */
+    EngineListener *listener;
+    /** LCD text */
+    QString lcdText;
+    /** LCD text matches the LCD register */
+    bool isTextValid;
+    /** LCD register matches the LCD text */
+    bool isValueValid;
+    /** Text shown in LCD */
+    QString displayText;
+    /** Register file : LCD value, operand, memory and temporary */
+    double registers[NUM_REGISTERS];
+    /** Register file in arbitrary precision */
+    BigFloat bigRegisters[NUM_REGISTERS];
+    /** Register file in decimal */
+    Decimal decimalRegisters[NUM_REGISTERS];
+    /** Register file in 64-bit integer */
+    qint64 intRegisters[NUM_REGISTERS];
+    /** Arithmetic */
+    int arithMode;
+    /** Arbitrary precision in digits */
+    int bigDigits;
+    /** Unary result memo table */
+    MemoCache memo;
+#if STATS
+    /** Statistics, 0 if not collected */
+    EngineStats *stats;
+#endif
+    /** History calculations are logged to, 0 for none */
+    HistoryLog *history;
+    /** Buffer calculations are held in instead, 0 for none */
+    QVector<HistoryEntry> *historyBuffer;
+    /** Request to stop long calculations, never made unless in the background */
+    BigCancel cancel;
+    /** Statistics of the values added to memory */
+    Accumulator summary;
+    /** Summary status, 'M+' adds to the summary too */
+    bool isSummaryEnabled;
+    /** Last operator */
+    int lastOperator;
+    /** Last clicked button type */
+    int lastClicked;
+    /** Decimal status */
+    bool isDecimalEnabled;
+    /** Negative sign status */
+    bool isNegativeEnabled;
+    /** 'Bin' button status */
+    int binButtonStatus;
+    /** 'Hex' button status */
+    int hexButtonStatus;
+    /** Base numbers are shown in : MODE_DEC, MODE_BIN or MODE_HEX */
+    int radix;
+    /** Number of digits in LCD */
+    int numLCDDigits;
+    /** Parse the LCD register from the text if needed */
+    void parseLCD(void);
+    /** Show error function */
+    void showError(void);
+    /** Check if calculations are logged */
+    bool isLogging(void);
+    /** Get the exact text of a register */
+    QString getRegisterText(int reg);
+    /** Log a calculation to the history */
+    void logCalculation(int op, int flags, double operand1, double operand2, const QByteArray &operandText, int reg);
+    /** Show the base on the 'Bin' and 'Hex' buttons */
+    void showRadix(void);
+    /** Run an expression in an exact arithmetic */
+    bool evaluateExact(const Expression &expression);
+    /** Handle button press, untimed */
+    void pressButton(int index);
+#if HEX
+    /** Handle hex button press, untimed */
+    void pressHexButton(int index);
+#endif
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,14 @@
+######################################################################
+# Calculator engine library, free of any widget
+######################################################################
+
+TEMPLATE = lib
+TARGET = qcalcengine
+CONFIG += staticlib
+QT -= gui
+DEPENDPATH += .
+INCLUDEPATH += .
+
+# Input
+HEADERS += engine.h bignum.h decimal.h gamma.h expression.h vectorcalc.h batch.h memo.h stats.h integer.h undo.h history.h server.h sessions.h accumulator.h format.h parse.h
+SOURCES += engine.cpp bignum.cpp decimal.cpp gamma.cpp expression.cpp vectorcalc.cpp batch.cpp memo.cpp stats.cpp integer.cpp undo.cpp history.cpp server.cpp sessions.cpp accumulator.cpp format.cpp parse.cpp
@@ -0,0 +1,571 @@
+/** @file expression.cpp
+ *
+ *  @brief This file contains the definitions of the expression compiler
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "expression.h"
+#include "engine.h"
+#include "parse.h"
+#include <QByteArray>
+#include <ctype.h>
+#include <string.h>
+
+/**
+ *  @brief  Expression object constructor
+ *
+ *  @return N/A
+ */
+Expression::Expression()
+    : isFolding(true), errorText("empty expression"), input(0), pos(0), depth(0), nesting(0)
+{
+    return;
+}
+
+/**
+ *  @brief  Expression object method : Compile an expression
+ *
+ *  @param  text    Expression text
+ *  @param  fold    Fold constant parts in double precision
+ *
+ *  @return true on success, see getError() otherwise
+ */
+bool Expression::compile(const QString &text, bool fold)
+{
+    /* The grammar is plain ASCII */
+    QByteArray bytes = text.toLatin1();
+
+    /* Start from scratch */
+    code.clear();
+    constants.clear();
+    constantTexts.clear();
+    isFolding = fold;
+    errorText = QString();
+    input = bytes.constData();
+    pos = input;
+    depth = 0;
+    nesting = 0;
+
+    /* Parse the whole text */
+    bool ok = parseSum();
+    if (ok && !peek('\0')) {
+        ok = fail("unexpected character");
+    }
+    if (ok && code.isEmpty()) {
+        ok = fail("empty expression");
+    }
+
+    /* Never evaluate half compiled code */
+    if (!ok) {
+        code.clear();
+        constants.clear();
+        constantTexts.clear();
+    }
+
+    /* The text goes away with the byte array */
+    input = 0;
+    pos = 0;
+    return ok;
+}
+
+/**
+ *  @brief  Expression object method : Check if the expression compiled
+ *
+ *  @return true if the expression can be evaluated
+ */
+bool Expression::isValid(void) const
+{
+    /* Return compile status */
+    return errorText.isEmpty();
+}
+
+/**
+ *  @brief  Expression object method : Get the compile error
+ *
+ *  @return Compile error, empty if none
+ */
+QString Expression::getError(void) const
+{
+    /* Return compile error */
+    return errorText;
+}
+
+/**
+ *  @brief  Expression object method : Evaluate the expression
+ *
+ *  @param  memory  Memory value for 'M'
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Result, 0 on error
+ */
+double Expression::evaluate(double memory, bool *error) const
+{
+    double stack[EXPRESSION_STACK];
+    double *top = stack - 1;
+    const Instruction *insn = code.constData();
+    const Instruction *end = insn + code.size();
+    const double *constant = constants.constData();
+    bool failed = false;
+
+    /* Nothing to run */
+    if (insn == end) {
+        *error = true;
+        return 0;
+    }
+
+    /* Run the bytecode */
+    for (; insn != end; insn++) {
+        switch (insn->code) {
+            case INSN_CONST:
+                *++top = constant[insn->index];
+                break;
+            case INSN_MEMORY:
+                *++top = memory;
+                break;
+            case INSN_NEG:
+                *top = -*top;
+                break;
+            case INSN_BINARY:
+                top--;
+                *top = Engine::compute(top[0], top[1], insn->op, &failed);
+                break;
+            case INSN_UNARY:
+                *top = Engine::compute(*top, *top, insn->op, &failed);
+                break;
+            case INSN_SQ:
+                *top = Engine::compute(*top, *top, OPERATOR_MUL, &failed);
+                break;
+            case INSN_CUBE:
+                *top = Engine::compute(Engine::compute(*top, *top, OPERATOR_MUL, &failed),
+                                       *top, OPERATOR_MUL, &failed);
+                break;
+            case INSN_INV:
+                *top = Engine::compute(1, *top, OPERATOR_DIV, &failed);
+                break;
+            default:
+                break;
+        }
+        if (failed) {
+            /* Stop on the first error */
+            *error = true;
+            return 0;
+        }
+    }
+    return *top;
+}
+
+/**
+ *  @brief  Expression object method : Get the bytecode
+ *
+ *  @return Bytecode, empty if the expression did not compile
+ */
+const QVector<Instruction> &Expression::getCode(void) const
+{
+    /* Return bytecode */
+    return code;
+}
+
+/**
+ *  @brief  Expression object method : Get a constant value
+ *
+ *  @param  index   Constant index of an INSN_CONST instruction
+ *
+ *  @return Constant value in double precision
+ */
+double Expression::getConstant(int index) const
+{
+    /* Return constant value */
+    return constants.at(index);
+}
+
+/**
+ *  @brief  Expression object method : Get a constant text
+ *
+ *  @param  index   Constant index of an INSN_CONST instruction
+ *
+ *  @return Constant text as written, empty for folded constants
+ */
+QString Expression::getConstantText(int index) const
+{
+    /* Return constant text */
+    return constantTexts.at(index);
+}
+
+/**
+ *  @brief  Expression object method : Parse a sum
+ *
+ *  @return true on success
+ */
+bool Expression::parseSum(void)
+{
+    /* First term */
+    if (!parseProduct()) {
+        return false;
+    }
+
+    /* Following terms */
+    for (;;) {
+        int op = OPERATOR_NONE;
+        if (peek('+')) {
+            op = OPERATOR_PLUS;
+        } else if (peek('-')) {
+            op = OPERATOR_MINUS;
+        } else {
+            return true;
+        }
+        pos++;
+        if (!parseProduct() || !emitInstruction(INSN_BINARY, op)) {
+            return false;
+        }
+    }
+}
+
+/**
+ *  @brief  Expression object method : Parse a product
+ *
+ *  @return true on success
+ */
+bool Expression::parseProduct(void)
+{
+    /* First factor */
+    if (!parseUnary()) {
+        return false;
+    }
+
+    /* Following factors */
+    for (;;) {
+        int op = OPERATOR_NONE;
+        if (peek('*')) {
+            op = OPERATOR_MUL;
+        } else if (peek('/')) {
+            op = OPERATOR_DIV;
+        } else {
+            return true;
+        }
+        pos++;
+        if (!parseUnary() || !emitInstruction(INSN_BINARY, op)) {
+            return false;
+        }
+    }
+}
+
+/**
+ *  @brief  Expression object method : Parse a unary expression
+ *
+ *  @return true on success
+ */
+bool Expression::parseUnary(void)
+{
+    int insn = -1, op = OPERATOR_NONE;
+    bool ok;
+
+    /* Find the prefix operator, if any */
+    if (peek('-')) {
+        pos++;
+        insn = INSN_NEG;
+    } else if (peek('+')) {
+        pos++;
+    } else if (peek('!')) {
+        pos++;
+        insn = INSN_UNARY;
+        op = OPERATOR_FACT;
+    } else if (matchName("sqrt")) {
+        insn = INSN_UNARY;
+        op = OPERATOR_SQRT;
+    } else if (matchName("fact")) {
+        insn = INSN_UNARY;
+        op = OPERATOR_FACT;
+    } else if (matchName("sq")) {
+        insn = INSN_SQ;
+    } else if (matchName("cube")) {
+        insn = INSN_CUBE;
+    } else if (matchName("inv")) {
+        insn = INSN_INV;
+    } else {
+        /* No prefix operator */
+        return parsePostfix();
+    }
+
+    /* Guard the stack against runaway nesting */
+    if (++nesting > EXPRESSION_STACK) {
+        return fail("expression nested too deep");
+    }
+    ok = parseUnary();
+    nesting--;
+    if (!ok) {
+        return false;
+    }
+
+    /* Apply the prefix operator to its operand */
+    return (insn < 0) || emitInstruction(insn, op);
+}
+
+/**
+ *  @brief  Expression object method : Parse a primary expression and its postfix operators
+ *
+ *  @return true on success
+ */
+bool Expression::parsePostfix(void)
+{
+    /* Operand */
+    if (!parsePrimary()) {
+        return false;
+    }
+
+    /* Postfix operators */
+    for (;;) {
+        if (peek('!')) {
+            /* Factorial */
+            pos++;
+            if (!emitInstruction(INSN_UNARY, OPERATOR_FACT)) {
+                return false;
+            }
+        } else if (peek('^')) {
+            /* Square or cube, the only powers the calculator knows */
+            pos++;
+            if (peek('2') && !isdigit((unsigned char) pos[1])) {
+                pos++;
+                if (!emitInstruction(INSN_SQ, OPERATOR_NONE)) {
+                    return false;
+                }
+            } else if (peek('3') && !isdigit((unsigned char) pos[1])) {
+                pos++;
+                if (!emitInstruction(INSN_CUBE, OPERATOR_NONE)) {
+                    return false;
+                }
+            } else {
+                return fail("only ^2 and ^3 are supported");
+            }
+        } else {
+            return true;
+        }
+    }
+}
+
+/**
+ *  @brief  Expression object method : Parse a primary expression
+ *
+ *  @return true on success
+ */
+bool Expression::parsePrimary(void)
+{
+    /* Parenthesized expression */
+    if (peek('(')) {
+        pos++;
+        if (++nesting > EXPRESSION_STACK) {
+            return fail("expression nested too deep");
+        }
+        if (!parseSum()) {
+            return false;
+        }
+        nesting--;
+        if (!peek(')')) {
+            return fail("missing ')'");
+        }
+        pos++;
+        return true;
+    }
+
+    /* Memory reference */
+    if (matchName("mr") || matchName("m")) {
+        return emitInstruction(INSN_MEMORY, OPERATOR_NONE);
+    }
+
+    /* Number */
+    const char *start = pos;
+    while (isdigit((unsigned char) *pos)) {
+        pos++;
+    }
+    if (*pos == '.') {
+        pos++;
+        while (isdigit((unsigned char) *pos)) {
+            pos++;
+        }
+    }
+    if ((pos == start) || ((pos - start == 1) && (*start == '.'))) {
+        pos = start;
+        return fail("expected a number");
+    }
+    if ((*pos == 'e') || (*pos == 'E')) {
+        /* Exponent, only if digits follow */
+        const char *mark = pos++;
+        if ((*pos == '+') || (*pos == '-')) {
+            pos++;
+        }
+        if (isdigit((unsigned char) *pos)) {
+            while (isdigit((unsigned char) *pos)) {
+                pos++;
+            }
+        } else {
+            pos = mark;
+        }
+    }
+
+    /* Convert the number, independent of the locale */
+    return emitConstant(Parse::toDouble(start, pos - start), QString::fromLatin1(start, pos - start));
+}
+
+/**
+ *  @brief  Expression object method : Skip white space and check the next character
+ *
+ *  @param  c   Character to check
+ *
+ *  @return true if the next character is c
+ */
+bool Expression::peek(char c)
+{
+    /* Skip white space */
+    while (isspace((unsigned char) *pos)) {
+        pos++;
+    }
+    return *pos == c;
+}
+
+/**
+ *  @brief  Expression object method : Skip white space and match a name
+ *
+ *  @param  name    Lower case name to match
+ *
+ *  @return true if matched, the name is consumed
+ */
+bool Expression::matchName(const char *name)
+{
+    int length = strlen(name);
+
+    /* Skip white space */
+    peek('\0');
+
+    /* Match the name, but not the start of a longer one */
+    for (int i = 0; i < length; i++) {
+        if (tolower((unsigned char) pos[i]) != name[i]) {
+            return false;
+        }
+    }
+    if (isalnum((unsigned char) pos[length])) {
+        return false;
+    }
+    pos += length;
+    return true;
+}
+
+/**
+ *  @brief  Expression object method : Emit a constant
+ *
+ *  @param  value   Constant value
+ *  @param  text    Constant text, empty for folded constants
+ *
+ *  @return true on success
+ */
+bool Expression::emitConstant(double value, const QString &text)
+{
+    Instruction insn = { INSN_CONST, OPERATOR_NONE, 0 };
+
+    /* Constant indexes are limited */
+    if (constants.size() > 0xffff) {
+        return fail("too many constants");
+    }
+
+    /* Save the constant and push it */
+    insn.index = constants.size();
+    constants.append(value);
+    constantTexts.append(text);
+    code.append(insn);
+
+    /* Track the stack depth */
+    if (++depth > EXPRESSION_STACK) {
+        return fail("expression nested too deep");
+    }
+    return true;
+}
+
+/**
+ *  @brief  Expression object method : Emit an instruction, folding constants
+ *
+ *  @param  insnCode    Instruction code
+ *  @param  op          Operator for INSN_BINARY and INSN_UNARY
+ *
+ *  @return true on success
+ */
+bool Expression::emitInstruction(int insnCode, int op)
+{
+    Instruction insn = { (unsigned char) insnCode, (unsigned char) op, 0 };
+    int operands = (insnCode == INSN_BINARY) ? 2 : ((insnCode == INSN_MEMORY) ? 0 : 1);
+    int size = code.size();
+
+    /* Memory is only known when evaluating */
+    if (insnCode == INSN_MEMORY) {
+        code.append(insn);
+        if (++depth > EXPRESSION_STACK) {
+            return fail("expression nested too deep");
+        }
+        return true;
+    }
+
+    /* Fold the operation if all operands are constants. The constants
+     * are always the last ones saved, so they can be dropped again. */
+    if (isFolding && (size >= operands) &&
+        (code[size - 1].code == INSN_CONST) &&
+        ((operands == 1) || (code[size - 2].code == INSN_CONST))) {
+        Expression single;
+        bool failed = false;
+        double value;
+
+        /* Evaluate the operation on its own */
+        for (int i = 0; i < operands; i++) {
+            single.constants.append(constants[constants.size() - operands + i]);
+            single.code.append(code[size - operands + i]);
+            single.code.last().index = i;
+        }
+        single.code.append(insn);
+        value = single.evaluate(0, &failed);
+
+        /* Errors are left for evaluation time to report */
+        if (!failed) {
+            code.resize(size - operands);
+            constants.resize(constants.size() - operands);
+            constantTexts.resize(constantTexts.size() - operands);
+            depth -= operands;
+            return emitConstant(value, QString());
+        }
+    }
+
+    /* Emit the instruction */
+    code.append(insn);
+    if (insnCode == INSN_BINARY) {
+        depth--;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Expression object method : Record a compile error
+ *
+ *  @param  message     Error message
+ *
+ *  @return false
+ */
+bool Expression::fail(const char *message)
+{
+    /* Keep the first error only */
+    if (errorText.isEmpty()) {
+        errorText = QString::fromLatin1(message) + " at column " + QString::number((int) (pos - input + 1));
+    }
+    return false;
+}
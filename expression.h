@@ -0,0 +1,137 @@
+/** @file expression.h
+ *
+ *  @brief This file contains the declarations of the expression compiler
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+/* Includes */
+#include <QString>
+#include <QVector>
+
+/* Defines */
+
+/** Maximum evaluation stack depth of an expression */
+#define EXPRESSION_STACK    64
+
+/** Instruction : Push constant */
+#define INSN_CONST      0
+/** Instruction : Push memory value */
+#define INSN_MEMORY     1
+/** Instruction : Negate */
+#define INSN_NEG        2
+/** Instruction : Binary operator, OPERATOR_* in the argument */
+#define INSN_BINARY     3
+/** Instruction : Unary operator, OPERATOR_* in the argument */
+#define INSN_UNARY      4
+/** Instruction : Square */
+#define INSN_SQ         5
+/** Instruction : Cube */
+#define INSN_CUBE       6
+/** Instruction : Inverse */
+#define INSN_INV        7
+
+/** One bytecode instruction */
+struct Instruction {
+    /** Instruction code, INSN_* */
+    unsigned char code;
+    /** Operator for INSN_BINARY and INSN_UNARY */
+    unsigned char op;
+    /** Constant index for INSN_CONST */
+    unsigned short index;
+};
+
+/**
+ *  A compiled calculator expression.
+ *
+ *  The grammar follows the usual precedence: '+' and '-' bind looser
+ *  than '*' and '/', which bind looser than the unary operators. Unary
+ *  operators are '-', '!' (factorial), 'sqrt', 'sq', 'cube' and 'inv',
+ *  written before their operand; '!', '^2' and '^3' may also follow it.
+ *  'M' (or 'MR') refers to the memory value given at evaluation time.
+ *
+ *  An expression is compiled once into stack bytecode, with constant
+ *  parts folded, and then evaluated with the same arithmetic as
+ *  Engine::calculate(). The text of each constant is kept, so that the
+ *  engine can run unfolded bytecode in its other arithmetics too.
+ */
+class Expression
+{
+public:
+    /** Constructor */
+    Expression();
+    /** Compile an expression */
+    bool compile(const QString &text, bool fold = true);
+    /** Check if the expression compiled */
+    bool isValid(void) const;
+    /** Get the compile error */
+    QString getError(void) const;
+    /** Evaluate the expression */
+    double evaluate(double memory, bool *error) const;
+    /** Get the bytecode */
+    const QVector<Instruction> &getCode(void) const;
+    /** Get a constant value */
+    double getConstant(int index) const;
+    /** Get a constant text, empty for folded constants */
+    QString getConstantText(int index) const;
+
+private:
+    /** Bytecode */
+    QVector<Instruction> code;
+    /** Constants */
+    QVector<double> constants;
+    /** Constant texts */
+    QVector<QString> constantTexts;
+    /** Fold constant parts while compiling */
+    bool isFolding;
+    /** Compile error, empty if none */
+    QString errorText;
+    /** Expression text being compiled */
+    const char *input;
+    /** Current position in the text */
+    const char *pos;
+    /** Current stack depth while compiling */
+    int depth;
+    /** Current nesting depth while compiling */
+    int nesting;
+    /** Parse a sum */
+    bool parseSum(void);
+    /** Parse a product */
+    bool parseProduct(void);
+    /** Parse a unary expression */
+    bool parseUnary(void);
+    /** Parse a primary expression and its postfix operators */
+    bool parsePostfix(void);
+    /** Parse a primary expression */
+    bool parsePrimary(void);
+    /** Skip white space and check the next character */
+    bool peek(char c);
+    /** Skip white space and match a name */
+    bool matchName(const char *name);
+    /** Emit a constant */
+    bool emitConstant(double value, const QString &text);
+    /** Emit an instruction, folding constants */
+    bool emitInstruction(int insn, int op);
+    /** Record a compile error */
+    bool fail(const char *message);
+};
+
+#endif // EXPRESSION_H
@@ -0,0 +1,543 @@
+/** @file format.cpp
+ *
+ *  @brief This file contains the definitions of the double formatting
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "format.h"
+#include "engine.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines */
+
+/** Exponent bias of a double with an integer significand */
+#define FORMAT_EXPONENT_BIAS    1075
+/** Bits of a double fraction, without the hidden bit */
+#define FORMAT_FRACTION_BITS    52
+/** Smallest binary exponent of a scaled boundary */
+#define FORMAT_ALPHA    (-60)
+/** Decimal exponent of the first cached power of ten */
+#define FORMAT_FIRST_POWER  (-300)
+/** Decimal exponent step between cached powers of ten */
+#define FORMAT_POWER_STEP   8
+/** Most significant digits needed to parse back to any double */
+#define FORMAT_MAX_DIGITS   17
+/** Smallest decimal exponent shown without exponent notation */
+#define FORMAT_MIN_POINT    (-4)
+
+/** Number with a 64-bit significand, f * 2^e */
+struct DiyFp
+{
+    /** Significand */
+    quint64 f;
+    /** Binary exponent */
+    int e;
+};
+
+/** Power of ten, f * 2^e rounded from 10^k */
+struct CachedPower
+{
+    /** Normalized significand */
+    quint64 f;
+    /** Binary exponent */
+    int e;
+    /** Decimal exponent */
+    int k;
+};
+
+/** Powers of ten, close enough that any double scales into [2^-60, 2^-32) */
+static const CachedPower cachedPowers[] = {
+        { 0xAB70FE17C79AC6CAULL, -1060, -300 },  /* 1e-300 */
+        { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },  /* 1e-292 */
+        { 0xBE5691EF416BD60CULL, -1007, -284 },  /* 1e-284 */
+        { 0x8DD01FAD907FFC3CULL,  -980, -276 },  /* 1e-276 */
+        { 0xD3515C2831559A83ULL,  -954, -268 },  /* 1e-268 */
+        { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },  /* 1e-260 */
+        { 0xEA9C227723EE8BCBULL,  -901, -252 },  /* 1e-252 */
+        { 0xAECC49914078536DULL,  -874, -244 },  /* 1e-244 */
+        { 0x823C12795DB6CE57ULL,  -847, -236 },  /* 1e-236 */
+        { 0xC21094364DFB5637ULL,  -821, -228 },  /* 1e-228 */
+        { 0x9096EA6F3848984FULL,  -794, -220 },  /* 1e-220 */
+        { 0xD77485CB25823AC7ULL,  -768, -212 },  /* 1e-212 */
+        { 0xA086CFCD97BF97F4ULL,  -741, -204 },  /* 1e-204 */
+        { 0xEF340A98172AACE5ULL,  -715, -196 },  /* 1e-196 */
+        { 0xB23867FB2A35B28EULL,  -688, -188 },  /* 1e-188 */
+        { 0x84C8D4DFD2C63F3BULL,  -661, -180 },  /* 1e-180 */
+        { 0xC5DD44271AD3CDBAULL,  -635, -172 },  /* 1e-172 */
+        { 0x936B9FCEBB25C996ULL,  -608, -164 },  /* 1e-164 */
+        { 0xDBAC6C247D62A584ULL,  -582, -156 },  /* 1e-156 */
+        { 0xA3AB66580D5FDAF6ULL,  -555, -148 },  /* 1e-148 */
+        { 0xF3E2F893DEC3F126ULL,  -529, -140 },  /* 1e-140 */
+        { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },  /* 1e-132 */
+        { 0x87625F056C7C4A8BULL,  -475, -124 },  /* 1e-124 */
+        { 0xC9BCFF6034C13053ULL,  -449, -116 },  /* 1e-116 */
+        { 0x964E858C91BA2655ULL,  -422, -108 },  /* 1e-108 */
+        { 0xDFF9772470297EBDULL,  -396, -100 },  /* 1e-100 */
+        { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 },  /* 1e-92 */
+        { 0xF8A95FCF88747D94ULL,  -343,  -84 },  /* 1e-84 */
+        { 0xB94470938FA89BCFULL,  -316,  -76 },  /* 1e-76 */
+        { 0x8A08F0F8BF0F156BULL,  -289,  -68 },  /* 1e-68 */
+        { 0xCDB02555653131B6ULL,  -263,  -60 },  /* 1e-60 */
+        { 0x993FE2C6D07B7FACULL,  -236,  -52 },  /* 1e-52 */
+        { 0xE45C10C42A2B3B06ULL,  -210,  -44 },  /* 1e-44 */
+        { 0xAA242499697392D3ULL,  -183,  -36 },  /* 1e-36 */
+        { 0xFD87B5F28300CA0EULL,  -157,  -28 },  /* 1e-28 */
+        { 0xBCE5086492111AEBULL,  -130,  -20 },  /* 1e-20 */
+        { 0x8CBCCC096F5088CCULL,  -103,  -12 },  /* 1e-12 */
+        { 0xD1B71758E219652CULL,   -77,   -4 },  /* 1e-4 */
+        { 0x9C40000000000000ULL,   -50,    4 },  /* 1e4 */
+        { 0xE8D4A51000000000ULL,   -24,   12 },  /* 1e12 */
+        { 0xAD78EBC5AC620000ULL,     3,   20 },  /* 1e20 */
+        { 0x813F3978F8940984ULL,    30,   28 },  /* 1e28 */
+        { 0xC097CE7BC90715B3ULL,    56,   36 },  /* 1e36 */
+        { 0x8F7E32CE7BEA5C70ULL,    83,   44 },  /* 1e44 */
+        { 0xD5D238A4ABE98068ULL,   109,   52 },  /* 1e52 */
+        { 0x9F4F2726179A2245ULL,   136,   60 },  /* 1e60 */
+        { 0xED63A231D4C4FB27ULL,   162,   68 },  /* 1e68 */
+        { 0xB0DE65388CC8ADA8ULL,   189,   76 },  /* 1e76 */
+        { 0x83C7088E1AAB65DBULL,   216,   84 },  /* 1e84 */
+        { 0xC45D1DF942711D9AULL,   242,   92 },  /* 1e92 */
+        { 0x924D692CA61BE758ULL,   269,  100 },  /* 1e100 */
+        { 0xDA01EE641A708DEAULL,   295,  108 },  /* 1e108 */
+        { 0xA26DA3999AEF774AULL,   322,  116 },  /* 1e116 */
+        { 0xF209787BB47D6B85ULL,   348,  124 },  /* 1e124 */
+        { 0xB454E4A179DD1877ULL,   375,  132 },  /* 1e132 */
+        { 0x865B86925B9BC5C2ULL,   402,  140 },  /* 1e140 */
+        { 0xC83553C5C8965D3DULL,   428,  148 },  /* 1e148 */
+        { 0x952AB45CFA97A0B3ULL,   455,  156 },  /* 1e156 */
+        { 0xDE469FBD99A05FE3ULL,   481,  164 },  /* 1e164 */
+        { 0xA59BC234DB398C25ULL,   508,  172 },  /* 1e172 */
+        { 0xF6C69A72A3989F5CULL,   534,  180 },  /* 1e180 */
+        { 0xB7DCBF5354E9BECEULL,   561,  188 },  /* 1e188 */
+        { 0x88FCF317F22241E2ULL,   588,  196 },  /* 1e196 */
+        { 0xCC20CE9BD35C78A5ULL,   614,  204 },  /* 1e204 */
+        { 0x98165AF37B2153DFULL,   641,  212 },  /* 1e212 */
+        { 0xE2A0B5DC971F303AULL,   667,  220 },  /* 1e220 */
+        { 0xA8D9D1535CE3B396ULL,   694,  228 },  /* 1e228 */
+        { 0xFB9B7CD9A4A7443CULL,   720,  236 },  /* 1e236 */
+        { 0xBB764C4CA7A44410ULL,   747,  244 },  /* 1e244 */
+        { 0x8BAB8EEFB6409C1AULL,   774,  252 },  /* 1e252 */
+        { 0xD01FEF10A657842CULL,   800,  260 },  /* 1e260 */
+        { 0x9B10A4E5E9913129ULL,   827,  268 },  /* 1e268 */
+        { 0xE7109BFBA19C0C9DULL,   853,  276 },  /* 1e276 */
+        { 0xAC2820D9623BF429ULL,   880,  284 },  /* 1e284 */
+        { 0x80444B5E7AA7CF85ULL,   907,  292 },  /* 1e292 */
+        { 0xBF21E44003ACDD2DULL,   933,  300 },  /* 1e300 */
+        { 0x8E679C2F5E44FF8FULL,   960,  308 },  /* 1e308 */
+        { 0xD433179D9C8CB841ULL,   986,  316 },  /* 1e316 */
+        { 0x9E19DB92B4E31BA9ULL,  1013,  324 }   /* 1e324 */
+    };
+
+/**
+ *  @brief  Normalize a number, so the top bit of the significand is set
+ *
+ *  @param  x   Number, not zero
+ *
+ *  @return Normalized number
+ */
+static DiyFp normalize(DiyFp x)
+{
+    /* Shift out the leading zeros */
+    int shift = __builtin_clzll(x.f);
+    x.f <<= shift;
+    x.e -= shift;
+    return x;
+}
+
+/**
+ *  @brief  Multiply two numbers, rounding to 64 bits
+ *
+ *  @param  x   Number
+ *  @param  y   Number
+ *
+ *  @return Product
+ */
+static DiyFp multiply(DiyFp x, DiyFp y)
+{
+    DiyFp r;
+
+    /* Four 32 by 32 bit products, with the lower half rounded into the upper */
+    quint64 a = x.f >> 32;
+    quint64 b = x.f & 0xffffffffULL;
+    quint64 c = y.f >> 32;
+    quint64 d = y.f & 0xffffffffULL;
+    quint64 ac = a * c;
+    quint64 bc = b * c;
+    quint64 ad = a * d;
+    quint64 bd = b * d;
+    quint64 middle = (bd >> 32) + (ad & 0xffffffffULL) + (bc & 0xffffffffULL) + (1ULL << 31);
+    r.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    r.e = x.e + y.e + 64;
+    return r;
+}
+
+/**
+ *  @brief  Get a double and the boundaries halfway to its neighbours
+ *
+ *  @param  value   Value, positive
+ *  @param  v       Set to the value, normalized
+ *  @param  low     Set to the lower boundary
+ *  @param  high    Set to the upper boundary, normalized
+ *
+ *  @return N/A
+ */
+static void boundaries(double value, DiyFp *v, DiyFp *low, DiyFp *high)
+{
+    quint64 bits;
+
+    /* Split the double, a subnormal has no hidden bit */
+    memcpy(&bits, &value, sizeof(bits));
+    quint64 fraction = bits & ((1ULL << FORMAT_FRACTION_BITS) - 1);
+    int biased = (int) (bits >> FORMAT_FRACTION_BITS);
+    if (biased == 0) {
+        v->f = fraction;
+        v->e = 1 - FORMAT_EXPONENT_BIAS;
+    } else {
+        v->f = fraction | (1ULL << FORMAT_FRACTION_BITS);
+        v->e = biased - FORMAT_EXPONENT_BIAS;
+    }
+
+    /* The lower neighbour is closer at a power of two */
+    high->f = 2 * v->f + 1;
+    high->e = v->e - 1;
+    *high = normalize(*high);
+    if ((fraction == 0) && (biased > 1)) {
+        low->f = 4 * v->f - 1;
+        low->e = v->e - 2;
+    } else {
+        low->f = 2 * v->f - 1;
+        low->e = v->e - 1;
+    }
+
+    /* Both boundaries on the same exponent */
+    low->f <<= low->e - high->e;
+    low->e = high->e;
+    *v = normalize(*v);
+    return;
+}
+
+/**
+ *  @brief  Get the cached power of ten that scales a binary exponent into range
+ *
+ *  @param  e   Binary exponent
+ *
+ *  @return Cached power of ten
+ */
+static const CachedPower &cachedPower(int e)
+{
+    /* Ceiling of the decimal logarithm, 78913 / 2^18 is close to log10(2) */
+    int f = FORMAT_ALPHA - e - 1;
+    int k = (f * 78913) / (1 << 18) + (f > 0);
+    return cachedPowers[(k - FORMAT_FIRST_POWER + FORMAT_POWER_STEP - 1) / FORMAT_POWER_STEP];
+}
+
+/**
+ *  @brief  Get the digits of a double correctly rounded to a precision
+ *
+ *  @param  value       Value, positive
+ *  @param  precision   Significant digits
+ *  @param  digits      Set to the digits
+ *  @param  point       Set to the position of the decimal point
+ *
+ *  @return Number of digits, without trailing zeros
+ */
+static int rounded(double value, int precision, char *digits, int *point)
+{
+    char text[FORMAT_SIZE];
+    int n = 0;
+
+    /* Rare, the C library rounds the exact binary value, its point follows the locale */
+    snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+    const char *t = text;
+    for (; *t != 'e'; t++) {
+        if ((*t >= '0') && (*t <= '9')) {
+            digits[n++] = *t;
+        }
+    }
+    *point = atoi(t + 1) + 1;
+    while ((n > 1) && (digits[n - 1] == '0')) {
+        n--;
+    }
+    return n;
+}
+
+/**
+ *  @brief  Move the last digit towards the scaled value, and check it is the closest
+ *
+ *  @param  digits      Digits
+ *  @param  n           Number of digits
+ *  @param  distance    Distance from the upper boundary to the value
+ *  @param  delta       Distance between the boundaries
+ *  @param  rest        Distance from the upper boundary to the digits
+ *  @param  power       Weight of the last digit
+ *  @param  unit        Uncertainty of the scaled numbers
+ *
+ *  @return true if the digits are surely the shortest and closest
+ */
+static bool weed(char *digits, int n, quint64 distance, quint64 delta, quint64 rest, quint64 power, quint64 unit)
+{
+    quint64 small = distance - unit;
+    quint64 big = distance + unit;
+
+    /* Step down while still inside the boundaries and closer to the value */
+    while ((rest < small) && (delta - rest >= power)
+           && ((rest + power < small) || (small - rest >= rest + power - small))) {
+        digits[n - 1]--;
+        rest += power;
+    }
+
+    /* The value is only known within a unit, the next digit down may be as close */
+    if ((rest < big) && (delta - rest >= power)
+        && ((rest + power < big) || (big - rest > rest + power - big))) {
+        return false;
+    }
+
+    /* The digits must also be inside the boundaries by more than the uncertainty */
+    return (2 * unit <= rest) && (rest <= delta - 4 * unit);
+}
+
+/**
+ *  @brief  Generate the fewest digits between two scaled boundaries
+ *
+ *  The scaled numbers may be one unit off. The boundaries are widened by
+ *  it, and the digits are only taken if they are surely within the real
+ *  ones, which fails for about one double in two hundred.
+ *
+ *  @param  low         Lower boundary
+ *  @param  w           Value
+ *  @param  high        Upper boundary
+ *  @param  digits      Set to the digits
+ *  @param  exponent    Decimal exponent of the last digit, updated
+ *
+ *  @return Number of digits, 0 if they may not be the shortest
+ */
+static int generate(DiyFp low, DiyFp w, DiyFp high, char *digits, int *exponent)
+{
+    quint64 unit = 1;
+    quint64 tooHigh = high.f + unit;
+    quint64 delta = tooHigh - (low.f - unit);
+    quint64 distance = tooHigh - w.f;
+    int shift = -high.e;
+    quint64 one = 1ULL << shift;
+    quint32 integral = (quint32) (tooHigh >> shift);
+    quint64 fractional = tooHigh & (one - 1);
+    quint32 power = 1000000000;
+    int kappa = 10;
+    int n = 0;
+
+    /* Digits of the integral part, stop as soon as inside the boundaries */
+    while (integral < power) {
+        power /= 10;
+        kappa--;
+    }
+    while (kappa > 0) {
+        digits[n++] = (char) ('0' + integral / power);
+        integral %= power;
+        kappa--;
+        quint64 rest = ((quint64) integral << shift) + fractional;
+        if (rest < delta) {
+            *exponent += kappa;
+            return weed(digits, n, distance, delta, rest, (quint64) power << shift, unit) ? n : 0;
+        }
+        power /= 10;
+    }
+
+    /* Digits of the fractional part, the uncertainty grows with them */
+    for (;;) {
+        fractional *= 10;
+        unit *= 10;
+        delta *= 10;
+        digits[n++] = (char) ('0' + (fractional >> shift));
+        fractional &= one - 1;
+        kappa--;
+        if (fractional < delta) {
+            *exponent += kappa;
+            return weed(digits, n, distance * unit, delta, fractional, one, unit) ? n : 0;
+        }
+    }
+}
+
+/**
+ *  @brief  Get the shortest digits that parse back to a double
+ *
+ *  @param  value   Value, positive
+ *  @param  digits  Set to the digits
+ *  @param  point   Set to the position of the decimal point
+ *
+ *  @return Number of digits
+ */
+static int shortest(double value, char *digits, int *point)
+{
+    DiyFp v;
+    DiyFp low;
+    DiyFp high;
+    char text[FORMAT_SIZE];
+    int precision;
+
+    /* Scale the value and its boundaries by a power of ten */
+    boundaries(value, &v, &low, &high);
+    const CachedPower &power = cachedPower(high.e);
+    DiyFp scale = { power.f, power.e };
+    DiyFp w = multiply(v, scale);
+    DiyFp wLow = multiply(low, scale);
+    DiyFp wHigh = multiply(high, scale);
+
+    /* Nearly always the digits are known to be the shortest */
+    int exponent = -power.k;
+    int n = generate(wLow, w, wHigh, digits, &exponent);
+    if (n > 0) {
+        *point = n + exponent;
+        return n;
+    }
+
+    /* Rare, the fewest digits the C library rounds back to the value */
+    for (precision = 1; precision < FORMAT_MAX_DIGITS; precision++) {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, 0) == value) {
+            break;
+        }
+    }
+    return rounded(value, precision, digits, point);
+}
+
+/**
+ *  @brief  Lay out digits, with an exponent if too small or too large
+ *
+ *  Whole numbers are written out while their digits fit on the LCD.
+ *
+ *  @param  buffer      Buffer of FORMAT_SIZE bytes
+ *  @param  negative    Sign
+ *  @param  digits      Digits
+ *  @param  n           Number of digits
+ *  @param  point       Position of the decimal point
+ *
+ *  @return Length of the text
+ */
+static int layout(char *buffer, bool negative, const char *digits, int n, int point)
+{
+    char *t = buffer;
+
+    if (negative) {
+        *t++ = '-';
+    }
+    if ((point - 1 < FORMAT_MIN_POINT) || (point > LCD_LENGTH - (t - buffer))) {
+        /* Exponent notation */
+        *t++ = digits[0];
+        if (n > 1) {
+            *t++ = '.';
+            memcpy(t, digits + 1, n - 1);
+            t += n - 1;
+        }
+        int exponent = point - 1;
+        *t++ = 'e';
+        *t++ = (exponent < 0) ? '-' : '+';
+        if (exponent < 0) {
+            exponent = -exponent;
+        }
+        if (exponent >= 100) {
+            *t++ = (char) ('0' + exponent / 100);
+        }
+        if (exponent >= 10) {
+            *t++ = (char) ('0' + exponent / 10 % 10);
+        }
+        *t++ = (char) ('0' + exponent % 10);
+    } else if (point >= n) {
+        /* Integer */
+        memcpy(t, digits, n);
+        t += n;
+        memset(t, '0', point - n);
+        t += point - n;
+    } else if (point > 0) {
+        /* Point inside the digits */
+        memcpy(t, digits, point);
+        t += point;
+        *t++ = '.';
+        memcpy(t, digits + point, n - point);
+        t += n - point;
+    } else {
+        /* Point before the digits */
+        *t++ = '0';
+        *t++ = '.';
+        memset(t, '0', -point);
+        t += -point;
+        memcpy(t, digits, n);
+        t += n;
+    }
+    *t = '\0';
+    return t - buffer;
+}
+
+/**
+ *  @brief  Format class method : Format a double into a buffer
+ *
+ *  @param  value   Value
+ *  @param  buffer  Buffer of FORMAT_SIZE bytes
+ *
+ *  @return Length of the text, at most LCD_LENGTH
+ */
+int Format::toText(double value, char *buffer)
+{
+    char digits[FORMAT_SIZE];
+    int point;
+
+    /* Not a number, infinity and zero */
+    bool negative = signbit(value);
+    const char *special = 0;
+    if (isnan(value)) {
+        special = "nan";
+    } else if (isinf(value)) {
+        special = negative ? "-inf" : "inf";
+    } else if (value == 0) {
+        special = negative ? "-0" : "0";
+    }
+    if (special != 0) {
+        strcpy(buffer, special);
+        return strlen(buffer);
+    }
+
+    /* The shortest digits, fewer correctly rounded ones if too long for the LCD */
+    value = fabs(value);
+    int n = shortest(value, digits, &point);
+    int length = layout(buffer, negative, digits, n, point);
+    while (length > LCD_LENGTH) {
+        n = rounded(value, n - (length - LCD_LENGTH), digits, &point);
+        length = layout(buffer, negative, digits, n, point);
+    }
+    return length;
+}
+
+/**
+ *  @brief  Format class method : Format a double as a string
+ *
+ *  @param  value   Value
+ *
+ *  @return Text, at most LCD_LENGTH characters
+ */
+QString Format::toString(double value)
+{
+    char buffer[FORMAT_SIZE];
+
+    /* Format on the stack, one copy into the string */
+    int length = toText(value, buffer);
+    return QString::fromLatin1(buffer, length);
+}
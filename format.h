@@ -0,0 +1,55 @@
+/** @file format.h
+ *
+ *  @brief This file contains the declarations of the double formatting
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+/* Includes */
+#include <QString>
+
+/* Defines */
+
+/** Size of a buffer for a formatted double, with the terminating null */
+#define FORMAT_SIZE     32
+
+/**
+ *  Double to text conversion for the LCD.
+ *
+ *  The digits are the shortest that parse back to the same double.
+ *  They are found with the Grisu3 algorithm of Florian Loitsch in
+ *  64-bit integer arithmetic, which proves them shortest for all but
+ *  about one double in two hundred. Those few are found by asking the
+ *  C library for more digits until they parse back. Exponent notation
+ *  is used below 1e-4 and for whole numbers wider than the LCD, and a
+ *  text still longer than LCD_LENGTH is rounded correctly to fewer
+ *  digits.
+ */
+class Format
+{
+public:
+    /** Format into a buffer of FORMAT_SIZE bytes */
+    static int toText(double value, char *buffer);
+    /** Format as a string */
+    static QString toString(double value);
+};
+
+#endif // FORMAT_H
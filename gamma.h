@@ -0,0 +1,51 @@
+/** @file gamma.h
+ *
+ *  @brief This file contains the declarations of the factorial and Gamma functions
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMMA_H
+#define GAMMA_H
+
+/* Defines */
+
+/** Largest integer whose factorial fits in a double */
+#define FACTORIAL_MAX   170
+
+/**
+ *  Factorial and Gamma functions, all in constant time.
+ *
+ *  Integer factorials come from a table of the correctly rounded values,
+ *  non-integers use a Lanczos approximation of Gamma(x + 1), and the
+ *  logarithmic forms give magnitudes far beyond the range of a double.
+ */
+class Gamma
+{
+public:
+    /** Factorial, Gamma(x + 1) for non-integers */
+    static double factorial(double x, bool *error);
+    /** Gamma function */
+    static double gamma(double x);
+    /** Natural logarithm of the absolute Gamma function */
+    static double logGamma(double x);
+    /** Decimal logarithm of the absolute factorial */
+    static double log10Factorial(double x);
+};
+
+#endif // GAMMA_H
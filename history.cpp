@@ -0,0 +1,402 @@
+/** @file history.cpp
+ *
+ *  @brief This file contains the definitions of the calculation history
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "history.h"
+#include <QtCore/QtAlgorithms>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+/** Orders record numbers by result */
+class HistoryLess
+{
+public:
+    /** Constructor */
+    HistoryLess(const HistoryRecord *newRecords) : records(newRecords) {}
+    /** Compare two records */
+    bool operator()(int a, int b) const { return records[a].result < records[b].result; }
+
+private:
+    /** Records */
+    const HistoryRecord *records;
+};
+
+/**
+ *  @brief  History object constructor
+ *
+ *  @return N/A
+ */
+HistoryLog::HistoryLog()
+    : fd(-1), textFd(-1), textSize(0), map(0), mapSize(0), count(0), indexed(0)
+{
+    return;
+}
+
+/**
+ *  @brief  History object destructor
+ *
+ *  @return N/A
+ */
+HistoryLog::~HistoryLog()
+{
+    /* Unmap and close the file */
+    close();
+    return;
+}
+
+/**
+ *  @brief  History object method : Open a history file, created if missing
+ *
+ *  Only the header is read. A record torn by a crash is cut off, texts
+ *  written for it are left unused.
+ *
+ *  @param  fileName    Name of the history file
+ *
+ *  @return true on success, false if it cannot be opened or is no history file
+ */
+bool HistoryLog::open(const QString &fileName)
+{
+    HistoryHeader header;
+    struct stat info;
+
+    /* Open the files for appending, the texts first */
+    close();
+    textFd = ::open((fileName + HISTORY_TEXT_SUFFIX).toLocal8Bit().constData(), O_RDWR | O_CREAT | O_APPEND, 0600);
+    if ((textFd < 0) || (fstat(textFd, &info) != 0)) {
+        close();
+        return false;
+    }
+    textSize = info.st_size;
+    fd = ::open(fileName.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_APPEND, 0600);
+    if ((fd < 0) || (fstat(fd, &info) != 0)) {
+        close();
+        return false;
+    }
+
+    if (info.st_size == 0) {
+        /* New file, write the header */
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+        header.version = HISTORY_VERSION;
+        header.recordSize = sizeof(HistoryRecord);
+        if (write(fd, &header, sizeof(header)) != (ssize_t) sizeof(header)) {
+            close();
+            return false;
+        }
+        count = 0;
+        return true;
+    }
+
+    /* Check the header */
+    if ((pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)) ||
+        (memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0) ||
+        (header.version != HISTORY_VERSION) || (header.recordSize != sizeof(HistoryRecord))) {
+        close();
+        return false;
+    }
+
+    /* Count the records, appending must stay aligned to them */
+    count = (info.st_size - sizeof(header)) / sizeof(HistoryRecord);
+    off_t size = sizeof(header) + (off_t) count * sizeof(HistoryRecord);
+    if ((size != info.st_size) && (ftruncate(fd, size) != 0)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  History object method : Close the history file
+ *
+ *  @return N/A
+ */
+void HistoryLog::close(void)
+{
+    /* Unmap */
+    if (map != 0) {
+        munmap(map, mapSize);
+        map = 0;
+        mapSize = 0;
+    }
+
+    /* Close */
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (textFd >= 0) {
+        ::close(textFd);
+        textFd = -1;
+    }
+    textSize = 0;
+    count = 0;
+    index.clear();
+    indexed = 0;
+    return;
+}
+
+/**
+ *  @brief  History object method : Check for an open file
+ *
+ *  @return true if a history file is open
+ */
+bool HistoryLog::isOpen(void)
+{
+    /* Return open status */
+    return fd >= 0;
+}
+
+/**
+ *  @brief  History object method : Append a calculation
+ *
+ *  The texts are written before the record, a record never points past
+ *  the texts written.
+ *
+ *  @param  entry   Calculation to append
+ *
+ *  @return true on success
+ */
+bool HistoryLog::append(const HistoryEntry &entry)
+{
+    QMutexLocker locker(&mutex);
+    HistoryRecord record = entry.record;
+
+    if (fd < 0) {
+        return false;
+    }
+
+    /* The texts, the file is opened for appending */
+    record.textOffset = textSize;
+    record.textLength = entry.text.size();
+    if (write(textFd, entry.text.constData(), entry.text.size()) != (ssize_t) entry.text.size()) {
+        /* Part of them may have been written */
+        textSize = lseek(textFd, 0, SEEK_END);
+        return false;
+    }
+    textSize += entry.text.size();
+
+    /* The record in one write */
+    if (write(fd, &record, sizeof(record)) != (ssize_t) sizeof(record)) {
+        return false;
+    }
+    count++;
+    return true;
+}
+
+/**
+ *  @brief  History object method : Get the number of records
+ *
+ *  @return Number of records
+ */
+int HistoryLog::getCount(void)
+{
+    QMutexLocker locker(&mutex);
+
+    /* Return count */
+    return count;
+}
+
+/**
+ *  @brief  History object method : Get the records, mapped up to the current count
+ *
+ *  The mapping is made twice as large as needed, the records appended
+ *  later are seen through it without mapping again.
+ *
+ *  @param  number  Set to the number of records
+ *
+ *  @return Records, 0 if they cannot be mapped
+ */
+const HistoryRecord *HistoryLog::records(int *number)
+{
+    int records = getCount();
+    qint64 needed = sizeof(HistoryHeader) + (qint64) records * sizeof(HistoryRecord);
+
+    /* Map again if the file has outgrown the mapping */
+    *number = 0;
+    if (needed > mapSize) {
+        qint64 size = (needed * 2 > HISTORY_MAP_MIN) ? needed * 2 : HISTORY_MAP_MIN;
+        if (map != 0) {
+            munmap(map, mapSize);
+        }
+        void *newMap = (fd < 0) ? MAP_FAILED : mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (newMap == MAP_FAILED) {
+            map = 0;
+            mapSize = 0;
+            return 0;
+        }
+        map = (char *) newMap;
+        mapSize = size;
+    }
+    *number = records;
+    return (const HistoryRecord *) (map + sizeof(HistoryHeader));
+}
+
+/**
+ *  @brief  History object method : Get a record
+ *
+ *  @param  index   Record number, oldest first
+ *
+ *  @return Record, 0 if there is no such record
+ */
+const HistoryRecord *HistoryLog::at(int index)
+{
+    int number;
+    const HistoryRecord *all = records(&number);
+
+    if ((index < 0) || (index >= number)) {
+        return 0;
+    }
+    return &all[index];
+}
+
+/**
+ *  @brief  History object method : Get the texts of the values of a record
+ *
+ *  The texts are read when asked for, only for the records looked at.
+ *
+ *  @param  record      Record
+ *  @param  operand1    Set to the text of operand 1
+ *  @param  operand2    Set to the text of operand 2
+ *  @param  result      Set to the text of the result, empty on error
+ *
+ *  @return true on success, false if the record has no texts
+ */
+bool HistoryLog::getTexts(const HistoryRecord *record, QString *operand1, QString *operand2, QString *result)
+{
+    QByteArray text(record->textLength, '\0');
+
+    /* Read them, three texts ended by nulls */
+    if ((textFd < 0) || (record->textLength == 0) ||
+        (pread(textFd, text.data(), text.size(), record->textOffset) != (ssize_t) text.size()) ||
+        (text.count('\0') != 3) || !text.endsWith('\0')) {
+        return false;
+    }
+    int end1 = text.indexOf('\0');
+    int end2 = text.indexOf('\0', end1 + 1);
+    *operand1 = QString::fromUtf8(text.constData(), end1);
+    *operand2 = QString::fromUtf8(text.constData() + end1 + 1, end2 - end1 - 1);
+    *result = QString::fromUtf8(text.constData() + end2 + 1, text.size() - end2 - 2);
+    return true;
+}
+
+/**
+ *  @brief  History object method : Add the records appended since to the index
+ *
+ *  The new records are sorted by themselves and merged in, so a search
+ *  after a few more calculations costs a merge instead of a sort.
+ *
+ *  @return N/A
+ */
+void HistoryLog::updateIndex(void)
+{
+    int number;
+    const HistoryRecord *all = records(&number);
+    HistoryLess less(all);
+    QVector<int> added, merged;
+
+    if (indexed >= number) {
+        return;
+    }
+
+    /* Sort the new records that have a result */
+    for (int i = indexed; i < number; i++) {
+        if (((all[i].flags & HISTORY_ERROR) == 0) && (all[i].result == all[i].result)) {
+            added.append(i);
+        }
+    }
+    indexed = number;
+    qSort(added.begin(), added.end(), less);
+
+    /* Merge them in */
+    merged.reserve(index.size() + added.size());
+    int i = 0, j = 0;
+    while ((i < index.size()) && (j < added.size())) {
+        if (less(added[j], index[i])) {
+            merged.append(added[j++]);
+        } else {
+            merged.append(index[i++]);
+        }
+    }
+    while (i < index.size()) {
+        merged.append(index[i++]);
+    }
+    while (j < added.size()) {
+        merged.append(added[j++]);
+    }
+    index = merged;
+    return;
+}
+
+/**
+ *  @brief  History object method : Find the records with a result in a range
+ *
+ *  @param  low     Lowest result
+ *  @param  high    Highest result
+ *  @param  found   Set to the record numbers, oldest first
+ *
+ *  @return Number of records found
+ */
+int HistoryLog::find(double low, double high, QVector<int> *found)
+{
+    int number;
+
+    /* Bring the index up to date */
+    updateIndex();
+    const HistoryRecord *all = records(&number);
+    found->clear();
+
+    /* First result not below the range */
+    int first = 0, last = index.size();
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (all[index[middle]].result < low) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    /* Take the results up to the end of the range, in time order */
+    for (int i = first; (i < index.size()) && (all[index[i]].result <= high); i++) {
+        found->append(index[i]);
+    }
+    qSort(found->begin(), found->end());
+    return found->size();
+}
+
+/**
+ *  @brief  Get the current time in milliseconds since 1970
+ *
+ *  @return Time
+ */
+qint64 HistoryLog::now(void)
+{
+    struct timeval time;
+
+    gettimeofday(&time, 0);
+    return (qint64) time.tv_sec * 1000 + time.tv_usec / 1000;
+}
@@ -0,0 +1,160 @@
+/** @file history.h
+ *
+ *  @brief This file contains the declarations of the calculation history
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/* Includes */
+#include <QString>
+#include <QtCore/QVector>
+#include <QtCore/QMutex>
+#include <QtCore/QByteArray>
+
+/* Defines */
+
+/** Magic text at the start of a history file */
+#define HISTORY_MAGIC       "QCALCHST"
+/** History file format version */
+#define HISTORY_VERSION     2
+/** Name of the history file in the home directory */
+#define HISTORY_FILE        ".qcalc_history"
+/** Added to the name of the history file for the file of the texts */
+#define HISTORY_TEXT_SUFFIX ".text"
+/** Smallest mapping of the history file in bytes, it grows by doubling */
+#define HISTORY_MAP_MIN     (1 << 20)
+
+/** Record flag : Unary operation, the operator is one of UNARY_* */
+#define HISTORY_UNARY       0x01
+/** Record flag : The calculation failed, there is no result */
+#define HISTORY_ERROR       0x02
+
+/** History file header */
+struct HistoryHeader
+{
+    /** HISTORY_MAGIC, not terminated */
+    char magic[8];
+    /** HISTORY_VERSION */
+    quint32 version;
+    /** Size of a record, for readers of later versions */
+    quint32 recordSize;
+};
+
+/** One calculation in the history file, in host byte order */
+struct HistoryRecord
+{
+    /** Time of the calculation in milliseconds since 1970 */
+    qint64 time;
+    /** Operand 1, the operand of unary operations */
+    double operand1;
+    /** Operand 2, 0 for unary operations */
+    double operand2;
+    /** Result, 0 on error */
+    double result;
+    /** Offset of the texts in the file of the texts */
+    qint64 textOffset;
+    /** Size of the texts in bytes, 0 for none */
+    quint32 textLength;
+    /** Operator, OPERATOR_* or UNARY_* */
+    qint16 op;
+    /** Arithmetic mode */
+    quint8 arithMode;
+    /** Flags, HISTORY_* */
+    quint8 flags;
+};
+
+/** One calculation as it is appended, with the texts of its values */
+struct HistoryEntry
+{
+    /** Record, the text offset and size are set when appended */
+    HistoryRecord record;
+    /** Texts of operand 1, operand 2 and the result in UTF-8, each ended by a null */
+    QByteArray text;
+};
+
+/**
+ *  Append only log of every calculation.
+ *
+ *  Records have a fixed size and follow a small header. The values are
+ *  kept as doubles for searching, and as the exact texts of the
+ *  arithmetic they were calculated in, in a second file the records
+ *  point into. Appending writes the texts, then the record in a single
+ *  write, so a crash loses at most the last record. The file is
+ *  memory mapped for reading: opening it reads nothing but the header,
+ *  and a record costs nothing until it is looked at. Search by result
+ *  uses an index sorted by result, built on the first search and
+ *  extended with the records appended since.
+ *
+ *  Records may be appended from any thread. Reading and searching are
+ *  for one thread only.
+ */
+class HistoryLog
+{
+public:
+    /** Constructor */
+    HistoryLog();
+    /** Destructor */
+    ~HistoryLog();
+    /** Open a history file, created if missing */
+    bool open(const QString &fileName);
+    /** Close the history file */
+    void close(void);
+    /** Check for an open file */
+    bool isOpen(void);
+    /** Append a calculation */
+    bool append(const HistoryEntry &entry);
+    /** Get the number of records */
+    int getCount(void);
+    /** Get a record */
+    const HistoryRecord *at(int index);
+    /** Get the texts of the values of a record */
+    bool getTexts(const HistoryRecord *record, QString *operand1, QString *operand2, QString *result);
+    /** Find the records with a result in a range */
+    int find(double low, double high, QVector<int> *found);
+    /** Get the current time in milliseconds since 1970 */
+    static qint64 now(void);
+
+private:
+    /** File descriptor, -1 if closed */
+    int fd;
+    /** File descriptor of the texts, -1 if closed */
+    int textFd;
+    /** Size of the file of the texts, guarded by the mutex */
+    qint64 textSize;
+    /** Mapping of the file */
+    char *map;
+    /** Size of the mapping in bytes */
+    qint64 mapSize;
+    /** Number of records, guarded by the mutex */
+    int count;
+    /** Guards appending */
+    QMutex mutex;
+    /** Records with a result, sorted by result */
+    QVector<int> index;
+    /** Number of records looked at for the index */
+    int indexed;
+    /** Get the records, mapped up to the current count */
+    const HistoryRecord *records(int *number);
+    /** Add the records appended since to the index */
+    void updateIndex(void);
+};
+
+#endif // HISTORY_H
@@ -0,0 +1,261 @@
+/** @file integer.cpp
+ *
+ *  @brief This file contains the definitions of the 64-bit integer arithmetic
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "integer.h"
+#include "engine.h"
+#include <math.h>
+#include <string.h>
+
+/** Digit values of ASCII characters, -1 for anything but 0-9, a-f and A-F */
+static const signed char digitValues[128] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+/** Hexadecimal digits */
+static const char hexDigits[] = "0123456789abcdef";
+
+/** Binary digits of each nibble */
+static const char binaryDigits[16][4] = {
+    { '0', '0', '0', '0' }, { '0', '0', '0', '1' }, { '0', '0', '1', '0' }, { '0', '0', '1', '1' },
+    { '0', '1', '0', '0' }, { '0', '1', '0', '1' }, { '0', '1', '1', '0' }, { '0', '1', '1', '1' },
+    { '1', '0', '0', '0' }, { '1', '0', '0', '1' }, { '1', '0', '1', '0' }, { '1', '0', '1', '1' },
+    { '1', '1', '0', '0' }, { '1', '1', '0', '1' }, { '1', '1', '1', '0' }, { '1', '1', '1', '1' }
+};
+
+/** Decimal digits of 00 to 99 */
+static const char decimalPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/** Factorials that fit in 64 bits */
+static const qint64 factorials[INTEGER_FACTORIAL_MAX + 1] = {
+    1LL, 1LL, 2LL, 6LL, 24LL, 120LL, 720LL, 5040LL, 40320LL, 362880LL, 3628800LL,
+    39916800LL, 479001600LL, 6227020800LL, 87178291200LL, 1307674368000LL,
+    20922789888000LL, 355687428096000LL, 6402373705728000LL, 121645100408832000LL,
+    2432902008176640000LL
+};
+
+/**
+ *  @brief  Integer class method : Parse text in a base
+ *
+ *  @param  text    Text, digits with an optional leading '-'
+ *  @param  base    2, 10 or 16
+ *  @param  value   Set to the value, wrapped to 64 bits
+ *
+ *  @return true if the whole text is a number
+ */
+bool Integer::fromString(const QString &text, int base, qint64 *value)
+{
+    quint64 result = 0;
+    bool negative = false;
+    int i = 0, length = text.length();
+
+    /* Sign */
+    if ((length > 0) && (text.at(0).unicode() == '-')) {
+        negative = true;
+        i++;
+    }
+    if (i == length) {
+        return false;
+    }
+
+    /* Digits, wrapping like the register would */
+    for (; i < length; i++) {
+        ushort c = text.at(i).unicode();
+        int digit = (c < 128) ? digitValues[c] : -1;
+        if ((digit < 0) || (digit >= base)) {
+            return false;
+        }
+        result = result * base + digit;
+    }
+
+    *value = (qint64) (negative ? 0 - result : result);
+    return true;
+}
+
+/**
+ *  @brief  Integer class method : Format in a base
+ *
+ *  @param  value   Value
+ *  @param  base    2, 10 or 16
+ *
+ *  @return Decimal text with a sign, others as the two's complement bits
+ */
+QString Integer::toString(qint64 value, int base)
+{
+    char buffer[72];
+    char *end = buffer + sizeof(buffer);
+    char *p = end;
+    quint64 bits = (quint64) value;
+
+    if (base == 16) {
+        /* A nibble per digit */
+        do {
+            *--p = hexDigits[bits & 15];
+            bits >>= 4;
+        } while (bits != 0);
+    } else if (base == 2) {
+        /* Four digits per nibble, then drop the leading zeros */
+        do {
+            p -= 4;
+            memcpy(p, binaryDigits[bits & 15], 4);
+            bits >>= 4;
+        } while (bits != 0);
+        while ((p < end - 1) && (*p == '0')) {
+            p++;
+        }
+    } else {
+        /* Two digits per division */
+        bool negative = value < 0;
+        if (negative) {
+            bits = 0 - bits;
+        }
+        while (bits >= 100) {
+            int pair = (int) (bits % 100) * 2;
+            bits /= 100;
+            p -= 2;
+            p[0] = decimalPairs[pair];
+            p[1] = decimalPairs[pair + 1];
+        }
+        if (bits >= 10) {
+            p -= 2;
+            p[0] = decimalPairs[bits * 2];
+            p[1] = decimalPairs[bits * 2 + 1];
+        } else {
+            *--p = (char) ('0' + bits);
+        }
+        if (negative) {
+            *--p = '-';
+        }
+    }
+    return QString::fromLatin1(p, (int) (end - p));
+}
+
+/**
+ *  @brief  Integer class method : Convert a double, truncating and saturating
+ *
+ *  @param  value   Value
+ *
+ *  @return Integer part, 0 for NaN
+ */
+qint64 Integer::fromDouble(double value)
+{
+    /* 2^63 is exact in a double */
+    if (value != value) {
+        return 0;
+    }
+    if (value >= 9223372036854775808.0) {
+        return Q_INT64_C(9223372036854775807);
+    }
+    if (value <= -9223372036854775808.0) {
+        return -Q_INT64_C(9223372036854775807) - 1;
+    }
+    return (qint64) value;
+}
+
+/**
+ *  @brief  Integer class method : Make calculation
+ *
+ *  @param  op1     Operand 1
+ *  @param  op2     Operand 2
+ *  @param  op      Operator
+ *  @param  error   Set to true on error, left untouched otherwise
+ *
+ *  @return Calculated result, 0 on error
+ */
+qint64 Integer::calculate(qint64 op1, qint64 op2, int op, bool *error)
+{
+    qint64 root;
+
+    switch (op) {
+        case OPERATOR_PLUS:
+            /* Addition, wrapping */
+            return (qint64) ((quint64) op1 + (quint64) op2);
+        case OPERATOR_MINUS:
+            /* Substraction, wrapping */
+            return (qint64) ((quint64) op1 - (quint64) op2);
+        case OPERATOR_MUL:
+            /* Multiplication, wrapping */
+            return (qint64) ((quint64) op1 * (quint64) op2);
+        case OPERATOR_DIV:
+            /* Division, truncating */
+            if (op2 == 0) {
+                *error = true;
+                return 0;
+            }
+            if (op2 == -1) {
+                /* The most negative value wraps to itself */
+                return (qint64) (0 - (quint64) op1);
+            }
+            return op1 / op2;
+        case OPERATOR_SQRT:
+            /* Square root, rounded down */
+            if (op1 < 0) {
+                *error = true;
+                return 0;
+            }
+            root = (qint64) sqrt((double) op1);
+            while ((root > 0) && ((quint64) root * (quint64) root > (quint64) op1)) {
+                root--;
+            }
+            while ((quint64) (root + 1) * (quint64) (root + 1) <= (quint64) op1) {
+                root++;
+            }
+            return root;
+        case OPERATOR_FACT:
+            /* Factorial, from the table */
+            if ((op1 < 0) || (op1 > INTEGER_FACTORIAL_MAX)) {
+                *error = true;
+                return 0;
+            }
+            return factorials[op1];
+        default:
+            return 0;
+    }
+}
+
+/**
+ *  @brief  Integer class method : Get the most digits of a value in a base
+ *
+ *  @param  base    2, 10 or 16
+ *
+ *  @return Number of digits, without a sign
+ */
+int Integer::maxDigits(int base)
+{
+    /* 64 bits */
+    if (base == 2) {
+        return 64;
+    } else if (base == 16) {
+        return 16;
+    }
+    return 19;
+}
@@ -0,0 +1,57 @@
+/** @file integer.h
+ *
+ *  @brief This file contains the declarations of the 64-bit integer arithmetic
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTEGER_H
+#define INTEGER_H
+
+/* Includes */
+#include <QString>
+
+/* Defines */
+
+/** Largest integer whose factorial fits in 64 bits */
+#define INTEGER_FACTORIAL_MAX   20
+
+/**
+ *  64-bit integer arithmetic for the Bin and Hex modes.
+ *
+ *  Values wrap around in two's complement, as firmware registers do.
+ *  Decimal text is signed, binary and hexadecimal text show the raw
+ *  bits. Conversions go through digit tables, a whole number never
+ *  round trips through a double.
+ */
+class Integer
+{
+public:
+    /** Parse text in a base */
+    static bool fromString(const QString &text, int base, qint64 *value);
+    /** Format in a base */
+    static QString toString(qint64 value, int base);
+    /** Convert a double, truncating and saturating */
+    static qint64 fromDouble(double value);
+    /** Make calculation */
+    static qint64 calculate(qint64 op1, qint64 op2, int op, bool *error);
+    /** Get the most digits of a value in a base */
+    static int maxDigits(int base);
+};
+
+#endif // INTEGER_H
@@ -0,0 +1,350 @@
+/** @file lcd.cpp
+ *
+ *  @brief This file contains the definitions of the LCD display widget
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "lcd.h"
+#include <QtGui/QPainter>
+#include <QtGui/QPaintEvent>
+#include <QtGui/QResizeEvent>
+#include <QtGui/QWheelEvent>
+
+/* Defines */
+
+/** Space around the cells in pixels */
+#define LCD_MARGIN          4
+/** Preferred width of a cell in pixels */
+#define LCD_CELL_WIDTH      15
+/** Preferred height of a cell in pixels */
+#define LCD_CELL_HEIGHT     42
+/** Space around a glyph and between its segments in pixels */
+#define LCD_GAP             1
+/** Cell width per pixel of segment thickness */
+#define LCD_THICKNESS_RATIO 7
+/** Screen resolution per pixel of the thinnest segment */
+#define LCD_THICKNESS_DPI   48
+/** Number of segments of a glyph */
+#define LCD_SEGMENTS        7
+/** Color of the segments */
+#define LCD_COLOR           QColor(255, 255, 255)
+/** Color of the background */
+#define LCD_BACKGROUND      QColor(90, 90, 150)
+/** Color of the border */
+#define LCD_BORDER          QColor(0, 0, 0)
+
+/** Character and the segments that show it */
+struct Glyph
+{
+    /** Character, lower case */
+    char character;
+    /** Segments, bit 0 the top one and on clockwise, bit 6 the middle one */
+    uchar segments;
+};
+
+/** Glyphs of the digits, the hex digits and the letters of the messages */
+static const Glyph lcdGlyphs[LCD_GLYPHS] = {
+        { ' ', 0x00 }, { '0', 0x3f }, { '1', 0x06 }, { '2', 0x5b }, { '3', 0x4f },
+        { '4', 0x66 }, { '5', 0x6d }, { '6', 0x7d }, { '7', 0x07 }, { '8', 0x7f },
+        { '9', 0x6f }, { 'a', 0x77 }, { 'b', 0x7c }, { 'c', 0x39 }, { 'd', 0x5e },
+        { 'e', 0x79 }, { 'f', 0x71 }, { 'h', 0x74 }, { 'i', 0x10 }, { 'l', 0x38 },
+        { 'n', 0x54 }, { 'o', 0x5c }, { 'p', 0x73 }, { 'r', 0x50 }, { 's', 0x6d },
+        { 't', 0x78 }, { 'u', 0x1c }, { 'y', 0x6e }, { '-', 0x40 } };
+
+/**
+ *  @brief  Get the glyph of a character
+ *
+ *  @param  c   Character
+ *
+ *  @return Index of the glyph, the blank one if there is none
+ */
+static uchar glyphIndex(ushort c)
+{
+    /* Upper case shows as lower case */
+    if ((c >= 'A') && (c <= 'Z')) {
+        c += 'a' - 'A';
+    }
+    for (int i = 1; i < LCD_GLYPHS; i++) {
+        if (lcdGlyphs[i].character == c) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  @brief  LCD display object constructor
+ *
+ *  @param  num     Number of cells shown
+ *  @param  parent  Parent widget
+ *
+ *  @return N/A
+ */
+LCDDisplay::LCDDisplay(int num, QWidget *parent)
+    : QWidget(parent), numCells(num), shownCells(num, 0), offset(0),
+      cellWidth(0), cellHeight(0), glyphDpi(0)
+{
+    /* Every pixel is painted here, there is no background to erase first */
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Show a text
+ *
+ *  @param  text    Text, a '.' lights the point of the cell before it
+ *
+ *  @return N/A
+ */
+void LCDDisplay::setText(const QString &text)
+{
+    /* One cell per character, except the points */
+    cells.resize(0);
+    for (int i = 0; i < text.length(); i++) {
+        ushort c = text.at(i).unicode();
+        if (c != '.') {
+            cells.append(glyphIndex(c));
+        } else {
+            if (cells.isEmpty() || (cells.last() & LCD_POINT)) {
+                cells.append(0);
+            }
+            cells.last() |= LCD_POINT;
+        }
+    }
+
+    /* Show the end, where digits are entered */
+    offset = 0;
+    showCells();
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Scroll the text
+ *
+ *  @param  steps   Cells to scroll, positive towards the start of the text
+ *
+ *  @return N/A
+ */
+void LCDDisplay::scrollText(int steps)
+{
+    /* Move the window */
+    offset += steps;
+    showCells();
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Get the preferred size
+ *
+ *  @return Size of the cells and the margins
+ */
+QSize LCDDisplay::sizeHint(void) const
+{
+    /* Return the preferred cell size times the cells */
+    return QSize(numCells * LCD_CELL_WIDTH + 2 * LCD_MARGIN, LCD_CELL_HEIGHT + 2 * LCD_MARGIN);
+}
+
+/**
+ *  @brief  LCD display object method : Paint the cells asked for
+ *
+ *  @param  event   Paint event
+ *
+ *  @return N/A
+ */
+void LCDDisplay::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+
+    /* The widget moved to a screen of another resolution */
+    if (logicalDpiX() != glyphDpi) {
+        drawGlyphs();
+    }
+
+    /* Background and border, only when the area is more than cells */
+    QRect area(cellRect(0).topLeft(), cellRect(numCells - 1).bottomRight());
+    if (!area.contains(event->rect())) {
+        painter.fillRect(rect(), LCD_BACKGROUND);
+        painter.setPen(LCD_BORDER);
+        painter.drawRect(rect().adjusted(0, 0, -1, -1));
+    }
+
+    /* One pixmap copy per cell */
+    for (int i = 0; i < numCells; i++) {
+        QRect cell = cellRect(i);
+        if (cell.intersects(event->rect())) {
+            painter.drawPixmap(cell.topLeft(), glyphs[shownCells[i] & ~LCD_POINT][(shownCells[i] & LCD_POINT) != 0]);
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Lay out the cells again
+ *
+ *  @param  event   Resize event
+ *
+ *  @return N/A
+ */
+void LCDDisplay::resizeEvent(QResizeEvent *event)
+{
+    /* Cells fill the width, the glyphs follow their size */
+    cellWidth = (width() - 2 * LCD_MARGIN) / numCells;
+    cellHeight = height() - 2 * LCD_MARGIN;
+    drawGlyphs();
+    QWidget::resizeEvent(event);
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Scroll with the mouse wheel
+ *
+ *  @param  event   Wheel event
+ *
+ *  @return N/A
+ */
+void LCDDisplay::wheelEvent(QWheelEvent *event)
+{
+    /* One cell per notch */
+    scrollText(event->delta() / LCD_WHEEL_DELTA);
+    event->accept();
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Show the visible cells, repainting those that change
+ *
+ *  @return N/A
+ */
+void LCDDisplay::showCells(void)
+{
+    /* Keep the window within the text */
+    int hidden = cells.size() - numCells;
+    if (offset > hidden) {
+        offset = hidden;
+    }
+    if (offset < 0) {
+        offset = 0;
+    }
+
+    /* Right aligned, blank on the left of a short text */
+    for (int i = 0; i < numCells; i++) {
+        int index = cells.size() - offset - numCells + i;
+        uchar cell = (index >= 0) ? cells.at(index) : 0;
+        if (cell != shownCells.at(i)) {
+            shownCells[i] = cell;
+            update(cellRect(i));
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Get the area of a cell
+ *
+ *  @param  cell    Cell, from the left
+ *
+ *  @return Area, the cells are right aligned
+ */
+QRect LCDDisplay::cellRect(int cell) const
+{
+    /* Return the area counted from the right margin */
+    return QRect(width() - LCD_MARGIN - (numCells - cell) * cellWidth, LCD_MARGIN, cellWidth, cellHeight);
+}
+
+/**
+ *  @brief  LCD display object method : Draw the glyphs for the cell size
+ *
+ *  @return N/A
+ */
+void LCDDisplay::drawGlyphs(void)
+{
+    /* Nothing to draw before the first layout */
+    glyphDpi = logicalDpiX();
+    if ((cellWidth <= 0) || (cellHeight <= 0)) {
+        return;
+    }
+
+    /* Every glyph with and without the point */
+    for (int i = 0; i < LCD_GLYPHS; i++) {
+        drawGlyph(&glyphs[i][0], lcdGlyphs[i].segments, false);
+        drawGlyph(&glyphs[i][1], lcdGlyphs[i].segments, true);
+    }
+    return;
+}
+
+/**
+ *  @brief  LCD display object method : Draw a glyph
+ *
+ *  @param  pixmap      Set to the glyph
+ *  @param  segments    Segments lit
+ *  @param  point       true to light the point
+ *
+ *  @return N/A
+ */
+void LCDDisplay::drawGlyph(QPixmap *pixmap, int segments, bool point)
+{
+    /* Segments thicken with the cell and the resolution, the point takes their width */
+    int thickness = qMax(cellWidth / LCD_THICKNESS_RATIO, qMax(glyphDpi / LCD_THICKNESS_DPI, 1));
+    double half = thickness / 2.0;
+    double left = LCD_GAP + half;
+    double right = cellWidth - thickness - 2 * LCD_GAP - half;
+    double top = LCD_GAP + half;
+    double bottom = cellHeight - LCD_GAP - half;
+    double middle = (top + bottom) / 2;
+
+    /* Ends of the segments, in the order of their bits */
+    const double ends[LCD_SEGMENTS][4] = {
+            { left, top, right, top },          { right, top, right, middle },
+            { right, middle, right, bottom },   { left, bottom, right, bottom },
+            { left, middle, left, bottom },     { left, top, left, middle },
+            { left, middle, right, middle } };
+
+    *pixmap = QPixmap(cellWidth, cellHeight);
+    pixmap->fill(LCD_BACKGROUND);
+    QPainter painter(pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(LCD_COLOR);
+
+    /* Each segment a hexagon, pointed at its ends */
+    for (int s = 0; s < LCD_SEGMENTS; s++) {
+        if (!(segments & (1 << s))) {
+            continue;
+        }
+        double x1 = ends[s][0], y1 = ends[s][1], x2 = ends[s][2], y2 = ends[s][3];
+        double dx = (x1 == x2) ? 0 : 1;
+        double dy = (x1 == x2) ? 1 : 0;
+        QPointF hexagon[6] = {
+                QPointF(x1 + dx * LCD_GAP, y1 + dy * LCD_GAP),
+                QPointF(x1 + dx * (LCD_GAP + half) + dy * half, y1 + dy * (LCD_GAP + half) - dx * half),
+                QPointF(x2 - dx * (LCD_GAP + half) + dy * half, y2 - dy * (LCD_GAP + half) - dx * half),
+                QPointF(x2 - dx * LCD_GAP, y2 - dy * LCD_GAP),
+                QPointF(x2 - dx * (LCD_GAP + half) - dy * half, y2 - dy * (LCD_GAP + half) + dx * half),
+                QPointF(x1 + dx * (LCD_GAP + half) - dy * half, y1 + dy * (LCD_GAP + half) + dx * half) };
+        painter.drawPolygon(hexagon, 6);
+    }
+
+    /* The point, right of the digit on the base line */
+    if (point) {
+        painter.drawRect(QRectF(cellWidth - thickness - LCD_GAP, cellHeight - LCD_GAP - thickness,
+                                thickness, thickness));
+    }
+    return;
+}
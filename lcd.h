@@ -0,0 +1,104 @@
+/** @file lcd.h
+ *
+ *  @brief This file contains the declarations of the LCD display widget
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LCD_H
+#define LCD_H
+
+/* Includes */
+#include <QtGui/QWidget>
+#include <QtGui/QPixmap>
+#include <QtCore/QVector>
+#include <QString>
+
+/* Forward declarations */
+class QPaintEvent;
+class QResizeEvent;
+class QWheelEvent;
+
+/* Defines */
+
+/** Wheel rotation that scrolls the LCD by one digit */
+#define LCD_WHEEL_DELTA 120
+/** Cell flag : Decimal point after the character */
+#define LCD_POINT       0x80
+/** Number of characters with a glyph, a blank first */
+#define LCD_GLYPHS      29
+
+/**
+ *  Seven segment display of the calculator.
+ *
+ *  Every character takes one cell, and a '.' lights the small point of
+ *  the cell before it. The glyphs are drawn once into pixmaps for the
+ *  cell size and the screen resolution, and only the cells whose
+ *  glyph changes are repainted, so a keystroke costs a few small
+ *  pixmap copies. A text wider than the display shows its end and
+ *  scrolls with the mouse wheel.
+ */
+class LCDDisplay : public QWidget
+{
+public:
+    /** Constructor */
+    LCDDisplay(int numCells, QWidget *parent = 0);
+    /** Show a text */
+    void setText(const QString &text);
+    /** Scroll the text */
+    void scrollText(int steps);
+    /** Preferred size */
+    QSize sizeHint(void) const;
+
+protected:
+    /** Paint the cells asked for */
+    void paintEvent(QPaintEvent *event);
+    /** Lay out the cells again */
+    void resizeEvent(QResizeEvent *event);
+    /** Scroll with the mouse wheel */
+    void wheelEvent(QWheelEvent *event);
+
+private:
+    /** Number of cells shown */
+    int numCells;
+    /** Cells of the whole text, a glyph index and the point flag each */
+    QVector<uchar> cells;
+    /** Cells shown, from the left */
+    QVector<uchar> shownCells;
+    /** Number of cells scrolled off the right */
+    int offset;
+    /** Width of a cell in pixels */
+    int cellWidth;
+    /** Height of a cell in pixels */
+    int cellHeight;
+    /** Resolution the glyphs are drawn for */
+    int glyphDpi;
+    /** Glyphs, without and with the point */
+    QPixmap glyphs[LCD_GLYPHS][2];
+
+    /** Show the visible cells, repainting those that change */
+    void showCells(void);
+    /** Get the area of a cell */
+    QRect cellRect(int cell) const;
+    /** Draw the glyphs for the cell size */
+    void drawGlyphs(void);
+    /** Draw a glyph */
+    void drawGlyph(QPixmap *pixmap, int segments, bool point);
+};
+
+#endif // LCD_H
@@ -21,22 +21,140 @@
  */
 
 #include <QtGui/QApplication>
+#include <QtCore/QTime>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "calculator.h"
+#include "batch.h"
+#include "history.h"
+#include "server.h"
+#include "accumulator.h"
 
 int main(int argc, char *argv[])
 {
+    /* Batch mode needs no widgets at all */
+    if ((argc > 1) && (strcmp(argv[1], "--batch") == 0)) {
+        BatchRunner runner;
+        HistoryLog history;
+        int skip = 2;
+#if STATS
+        EngineStats stats;
+        bool counters = false;
+#endif
+        for (; skip < argc; skip++) {
+            if (strcmp(argv[skip], "--expr") == 0) {
+                /* Scripts hold expressions instead of keystrokes */
+                runner.setExpressionMode(true);
+            } else if ((strcmp(argv[skip], "--precision") == 0) && (skip + 1 < argc)) {
+                /* Calculate in arbitrary precision with that many digits */
+                runner.getEngine()->setArithMode(ARITH_BIG);
+                runner.getEngine()->setPrecision(atoi(argv[++skip]));
+            } else if (strcmp(argv[skip], "--paste") == 0) {
+                /* Numbers are entered whole, as pasted */
+                runner.setPasteMode(true);
+            } else if (strcmp(argv[skip], "--undo") == 0) {
+                /* Record the tokens for 'undo' and 'redo' */
+                runner.setUndoMode(true);
+            } else if ((strcmp(argv[skip], "--history") == 0) && (skip + 1 < argc)) {
+                /* Log the calculations to a history file */
+                if (!history.open(QString::fromLocal8Bit(argv[++skip]))) {
+                    fprintf(stderr, "qcalc: cannot open history '%s'\n", argv[skip]);
+                    return 1;
+                }
+                runner.getEngine()->setHistory(&history);
+            } else if (strcmp(argv[skip], "--decimal") == 0) {
+                /* Calculate in decimal */
+                runner.getEngine()->setArithMode(ARITH_DECIMAL);
+#if STATS
+            } else if (strcmp(argv[skip], "--counters") == 0) {
+                /* Collect statistics, dumped at exit */
+                counters = true;
+                runner.getEngine()->setStats(&stats);
+#endif
+            } else {
+                break;
+            }
+        }
+        int status = runner.runFiles(argc - skip, argv + skip);
+#if STATS
+        if (counters) {
+            runner.getEngine()->dumpStats(stderr);
+        }
+#endif
+        return status;
+    }
+
+    /* Nor do the statistics of number streams, stdin without files */
+    if ((argc > 1) && (strcmp(argv[1], "--summary") == 0)) {
+        Accumulator summary;
+        int first = 2;
+        if ((argc > 2) && (strcmp(argv[2], "--pairs") == 0)) {
+            /* Lines of two numbers are x and y for the regression */
+            summary.setPairMode(true);
+            first = 3;
+        }
+        quint64 skipped = (argc == first) ? summary.addStream(stdin) : 0;
+        for (int i = first; i < argc; i++) {
+            FILE *file = (strcmp(argv[i], "-") == 0) ? stdin : fopen(argv[i], "r");
+            if (file == 0) {
+                fprintf(stderr, "qcalc: cannot open '%s'\n", argv[i]);
+                return 1;
+            }
+            skipped += summary.addStream(file);
+            if (file != stdin) {
+                fclose(file);
+            }
+        }
+        printf("{\"count\": %llu, \"sum\": %.17g, \"mean\": %.17g, \"variance\": %.17g, "
+               "\"deviation\": %.17g, \"min\": %.17g, \"max\": %.17g, \"pairs\": %llu, "
+               "\"slope\": %.17g, \"intercept\": %.17g, \"correlation\": %.17g, \"skipped\": %llu}\n",
+               (unsigned long long) summary.getCount(), summary.getSum(), summary.getMean(),
+               summary.getVariance(), summary.getDeviation(), summary.getMin(), summary.getMax(),
+               (unsigned long long) summary.getPairCount(), summary.getSlope(), summary.getIntercept(),
+               summary.getCorrelation(), (unsigned long long) skipped);
+        return 0;
+    }
+
+    /* The evaluation service needs no widgets either */
+    if ((argc > 2) && (strcmp(argv[1], "--serve") == 0)) {
+        EvalServer server;
+        int threads = 1;
+        if ((argc > 4) && (strcmp(argv[3], "--threads") == 0)) {
+            threads = atoi(argv[4]);
+        }
+        if (!server.listen(QString::fromLocal8Bit(argv[2]))) {
+            return 1;
+        }
+        return server.run(threads);
+    }
+
+    /* Time the startup from here, loading the libraries comes before */
+    bool timeStartup = (argc > 1) && (strcmp(argv[1], "--startup-time") == 0);
+    QTime startup;
+    startup.start();
+
     /* Give control to Qt */
     QApplication a(argc, argv);
+    int appTime = startup.elapsed();
 
     /* Create our widget, the calculator */
     Calculator w;
-
-    /* Color it */
-    w.setStyleSheet("background-color: white");
+    int widgetTime = startup.elapsed();
 
     /* Show it */
     w.show();
 
+    if (timeStartup) {
+        /* Run until it is first painted, report the milliseconds spent and quit.
+         * Queued, the widgets in it are painted in the same pass */
+        QObject::connect(&w, SIGNAL(painted()), &a, SLOT(quit()), Qt::QueuedConnection);
+        a.exec();
+        printf("{\"application\": %d, \"widget\": %d, \"shown\": %d}\n",
+               appTime, widgetTime, startup.elapsed());
+        return 0;
+    }
+
     /* Execute it */
     return a.exec();
 }
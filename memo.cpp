@@ -0,0 +1,261 @@
+/** @file memo.cpp
+ *
+ *  @brief This file contains the definitions of the result memo table
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "memo.h"
+#include <string.h>
+
+/**
+ *  @brief  Slot of a key in a table
+ *
+ *  @param  hash    Hash of the operand
+ *  @param  op      Operation
+ *  @param  entries Table size, a power of two
+ *
+ *  @return Slot index
+ */
+static int slot(quint64 hash, int op, int entries)
+{
+    /* Mix, the upper bits are the best */
+    hash = (hash ^ ((quint64) op * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+    return (int) (hash >> 40) & (entries - 1);
+}
+
+/**
+ *  @brief  Memo table object constructor
+ *
+ *  @return N/A
+ */
+MemoCache::MemoCache()
+{
+    /* Start empty */
+    clear();
+    return;
+}
+
+/**
+ *  @brief  Memo table object method : Drop all entries
+ *
+ *  @return N/A
+ */
+void MemoCache::clear(void)
+{
+    /* Mark every entry empty */
+    for (int i = 0; i < MEMO_DOUBLE_ENTRIES; i++) {
+        doubleEntries[i].op = -1;
+    }
+    for (int i = 0; i < MEMO_DECIMAL_ENTRIES; i++) {
+        decimalEntries[i].op = -1;
+    }
+    for (int i = 0; i < MEMO_BIG_ENTRIES; i++) {
+        bigEntries[i].op = -1;
+        bigEntries[i].operand = BigFloat();
+        bigEntries[i].result = BigFloat();
+    }
+    resetCounters();
+    return;
+}
+
+/**
+ *  @brief  Memo table object method : Look up a double result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  result  Set to the result if found
+ *  @param  error   Set to true if found with an error
+ *
+ *  @return true if found
+ */
+bool MemoCache::lookup(int op, double operand, double *result, bool *error)
+{
+    quint64 bits;
+
+    /* Key on the exact bits, so 0 and -0 differ */
+    memcpy(&bits, &operand, sizeof(bits));
+    DoubleEntry &entry = doubleEntries[slot(bits, op, MEMO_DOUBLE_ENTRIES)];
+    if ((entry.op != op) || (entry.bits != bits)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    *result = entry.result;
+    if (entry.error) {
+        *error = true;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Memo table object method : Save a double result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  result  Result
+ *  @param  error   Error status
+ *
+ *  @return N/A
+ */
+void MemoCache::insert(int op, double operand, double result, bool error)
+{
+    quint64 bits;
+
+    /* Replace whatever is in the slot */
+    memcpy(&bits, &operand, sizeof(bits));
+    DoubleEntry &entry = doubleEntries[slot(bits, op, MEMO_DOUBLE_ENTRIES)];
+    entry.bits = bits;
+    entry.result = result;
+    entry.op = op;
+    entry.error = error;
+    return;
+}
+
+/**
+ *  @brief  Memo table object method : Look up a decimal result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  result  Set to the result if found
+ *  @param  error   Set to true if found with an error
+ *
+ *  @return true if found
+ */
+bool MemoCache::lookup(int op, const Decimal &operand, Decimal *result, bool *error)
+{
+    /* Check the slot */
+    DecimalEntry &entry = decimalEntries[slot(operand.hash(), op, MEMO_DECIMAL_ENTRIES)];
+    if ((entry.op != op) || !entry.operand.isSame(operand)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    *result = entry.result;
+    if (entry.error) {
+        *error = true;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Memo table object method : Save a decimal result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  result  Result
+ *  @param  error   Error status
+ *
+ *  @return N/A
+ */
+void MemoCache::insert(int op, const Decimal &operand, const Decimal &result, bool error)
+{
+    /* Replace whatever is in the slot */
+    DecimalEntry &entry = decimalEntries[slot(operand.hash(), op, MEMO_DECIMAL_ENTRIES)];
+    entry.operand = operand;
+    entry.result = result;
+    entry.op = op;
+    entry.error = error;
+    return;
+}
+
+/**
+ *  @brief  Memo table object method : Look up an arbitrary precision result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  digits  Precision in digits
+ *  @param  result  Set to the result if found
+ *  @param  error   Set to true if found with an error
+ *
+ *  @return true if found
+ */
+bool MemoCache::lookup(int op, const BigFloat &operand, int digits, BigFloat *result, bool *error)
+{
+    /* Check the slot, the precision is part of the key */
+    BigEntry &entry = bigEntries[slot(operand.hash() ^ (quint64) digits, op, MEMO_BIG_ENTRIES)];
+    if ((entry.op != op) || (entry.digits != digits) || !entry.operand.isSame(operand)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    *result = entry.result;
+    if (entry.error) {
+        *error = true;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Memo table object method : Save an arbitrary precision result
+ *
+ *  @param  op      Operation
+ *  @param  operand Operand
+ *  @param  digits  Precision in digits
+ *  @param  result  Result
+ *  @param  error   Error status
+ *
+ *  @return N/A
+ */
+void MemoCache::insert(int op, const BigFloat &operand, int digits, const BigFloat &result, bool error)
+{
+    /* Replace whatever is in the slot */
+    BigEntry &entry = bigEntries[slot(operand.hash() ^ (quint64) digits, op, MEMO_BIG_ENTRIES)];
+    entry.operand = operand;
+    entry.result = result;
+    entry.op = op;
+    entry.digits = digits;
+    entry.error = error;
+    return;
+}
+
+/**
+ *  @brief  Memo table object method : Get the number of lookups found
+ *
+ *  @return Number of hits
+ */
+quint64 MemoCache::getHits(void) const
+{
+    /* Return hits */
+    return hits;
+}
+
+/**
+ *  @brief  Memo table object method : Get the number of lookups not found
+ *
+ *  @return Number of misses
+ */
+quint64 MemoCache::getMisses(void) const
+{
+    /* Return misses */
+    return misses;
+}
+
+/**
+ *  @brief  Memo table object method : Reset the counters
+ *
+ *  @return N/A
+ */
+void MemoCache::resetCounters(void)
+{
+    /* Reset hits and misses */
+    hits = 0;
+    misses = 0;
+    return;
+}
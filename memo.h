@@ -0,0 +1,126 @@
+/** @file memo.h
+ *
+ *  @brief This file contains the declarations of the result memo table
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMO_H
+#define MEMO_H
+
+/* Includes */
+#include "bignum.h"
+#include "decimal.h"
+
+/* Defines */
+
+/** Memo table entries for doubles, a power of two */
+#define MEMO_DOUBLE_ENTRIES     512
+/** Memo table entries for decimal numbers, a power of two */
+#define MEMO_DECIMAL_ENTRIES    128
+/** Memo table entries for arbitrary precision numbers, a power of two */
+#define MEMO_BIG_ENTRIES        32
+
+/**
+ *  Memo table of unary operation results.
+ *
+ *  Results are keyed by the operation and the exact representation of
+ *  the operand, and for arbitrary precision also by the precision. Each
+ *  arithmetic has its own direct mapped table of fixed size, so a new
+ *  result simply replaces whatever shared its slot. Errors are kept as
+ *  results too.
+ */
+class MemoCache
+{
+public:
+    /** Constructor */
+    MemoCache();
+    /** Drop all entries */
+    void clear(void);
+    /** Look up a double result */
+    bool lookup(int op, double operand, double *result, bool *error);
+    /** Save a double result */
+    void insert(int op, double operand, double result, bool error);
+    /** Look up a decimal result */
+    bool lookup(int op, const Decimal &operand, Decimal *result, bool *error);
+    /** Save a decimal result */
+    void insert(int op, const Decimal &operand, const Decimal &result, bool error);
+    /** Look up an arbitrary precision result */
+    bool lookup(int op, const BigFloat &operand, int digits, BigFloat *result, bool *error);
+    /** Save an arbitrary precision result */
+    void insert(int op, const BigFloat &operand, int digits, const BigFloat &result, bool error);
+    /** Get the number of lookups found */
+    quint64 getHits(void) const;
+    /** Get the number of lookups not found */
+    quint64 getMisses(void) const;
+    /** Reset the counters */
+    void resetCounters(void);
+
+private:
+    /** Double entry */
+    struct DoubleEntry
+    {
+        /** Operand bits */
+        quint64 bits;
+        /** Result */
+        double result;
+        /** Operation, -1 if empty */
+        int op;
+        /** Error status */
+        bool error;
+    };
+    /** Decimal entry */
+    struct DecimalEntry
+    {
+        /** Operand */
+        Decimal operand;
+        /** Result */
+        Decimal result;
+        /** Operation, -1 if empty */
+        int op;
+        /** Error status */
+        bool error;
+    };
+    /** Arbitrary precision entry */
+    struct BigEntry
+    {
+        /** Operand */
+        BigFloat operand;
+        /** Result */
+        BigFloat result;
+        /** Operation, -1 if empty */
+        int op;
+        /** Precision in digits */
+        int digits;
+        /** Error status */
+        bool error;
+    };
+
+    /** Double table */
+    DoubleEntry doubleEntries[MEMO_DOUBLE_ENTRIES];
+    /** Decimal table */
+    DecimalEntry decimalEntries[MEMO_DECIMAL_ENTRIES];
+    /** Arbitrary precision table */
+    BigEntry bigEntries[MEMO_BIG_ENTRIES];
+    /** Lookups found */
+    quint64 hits;
+    /** Lookups not found */
+    quint64 misses;
+};
+
+#endif // MEMO_H
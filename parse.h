@@ -0,0 +1,52 @@
+/** @file parse.h
+ *
+ *  @brief This file contains the declarations of the number parsing
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARSE_H
+#define PARSE_H
+
+/* Includes */
+#include <QString>
+
+/**
+ *  Text to double conversion, for the calculator's number grammar.
+ *
+ *  A number is an optional sign, digits with at most one '.', and an
+ *  optional exponent. The point is always '.', whatever the locale.
+ *  The conversion works on the text in place, without allocating, and
+ *  rounds correctly: small numbers are exact products of two doubles,
+ *  the rest goes through the Eisel-Lemire algorithm, and the rare
+ *  numbers it cannot decide are left to QString::toDouble().
+ */
+class Parse
+{
+public:
+    /** Scan a number at the start of a text */
+    static int scan(const char *text, int length, double *value);
+    /** Scan a number at the start of a text */
+    static int scan(const QChar *text, int length, double *value);
+    /** Parse a whole text */
+    static double toDouble(const char *text, int length, bool *ok = 0);
+    /** Parse a whole text */
+    static double toDouble(const QString &text, bool *ok = 0);
+};
+
+#endif // PARSE_H
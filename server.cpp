@@ -0,0 +1,417 @@
+/** @file server.cpp
+ *
+ *  @brief This file contains the definitions of the evaluation service
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "server.h"
+#include "engine.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** One client connection, owned by the thread that accepted it */
+struct ServerConnection
+{
+    /** Socket */
+    int fd;
+    /** Engine of the connection */
+    Engine engine;
+    /** Bytes read, not a complete line yet */
+    QByteArray input;
+    /** Replies not written yet */
+    QByteArray output;
+    /** Waiting for the socket to take more output */
+    bool isWriting;
+};
+
+/** Request word to operator map entry */
+struct ServerOperator {
+    /** Request word */
+    const char *name;
+    /** Operator */
+    int op;
+    /** Number of operands */
+    int operands;
+};
+
+/** Request words of the operators */
+static const ServerOperator serverOperators[] = {
+    { "+", OPERATOR_PLUS, 2 }, { "-", OPERATOR_MINUS, 2 },
+    { "*", OPERATOR_MUL, 2 },  { "/", OPERATOR_DIV, 2 },
+    { "sqrt", OPERATOR_SQRT, 1 }, { "!", OPERATOR_FACT, 1 } };
+
+/** Number of request operators */
+#define NUM_SERVER_OPERATORS    ((int) (sizeof(serverOperators) / sizeof(serverOperators[0])))
+
+/** Request words of the arithmetic modes, by ARITH_* */
+static const char * const serverModes[] = { "double", "big", "decimal", "integer" };
+
+/**
+ *  @brief  Compare a request word
+ *
+ *  @param  word    Word, not terminated
+ *  @param  length  Word length
+ *  @param  name    Name to compare with
+ *
+ *  @return true if they are the same
+ */
+static bool isWord(const char *word, int length, const char *name)
+{
+    return ((int) strlen(name) == length) && (memcmp(word, name, length) == 0);
+}
+
+/**
+ *  @brief  Answer one request line
+ *
+ *  @param  engine  Engine of the connection
+ *  @param  line    Request, not terminated
+ *  @param  length  Request length, without the newline
+ *  @param  out     Reply is appended to it
+ *
+ *  @return N/A
+ */
+static void answer(Engine *engine, const char *line, int length, QByteArray *out)
+{
+    const char *words[3];
+    int lengths[3], count = 0;
+
+    /* Split into at most three words */
+    for (int i = 0; i < length; ) {
+        while ((i < length) && ((line[i] == ' ') || (line[i] == '\t') || (line[i] == '\r'))) {
+            i++;
+        }
+        if (i == length) {
+            break;
+        }
+        if (count == 3) {
+            out->append("error\n");
+            return;
+        }
+        words[count] = line + i;
+        while ((i < length) && (line[i] != ' ') && (line[i] != '\t') && (line[i] != '\r')) {
+            i++;
+        }
+        lengths[count] = line + i - words[count];
+        count++;
+    }
+    if (count == 0) {
+        out->append("error\n");
+        return;
+    }
+
+    /* Settings */
+    if ((count == 2) && isWord(words[0], lengths[0], "mode")) {
+        for (int mode = ARITH_DOUBLE; mode <= ARITH_INTEGER; mode++) {
+            if (isWord(words[1], lengths[1], serverModes[mode])) {
+                engine->setArithMode(mode);
+                out->append("ok\n");
+                return;
+            }
+        }
+        out->append("error\n");
+        return;
+    }
+    if ((count == 2) && isWord(words[0], lengths[0], "precision")) {
+        engine->setPrecision(atoi(QByteArray(words[1], lengths[1]).constData()));
+        out->append("ok\n");
+        return;
+    }
+
+    /* Calculations, unary ones take the operand twice as the engine does */
+    for (int i = 0; i < NUM_SERVER_OPERATORS; i++) {
+        if ((count == serverOperators[i].operands + 1) &&
+            isWord(words[0], lengths[0], serverOperators[i].name)) {
+            bool error = false;
+            QString operand1 = QString::fromLatin1(words[1], lengths[1]);
+            QString operand2 = (count == 3) ? QString::fromLatin1(words[2], lengths[2]) : operand1;
+            QString result = engine->calculate(operand1, operand2, serverOperators[i].op, &error);
+            out->append(error ? QByteArray("error") : result.toLatin1());
+            out->append('\n');
+            return;
+        }
+    }
+    out->append("error\n");
+    return;
+}
+
+/**
+ *  @brief  Evaluation server object constructor
+ *
+ *  @return N/A
+ */
+EvalServer::EvalServer()
+    : listenFd(-1)
+{
+    return;
+}
+
+/**
+ *  @brief  Evaluation server object destructor
+ *
+ *  @return N/A
+ */
+EvalServer::~EvalServer()
+{
+    /* Stop listening */
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+    return;
+}
+
+/**
+ *  @brief  Evaluation server object method : Listen on a socket path
+ *
+ *  A socket left over at the path is replaced.
+ *
+ *  @param  path    Socket path
+ *
+ *  @return true on success
+ */
+bool EvalServer::listen(const QString &path)
+{
+    struct sockaddr_un address;
+    QByteArray name = path.toLocal8Bit();
+
+    if (name.size() >= (int) sizeof(address.sun_path)) {
+        fprintf(stderr, "qcalc: socket path too long\n");
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, name.constData(), name.size());
+
+    /* Non-blocking, the threads all wait on it */
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(name.constData());
+    if ((listenFd < 0) || (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) != 0) ||
+        (::listen(listenFd, SOMAXCONN) != 0)) {
+        perror("qcalc: listen");
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Evaluation server object method : Serve requests
+ *
+ *  @param  threads     Number of threads, each with its own epoll loop
+ *
+ *  @return 1 on error
+ */
+int EvalServer::run(int threads)
+{
+    QList<EvalServerThread *> workers;
+
+    /* The calling thread is one of them */
+    if (threads > SERVER_MAX_THREADS) {
+        threads = SERVER_MAX_THREADS;
+    }
+    for (int i = 1; i < threads; i++) {
+        EvalServerThread *worker = new EvalServerThread(this);
+        worker->start();
+        workers.append(worker);
+    }
+    serve();
+
+    /* Only on error */
+    for (int i = 0; i < workers.size(); i++) {
+        workers[i]->wait();
+        delete workers[i];
+    }
+    return 1;
+}
+
+/**
+ *  @brief  Flush the replies of a connection
+ *
+ *  A lost client raises no SIGPIPE, it is closed.
+ *
+ *  @param  connection  Connection
+ *
+ *  @return false if the connection is lost
+ */
+static bool flush(ServerConnection *connection)
+{
+    int done = 0;
+
+    /* Write what the socket takes */
+    while (done < connection->output.size()) {
+        ssize_t written = send(connection->fd, connection->output.constData() + done,
+                               connection->output.size() - done, MSG_NOSIGNAL);
+        if (written > 0) {
+            done += written;
+        } else if ((written < 0) && (errno == EINTR)) {
+            continue;
+        } else if ((written < 0) && (errno == EAGAIN)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    connection->output.remove(0, done);
+    return true;
+}
+
+/**
+ *  @brief  Read the requests of a connection and answer them
+ *
+ *  @param  connection  Connection
+ *
+ *  @return false if the connection is closed or lost
+ */
+static bool receive(ServerConnection *connection)
+{
+    char buffer[SERVER_READ_SIZE];
+
+    /* Read until the socket is empty or the replies pile up */
+    while (connection->output.size() < SERVER_OUTPUT_LIMIT) {
+        ssize_t got = read(connection->fd, buffer, sizeof(buffer));
+        if (got == 0) {
+            /* The last request may end without a newline */
+            if (!connection->input.isEmpty()) {
+                answer(&connection->engine, connection->input.constData(), connection->input.size(),
+                       &connection->output);
+                connection->input.clear();
+            }
+            return false;
+        } else if ((got < 0) && (errno == EINTR)) {
+            continue;
+        } else if ((got < 0) && (errno == EAGAIN)) {
+            break;
+        } else if (got < 0) {
+            return false;
+        }
+
+        /* Answer the complete lines, straight from the buffer if nothing is left over */
+        const char *data = buffer;
+        int size = got;
+        if (!connection->input.isEmpty()) {
+            connection->input.append(buffer, got);
+            data = connection->input.constData();
+            size = connection->input.size();
+        }
+        int start = 0;
+        for (const char *end; (end = (const char *) memchr(data + start, '\n', size - start)) != 0; ) {
+            if (end - data - start > SERVER_MAX_LINE) {
+                return false;
+            }
+            answer(&connection->engine, data + start, end - data - start, &connection->output);
+            start = end - data + 1;
+        }
+
+        /* Keep the rest for the next read */
+        if (size - start > SERVER_MAX_LINE) {
+            return false;
+        }
+        if (data == buffer) {
+            connection->input = QByteArray(buffer + start, size - start);
+        } else {
+            connection->input.remove(0, start);
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief  Evaluation server object method : Serve requests in the calling thread
+ *
+ *  @return N/A
+ */
+void EvalServer::serve(void)
+{
+    struct epoll_event event, events[SERVER_MAX_EVENTS];
+
+    /* Wait for connections, only one thread is woken for each */
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.ptr = 0;
+    if ((epollFd < 0) || (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0)) {
+        perror("qcalc: epoll");
+        return;
+    }
+
+    for (;;) {
+        int count = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+        if ((count < 0) && (errno != EINTR)) {
+            perror("qcalc: epoll");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            ServerConnection *connection = (ServerConnection *) events[i].data.ptr;
+
+            if (connection == 0) {
+                /* Accept the new connections */
+                int fd;
+                while ((fd = accept4(listenFd, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    connection = new ServerConnection;
+                    connection->fd = fd;
+                    connection->isWriting = false;
+                    event.events = EPOLLIN | EPOLLRDHUP;
+                    event.data.ptr = connection;
+                    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                        close(fd);
+                        delete connection;
+                    }
+                }
+                continue;
+            }
+
+            /* Answer, then write as much as the socket takes */
+            bool isAlive = ((events[i].events & (EPOLLERR | EPOLLHUP)) == 0);
+            if (isAlive && ((events[i].events & (EPOLLIN | EPOLLRDHUP)) != 0) &&
+                (connection->output.size() < SERVER_OUTPUT_LIMIT)) {
+                isAlive = receive(connection);
+            }
+            if (isAlive || !connection->output.isEmpty()) {
+                isAlive = flush(connection) && (isAlive || !connection->output.isEmpty());
+            }
+            if (!isAlive) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, 0);
+                close(connection->fd);
+                delete connection;
+                continue;
+            }
+
+            /* Wait for the socket to take the rest, reading waits with it */
+            bool isWriting = !connection->output.isEmpty();
+            if (isWriting != connection->isWriting) {
+                event.events = isWriting ? (EPOLLOUT | EPOLLRDHUP) : (EPOLLIN | EPOLLRDHUP);
+                event.data.ptr = connection;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+                connection->isWriting = isWriting;
+            }
+        }
+    }
+    close(epollFd);
+    return;
+}
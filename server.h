@@ -0,0 +1,101 @@
+/** @file server.h
+ *
+ *  @brief This file contains the declarations of the evaluation service
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+/* Includes */
+#include <QString>
+#include <QtCore/QThread>
+
+/* Defines */
+
+/** Bytes read from a connection at a time */
+#define SERVER_READ_SIZE        65536
+/** Events taken from epoll at a time */
+#define SERVER_MAX_EVENTS       64
+/** Longest request line, longer ones close the connection */
+#define SERVER_MAX_LINE         4096
+/** Replies held for a connection before its requests wait */
+#define SERVER_OUTPUT_LIMIT     (1 << 20)
+/** Largest number of threads */
+#define SERVER_MAX_THREADS      64
+
+/**
+ *  Evaluation service on a Unix domain socket.
+ *
+ *  Each request is one line and gets one reply line, in order, so
+ *  clients may send many requests without waiting. The last request
+ *  may end with the connection instead of a newline, and is answered
+ *  before the connection is closed. A request is
+ *
+ *      <op> <operand1> <operand2>      op is + - * /
+ *      sqrt <operand>
+ *      ! <operand>
+ *      mode double|big|decimal|integer
+ *      precision <digits>
+ *
+ *  The reply is the result as the calculator shows it, "ok" for mode
+ *  and precision, or "error". Every connection has its own engine,
+ *  starting in double precision, and calculates as Engine::calculate
+ *  does.
+ *
+ *  Sockets are non-blocking and served from epoll. All complete lines
+ *  read at once are answered with a single write. Every thread runs
+ *  its own epoll loop, and accepts its own connections.
+ */
+class EvalServer
+{
+public:
+    /** Constructor */
+    EvalServer();
+    /** Destructor */
+    ~EvalServer();
+    /** Listen on a socket path */
+    bool listen(const QString &path);
+    /** Serve requests, does not return unless on error */
+    int run(int threads);
+    /** Serve requests in the calling thread */
+    void serve(void);
+
+private:
+    /** Listening socket, -1 if none */
+    int listenFd;
+};
+
+/** Thread running an evaluation server loop */
+class EvalServerThread : public QThread
+{
+public:
+    /** Constructor */
+    EvalServerThread(EvalServer *newServer) : server(newServer) {}
+
+protected:
+    /** Serve requests */
+    void run() { server->serve(); }
+
+private:
+    /** Server */
+    EvalServer *server;
+};
+
+#endif // SERVER_H
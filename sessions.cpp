@@ -0,0 +1,828 @@
+/** @file sessions.cpp
+ *
+ *  @brief This file contains the definitions of the multi-session store
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "sessions.h"
+#include "engine.h"
+#include "format.h"
+#include "parse.h"
+#include "vectorcalc.h"
+#include <QtCore/QByteArray>
+#include <string.h>
+#include <math.h>
+
+/** Text shown on an error */
+static const char errorText[] = "-- error --";
+
+/**
+ *  @brief  Session store object constructor
+ *
+ *  @return N/A
+ */
+SessionStore::SessionStore()
+    : count(0)
+{
+    /* Start empty */
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Set the number of sessions
+ *
+ *  @param  newCount    Number of sessions
+ *
+ *  @return N/A
+ */
+void SessionStore::setCount(int newCount)
+{
+    int oldCount = count;
+
+    /* Resize every column */
+    lcd.resize(newCount);
+    operand.resize(newCount);
+    memory.resize(newCount);
+    text.resize(newCount * SESSION_TEXT_SIZE);
+    display.resize(newCount * SESSION_TEXT_SIZE);
+    textLength.resize(newCount);
+    displayLength.resize(newCount);
+    flags.resize(newCount);
+    lastOperator.resize(newCount);
+    lastClicked.resize(newCount);
+    count = newCount;
+
+    /* New sessions start in init status */
+    if (newCount > oldCount) {
+        reset(oldCount, newCount - oldCount);
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Get the number of sessions
+ *
+ *  @return Number of sessions
+ */
+int SessionStore::getCount(void) const
+{
+    /* Return count */
+    return count;
+}
+
+/**
+ *  @brief  Session store object method : Reset a range of sessions to init status
+ *
+ *  @param  first   First session
+ *  @param  number  Number of sessions
+ *
+ *  @return N/A
+ */
+void SessionStore::reset(int first, int number)
+{
+    /* Clear, then forget the memory too */
+    press(BUTTON_CLR, first, number);
+    press(BUTTON_MC, first, number);
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a button in all sessions
+ *
+ *  @param  button  Button index
+ *
+ *  @return N/A
+ */
+void SessionStore::press(int button)
+{
+    /* Whole range */
+    press(button, 0, count);
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a button in a range of sessions
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  number  Number of sessions
+ *
+ *  @return N/A
+ */
+void SessionStore::press(int button, int first, int number)
+{
+    int last = first + number;
+
+    /* Keep to the sessions there are */
+    if (first < 0) {
+        first = 0;
+    }
+    if (last > count) {
+        last = count;
+    }
+    if (first >= last) {
+        return;
+    }
+
+    /* Dispatch once for the whole range */
+    switch (button) {
+        case BUTTON_1:  /* Button 1: Fall through */
+        case BUTTON_2:  /* Button 2: Fall through */
+        case BUTTON_3:  /* Button 3: Fall through */
+        case BUTTON_4:  /* Button 4: Fall through */
+        case BUTTON_5:  /* Button 5: Fall through */
+        case BUTTON_6:  /* Button 6: Fall through */
+        case BUTTON_7:  /* Button 7: Fall through */
+        case BUTTON_8:  /* Button 8: Fall through */
+        case BUTTON_9:  /* Button 9: Fall through */
+        case BUTTON_0:  /* Button 0 */
+            pressDigit(button, first, last);
+            break;
+        case BUTTON_SQ:     /* Button square : Fall through */
+        case BUTTON_SQRT:   /* Button square root : Fall through */
+        case BUTTON_FACT:   /* Button factorial : Fall through */
+        case BUTTON_INV:    /* Button inverse : Fall through */
+        case BUTTON_CUBE:   /* Button cube */
+            pressUnary(button, first, last);
+            break;
+        case BUTTON_PLUS:   /* Button plus : Fall through */
+        case BUTTON_NEG:    /* Button minus : Fall through */
+        case BUTTON_MUL:    /* Button multiply : Fall through */
+        case BUTTON_DIV:    /* Button divide */
+            pressOperator(button, first, last);
+            break;
+        case BUTTON_EQ:     /* Button equal to */
+            pressEqual(first, last);
+            break;
+        case BUTTON_SIGN:   /* Button sign : Fall through */
+        case BUTTON_DOT:    /* Button dot : Fall through */
+        case BUTTON_BS:     /* Button backspace */
+            pressEdit(button, first, last);
+            break;
+        case BUTTON_MC:     /* Button memory clear : Fall through */
+        case BUTTON_MR:     /* Button memory recall : Fall through */
+        case BUTTON_MS:     /* Button memory set : Fall through */
+        case BUTTON_MP:     /* Button memory plus */
+            pressMemory(button, first, last);
+            break;
+        case BUTTON_CLR:    /* Button clear */
+            /* Reset everything except memory, the same for every session */
+            for (int i = first; i < last; i++) {
+                lcd[i] = 0;
+                operand[i] = 0;
+                lastOperator[i] = OPERATOR_NONE;
+                lastClicked[i] = TYPE_INIT;
+                flags[i] = SESSION_TEXT_VALID | SESSION_VALUE_VALID;
+                textLength[i] = 1;
+                displayLength[i] = 1;
+            }
+            for (int i = first; i < last; i++) {
+                text[i * SESSION_TEXT_SIZE] = '0';
+                text[i * SESSION_TEXT_SIZE + 1] = '\0';
+                display[i * SESSION_TEXT_SIZE] = '0';
+                display[i * SESSION_TEXT_SIZE + 1] = '\0';
+            }
+            break;
+        default:
+            /* The bases need integers, sessions are doubles only */
+            break;
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Get the text shown by a session
+ *
+ *  @param  session Session index
+ *
+ *  @return Text last shown
+ */
+QString SessionStore::getDisplayText(int session) const
+{
+    /* Return shown text */
+    return QString::fromLatin1(display.constData() + session * SESSION_TEXT_SIZE, displayLength[session]);
+}
+
+/**
+ *  @brief  Session store object method : Get the value in the LCD of a session
+ *
+ *  @param  session Session index
+ *
+ *  @return LCD value
+ */
+double SessionStore::getValue(int session)
+{
+    /* Parse the text only when needed */
+    parseValue(session);
+    return lcd[session];
+}
+
+/**
+ *  @brief  Session store object method : Get the memory value of a session
+ *
+ *  @param  session Session index
+ *
+ *  @return Memory value
+ */
+double SessionStore::getMemory(int session) const
+{
+    /* Return memory value */
+    return memory[session];
+}
+
+/**
+ *  @brief  Session store object method : Press a digit
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressDigit(int button, int first, int last)
+{
+    char digit = buttonLabels[button][0];
+    char newText[SESSION_TEXT_SIZE];
+    int length;
+
+    for (int i = first; i < last; i++) {
+        int lc = lastClicked[i];
+        parseValue(i);
+        if (lcd[i] == 0) {
+            /* Value is zero, take a new value ... */
+            length = 0;
+            if (lc == TYPE_DOT) {
+                /* ... after the '.' pressed before */
+                newText[length++] = '0';
+                newText[length++] = '.';
+            }
+            newText[length++] = digit;
+        } else if ((lc == TYPE_OP) || (lc == TYPE_EQ) || hasExponent(i)) {
+            /* Value is not zero, but need to take a new value */
+            length = 0;
+            newText[length++] = digit;
+        } else {
+            /* Value is not zero, append to existing text */
+            formatText(i);
+            length = textLength[i];
+            if (length >= LCD_LENGTH) {
+                lastClicked[i] = TYPE_NUM;
+                continue;
+            }
+            memcpy(newText, text.constData() + i * SESSION_TEXT_SIZE, length);
+            newText[length++] = digit;
+        }
+        if (setText(i, newText, length)) {
+            updateLCD(i);
+        }
+        lastClicked[i] = TYPE_NUM;
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a unary operator
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressUnary(int button, int first, int last)
+{
+    int number = 0;
+
+    /* The factorial needs the gamma function, one session at a time */
+    if (button == BUTTON_FACT) {
+        for (int i = first; i < last; i++) {
+            bool error = false;
+            parseValue(i);
+            double value = lcd[i];
+            if ((value < 0) && (value == floor(value))) {
+                /* Negative integer, factorial has a pole here */
+                showError(i);
+                continue;
+            }
+            double result = Engine::compute(value, value, OPERATOR_FACT, &error);
+            if (error) {
+                showError(i);
+                continue;
+            }
+            setValue(i, result);
+            if (isinf(result) && !isinf(value)) {
+                /* Too large for a double, show the magnitude at least */
+                QByteArray magnitude = Engine::factorialText(value).toLatin1();
+                if (!setText(i, magnitude.constData(), magnitude.length())) {
+                    continue;
+                }
+            }
+            updateLCD(i);
+            lastClicked[i] = TYPE_OP;
+        }
+        return;
+    }
+
+    /* Gather the non-zero values, inverting zero is an error */
+    batch.resize(last - first);
+    batchOp1.resize(last - first);
+    for (int i = first; i < last; i++) {
+        parseValue(i);
+        if (lcd[i] != 0) {
+            batch[number] = i;
+            batchOp1[number] = lcd[i];
+            number++;
+        } else if (button == BUTTON_INV) {
+            showError(i);
+        }
+    }
+    if (number == 0) {
+        return;
+    }
+
+    /* Same steps as the engine takes */
+    batchOp2.resize(number);
+    batchResult.resize(number);
+    batchErrors.resize((number + 7) / 8);
+    if (button == BUTTON_SQ) {
+        VectorCalc::calculate(OPERATOR_MUL, batchOp1.constData(), NULL, batchResult.data(), batchErrors.data(), number);
+    } else if (button == BUTTON_SQRT) {
+        VectorCalc::calculate(OPERATOR_SQRT, batchOp1.constData(), NULL, batchResult.data(), batchErrors.data(), number);
+    } else if (button == BUTTON_INV) {
+        batchOp2.fill(1);
+        VectorCalc::calculate(OPERATOR_DIV, batchOp2.constData(), batchOp1.constData(), batchResult.data(), batchErrors.data(), number);
+    } else {
+        VectorCalc::calculate(OPERATOR_MUL, batchOp1.constData(), NULL, batchOp2.data(), batchErrors.data(), number);
+        VectorCalc::calculate(OPERATOR_MUL, batchOp2.constData(), batchOp1.constData(), batchResult.data(), batchErrors.data(), number);
+    }
+
+    /* None of these can fail for a non-zero value */
+    for (int k = 0; k < number; k++) {
+        int i = batch[k];
+        setValue(i, batchResult[k]);
+        updateLCD(i);
+        lastClicked[i] = TYPE_OP;
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a binary operator
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressOperator(int button, int first, int last)
+{
+    int newOp = OPERATOR_NONE;
+    int start[OPERATOR_DIV + 2];
+    int number = 0;
+
+    /* Map the button to the operator */
+    if (button == BUTTON_PLUS) {
+        newOp = OPERATOR_PLUS;
+    } else if (button == BUTTON_NEG) {
+        newOp = OPERATOR_MINUS;
+    } else if (button == BUTTON_MUL) {
+        newOp = OPERATOR_MUL;
+    } else {
+        newOp = OPERATOR_DIV;
+    }
+
+    /* Finish the sessions with nothing to calculate, count the others */
+    memset(start, 0, sizeof(start));
+    batch.resize(last - first);
+    for (int i = first; i < last; i++) {
+        int lc = lastClicked[i];
+        int op = lastOperator[i];
+        parseValue(i);
+        if ((lcd[i] == 0) || (lc == TYPE_OP)) {
+            /* Just update the operator */
+            lastOperator[i] = newOp;
+            lastClicked[i] = TYPE_OP;
+        } else if ((operand[i] == 0) || (lc == TYPE_EQ) || (op == OPERATOR_NONE)) {
+            /* No last operand, save current value for next calculation */
+            operand[i] = lcd[i];
+            lastOperator[i] = newOp;
+            lastClicked[i] = TYPE_OP;
+            flags[i] &= ~SESSION_DECIMAL;
+        } else {
+            /* Calculate with the saved operand */
+            batch[number++] = i;
+            start[op + 1]++;
+        }
+    }
+    if (number == 0) {
+        return;
+    }
+
+    /* Sort by the saved operator, so each runs as one vector */
+    gatherOperands(number, start);
+
+    for (int op = OPERATOR_PLUS; op <= OPERATOR_DIV; op++) {
+        int size = start[op + 1] - start[op];
+        if (size == 0) {
+            continue;
+        }
+        VectorCalc::calculate(op, batchOp1.constData() + start[op], batchOp2.constData() + start[op],
+                              batchResult.data() + start[op], batchErrors.data(), size);
+        for (int k = 0; k < size; k++) {
+            int i = batch[start[op] + k];
+            operand[i] = batchResult[start[op] + k];
+            if (batchErrors[k >> 3] & (1 << (k & 7))) {
+                /* Show the error, it resets the operand */
+                showError(i);
+            }
+            /* Update LCD */
+            setValue(i, operand[i]);
+            updateLCD(i);
+            lastOperator[i] = newOp;
+            lastClicked[i] = TYPE_OP;
+            flags[i] &= ~SESSION_DECIMAL;
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press equal to
+ *
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressEqual(int first, int last)
+{
+    int start[OPERATOR_DIV + 2];
+    int number = 0;
+
+    /* Finish the sessions with nothing to calculate, count the others */
+    memset(start, 0, sizeof(start));
+    batch.resize(last - first);
+    for (int i = first; i < last; i++) {
+        int lc = lastClicked[i];
+        int op = lastOperator[i];
+        parseValue(i);
+        if ((lcd[i] == 0) || (lc == TYPE_OP) || (lc == TYPE_EQ)) {
+            /* Nothing to do */
+            lastClicked[i] = TYPE_EQ;
+        } else if ((operand[i] == 0) || (op == OPERATOR_NONE)) {
+            /* No operand or operator, the result would be zero and is not shown */
+            lastClicked[i] = TYPE_EQ;
+            flags[i] &= ~SESSION_DECIMAL;
+        } else {
+            /* Calculate with the saved operand */
+            batch[number++] = i;
+            start[op + 1]++;
+        }
+    }
+    if (number == 0) {
+        return;
+    }
+
+    /* Sort by the saved operator, so each runs as one vector */
+    gatherOperands(number, start);
+
+    for (int op = OPERATOR_PLUS; op <= OPERATOR_DIV; op++) {
+        int size = start[op + 1] - start[op];
+        if (size == 0) {
+            continue;
+        }
+        VectorCalc::calculate(op, batchOp1.constData() + start[op], batchOp2.constData() + start[op],
+                              batchResult.data() + start[op], batchErrors.data(), size);
+        for (int k = 0; k < size; k++) {
+            int i = batch[start[op] + k];
+            double result = batchResult[start[op] + k];
+            if (batchErrors[k >> 3] & (1 << (k & 7))) {
+                /* Show the error, the result is zero */
+                showError(i);
+            } else if (result != 0) {
+                /* Forget the operator and show the result */
+                lastOperator[i] = OPERATOR_NONE;
+                setValue(i, result);
+                updateLCD(i);
+            }
+            lastClicked[i] = TYPE_EQ;
+            flags[i] &= ~SESSION_DECIMAL;
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Sort the waiting sessions by operator
+ *
+ *  @param  number  Number of sessions waiting
+ *  @param  start   Number of sessions for each operator at [op + 1],
+ *                  set to the first position of each operator at [op]
+ *
+ *  @return N/A
+ */
+void SessionStore::gatherOperands(int number, int *start)
+{
+    int next[OPERATOR_DIV + 1];
+    QVector<int> sorted(number);
+
+    /* Counts to positions */
+    for (int op = OPERATOR_PLUS; op <= OPERATOR_DIV; op++) {
+        start[op + 1] += start[op];
+    }
+    memcpy(next, start, sizeof(next));
+
+    /* Place each session with its operands */
+    batchOp1.resize(number);
+    batchOp2.resize(number);
+    batchResult.resize(number);
+    batchErrors.resize((number + 7) / 8);
+    for (int k = 0; k < number; k++) {
+        int i = batch[k];
+        int position = next[lastOperator[i]]++;
+        sorted[position] = i;
+        batchOp1[position] = operand[i];
+        batchOp2[position] = lcd[i];
+    }
+    batch = sorted;
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a key that edits the text
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressEdit(int button, int first, int last)
+{
+    char newText[SESSION_TEXT_SIZE + 1];
+
+    for (int i = first; i < last; i++) {
+        int length;
+        if ((button == BUTTON_DOT) && (flags[i] & SESSION_DECIMAL)) {
+            /* A dot is already shown */
+            continue;
+        }
+        if (button == BUTTON_DOT) {
+            parseValue(i);
+        }
+        formatText(i);
+        length = textLength[i];
+        memcpy(newText, text.constData() + i * SESSION_TEXT_SIZE, length);
+        if (button == BUTTON_DOT) {
+            if ((lcd[i] == 0) || (lastClicked[i] == TYPE_OP) || hasExponent(i)) {
+                /* Start a fraction */
+                length = 0;
+                newText[length++] = '0';
+            }
+            newText[length++] = '.';
+            lastClicked[i] = TYPE_DOT;
+        } else if (button == BUTTON_SIGN) {
+            if (!(flags[i] & SESSION_NEGATIVE)) {
+                /* Add the sign, if it does not affect the LCD precision */
+                if (length <= LCD_LENGTH) {
+                    memmove(newText + 1, newText, length);
+                    newText[0] = '-';
+                    length++;
+                }
+            } else if (length > 0) {
+                /* Remove the sign */
+                memmove(newText, newText + 1, --length);
+            }
+        } else {
+            if (hasExponent(i)) {
+                /* An exponent is not taken back digit by digit */
+                lastClicked[i] = TYPE_OTHER;
+                continue;
+            } else if (length > 1) {
+                /* Cut one from end */
+                length--;
+            } else if (length == 1) {
+                /* Nothing left, set the value to zero */
+                newText[0] = '0';
+            }
+            lastClicked[i] = TYPE_OTHER;
+            if (length == 0) {
+                continue;
+            }
+        }
+        if (setText(i, newText, length)) {
+            updateLCD(i);
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Press a memory key
+ *
+ *  @param  button  Button index
+ *  @param  first   First session
+ *  @param  last    Last session, exclusive
+ *
+ *  @return N/A
+ */
+void SessionStore::pressMemory(int button, int first, int last)
+{
+    if (button == BUTTON_MC) {
+        /* Reset the memory value */
+        for (int i = first; i < last; i++) {
+            memory[i] = 0;
+        }
+    } else if (button == BUTTON_MR) {
+        /* Update LCD with the current memory value */
+        for (int i = first; i < last; i++) {
+            setValue(i, memory[i]);
+            updateLCD(i);
+        }
+    } else if (button == BUTTON_MS) {
+        /* Save current value to memory, the next value is started anew */
+        for (int i = first; i < last; i++) {
+            parseValue(i);
+            memory[i] = lcd[i];
+            setValue(i, 0);
+            lastClicked[i] = TYPE_INIT;
+        }
+    } else {
+        /* Add a non-zero value to the memory */
+        for (int i = first; i < last; i++) {
+            parseValue(i);
+            if (lcd[i] != 0) {
+                memory[i] = (memory[i] == 0) ? lcd[i] : (lcd[i] + memory[i]);
+            }
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Format the LCD text of a session when needed
+ *
+ *  @param  session Session index
+ *
+ *  @return N/A
+ */
+void SessionStore::formatText(int session)
+{
+    /* Nothing to do if the text is up to date */
+    if (flags[session] & SESSION_TEXT_VALID) {
+        return;
+    }
+
+    /* The engine's format, at most LCD_LENGTH characters */
+    char buffer[FORMAT_SIZE];
+    int length = Format::toText(lcd[session], buffer);
+    memcpy(text.data() + session * SESSION_TEXT_SIZE, buffer, length + 1);
+    textLength[session] = length;
+    flags[session] |= SESSION_TEXT_VALID;
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Check the LCD text of a session for an exponent
+ *
+ *  @param  session Session index
+ *
+ *  @return true if the text has an exponent
+ */
+bool SessionStore::hasExponent(int session)
+{
+    /* Format it first, the value may be newer */
+    formatText(session);
+    return memchr(text.constData() + session * SESSION_TEXT_SIZE, 'e', textLength[session]) != NULL;
+}
+
+/**
+ *  @brief  Session store object method : Parse the LCD value of a session when needed
+ *
+ *  @param  session Session index
+ *
+ *  @return N/A
+ */
+void SessionStore::parseValue(int session)
+{
+    /* Nothing to do if the value is up to date */
+    if (flags[session] & SESSION_VALUE_VALID) {
+        return;
+    }
+
+    /* The engine's parse, 0 if not a number */
+    lcd[session] = Parse::toDouble(text.constData() + session * SESSION_TEXT_SIZE, textLength[session]);
+    flags[session] |= SESSION_VALUE_VALID;
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Set the LCD text of a session
+ *
+ *  @param  session     Session index
+ *  @param  newText     Text
+ *  @param  length      Length of the text
+ *
+ *  @return true if set, false if too long and an error is shown instead
+ */
+bool SessionStore::setText(int session, const char *newText, int length)
+{
+    /* Keep the terminator */
+    if (length >= SESSION_TEXT_SIZE) {
+        showError(session);
+        return false;
+    }
+
+    /* Set text, the value is parsed from it when needed */
+    char *target = text.data() + session * SESSION_TEXT_SIZE;
+    memcpy(target, newText, length);
+    target[length] = '\0';
+    textLength[session] = length;
+    flags[session] = (flags[session] | SESSION_TEXT_VALID) & ~SESSION_VALUE_VALID;
+    return true;
+}
+
+/**
+ *  @brief  Session store object method : Set the LCD value of a session
+ *
+ *  @param  session Session index
+ *  @param  value   Value
+ *
+ *  @return N/A
+ */
+void SessionStore::setValue(int session, double value)
+{
+    /* Set value, the text is formatted from it when needed */
+    lcd[session] = value;
+    flags[session] = (flags[session] | SESSION_VALUE_VALID) & ~SESSION_TEXT_VALID;
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Show the LCD text of a session
+ *
+ *  @param  session Session index
+ *
+ *  @return N/A
+ */
+void SessionStore::updateLCD(int session)
+{
+    formatText(session);
+    const char *current = text.constData() + session * SESSION_TEXT_SIZE;
+    int length = textLength[session];
+
+    /* Disable dot and sign actions if already present */
+    quint8 status = flags[session] & ~(SESSION_DECIMAL | SESSION_NEGATIVE);
+    if (memchr(current, '.', length) != NULL) {
+        status |= SESSION_DECIMAL;
+    }
+    if (current[0] == '-') {
+        status |= SESSION_NEGATIVE;
+    }
+    flags[session] = status;
+
+    /* Save the text shown */
+    memcpy(display.data() + session * SESSION_TEXT_SIZE, current, length + 1);
+    displayLength[session] = length;
+    return;
+}
+
+/**
+ *  @brief  Session store object method : Show an error in a session
+ *
+ *  @param  session Session index
+ *
+ *  @return N/A
+ */
+void SessionStore::showError(int session)
+{
+    /* Show error */
+    memcpy(display.data() + session * SESSION_TEXT_SIZE, errorText, sizeof(errorText));
+    displayLength[session] = sizeof(errorText) - 1;
+
+    /* Reset the components */
+    setValue(session, 0);
+    flags[session] &= ~(SESSION_DECIMAL | SESSION_NEGATIVE);
+    lastOperator[session] = OPERATOR_NONE;
+    operand[session] = 0;
+    lastClicked[session] = TYPE_INIT;
+    return;
+}
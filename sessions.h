@@ -0,0 +1,143 @@
+/** @file sessions.h
+ *
+ *  @brief This file contains the declarations of the multi-session store
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSIONS_H
+#define SESSIONS_H
+
+/* Includes */
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/* Defines */
+
+/** Bytes kept for the LCD text of a session, including the terminator */
+#define SESSION_TEXT_SIZE   24
+
+/** Session flag : The LCD text is up to date */
+#define SESSION_TEXT_VALID  0x01
+/** Session flag : The LCD value is up to date */
+#define SESSION_VALUE_VALID 0x02
+/** Session flag : A dot is shown */
+#define SESSION_DECIMAL     0x04
+/** Session flag : A negative sign is shown */
+#define SESSION_NEGATIVE    0x08
+
+/**
+ *  Many calculator sessions, kept as columns.
+ *
+ *  Each session behaves as an engine in double arithmetic does, but
+ *  the state lives in one array per field instead of one object per
+ *  session, some 80 bytes a session. A keystroke is applied to a range
+ *  of sessions at once: the button is dispatched once for the range,
+ *  the simple keys are plain loops over a column, and the arithmetic is
+ *  gathered by operator and run through VectorCalc.
+ *
+ *  A text longer than SESSION_TEXT_SIZE - 1, which only the factorial
+ *  of a huge number gives, is shown as an error.
+ */
+class SessionStore
+{
+public:
+    /** Constructor */
+    SessionStore();
+    /** Set the number of sessions, new ones start in init status */
+    void setCount(int count);
+    /** Get the number of sessions */
+    int getCount(void) const;
+    /** Reset a range of sessions to init status */
+    void reset(int first, int count);
+    /** Press a button in all sessions */
+    void press(int button);
+    /** Press a button in a range of sessions */
+    void press(int button, int first, int count);
+    /** Get the text shown by a session */
+    QString getDisplayText(int session) const;
+    /** Get the value in the LCD of a session */
+    double getValue(int session);
+    /** Get the memory value of a session */
+    double getMemory(int session) const;
+
+private:
+    /** LCD values */
+    QVector<double> lcd;
+    /** Saved operands */
+    QVector<double> operand;
+    /** Memory values */
+    QVector<double> memory;
+    /** LCD texts, SESSION_TEXT_SIZE bytes each */
+    QVector<char> text;
+    /** Shown texts, SESSION_TEXT_SIZE bytes each */
+    QVector<char> display;
+    /** LCD text lengths */
+    QVector<quint8> textLength;
+    /** Shown text lengths */
+    QVector<quint8> displayLength;
+    /** SESSION_ flags */
+    QVector<quint8> flags;
+    /** Saved operators */
+    QVector<quint8> lastOperator;
+    /** Last clicked button types */
+    QVector<quint8> lastClicked;
+    /** Sessions waiting for a calculation */
+    QVector<int> batch;
+    /** Operand 1 of the calculations */
+    QVector<double> batchOp1;
+    /** Operand 2 of the calculations */
+    QVector<double> batchOp2;
+    /** Results of the calculations */
+    QVector<double> batchResult;
+    /** Error mask of the calculations */
+    QVector<unsigned char> batchErrors;
+    /** Number of sessions */
+    int count;
+
+    /** Press a digit */
+    void pressDigit(int button, int first, int last);
+    /** Press a unary operator */
+    void pressUnary(int button, int first, int last);
+    /** Press a binary operator */
+    void pressOperator(int button, int first, int last);
+    /** Press equal to */
+    void pressEqual(int first, int last);
+    /** Sort the waiting sessions by operator */
+    void gatherOperands(int number, int *start);
+    /** Press a key that edits the text */
+    void pressEdit(int button, int first, int last);
+    /** Press a memory key */
+    void pressMemory(int button, int first, int last);
+    /** Format the LCD text of a session when needed */
+    void formatText(int session);
+    /** Check the LCD text of a session for an exponent */
+    bool hasExponent(int session);
+    /** Parse the LCD value of a session when needed */
+    void parseValue(int session);
+    /** Set the LCD text of a session */
+    bool setText(int session, const char *newText, int length);
+    /** Set the LCD value of a session */
+    void setValue(int session, double value);
+    /** Show the LCD text of a session */
+    void updateLCD(int session);
+    /** Show an error in a session */
+    void showError(int session);
+};
+
+#endif // SESSIONS_H
@@ -0,0 +1,228 @@
+/** @file stats.cpp
+ *
+ *  @brief This file contains the definitions of the engine instrumentation
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "stats.h"
+#include <time.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define STATS_TSC   1
+#endif
+
+/**
+ *  @brief  Monotonic clock
+ *
+ *  @return Time in nanoseconds
+ */
+static double nanoseconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ *  @brief  Histogram object constructor
+ *
+ *  @return N/A
+ */
+Histogram::Histogram()
+{
+    /* Start empty */
+    clear();
+    return;
+}
+
+/**
+ *  @brief  Histogram object method : Drop all values
+ *
+ *  @return N/A
+ */
+void Histogram::clear(void)
+{
+    /* Empty all buckets */
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        counts[i] = 0;
+    }
+    total = 0;
+    largest = 0;
+    return;
+}
+
+/**
+ *  @brief  Histogram object method : Get the number of values
+ *
+ *  @return Number of values
+ */
+quint64 Histogram::getCount(void) const
+{
+    /* Return number of values */
+    return total;
+}
+
+/**
+ *  @brief  Histogram object method : Get the largest value
+ *
+ *  @return Largest value
+ */
+quint64 Histogram::getMax(void) const
+{
+    /* Return largest value */
+    return largest;
+}
+
+/**
+ *  @brief  Histogram object method : Get a value at a percentile
+ *
+ *  @param  percent Percentile, 0 to 100
+ *
+ *  @return Smallest value of the bucket holding the percentile
+ */
+quint64 Histogram::getPercentile(double percent) const
+{
+    /* Rank of the value wanted, counting from 1 */
+    quint64 rank = (quint64) (percent / 100 * total + 0.5);
+    quint64 seen = 0;
+
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return lowest(i);
+        }
+    }
+    return 0;
+}
+
+/**
+ *  @brief  Histogram class method : Smallest value of a bucket
+ *
+ *  @param  bucket  Bucket
+ *
+ *  @return Smallest value
+ */
+quint64 Histogram::lowest(int bucket)
+{
+    /* Inverse of index() */
+    if (bucket < STATS_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / STATS_SUB_BUCKETS - 1;
+    return (quint64) (STATS_SUB_BUCKETS + bucket % STATS_SUB_BUCKETS) << shift;
+}
+
+/**
+ *  @brief  Engine statistics object constructor
+ *
+ *  @return N/A
+ */
+EngineStats::EngineStats()
+{
+    /* Start empty */
+    clear();
+    return;
+}
+
+/**
+ *  @brief  Engine statistics object method : Drop all counts
+ *
+ *  @return N/A
+ */
+void EngineStats::clear(void)
+{
+    /* Reset the counters and histograms */
+    for (int i = 0; i < NUM_STATS; i++) {
+        counters[i] = 0;
+    }
+    for (int i = 0; i < STATS_KEYS; i++) {
+        histograms[i].clear();
+    }
+
+    /* Ticks are converted by the rate seen from now on */
+    startTicks = now();
+    startTime = nanoseconds();
+    return;
+}
+
+/**
+ *  @brief  Engine statistics class method : Current time in ticks
+ *
+ *  @return Time stamp counter where there is one, nanoseconds otherwise
+ */
+quint64 EngineStats::now(void)
+{
+#ifdef STATS_TSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (quint64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+ *  @brief  Engine statistics object method : Get a counter
+ *
+ *  @param  counter Counter
+ *
+ *  @return Count
+ */
+quint64 EngineStats::getCounter(int counter) const
+{
+    /* Return count */
+    return counters[counter];
+}
+
+/**
+ *  @brief  Engine statistics object method : Dump the counters and histograms
+ *
+ *  @param  out     Output stream
+ *  @param  names   Key names
+ *  @param  numKeys Number of keys
+ *
+ *  @return N/A
+ */
+void EngineStats::dump(FILE *out, const QString names[], int numKeys) const
+{
+    /* Nanoseconds per tick since cleared */
+    quint64 ticks = now() - startTicks;
+    double scale = (ticks > 0) ? (nanoseconds() - startTime) / ticks : 1;
+
+    fprintf(out, "parses %llu formats %llu calculations %llu errors %llu\n",
+            (unsigned long long) counters[STAT_PARSE], (unsigned long long) counters[STAT_FORMAT],
+            (unsigned long long) counters[STAT_CALCULATE], (unsigned long long) counters[STAT_ERROR]);
+    fprintf(out, "%-8s %10s %10s %10s %10s %10s\n", "key", "count", "p50 ns", "p90 ns", "p99 ns", "max ns");
+    for (int i = 0; (i < numKeys) && (i < STATS_KEYS); i++) {
+        const Histogram &histogram = histograms[i];
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        fprintf(out, "%-8s %10llu %10.0f %10.0f %10.0f %10.0f\n",
+                names[i].toLatin1().constData(), (unsigned long long) histogram.getCount(),
+                histogram.getPercentile(50) * scale, histogram.getPercentile(90) * scale,
+                histogram.getPercentile(99) * scale, histogram.getMax() * scale);
+    }
+    return;
+}
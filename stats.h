@@ -0,0 +1,148 @@
+/** @file stats.h
+ *
+ *  @brief This file contains the declarations of the engine instrumentation
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+/* Includes */
+#include <stdio.h>
+#include <QString>
+
+/* Defines */
+
+/** Bits of precision below the leading bit, 16 buckets per power of two */
+#define STATS_SUB_BITS      4
+/** Buckets per power of two */
+#define STATS_SUB_BUCKETS   (1 << STATS_SUB_BITS)
+/** Largest latency kept apart in bits, longer ones share the last bucket */
+#define STATS_MAX_BITS      40
+/** Buckets in a histogram */
+#define STATS_BUCKETS       ((STATS_MAX_BITS - STATS_SUB_BITS + 1) * STATS_SUB_BUCKETS)
+/** Keys with a histogram, buttons then hex buttons */
+#define STATS_KEYS          40
+
+/** Counter : Number parsed from text */
+#define STAT_PARSE          0
+/** Counter : Number formatted to text */
+#define STAT_FORMAT         1
+/** Counter : Calculation */
+#define STAT_CALCULATE      2
+/** Counter : Error shown */
+#define STAT_ERROR          3
+/** Number of counters */
+#define NUM_STATS           4
+
+/**
+ *  Latency histogram with a fixed relative precision.
+ *
+ *  Values below STATS_SUB_BUCKETS have a bucket each, above that each
+ *  power of two is split in STATS_SUB_BUCKETS buckets, so any value is
+ *  known to within about 6%.
+ */
+class Histogram
+{
+public:
+    /** Constructor */
+    Histogram();
+    /** Drop all values */
+    void clear(void);
+    /** Record a value */
+    void record(quint64 value)
+    {
+        counts[index(value)]++;
+        total++;
+        if (value > largest) {
+            largest = value;
+        }
+    }
+    /** Get the number of values */
+    quint64 getCount(void) const;
+    /** Get the largest value */
+    quint64 getMax(void) const;
+    /** Get a value at a percentile */
+    quint64 getPercentile(double percent) const;
+
+private:
+    /** Bucket of a value */
+    static int index(quint64 value)
+    {
+        if (value < STATS_SUB_BUCKETS) {
+            return (int) value;
+        }
+        int shift = 63 - __builtin_clzll(value) - STATS_SUB_BITS;
+        int bucket = (shift + 1) * STATS_SUB_BUCKETS + (int) ((value >> shift) & (STATS_SUB_BUCKETS - 1));
+        return (bucket < STATS_BUCKETS) ? bucket : STATS_BUCKETS - 1;
+    }
+    /** Smallest value of a bucket */
+    static quint64 lowest(int bucket);
+
+    /** Values per bucket */
+    quint32 counts[STATS_BUCKETS];
+    /** Number of values */
+    quint64 total;
+    /** Largest value */
+    quint64 largest;
+};
+
+/**
+ *  Engine instrumentation : event counters and a keystroke latency
+ *  histogram per key.
+ *
+ *  Latencies are kept in clock ticks, the time stamp counter where there
+ *  is one, and converted to nanoseconds only when dumped.
+ */
+class EngineStats
+{
+public:
+    /** Constructor */
+    EngineStats();
+    /** Drop all counts */
+    void clear(void);
+    /** Count an event */
+    void count(int counter)
+    {
+        counters[counter]++;
+    }
+    /** Record a keystroke latency in ticks */
+    void record(int key, quint64 ticks)
+    {
+        histograms[key].record(ticks);
+    }
+    /** Get a counter */
+    quint64 getCounter(int counter) const;
+    /** Dump the counters and histograms */
+    void dump(FILE *out, const QString names[], int numKeys) const;
+    /** Current time in ticks */
+    static quint64 now(void);
+
+private:
+    /** Event counters */
+    quint64 counters[NUM_STATS];
+    /** Keystroke latencies */
+    Histogram histograms[STATS_KEYS];
+    /** Ticks when cleared */
+    quint64 startTicks;
+    /** Nanoseconds when cleared */
+    double startTime;
+};
+
+#endif // STATS_H
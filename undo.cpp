@@ -0,0 +1,622 @@
+/** @file undo.cpp
+ *
+ *  @brief This file contains the definitions of the undo history
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include <string.h>
+#include "undo.h"
+
+/** Compile time check : One bit per field in a step */
+typedef char undoFieldsCheck[(NUM_UNDO_FIELDS <= 32) ? 1 : -1];
+
+/**
+ *  @brief  Append a number to packed values, seven bits a byte
+ *
+ *  @param  data    Packed values
+ *  @param  value   Number
+ *
+ *  @return N/A
+ */
+static void putNumber(QByteArray *data, quint32 value)
+{
+    /* Low bits first, the top bit tells more follow */
+    while (value >= 0x80) {
+        data->append((char) ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data->append((char) value);
+    return;
+}
+
+/**
+ *  @brief  Read a number from packed values
+ *
+ *  @param  position    Read position, moved past the number
+ *
+ *  @return Number
+ */
+static quint32 getNumber(const char **position)
+{
+    quint32 value = 0;
+    int shift = 0;
+    quint8 byte;
+
+    /* Low bits first, the top bit tells more follow */
+    do {
+        byte = (quint8) *(*position)++;
+        value |= (quint32) (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+/**
+ *  @brief  Append a text to packed values, its length first
+ *
+ *  @param  data    Packed values
+ *  @param  text    Text
+ *
+ *  @return N/A
+ */
+static void putText(QByteArray *data, const QString &text)
+{
+    QByteArray bytes = text.toUtf8();
+
+    /* Length, then the bytes */
+    putNumber(data, bytes.size());
+    data->append(bytes.constData(), bytes.size());
+    return;
+}
+
+/**
+ *  @brief  Read a text from packed values
+ *
+ *  @param  position    Read position, moved past the text
+ *
+ *  @return Text
+ */
+static QString getText(const char **position)
+{
+    /* Length, then the bytes */
+    int length = getNumber(position);
+    QString text = QString::fromUtf8(*position, length);
+    *position += length;
+    return text;
+}
+
+/**
+ *  @brief  Append plain bytes to packed values
+ *
+ *  @param  data    Packed values
+ *  @param  value   Value, a number or a class made of numbers
+ *  @param  size    Size of the value
+ *
+ *  @return N/A
+ */
+static void putBytes(QByteArray *data, const void *value, int size)
+{
+    /* Copy as is */
+    data->append((const char *) value, size);
+    return;
+}
+
+/**
+ *  @brief  Read plain bytes from packed values
+ *
+ *  @param  position    Read position, moved past the value
+ *  @param  value       Set to the value
+ *  @param  size        Size of the value
+ *
+ *  @return N/A
+ */
+static void getBytes(const char **position, void *value, int size)
+{
+    /* Copy as is */
+    memcpy(value, *position, size);
+    *position += size;
+    return;
+}
+
+/**
+ *  @brief  Undo log object method : Forget all the steps
+ *
+ *  @return N/A
+ */
+void UndoLog::clear(void)
+{
+    /* Drop the steps and their values */
+    steps.clear();
+    data.clear();
+    numbers.clear();
+    return;
+}
+
+/**
+ *  @brief  Undo log object method : Get the number of steps
+ *
+ *  @return Number of steps
+ */
+int UndoLog::getCount(void) const
+{
+    /* Return step count */
+    return steps.size();
+}
+
+/**
+ *  @brief  Undo log object method : Get the fields of a step
+ *
+ *  @param  index   Index of the step
+ *
+ *  @return Fields, a bit for each UNDO_ field
+ */
+quint32 UndoLog::getFields(int index) const
+{
+    /* Return step fields */
+    return steps.at(index).fields;
+}
+
+/**
+ *  @brief  Undo log class method : Get the fields that differ between two states
+ *
+ *  Doubles are compared bit for bit, so signs of zero and not-a-numbers
+ *  count.
+ *
+ *  @param  a   State
+ *  @param  b   State
+ *
+ *  @return Fields, a bit for each UNDO_ field
+ */
+quint32 UndoLog::compare(const EngineState &a, const EngineState &b)
+{
+    quint32 fields = 0;
+
+    /* Texts and their status */
+    if (a.lcdText != b.lcdText) {
+        fields |= 1u << UNDO_LCD_TEXT;
+    }
+    if (a.isTextValid != b.isTextValid) {
+        fields |= 1u << UNDO_TEXT_VALID;
+    }
+    if (a.isValueValid != b.isValueValid) {
+        fields |= 1u << UNDO_VALUE_VALID;
+    }
+    if (a.displayText != b.displayText) {
+        fields |= 1u << UNDO_DISPLAY_TEXT;
+    }
+
+    /* Registers in each arithmetic */
+    for (int reg = 0; reg < NUM_REGISTERS; reg++) {
+        if (memcmp(&a.registers[reg], &b.registers[reg], sizeof(double)) != 0) {
+            fields |= 1u << (UNDO_REGISTERS + reg);
+        }
+        if (!a.bigRegisters[reg].isSame(b.bigRegisters[reg])) {
+            fields |= 1u << (UNDO_BIG_REGISTERS + reg);
+        }
+        if (!a.decimalRegisters[reg].isSame(b.decimalRegisters[reg])) {
+            fields |= 1u << (UNDO_DECIMAL_REGISTERS + reg);
+        }
+        if (a.intRegisters[reg] != b.intRegisters[reg]) {
+            fields |= 1u << (UNDO_INT_REGISTERS + reg);
+        }
+    }
+
+    /* Modes and keypad status */
+    if (a.arithMode != b.arithMode) {
+        fields |= 1u << UNDO_ARITH_MODE;
+    }
+    if (a.bigDigits != b.bigDigits) {
+        fields |= 1u << UNDO_BIG_DIGITS;
+    }
+    if (a.lastOperator != b.lastOperator) {
+        fields |= 1u << UNDO_LAST_OPERATOR;
+    }
+    if (a.lastClicked != b.lastClicked) {
+        fields |= 1u << UNDO_LAST_CLICKED;
+    }
+    if (a.isDecimalEnabled != b.isDecimalEnabled) {
+        fields |= 1u << UNDO_DECIMAL_ENABLED;
+    }
+    if (a.isNegativeEnabled != b.isNegativeEnabled) {
+        fields |= 1u << UNDO_NEGATIVE_ENABLED;
+    }
+    if (a.radix != b.radix) {
+        fields |= 1u << UNDO_RADIX;
+    }
+    if (a.numLCDDigits != b.numLCDDigits) {
+        fields |= 1u << UNDO_LCD_DIGITS;
+    }
+
+    /* Summary, it only changes as values are added or it starts over */
+    if ((a.summary.getCount() != b.summary.getCount()) ||
+        (a.summary.getPairCount() != b.summary.getPairCount())) {
+        fields |= 1u << UNDO_SUMMARY;
+    }
+    if (a.isSummaryEnabled != b.isSummaryEnabled) {
+        fields |= 1u << UNDO_SUMMARY_ENABLED;
+    }
+    return fields;
+}
+
+/**
+ *  @brief  Undo log object method : Add a step with the values of some fields of a state
+ *
+ *  @param  fields  Fields, a bit for each UNDO_ field
+ *  @param  state   State to take the values from
+ *
+ *  @return N/A
+ */
+void UndoLog::append(quint32 fields, const EngineState &state)
+{
+    UndoStep step;
+
+    /* The values follow those of the step before */
+    step.fields = fields;
+    step.offset = data.size();
+    step.number = numbers.size();
+    steps.append(step);
+
+    /* Pack the values, in field order */
+    for (int field = 0; field < NUM_UNDO_FIELDS; field++) {
+        if (!(fields & (1u << field))) {
+            continue;
+        }
+        if ((field >= UNDO_REGISTERS) && (field < UNDO_BIG_REGISTERS)) {
+            putBytes(&data, &state.registers[field - UNDO_REGISTERS], sizeof(double));
+        } else if ((field >= UNDO_BIG_REGISTERS) && (field < UNDO_DECIMAL_REGISTERS)) {
+            /* Shares its digits, no copy */
+            numbers.append(state.bigRegisters[field - UNDO_BIG_REGISTERS]);
+        } else if ((field >= UNDO_DECIMAL_REGISTERS) && (field < UNDO_INT_REGISTERS)) {
+            putBytes(&data, &state.decimalRegisters[field - UNDO_DECIMAL_REGISTERS], sizeof(Decimal));
+        } else if ((field >= UNDO_INT_REGISTERS) && (field < UNDO_ARITH_MODE)) {
+            putBytes(&data, &state.intRegisters[field - UNDO_INT_REGISTERS], sizeof(qint64));
+        } else {
+            switch (field) {
+                case UNDO_LCD_TEXT:
+                    putText(&data, state.lcdText);
+                    break;
+                case UNDO_TEXT_VALID:
+                    putNumber(&data, state.isTextValid);
+                    break;
+                case UNDO_VALUE_VALID:
+                    putNumber(&data, state.isValueValid);
+                    break;
+                case UNDO_DISPLAY_TEXT:
+                    putText(&data, state.displayText);
+                    break;
+                case UNDO_ARITH_MODE:
+                    putNumber(&data, state.arithMode);
+                    break;
+                case UNDO_BIG_DIGITS:
+                    putNumber(&data, state.bigDigits);
+                    break;
+                case UNDO_LAST_OPERATOR:
+                    putNumber(&data, state.lastOperator);
+                    break;
+                case UNDO_LAST_CLICKED:
+                    putNumber(&data, state.lastClicked);
+                    break;
+                case UNDO_DECIMAL_ENABLED:
+                    putNumber(&data, state.isDecimalEnabled);
+                    break;
+                case UNDO_NEGATIVE_ENABLED:
+                    putNumber(&data, state.isNegativeEnabled);
+                    break;
+                case UNDO_RADIX:
+                    putNumber(&data, state.radix);
+                    break;
+                case UNDO_LCD_DIGITS:
+                    putNumber(&data, state.numLCDDigits);
+                    break;
+                case UNDO_SUMMARY:
+                    putBytes(&data, &state.summary, sizeof(Accumulator));
+                    break;
+                case UNDO_SUMMARY_ENABLED:
+                    putNumber(&data, state.isSummaryEnabled);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Undo log object method : Set the fields of a step in a state
+ *
+ *  @param  index   Index of the step
+ *  @param  state   State to set the values in
+ *
+ *  @return N/A
+ */
+void UndoLog::apply(int index, EngineState *state) const
+{
+    const UndoStep &step = steps.at(index);
+    const char *position = data.constData() + step.offset;
+    int number = step.number;
+
+    /* Unpack the values, in field order */
+    for (int field = 0; field < NUM_UNDO_FIELDS; field++) {
+        if (!(step.fields & (1u << field))) {
+            continue;
+        }
+        if ((field >= UNDO_REGISTERS) && (field < UNDO_BIG_REGISTERS)) {
+            getBytes(&position, &state->registers[field - UNDO_REGISTERS], sizeof(double));
+        } else if ((field >= UNDO_BIG_REGISTERS) && (field < UNDO_DECIMAL_REGISTERS)) {
+            state->bigRegisters[field - UNDO_BIG_REGISTERS] = numbers.at(number++);
+        } else if ((field >= UNDO_DECIMAL_REGISTERS) && (field < UNDO_INT_REGISTERS)) {
+            getBytes(&position, &state->decimalRegisters[field - UNDO_DECIMAL_REGISTERS], sizeof(Decimal));
+        } else if ((field >= UNDO_INT_REGISTERS) && (field < UNDO_ARITH_MODE)) {
+            getBytes(&position, &state->intRegisters[field - UNDO_INT_REGISTERS], sizeof(qint64));
+        } else {
+            switch (field) {
+                case UNDO_LCD_TEXT:
+                    state->lcdText = getText(&position);
+                    break;
+                case UNDO_TEXT_VALID:
+                    state->isTextValid = getNumber(&position) != 0;
+                    break;
+                case UNDO_VALUE_VALID:
+                    state->isValueValid = getNumber(&position) != 0;
+                    break;
+                case UNDO_DISPLAY_TEXT:
+                    state->displayText = getText(&position);
+                    break;
+                case UNDO_ARITH_MODE:
+                    state->arithMode = (int) getNumber(&position);
+                    break;
+                case UNDO_BIG_DIGITS:
+                    state->bigDigits = (int) getNumber(&position);
+                    break;
+                case UNDO_LAST_OPERATOR:
+                    state->lastOperator = (int) getNumber(&position);
+                    break;
+                case UNDO_LAST_CLICKED:
+                    state->lastClicked = (int) getNumber(&position);
+                    break;
+                case UNDO_DECIMAL_ENABLED:
+                    state->isDecimalEnabled = getNumber(&position) != 0;
+                    break;
+                case UNDO_NEGATIVE_ENABLED:
+                    state->isNegativeEnabled = getNumber(&position) != 0;
+                    break;
+                case UNDO_RADIX:
+                    state->radix = (int) getNumber(&position);
+                    break;
+                case UNDO_LCD_DIGITS:
+                    state->numLCDDigits = (int) getNumber(&position);
+                    break;
+                case UNDO_SUMMARY:
+                    getBytes(&position, &state->summary, sizeof(Accumulator));
+                    break;
+                case UNDO_SUMMARY_ENABLED:
+                    state->isSummaryEnabled = getNumber(&position) != 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return;
+}
+
+/**
+ *  @brief  Undo log object method : Drop the steps from an index on
+ *
+ *  @param  index   Index of the first step to drop
+ *
+ *  @return N/A
+ */
+void UndoLog::truncate(int index)
+{
+    /* Nothing past the end */
+    if (index >= steps.size()) {
+        return;
+    }
+
+    /* Values go with their steps */
+    data.truncate(steps.at(index).offset);
+    numbers.resize(steps.at(index).number);
+    steps.resize(index);
+    return;
+}
+
+/**
+ *  @brief  Undo object constructor
+ *
+ *  @return N/A
+ */
+UndoHistory::UndoHistory()
+    : current(0), count(0)
+{
+    return;
+}
+
+/**
+ *  @brief  Undo object method : Forget all the history
+ *
+ *  @return N/A
+ */
+void UndoHistory::clear(void)
+{
+    /* Drop the steps, the last state is not used without them */
+    undoLog.clear();
+    redoLog.clear();
+    current = 0;
+    count = 0;
+    return;
+}
+
+/**
+ *  @brief  Undo object method : Add the current state after the last one
+ *
+ *  The step back to the last state keeps the fields the current state
+ *  changed, the current state is the last one from then on.
+ *
+ *  @param  engine  Engine in the current state
+ *
+ *  @return N/A
+ */
+void UndoHistory::push(Engine *engine)
+{
+    EngineState state;
+
+    /* Only the fields that changed since */
+    engine->saveState(&state);
+    if (count > 0) {
+        undoLog.append(UndoLog::compare(last, state), last);
+    }
+    last = state;
+    count++;
+    return;
+}
+
+/**
+ *  @brief  Undo object method : Record the state before a keystroke
+ *
+ *  Anything undone before can no longer be redone.
+ *
+ *  @param  engine  Engine about to take a keystroke
+ *
+ *  @return N/A
+ */
+void UndoHistory::record(Engine *engine)
+{
+    if (current < count) {
+        /* Undone, the states from the current one on are dropped. The
+         * engine may have moved off it, so it is added again */
+        if (current > 0) {
+            undoLog.apply(current - 1, &last);
+            undoLog.truncate(current - 1);
+        } else {
+            undoLog.clear();
+        }
+        redoLog.clear();
+        count = current;
+    }
+
+    /* Add the state */
+    push(engine);
+    current++;
+    return;
+}
+
+/**
+ *  @brief  Undo object method : Forget the last record
+ *
+ *  For a keystroke that was cancelled, undo would have nothing to undo.
+ *
+ *  @return N/A
+ */
+void UndoHistory::drop(void)
+{
+    /* Only a record not undone yet */
+    if ((current == 0) || (current != count)) {
+        return;
+    }
+
+    /* The state before it is the last one again */
+    if (count > 1) {
+        undoLog.apply(count - 2, &last);
+        undoLog.truncate(count - 2);
+    }
+    current--;
+    count--;
+    return;
+}
+
+/**
+ *  @brief  Undo object method : Go back one keystroke
+ *
+ *  @param  engine  Engine to set back
+ *
+ *  @return true if there was a keystroke to undo
+ */
+bool UndoHistory::undo(Engine *engine)
+{
+    EngineState state;
+
+    if (current == 0) {
+        return false;
+    }
+
+    /* Keep the current state for redo */
+    if (current == count) {
+        push(engine);
+    }
+
+    /* Go back one step, keeping the values it replaces to go forward again */
+    engine->saveState(&state);
+    redoLog.append(undoLog.getFields(current - 1), state);
+    undoLog.apply(current - 1, &state);
+    current--;
+    last = state;
+    engine->restoreState(state);
+    return true;
+}
+
+/**
+ *  @brief  Undo object method : Go forward one undone keystroke
+ *
+ *  @param  engine  Engine to set forward
+ *
+ *  @return true if there was a keystroke to redo
+ */
+bool UndoHistory::redo(Engine *engine)
+{
+    EngineState state;
+    int top = redoLog.getCount() - 1;
+
+    if (current + 1 >= count) {
+        return false;
+    }
+
+    /* Go forward one step, the values it replaces are still in the undo step */
+    engine->saveState(&state);
+    redoLog.apply(top, &state);
+    redoLog.truncate(top);
+    current++;
+    last = state;
+    engine->restoreState(state);
+    return true;
+}
+
+/**
+ *  @brief  Undo object method : Get the number of keystrokes that can be undone
+ *
+ *  @return Number of keystrokes
+ */
+int UndoHistory::getUndoCount(void)
+{
+    /* Return undo count */
+    return current;
+}
+
+/**
+ *  @brief  Undo object method : Get the number of keystrokes that can be redone
+ *
+ *  @return Number of keystrokes
+ */
+int UndoHistory::getRedoCount(void)
+{
+    /* Return redo count, the current state is not one */
+    return (count > current) ? count - current - 1 : 0;
+}
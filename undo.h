@@ -0,0 +1,163 @@
+/** @file undo.h
+ *
+ *  @brief This file contains the declarations of the undo history
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNDO_H
+#define UNDO_H
+
+/* Includes */
+#include <QtCore/QVector>
+#include <QtCore/QByteArray>
+#include "engine.h"
+
+/* Defines */
+
+/** Undo field : LCD text */
+#define UNDO_LCD_TEXT           0
+/** Undo field : LCD text status */
+#define UNDO_TEXT_VALID         1
+/** Undo field : LCD register status */
+#define UNDO_VALUE_VALID        2
+/** Undo field : Text shown */
+#define UNDO_DISPLAY_TEXT       3
+/** Undo field : Registers, one each */
+#define UNDO_REGISTERS          4
+/** Undo field : Registers in arbitrary precision, one each */
+#define UNDO_BIG_REGISTERS      (UNDO_REGISTERS + NUM_REGISTERS)
+/** Undo field : Registers in decimal, one each */
+#define UNDO_DECIMAL_REGISTERS  (UNDO_BIG_REGISTERS + NUM_REGISTERS)
+/** Undo field : Registers in 64-bit integer, one each */
+#define UNDO_INT_REGISTERS      (UNDO_DECIMAL_REGISTERS + NUM_REGISTERS)
+/** Undo field : Arithmetic mode */
+#define UNDO_ARITH_MODE         (UNDO_INT_REGISTERS + NUM_REGISTERS)
+/** Undo field : Arbitrary precision digits */
+#define UNDO_BIG_DIGITS         (UNDO_ARITH_MODE + 1)
+/** Undo field : Last operator */
+#define UNDO_LAST_OPERATOR      (UNDO_ARITH_MODE + 2)
+/** Undo field : Last clicked button type */
+#define UNDO_LAST_CLICKED       (UNDO_ARITH_MODE + 3)
+/** Undo field : Decimal status */
+#define UNDO_DECIMAL_ENABLED    (UNDO_ARITH_MODE + 4)
+/** Undo field : Negative status */
+#define UNDO_NEGATIVE_ENABLED   (UNDO_ARITH_MODE + 5)
+/** Undo field : Base */
+#define UNDO_RADIX              (UNDO_ARITH_MODE + 6)
+/** Undo field : Number of digits shown */
+#define UNDO_LCD_DIGITS         (UNDO_ARITH_MODE + 7)
+/** Undo field : Statistics of the values added to memory */
+#define UNDO_SUMMARY            (UNDO_ARITH_MODE + 8)
+/** Undo field : Summary status */
+#define UNDO_SUMMARY_ENABLED    (UNDO_ARITH_MODE + 9)
+/** Number of undo fields, one bit each in a step */
+#define NUM_UNDO_FIELDS         (UNDO_ARITH_MODE + 10)
+
+/** One step of a log, the fields of a state that differ from the state next to it */
+struct UndoStep
+{
+    /** Fields, a bit for each UNDO_ field */
+    quint32 fields;
+    /** Offset of the values in the log data */
+    int offset;
+    /** Index of the first value in the log numbers */
+    int number;
+};
+
+/**
+ *  Log of state differences.
+ *
+ *  A step keeps the values of the fields one state has and the state
+ *  next to it does not. Small values are packed in bytes, the arbitrary
+ *  precision registers are kept as numbers that share their digits with
+ *  the engine. A keystroke typically changes a few fields, so a step
+ *  takes a few dozen bytes.
+ */
+class UndoLog
+{
+public:
+    /** Forget all the steps */
+    void clear(void);
+    /** Get the number of steps */
+    int getCount(void) const;
+    /** Get the fields of a step */
+    quint32 getFields(int index) const;
+    /** Add a step with the values of some fields of a state */
+    void append(quint32 fields, const EngineState &state);
+    /** Set the fields of a step in a state */
+    void apply(int index, EngineState *state) const;
+    /** Drop the steps from an index on */
+    void truncate(int index);
+    /** Get the fields that differ between two states */
+    static quint32 compare(const EngineState &a, const EngineState &b);
+
+private:
+    /** Steps, oldest first */
+    QVector<UndoStep> steps;
+    /** Packed values of the steps */
+    QByteArray data;
+    /** Arbitrary precision values of the steps */
+    QVector<BigFloat> numbers;
+};
+
+/**
+ *  Undo and redo history of an engine.
+ *
+ *  The state before each keystroke is recorded as the fields it has and
+ *  the state after it does not, so each step takes constant time and a
+ *  few bytes and there is no limit on the number of steps. Only the last
+ *  state recorded is kept whole. Undo sets the fields of a step back,
+ *  keeping the values it replaces for redo.
+ */
+class UndoHistory
+{
+public:
+    /** Constructor */
+    UndoHistory();
+    /** Forget all the history */
+    void clear(void);
+    /** Record the state before a keystroke */
+    void record(Engine *engine);
+    /** Forget the last record, the keystroke did not happen */
+    void drop(void);
+    /** Go back one keystroke */
+    bool undo(Engine *engine);
+    /** Go forward one undone keystroke */
+    bool redo(Engine *engine);
+    /** Get the number of keystrokes that can be undone */
+    int getUndoCount(void);
+    /** Get the number of keystrokes that can be redone */
+    int getRedoCount(void);
+
+private:
+    /** Steps back from each state recorded to the one before */
+    UndoLog undoLog;
+    /** Steps forward from each state undone, the last undone last */
+    UndoLog redoLog;
+    /** Last state recorded, or the current one once undone */
+    EngineState last;
+    /** Number of states before the current state */
+    int current;
+    /** Number of states recorded */
+    int count;
+    /** Add the current state after the last one */
+    void push(Engine *engine);
+};
+
+#endif // UNDO_H
@@ -0,0 +1,397 @@
+/** @file vectorcalc.cpp
+ *
+ *  @brief This file contains the definitions of the array calculation kernels
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Includes */
+#include "vectorcalc.h"
+#include "engine.h"
+#include <string.h>
+#include <math.h>
+
+/** Build the x86 kernels where the compiler can target them */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_X86  1
+#include <immintrin.h>
+#else
+#define VECTOR_X86  0
+#endif
+
+/** Kernel function */
+typedef void (*VectorKernel)(int op, const double *op1, const double *op2,
+                             double *result, unsigned char *errors, int count);
+
+/** A kernel and its function */
+struct VectorKernelEntry
+{
+    /** Kernel, VECTOR_KERNEL_* */
+    int kernel;
+    /** Kernel function */
+    VectorKernel function;
+};
+
+/** Kernel in use, 0 until selected. Only ever read and set whole and
+ *  atomically, threads may select it on first use at the same time. */
+static const VectorKernelEntry *vectorKernelEntry = 0;
+
+/**
+ *  @brief  Calculate a range of elements in plain C++
+ *
+ *  @param  op      Operator
+ *  @param  op1     Operand 1 array
+ *  @param  op2     Operand 2 array
+ *  @param  result  Result array
+ *  @param  errors  Error mask
+ *  @param  start   First element, a multiple of 8
+ *  @param  count   Number of elements
+ *
+ *  @return N/A
+ */
+static void calculateRange(int op, const double *op1, const double *op2,
+                           double *result, unsigned char *errors, int start, int count)
+{
+    /* Clear the error bits of the range */
+    if (start < count) {
+        memset(errors + (start >> 3), 0, ((count + 7) >> 3) - (start >> 3));
+    }
+
+    /* Perform the calculation */
+    switch (op) {
+        case OPERATOR_PLUS:
+            for (int i = start; i < count; i++) {
+                result[i] = op1[i] + op2[i];
+            }
+            break;
+        case OPERATOR_MINUS:
+            for (int i = start; i < count; i++) {
+                result[i] = op1[i] - op2[i];
+            }
+            break;
+        case OPERATOR_MUL:
+            for (int i = start; i < count; i++) {
+                result[i] = op1[i] * op2[i];
+            }
+            break;
+        case OPERATOR_DIV:
+            for (int i = start; i < count; i++) {
+                if (op2[i] == 0) {
+                    /* Divide-by-zero error */
+                    result[i] = 0;
+                    errors[i >> 3] |= 1 << (i & 7);
+                } else {
+                    result[i] = op1[i] / op2[i];
+                }
+            }
+            break;
+        case OPERATOR_SQRT:
+            for (int i = start; i < count; i++) {
+                result[i] = sqrt(op1[i]);
+            }
+            break;
+        default:
+            /* Everything else goes through the engine one by one */
+            for (int i = start; i < count; i++) {
+                bool error = false;
+                result[i] = Engine::compute(op1[i], op2[i], op, &error);
+                if (error) {
+                    errors[i >> 3] |= 1 << (i & 7);
+                }
+            }
+            break;
+    }
+    return;
+}
+
+/**
+ *  @brief  Kernel : Plain C++
+ *
+ *  @param  op      Operator
+ *  @param  op1     Operand 1 array
+ *  @param  op2     Operand 2 array
+ *  @param  result  Result array
+ *  @param  errors  Error mask
+ *  @param  count   Number of elements
+ *
+ *  @return N/A
+ */
+static void calculateScalar(int op, const double *op1, const double *op2,
+                            double *result, unsigned char *errors, int count)
+{
+    /* All elements in one range */
+    calculateRange(op, op1, op2, result, errors, 0, count);
+    return;
+}
+
+#if VECTOR_X86
+/**
+ *  @brief  Kernel : AVX2, 8 elements per step to fill whole mask bytes
+ *
+ *  @param  op      Operator
+ *  @param  op1     Operand 1 array
+ *  @param  op2     Operand 2 array
+ *  @param  result  Result array
+ *  @param  errors  Error mask
+ *  @param  count   Number of elements
+ *
+ *  @return N/A
+ */
+__attribute__((target("avx2")))
+static void calculateAvx2(int op, const double *op1, const double *op2,
+                          double *result, unsigned char *errors, int count)
+{
+    int blocks = count & ~7;
+    const __m256d zero = _mm256_setzero_pd();
+
+    /* Perform the calculation on whole blocks */
+    switch (op) {
+        case OPERATOR_PLUS:
+            for (int i = 0; i < blocks; i += 4) {
+                _mm256_storeu_pd(result + i, _mm256_add_pd(_mm256_loadu_pd(op1 + i), _mm256_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_MINUS:
+            for (int i = 0; i < blocks; i += 4) {
+                _mm256_storeu_pd(result + i, _mm256_sub_pd(_mm256_loadu_pd(op1 + i), _mm256_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_MUL:
+            for (int i = 0; i < blocks; i += 4) {
+                _mm256_storeu_pd(result + i, _mm256_mul_pd(_mm256_loadu_pd(op1 + i), _mm256_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_DIV:
+            for (int i = 0; i < blocks; i += 8) {
+                __m256d b0 = _mm256_loadu_pd(op2 + i);
+                __m256d b1 = _mm256_loadu_pd(op2 + i + 4);
+                /* Lanes dividing by zero give 0 and an error bit */
+                __m256d z0 = _mm256_cmp_pd(b0, zero, _CMP_EQ_OQ);
+                __m256d z1 = _mm256_cmp_pd(b1, zero, _CMP_EQ_OQ);
+                __m256d q0 = _mm256_div_pd(_mm256_loadu_pd(op1 + i), b0);
+                __m256d q1 = _mm256_div_pd(_mm256_loadu_pd(op1 + i + 4), b1);
+                _mm256_storeu_pd(result + i, _mm256_andnot_pd(z0, q0));
+                _mm256_storeu_pd(result + i + 4, _mm256_andnot_pd(z1, q1));
+                errors[i >> 3] = _mm256_movemask_pd(z0) | (_mm256_movemask_pd(z1) << 4);
+            }
+            break;
+        case OPERATOR_SQRT:
+            for (int i = 0; i < blocks; i += 4) {
+                _mm256_storeu_pd(result + i, _mm256_sqrt_pd(_mm256_loadu_pd(op1 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        default:
+            /* No vector form, all elements are left over */
+            blocks = 0;
+            break;
+    }
+
+    /* Left over elements */
+    calculateRange(op, op1, op2, result, errors, blocks, count);
+    return;
+}
+
+/**
+ *  @brief  Kernel : AVX-512, one mask byte per vector
+ *
+ *  @param  op      Operator
+ *  @param  op1     Operand 1 array
+ *  @param  op2     Operand 2 array
+ *  @param  result  Result array
+ *  @param  errors  Error mask
+ *  @param  count   Number of elements
+ *
+ *  @return N/A
+ */
+__attribute__((target("avx512f")))
+static void calculateAvx512(int op, const double *op1, const double *op2,
+                            double *result, unsigned char *errors, int count)
+{
+    int blocks = count & ~7;
+    const __m512d zero = _mm512_setzero_pd();
+
+    /* Perform the calculation on whole blocks */
+    switch (op) {
+        case OPERATOR_PLUS:
+            for (int i = 0; i < blocks; i += 8) {
+                _mm512_storeu_pd(result + i, _mm512_add_pd(_mm512_loadu_pd(op1 + i), _mm512_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_MINUS:
+            for (int i = 0; i < blocks; i += 8) {
+                _mm512_storeu_pd(result + i, _mm512_sub_pd(_mm512_loadu_pd(op1 + i), _mm512_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_MUL:
+            for (int i = 0; i < blocks; i += 8) {
+                _mm512_storeu_pd(result + i, _mm512_mul_pd(_mm512_loadu_pd(op1 + i), _mm512_loadu_pd(op2 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        case OPERATOR_DIV:
+            for (int i = 0; i < blocks; i += 8) {
+                __m512d b = _mm512_loadu_pd(op2 + i);
+                /* Lanes dividing by zero give 0 and an error bit */
+                __mmask8 z = _mm512_cmp_pd_mask(b, zero, _CMP_EQ_OQ);
+                _mm512_storeu_pd(result + i, _mm512_maskz_div_pd((__mmask8) ~z, _mm512_loadu_pd(op1 + i), b));
+                errors[i >> 3] = z;
+            }
+            break;
+        case OPERATOR_SQRT:
+            for (int i = 0; i < blocks; i += 8) {
+                /* All lanes taken, the zero masked form leaves none undefined */
+                _mm512_storeu_pd(result + i, _mm512_maskz_sqrt_pd((__mmask8) 0xff, _mm512_loadu_pd(op1 + i)));
+            }
+            memset(errors, 0, blocks >> 3);
+            break;
+        default:
+            /* No vector form, all elements are left over */
+            blocks = 0;
+            break;
+    }
+
+    /* Left over elements */
+    calculateRange(op, op1, op2, result, errors, blocks, count);
+    return;
+}
+#endif
+
+/**
+ *  @brief  Get the kernel in use, selecting the best one on first use
+ *
+ *  @return Kernel in use
+ */
+static const VectorKernelEntry *currentKernel(void)
+{
+    const VectorKernelEntry *entry = __atomic_load_n(&vectorKernelEntry, __ATOMIC_ACQUIRE);
+
+    /* Threads racing here all select the same kernel */
+    if (entry == 0) {
+        VectorCalc::setKernel(VECTOR_KERNEL_AVX512);
+        entry = __atomic_load_n(&vectorKernelEntry, __ATOMIC_ACQUIRE);
+    }
+    return entry;
+}
+
+/**
+ *  @brief  Vector class method : Calculate over arrays of operands
+ *
+ *  @param  op      Operator
+ *  @param  op1     Operand 1 array
+ *  @param  op2     Operand 2 array, NULL to use operand 1
+ *  @param  result  Result array
+ *  @param  errors  Error mask, (count + 7) / 8 bytes
+ *  @param  count   Number of elements
+ *
+ *  @return Number of elements in error
+ */
+int VectorCalc::calculate(int op, const double *op1, const double *op2,
+                          double *result, unsigned char *errors, int count)
+{
+    int numErrors = 0;
+
+    /* Nothing to do */
+    if (count <= 0) {
+        return 0;
+    }
+
+    /* Unary use, as the square button does */
+    if (op2 == NULL) {
+        op2 = op1;
+    }
+
+    /* Perform the calculation */
+    currentKernel()->function(op, op1, op2, result, errors, count);
+
+    /* Count the errors */
+    for (int i = 0; i < ((count + 7) >> 3); i++) {
+        numErrors += __builtin_popcount(errors[i]);
+    }
+    return numErrors;
+}
+
+/**
+ *  @brief  Vector class method : Get the kernel in use
+ *
+ *  @return Kernel in use
+ */
+int VectorCalc::getKernel(void)
+{
+    /* Return kernel */
+    return currentKernel()->kernel;
+}
+
+/**
+ *  @brief  Vector class method : Select a kernel
+ *
+ *  @param  kernel  Kernel wanted
+ *
+ *  @return Kernel selected, the best supported one up to the one wanted
+ */
+int VectorCalc::setKernel(int kernel)
+{
+    /* Constant data, nothing is built at run time */
+    static const VectorKernelEntry scalar = { VECTOR_KERNEL_SCALAR, calculateScalar };
+#if VECTOR_X86
+    static const VectorKernelEntry avx2 = { VECTOR_KERNEL_AVX2, calculateAvx2 };
+    static const VectorKernelEntry avx512 = { VECTOR_KERNEL_AVX512, calculateAvx512 };
+#endif
+
+    /* Plain C++ always works */
+    const VectorKernelEntry *entry = &scalar;
+
+#if VECTOR_X86
+    /* Ask the CPU what it supports */
+    __builtin_cpu_init();
+    if ((kernel >= VECTOR_KERNEL_AVX512) && __builtin_cpu_supports("avx512f")) {
+        entry = &avx512;
+    } else if ((kernel >= VECTOR_KERNEL_AVX2) && __builtin_cpu_supports("avx2")) {
+        entry = &avx2;
+    }
+#else
+    (void) kernel;
+#endif
+
+    /* Publish the kernel and its function together */
+    __atomic_store_n(&vectorKernelEntry, entry, __ATOMIC_RELEASE);
+    return entry->kernel;
+}
+
+/**
+ *  @brief  Vector class method : Get the name of the kernel in use
+ *
+ *  @return Kernel name
+ */
+const char *VectorCalc::getKernelName(void)
+{
+    /* Return kernel name */
+    switch (getKernel()) {
+        case VECTOR_KERNEL_AVX2:
+            return "avx2";
+        case VECTOR_KERNEL_AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
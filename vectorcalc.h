@@ -0,0 +1,61 @@
+/** @file vectorcalc.h
+ *
+ *  @brief This file contains the declarations of the array calculation kernels
+ *
+ *  Copyright (C) 2009, Romit Chatterjee
+ *
+ *  This file is part of QCalc.
+ *
+ *  QCalc is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VECTORCALC_H
+#define VECTORCALC_H
+
+/* Defines */
+
+/** Kernel : Plain C++ */
+#define VECTOR_KERNEL_SCALAR    0
+/** Kernel : AVX2, 4 lanes */
+#define VECTOR_KERNEL_AVX2      1
+/** Kernel : AVX-512, 8 lanes */
+#define VECTOR_KERNEL_AVX512    2
+
+/**
+ *  Element-wise calculation over arrays of operands.
+ *
+ *  Each element gets the same result as Engine::calculate() would give
+ *  for it. Where the engine shows a divide-by-zero error the result is
+ *  0 and the element's bit is set in the error mask instead: bit
+ *  (i % 8) of byte (i / 8) belongs to element i. The error mask must
+ *  hold (count + 7) / 8 bytes. Operand 2 may be NULL, it is then taken
+ *  to be operand 1, as the square button does.
+ *
+ *  The fastest kernel the CPU supports is picked on first use.
+ */
+class VectorCalc
+{
+public:
+    /** Calculate over arrays of operands */
+    static int calculate(int op, const double *op1, const double *op2,
+                         double *result, unsigned char *errors, int count);
+    /** Get the kernel in use */
+    static int getKernel(void);
+    /** Select a kernel, falls back to the best supported one */
+    static int setKernel(int kernel);
+    /** Get the name of the kernel in use */
+    static const char *getKernelName(void);
+};
+
+#endif // VECTORCALC_H